@@ -118,7 +118,7 @@ acpi_read_madt(uint32_t type, int(*cb)(struct apic_header *, size_t), size_t arg
     static struct acpi_madt *madt;
     struct apic_header *hdr;
     uint8_t *cur, *end;
-    int retval;
+    int retval = -1;
 
     if (cb == NULL) {
         return -EINVAL;
@@ -140,10 +140,9 @@ acpi_read_madt(uint32_t type, int(*cb)(struct apic_header *, size_t), size_t arg
 
         if (hdr->type == type) {
             retval = cb(hdr, arg);
-        }
-
-        if (retval >= 0) {
-            return retval;
+            if (retval >= 0) {
+                return retval;
+            }
         }
 
         cur += hdr->length;
@@ -31,9 +31,83 @@
 #include <sys/cdefs.h>
 #include <sys/param.h>
 #include <os/trace.h>
+#include <kern/panic.h>
+#include <os/intr.h>
+#include <os/softint.h>
 #include <mu/cpu.h>
+#include <mu/irq.h>
+#include <vm/vm.h>
+#include <vm/phys.h>
+#include <lib/string.h>
 #include <md/msr.h>
+#include <md/gdt.h>
+#include <md/cpu.h>
+#include <md/tsc.h>
+#include <md/timepage.h>
+#include <md/idle.h>
 #include <md/lapic.h>
+#include <md/ioapic.h>
+
+/* Offsets used by the syscall entry path */
+_Static_assert(__builtin_offsetof(struct cpu_info, kstack) == CI_KSTACK,
+    "cpu_info kstack offset mismatch");
+_Static_assert(__builtin_offsetof(struct cpu_info, uscratch) == CI_USCRATCH,
+    "cpu_info uscratch offset mismatch");
+
+extern void syscall_entry(void);
+
+/*
+ * Set up the per processor kernel stack, TSS and the
+ * SYSCALL entry point.
+ *
+ * XXX: The GDT of the current processor must already
+ *      be loaded.
+ */
+static void
+cpu_kentry_init(struct cpu_info *ci)
+{
+    struct tss_desc *desc;
+    struct gdtr gdtr;
+    uintptr_t tss_base, stack;
+    uint64_t efer;
+
+    stack = vm_phys_alloc(KSTACK_SIZE / PAGESIZE);
+    if (stack == 0) {
+        panic("cpu: could not allocate kernel stack\n");
+    }
+
+    ci->kstack = (uintptr_t)PHYS_TO_VIRT(stack) + KSTACK_SIZE;
+    ci->uscratch = 0;
+    memset(&ci->sysstat, 0, sizeof(ci->sysstat));
+    memset(&ci->tss, 0, sizeof(ci->tss));
+    ci->tss.rsp0 = ci->kstack;
+    ci->tss.iomap = sizeof(ci->tss);
+
+    /* Point our TSS descriptor at the TSS */
+    __asmv("sgdt %0" : "=m" (gdtr) :: "memory");
+    desc = (struct tss_desc *)(gdtr.offset + GDT_TSS);
+    tss_base = (uintptr_t)&ci->tss;
+    desc->limit = sizeof(ci->tss) - 1;
+    desc->base_low = tss_base & 0xFFFF;
+    desc->base_mid = (tss_base >> 16) & 0xFF;
+    desc->access = 0x89;                    /* Present, available TSS */
+    desc->granularity = 0;
+    desc->base_hi = (tss_base >> 24) & 0xFF;
+    desc->base_upper = (tss_base >> 32) & 0xFFFFFFFF;
+    desc->reserved = 0;
+    __asmv("ltr %w0" :: "r" (GDT_TSS) : "memory");
+
+    /*
+     * SYSRET loads CS from STAR[63:48] + 16 and SS from
+     * STAR[63:48] + 8, see the selectors in md/gdt.h
+     */
+    efer = rdmsr(IA32_EFER);
+    wrmsr(IA32_EFER, efer | EFER_SCE);
+    wrmsr(IA32_STAR, ((uint64_t)GDT_KERNDATA << 48) |
+        ((uint64_t)GDT_KERNCODE << 32));
+    wrmsr(IA32_LSTAR, (uintptr_t)syscall_entry);
+    wrmsr(IA32_FMASK, RFLAGS_IF | RFLAGS_DF | RFLAGS_TF | RFLAGS_AC);
+}
 
 bool
 mu_irq_state(void)
@@ -44,6 +118,18 @@ mu_irq_state(void)
     return ISSET(rflags, BIT(9)) != 0;
 }
 
+void
+mu_irq_enable(void)
+{
+    __asmv("sti" ::: "memory");
+}
+
+void
+mu_irq_disable(void)
+{
+    __asmv("cli" ::: "memory");
+}
+
 struct cpu_info *
 cpu_self(void)
 {
@@ -56,10 +142,42 @@ cpu_self(void)
     return (void *)rdmsr(IA32_GS_BASE);
 }
 
+void
+cpu_pause(void)
+{
+    __asmv("pause" ::: "memory");
+}
+
 void
 cpu_conf(struct cpu_info *ci)
 {
     wrmsr(IA32_GS_BASE, (uintptr_t)ci);
     lapic_init();
+    ci->curthread = NULL;
+    ci->idle = NULL;
+    ci->flags = 0;
     TAILQ_INIT(&ci->pqueue);
+    spinlock_init("pqueue", &ci->pqueue_lock);
+    cpu_kentry_init(ci);
+
+    if (intr_cpu_init(ci) < 0) {
+        panic("cpu: failed to initialize interrupts\n");
+    }
+
+    softint_cpu_init();
+
+    /* Vectors with fixed handlers */
+    intr_reserve(ci, LAPIC_TMR_VEC);
+
+    /*
+     * The BSP installs the shared interrupt entry points
+     * and brings up the I/O APICs
+     */
+    if (ci->id == 0) {
+        mu_intr_init();
+        ioapic_init();
+        tsc_init();
+        timepage_init();
+        idle_init();
+    }
 }
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <mu/irq.h>
+#include <md/cpuid.h>
+#include <md/lapic.h>
+#include <md/idle.h>
+
+#define dtrace(fmt, ...) trace("idle: " fmt, ##__VA_ARGS__)
+
+/* CPUID.05H:ECX bits */
+#define MWAIT_ECX_EMX   BIT(0)  /* Extensions enumerated */
+
+/*
+ * An MWAIT idle state
+ *
+ * @hint: MWAIT hint in EAX
+ * @latency: Worst case exit latency in usec
+ */
+struct idle_state {
+    uint32_t hint;
+    uint32_t latency;
+};
+
+/*
+ * Exit latencies of C1 through C7 in usec, there is no
+ * _CST parsing so these are conservative guesses.
+ */
+static const uint32_t idle_latency[IDLE_NSTATE] = {
+    2, 10, 80, 150, 200, 250, 300
+};
+
+static struct idle_state idle_states[IDLE_NSTATE];
+static size_t idle_nstates = 0;
+static bool has_mwait = false;
+
+/*
+ * Pick the deepest state whose exit latency pays off
+ * within the time left until the next timer event.
+ */
+static struct idle_state *
+idle_select(struct cpu_info *ci)
+{
+    struct idle_state *st;
+    size_t predict;
+
+    if (ISSET(ci->flags, CPU_TICKLESS)) {
+        predict = (size_t)-1;
+    } else {
+        predict = lapic_remaining_usec(&ci->mcb);
+    }
+
+    for (size_t i = idle_nstates; i > 1; --i) {
+        st = &idle_states[i - 1];
+        if (predict / IDLE_RESIDENCY_MULT >= st->latency) {
+            return st;
+        }
+    }
+
+    return &idle_states[0];
+}
+
+bool
+idle_has_mwait(void)
+{
+    return has_mwait;
+}
+
+void
+idle_wait(struct cpu_info *ci)
+{
+    struct idle_state *st;
+    struct lapic_ipi ipi;
+
+    if (!has_mwait) {
+        __asmv("sti; hlt");
+        return;
+    }
+
+    /*
+     * Arm the monitor before the last look at the queue,
+     * an enqueue after that look breaks us out of MWAIT.
+     */
+    mu_irq_disable();
+    st = idle_select(ci);
+    __atomic_fetch_or(&ci->flags, CPU_IDLEWAIT, __ATOMIC_SEQ_CST);
+    __asmv(
+        "monitor"
+        :
+        : "a" (&TAILQ_FIRST(&ci->pqueue)), "c" (0), "d" (0)
+        : "memory"
+    );
+
+    if (TAILQ_EMPTY(&ci->pqueue) && ci->softint.pending == 0) {
+        __asmv("sti; mwait" :: "a" (st->hint), "c" (0) : "memory");
+        mu_irq_disable();
+    }
+
+    __atomic_fetch_and(&ci->flags, ~CPU_IDLEWAIT, __ATOMIC_SEQ_CST);
+
+    /* Woken by an enqueue, switch to it right away */
+    if (!TAILQ_EMPTY(&ci->pqueue)) {
+        ipi.dest_id = 0;
+        ipi.vector = LAPIC_TMR_VEC;
+        ipi.delmod = IPI_DELMOD_FIXED;
+        ipi.shorthand = IPI_SHAND_SELF;
+        ipi.logical_dest = 0;
+        lapic_send_ipi(&ci->mcb, &ipi);
+    }
+
+    mu_irq_enable();
+}
+
+void
+idle_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t nsub;
+    bool arat;
+
+    CPUID(0x00, eax, ebx, ecx, edx);
+    if (eax < 0x06) {
+        dtrace("no mwait leaf, using hlt\n");
+        return;
+    }
+
+    CPUID(0x01, eax, ebx, ecx, edx);
+    if (!ISSET(ecx, BIT(3))) {
+        dtrace("no monitor/mwait, using hlt\n");
+        return;
+    }
+
+    /* The local APIC timer may stop past C1 without ARAT */
+    CPUID(0x06, eax, ebx, ecx, edx);
+    arat = ISSET(eax, BIT(2)) != 0;
+
+    CPUID(0x05, eax, ebx, ecx, edx);
+    for (uint32_t cstate = 1; cstate <= IDLE_NSTATE; ++cstate) {
+        if (!arat && cstate > 1) {
+            break;
+        }
+
+        /* Without enumeration only C1 is known to exist */
+        nsub = (edx >> (cstate * 4)) & 0xF;
+        if (!ISSET(ecx, MWAIT_ECX_EMX)) {
+            nsub = (cstate == 1);
+        }
+
+        if (nsub == 0) {
+            continue;
+        }
+
+        idle_states[idle_nstates].hint = (cstate - 1) << 4;
+        idle_states[idle_nstates].latency = idle_latency[cstate - 1];
+        ++idle_nstates;
+    }
+
+    if (idle_nstates == 0) {
+        idle_states[0].hint = 0;
+        idle_states[0].latency = idle_latency[0];
+        idle_nstates = 1;
+    }
+
+    has_mwait = true;
+    dtrace("using mwait, %d state(s)\n", idle_nstates);
+}
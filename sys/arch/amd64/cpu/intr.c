@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <sys/errno.h>
+#include <mu/irq.h>
+#include <mu/cpu.h>
+#include <md/intr.h>
+#include <md/idt.h>
+#include <md/lapic.h>
+
+/* MSI address window of the Local APICs */
+#define MSI_ADDR_BASE 0xFEE00000ULL
+
+extern const uintptr_t intr_stubs[NIVEC];
+extern void intr_spurious(void);
+
+void
+mu_intr_init(void)
+{
+    /*
+     * The IDT is shared by every processor, vectors with
+     * fixed handlers of their own are left alone.
+     */
+    for (int vec = IVEC_MIN; vec <= IVEC_MAX; ++vec) {
+        if (vec == LAPIC_TMR_VEC) {
+            continue;
+        }
+
+        idt_set_gate(vec, INT_GATE, intr_stubs[vec - IVEC_MIN], 0);
+    }
+
+    idt_set_gate(IVEC_SPURIOUS, INT_GATE, (uintptr_t)intr_spurious, 0);
+}
+
+int
+mu_msi_compose(struct cpu_info *ci, uint8_t vec, uint64_t *addr_res,
+    uint32_t *data_res)
+{
+    if (ci == NULL || addr_res == NULL || data_res == NULL) {
+        return -EINVAL;
+    }
+
+    /*
+     * Physical destination mode, fixed delivery and edge
+     * triggered. Only 8-bit APIC IDs can be addressed without
+     * interrupt remapping.
+     */
+    if (ci->mcb.hwid > 0xFF) {
+        return -ENOTSUP;
+    }
+
+    *addr_res = MSI_ADDR_BASE | ((uint64_t)ci->mcb.hwid << 12);
+    *data_res = vec;
+    return 0;
+}
+
+void
+mu_intr_eoi(void)
+{
+    struct cpu_info *ci = cpu_self();
+
+    lapic_eoi(&ci->mcb);
+}
@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/errno.h>
+#include <sys/cdefs.h>
+#include <acpi/acpi.h>
+#include <acpi/tables.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <os/mmio.h>
+#include <os/trace.h>
+#include <os/intr.h>
+#include <mu/cpu.h>
+#include <md/ioapic.h>
+#include <vm/vm.h>
+
+#define dtrace(fmt, ...) trace("ioapic: " fmt, ##__VA_ARGS__)
+
+/* Register select and window */
+#define IOREGSEL    0x00
+#define IOWIN       0x10
+
+/* Registers */
+#define IOAPICID    0x00
+#define IOAPICVER   0x01
+#define IOREDTBL(N) (0x10 + ((N) * 2))
+
+/* Interrupt source override flags */
+#define ISO_POL_MASK    0x03
+#define ISO_POL_LOW     0x03
+#define ISO_TRIG_MASK   0x0C
+#define ISO_TRIG_LEVEL  0x0C
+
+#define ISA_IRQ_COUNT 16
+
+/*
+ * Represents an I/O APIC unit
+ *
+ * @id: I/O APIC ID
+ * @base: Virtual register base
+ * @gsi_base: First GSI served by this unit
+ * @npins: Number of redirection entries
+ */
+struct ioapic_unit {
+    uint8_t id;
+    void *base;
+    uint32_t gsi_base;
+    uint32_t npins;
+};
+
+/*
+ * Legacy IRQ wiring
+ *
+ * @gsi: GSI the IRQ is wired to
+ * @flags: Redirection entry flags
+ */
+struct isa_irq {
+    uint32_t gsi;
+    uint32_t flags;
+};
+
+static struct ioapic_unit ioapics[IOAPIC_MAX];
+static struct isa_irq isa_irqs[ISA_IRQ_COUNT];
+static size_t ioapic_count = 0;
+static struct spinlock ioapic_lock;
+
+static uint32_t
+ioapic_read(struct ioapic_unit *iop, uint8_t reg)
+{
+    mmio_write32(PTR_OFFSET(iop->base, IOREGSEL), reg);
+    return mmio_read32(PTR_OFFSET(iop->base, IOWIN));
+}
+
+static void
+ioapic_write(struct ioapic_unit *iop, uint8_t reg, uint32_t val)
+{
+    mmio_write32(PTR_OFFSET(iop->base, IOREGSEL), reg);
+    mmio_write32(PTR_OFFSET(iop->base, IOWIN), val);
+}
+
+/*
+ * Find the unit serving a GSI and the pin on it
+ */
+static struct ioapic_unit *
+ioapic_by_gsi(uint32_t gsi, uint32_t *pin_res)
+{
+    struct ioapic_unit *iop;
+
+    for (size_t i = 0; i < ioapic_count; ++i) {
+        iop = &ioapics[i];
+        if (gsi >= iop->gsi_base && gsi < iop->gsi_base + iop->npins) {
+            *pin_res = gsi - iop->gsi_base;
+            return iop;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Find the processor an entry currently delivers to
+ */
+static struct cpu_info *
+ioapic_dest_cpu(uint32_t hi)
+{
+    struct cpu_info *ci;
+
+    for (uint32_t i = 0; (ci = cpu_get(i)) != NULL; ++i) {
+        if (ci->mcb.hwid == (hi >> 24)) {
+            return ci;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+ioapic_madt_cb(struct apic_header *h, size_t arg)
+{
+    struct ioapic *ioapic = (struct ioapic *)h;
+    struct ioapic_unit *iop;
+
+    if (ioapic_count >= IOAPIC_MAX) {
+        dtrace("too many I/O APICs, ignoring id %d\n", ioapic->ioapic_id);
+        return -1;
+    }
+
+    iop = &ioapics[ioapic_count++];
+    iop->id = ioapic->ioapic_id;
+    iop->base = PHYS_TO_VIRT((uintptr_t)ioapic->ioapic_addr);
+    iop->gsi_base = ioapic->gsi_base;
+    iop->npins = ((ioapic_read(iop, IOAPICVER) >> 16) & 0xFF) + 1;
+    return -1;
+}
+
+static int
+ioapic_iso_cb(struct apic_header *h, size_t arg)
+{
+    struct interrupt_override *iso = (struct interrupt_override *)h;
+    struct isa_irq *irq;
+
+    if (iso->bus != 0 || iso->source >= ISA_IRQ_COUNT) {
+        return -1;
+    }
+
+    irq = &isa_irqs[iso->source];
+    irq->gsi = iso->interrupt;
+    irq->flags = 0;
+
+    if ((iso->flags & ISO_POL_MASK) == ISO_POL_LOW) {
+        irq->flags |= IOAPIC_ACTIVE_LOW;
+    }
+    if ((iso->flags & ISO_TRIG_MASK) == ISO_TRIG_LEVEL) {
+        irq->flags |= IOAPIC_LEVEL;
+    }
+
+    return -1;
+}
+
+uint32_t
+ioapic_irq_to_gsi(uint8_t irq, uint32_t *flags_res)
+{
+    if (irq >= ISA_IRQ_COUNT) {
+        if (flags_res != NULL)
+            *flags_res = 0;
+        return irq;
+    }
+
+    if (flags_res != NULL) {
+        *flags_res = isa_irqs[irq].flags;
+    }
+
+    return isa_irqs[irq].gsi;
+}
+
+int
+ioapic_route(uint32_t gsi, uint8_t vector, struct cpu_info *ci, uint32_t flags)
+{
+    struct ioapic_unit *iop;
+    uint32_t pin, lo;
+
+    if ((iop = ioapic_by_gsi(gsi, &pin)) == NULL) {
+        return -ENXIO;
+    }
+
+    /* Vectors below 0x20 belong to exceptions */
+    if (vector < 0x20 || ci == NULL) {
+        return -EINVAL;
+    }
+
+    spinlock_acquire(&ioapic_lock, true);
+
+    /*
+     * Fixed delivery, physical destination. Without interrupt
+     * remapping only APIC IDs below 256 can be targeted, which
+     * holds for every machine we support.
+     */
+    lo = vector | IOAPIC_MASKED;
+    lo |= flags & (IOAPIC_ACTIVE_LOW | IOAPIC_LEVEL);
+
+    /* Mask first so a half written entry never fires */
+    ioapic_write(iop, IOREDTBL(pin), IOAPIC_MASKED);
+    ioapic_write(iop, IOREDTBL(pin) + 1, ci->mcb.hwid << 24);
+    ioapic_write(iop, IOREDTBL(pin), lo);
+    spinlock_release(&ioapic_lock, true);
+    return 0;
+}
+
+int
+ioapic_route_irq(uint8_t irq, uint8_t vector, struct cpu_info *ci)
+{
+    uint32_t gsi, flags;
+
+    gsi = ioapic_irq_to_gsi(irq, &flags);
+    return ioapic_route(gsi, vector, ci, flags);
+}
+
+int
+ioapic_set_affinity(uint32_t gsi, struct cpu_info *ci)
+{
+    struct ioapic_unit *iop;
+    struct cpu_info *old;
+    uint32_t pin, lo, hi;
+    uint8_t vec;
+    int error;
+
+    if (ci == NULL) {
+        return -EINVAL;
+    }
+
+    if ((iop = ioapic_by_gsi(gsi, &pin)) == NULL) {
+        return -ENXIO;
+    }
+
+    spinlock_acquire(&ioapic_lock, true);
+    lo = ioapic_read(iop, IOREDTBL(pin));
+    hi = ioapic_read(iop, IOREDTBL(pin) + 1);
+    if ((old = ioapic_dest_cpu(hi)) == NULL) {
+        spinlock_release(&ioapic_lock, true);
+        return -ENXIO;
+    }
+
+    if (old == ci) {
+        spinlock_release(&ioapic_lock, true);
+        return 0;
+    }
+
+    /*
+     * Vectors are per processor, so the handlers go over to
+     * one allocated on the target while the pin is masked,
+     * then the entry is pointed at it with its old mask.
+     */
+    ioapic_write(iop, IOREDTBL(pin), lo | IOAPIC_MASKED);
+    if ((error = intr_move(old, lo & 0xFF, ci, &vec)) < 0) {
+        ioapic_write(iop, IOREDTBL(pin), lo);
+        spinlock_release(&ioapic_lock, true);
+        return error;
+    }
+
+    ioapic_write(iop, IOREDTBL(pin) + 1, ci->mcb.hwid << 24);
+    ioapic_write(iop, IOREDTBL(pin), (lo & ~0xFFU) | vec);
+    spinlock_release(&ioapic_lock, true);
+    return 0;
+}
+
+int
+ioapic_mask(uint32_t gsi, bool mask)
+{
+    struct ioapic_unit *iop;
+    uint32_t pin, lo;
+
+    if ((iop = ioapic_by_gsi(gsi, &pin)) == NULL) {
+        return -ENXIO;
+    }
+
+    spinlock_acquire(&ioapic_lock, true);
+    lo = ioapic_read(iop, IOREDTBL(pin));
+    if (mask) {
+        lo |= IOAPIC_MASKED;
+    } else {
+        lo &= ~IOAPIC_MASKED;
+    }
+
+    ioapic_write(iop, IOREDTBL(pin), lo);
+    spinlock_release(&ioapic_lock, true);
+    return 0;
+}
+
+void
+ioapic_init(void)
+{
+    struct ioapic_unit *iop;
+
+    if (spinlock_init("ioapic", &ioapic_lock) != 0) {
+        panic("ioapic: failed to initialize lock\n");
+    }
+
+    /* ISA IRQs are identity mapped unless overridden */
+    for (uint8_t i = 0; i < ISA_IRQ_COUNT; ++i) {
+        isa_irqs[i].gsi = i;
+        isa_irqs[i].flags = 0;
+    }
+
+    acpi_read_madt(APIC_TYPE_IO_APIC, ioapic_madt_cb, 0);
+    acpi_read_madt(APIC_TYPE_INTERRUPT_OVERRIDE, ioapic_iso_cb, 0);
+    if (ioapic_count == 0) {
+        panic("ioapic: no I/O APIC found\n");
+    }
+
+    for (size_t i = 0; i < ioapic_count; ++i) {
+        iop = &ioapics[i];
+        for (uint32_t pin = 0; pin < iop->npins; ++pin) {
+            ioapic_write(iop, IOREDTBL(pin), IOAPIC_MASKED);
+            ioapic_write(iop, IOREDTBL(pin) + 1, 0);
+        }
+
+        dtrace(
+            "ioapic%d: gsi %d-%d\n", iop->id,
+            iop->gsi_base, iop->gsi_base + iop->npins - 1
+        );
+    }
+}
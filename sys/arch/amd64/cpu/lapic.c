@@ -215,13 +215,13 @@ lapic_tmr_clbr(struct mcb *mcb)
     lapic_write(mcb, LAPIC_REG_TICR, LAPIC_TMR_SAMPLES);
     while (lapic_read(mcb, LAPIC_REG_TCCR) != 0);
 
-    /* Compute the deviation [total ticks] */
+    /* Compute the deviation [total ticks], the i8254 counts down */
     lapic_tmr_disable(mcb);
     ticks_end = i8254_get_count();
-    ticks_total = ticks_end - ticks_begin;
+    ticks_total = ticks_begin - ticks_end;
 
     /* Compute the frequency */
-    freq = (LAPIC_TMR_SAMPLES / ticks_total) * I8254_DIVIDEND;
+    freq = (LAPIC_TMR_SAMPLES * I8254_DIVIDEND) / ticks_total;
     return freq;
 }
 
@@ -357,7 +357,7 @@ lapic_read_id(struct mcb *mcb)
     uint32_t id;
 
     if (!mcb->has_x2apic) {
-        return (lapic_read(mcb, LAPIC_REG_ID) >> 24) & 0xF;
+        return (lapic_read(mcb, LAPIC_REG_ID) >> 24) & 0xFF;
     } else {
         return lapic_read(mcb, LAPIC_REG_ID);
     }
@@ -370,7 +370,24 @@ lapic_oneshot_usec(struct mcb *mcb, size_t usec)
         return;
     }
 
-    lapic_timer_oneshot(mcb, mcb->lapic_tmr_freq / 1000000);
+    lapic_timer_oneshot(mcb, (mcb->lapic_tmr_freq / 1000000) * usec);
+}
+
+size_t
+lapic_remaining_usec(struct mcb *mcb)
+{
+    size_t ticks_per_usec;
+
+    if (mcb == NULL) {
+        return 0;
+    }
+
+    ticks_per_usec = mcb->lapic_tmr_freq / 1000000;
+    if (ticks_per_usec == 0) {
+        return 0;
+    }
+
+    return lapic_read(mcb, LAPIC_REG_TCCR) / ticks_per_usec;
 }
 
 void
@@ -404,6 +421,7 @@ lapic_init(void)
     mcb->xapic_io = PHYS_TO_VIRT((uintptr_t)madt->lapic_addr);
 
     lapic_enable(mcb);
+    mcb->hwid = lapic_read_id(mcb);
     mcb->lapic_tmr_freq = lapic_tmr_clbr(mcb);
     idt_set_gate(LAPIC_TMR_VEC, INT_GATE, (uintptr_t)lapic_tmr_isr, 0);
 }
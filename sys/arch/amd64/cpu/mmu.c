@@ -31,10 +31,17 @@
 #include <sys/errno.h>
 #include <sys/cdefs.h>
 #include <kern/panic.h>
+#include <sys/mman.h>
 #include <mu/mmu.h>
+#include <mu/cpu.h>
+#include <os/process.h>
+#include <os/thread.h>
+#include <os/trace.h>
 #include <vm/vm.h>
+#include <vm/map.h>
 #include <vm/phys.h>
 #include <md/vas.h>
+#include <md/frame.h>
 #include <lib/stdbool.h>
 #include <lib/string.h>
 
@@ -53,6 +60,18 @@
 #define PTE_GLOBAL      BIT(8)        /* Global / sticky map */
 #define PTE_NX          BIT(63)       /* Execute-disable */
 
+/*
+ * See Intel SDM Vol 3A, Section 4.7, Figure 4-12
+ */
+#define PFEC_P          BIT(0)        /* Protection violation */
+#define PFEC_W          BIT(1)        /* Write access */
+#define PFEC_U          BIT(2)        /* User mode access */
+#define PFEC_I          BIT(4)        /* Instruction fetch */
+
+#define dtrace(fmt, ...) trace("pmap: " fmt, ##__VA_ARGS__)
+
+extern void trap_dispatch(struct trapframe *tf);
+
 typedef enum {
     PMAP_PML1,
     PMAP_PML2,
@@ -140,11 +159,10 @@ pmap_get_level(struct mmu_vas *vas, uintptr_t va, bool en_alloc, pagelevel_t lvl
     curlvl = PMAP_PML4;
 
     /* Start moving down */
-    while ((curlvl--) > lvl) {
+    for (; curlvl > lvl; --curlvl) {
         index = pmap_get_index(va, curlvl);
         if (ISSET(pmap[index], PTE_P)) {
             pmap = PHYS_TO_VIRT(pmap[index] & PTE_ADDR_MASK);
-            --curlvl;
             continue;
         }
 
@@ -192,6 +210,48 @@ mu_pmap_map(struct mmu_vas *vas, uintptr_t pa, uintptr_t va,
     return 0;
 }
 
+int
+mu_pmap_unmap(struct mmu_vas *vas, uintptr_t va)
+{
+    uintptr_t *pgtbl;
+
+    if (vas == NULL) {
+        return -EINVAL;
+    }
+
+    pgtbl = pmap_get_level(vas, va, false, PMAP_PML1);
+    if (pgtbl == NULL) {
+        return -EFAULT;
+    }
+
+    pgtbl[pmap_get_index(va, PMAP_PML1)] = 0;
+    pmap_invlpg(va);
+    return 0;
+}
+
+int
+mu_pmap_translate(struct mmu_vas *vas, uintptr_t va, uintptr_t *res)
+{
+    uintptr_t *pgtbl, pte;
+
+    if (vas == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    pgtbl = pmap_get_level(vas, va, false, PMAP_PML1);
+    if (pgtbl == NULL) {
+        return -EFAULT;
+    }
+
+    pte = pgtbl[pmap_get_index(va, PMAP_PML1)];
+    if (!ISSET(pte, PTE_P)) {
+        return -EFAULT;
+    }
+
+    *res = (pte & PTE_ADDR_MASK) | (va & (PAGESIZE - 1));
+    return 0;
+}
+
 int
 mu_pmap_readvas(struct mmu_vas *vas)
 {
@@ -258,6 +318,15 @@ mu_pmap_init(void)
         pml4[i] = 0;
     }
 
+    /*
+     * Kernel stacks are mapped after address spaces are
+     * forked, their top level entry must exist now so it
+     * is shared.
+     */
+    if (pmap_get_level(&cur_vas, KSTACK_AREA, true, PMAP_PML3) == NULL) {
+        panic("pmap: could not map kernel stack area\n");
+    }
+
     /*
      * The entries in the TLB may still refer to the old lower
      * half mappings which are now stale... To avoid this biting
@@ -265,3 +334,44 @@ mu_pmap_init(void)
      */
     mu_pmap_writevas(&cur_vas);
 }
+
+void
+mu_pmap_fault(struct trapframe *tf)
+{
+    struct process *proc;
+    struct thread *td;
+    uintptr_t va;
+    uint16_t access = PROT_READ;
+    int error;
+
+    __asmv("mov %%cr2, %0" : "=r" (va) :: "memory");
+
+    /*
+     * Only pages that are not present yet can be paged
+     * in, anything else is fatal.
+     */
+    if (ISSET(tf->error_code, PFEC_P) || va > VM_MAXUSER) {
+        trap_dispatch(tf);
+        return;
+    }
+
+    if ((td = cpu_self()->curthread) == NULL) {
+        trap_dispatch(tf);
+        return;
+    }
+
+    if (ISSET(tf->error_code, PFEC_W)) {
+        access |= PROT_WRITE;
+    }
+
+    if (ISSET(tf->error_code, PFEC_I)) {
+        access |= PROT_EXEC;
+    }
+
+    proc = td->proc;
+    error = vm_fault(&proc->map, &proc->vas, va, access);
+    if (error < 0) {
+        dtrace("pid %d: fault at %p (%d)\n", proc->pid, va, error);
+        trap_dispatch(tf);
+    }
+}
@@ -41,13 +41,15 @@
 #include <md/msr.h>
 #include <md/cpu.h>
 #include <md/gdt.h>
+#include <md/idle.h>
 #include <mu/cpu.h>
 #include <mu/mmu.h>
 #include <os/process.h>
+#include <os/thread.h>
 #include <os/sched.h>
+#include <os/softint.h>
 #include <vm/vm.h>
 #include <vm/phys.h>
-#include <vm/kalloc.h>
 
 #define MAX_CPUS 256
 
@@ -128,14 +130,37 @@ clean_addrsp(void)
 }
 
 static void
-cpu_idle(struct mcb *mcb)
+cpu_idle(struct cpu_info *ci)
 {
-    lapic_oneshot_usec(mcb, SCHED_QUANTUM);
+    lapic_oneshot_usec(&ci->mcb, SCHED_QUANTUM);
     for (;;) {
-        __asmv("sti; hlt");
+        softint_run();
+        idle_wait(ci);
     }
 }
 
+/*
+ * Allocate a processor descriptor on pages of its own so
+ * that its cache lines are never shared with unrelated
+ * data, APs call this themselves so they touch it first.
+ */
+static struct cpu_info *
+cpu_alloc(void)
+{
+    struct cpu_info *ci;
+    uintptr_t pa;
+    size_t npgs;
+
+    npgs = ALIGN_UP(sizeof(*ci), PAGESIZE) / PAGESIZE;
+    if ((pa = vm_phys_alloc(npgs)) == 0) {
+        return NULL;
+    }
+
+    ci = PHYS_TO_VIRT(pa);
+    memset(ci, 0, sizeof(*ci));
+    return ci;
+}
+
 static void
 cpu_mtrr_save(void)
 {
@@ -298,20 +323,19 @@ cpu_lm_entry(void)
         : "rax", "rbx"
     );
 
-    ci = kalloc(sizeof(*ci));
+    ci = cpu_alloc();
     if (ci == NULL) {
         panic("mp: could not allocate processor\n");
     }
 
     ci->id = aps_up + 1;
     cpu_loinit();
-    cpu_conf(ci);
-
-    atomic_inc_int(&aps_up);
-    cpu_list[aps_up] = ci;
 
-    /* Initialize the GDT */
-    memcpy(ci->ap_gdt, (void *)GDTR.offset, GDTR.limit);
+    /*
+     * Initialize the GDT, this must be done before
+     * configuring the processor as our TSS lives in it.
+     */
+    memcpy(ci->ap_gdt, (void *)GDTR.offset, GDTR.limit + 1);
     ci->ap_gdtr.offset = (uintptr_t)&ci->ap_gdt[0];
     ci->ap_gdtr.limit = GDTR.limit;
     __asmv(
@@ -321,8 +345,12 @@ cpu_lm_entry(void)
         : "memory"
     );
 
+    cpu_conf(ci);
+    atomic_inc_int(&aps_up);
+    cpu_list[aps_up] = ci;
+
     idt_load();
-    cpu_idle(&ci->mcb);
+    cpu_idle(ci);
     __builtin_unreachable();
 }
 
@@ -401,27 +429,35 @@ cpu_lapic_cb(struct apic_header *h, size_t arg)
     return -1;  /* Keep going */
 }
 
+/*
+ * Give every processor an idle thread pinned to it,
+ * this must be done once they are all up. Idle threads
+ * never go on a run queue, they only run when there is
+ * nothing else.
+ */
 static void
 cpu_start_idle(void)
 {
-    struct process *p;
     struct cpu_info *core;
+    struct thread *td;
     int error;
 
-    for (size_t i = 0; i < ap_count + 1; ++i) {
-        p = kalloc(sizeof(*p));
-        if (p == NULL) {
-            panic("mp: could not allocate idle thread\n");
-        }
+    for (size_t i = 0; i < aps_up + 1; ++i) {
+        core = cpu_get(i);
+        error = thread_create(
+            &proc0,
+            (uintptr_t)cpu_idle,
+            (uintptr_t)core,
+            PROC_KERN,
+            &td
+        );
 
-        /* Initialize the process */
-        error = process_init(p, (uintptr_t)cpu_idle, PROC_KERN);
         if (error < 0) {
-            panic("mp: could not initialize process\n");
+            panic("mp: could not create idle thread\n");
         }
 
-        core = sched_enqueue_proc(p);
-        core->curproc = NULL;
+        td->affinity = i;
+        core->idle = td;
     }
 }
 
@@ -441,6 +477,50 @@ cpu_count(void)
     return ap_count + 1;
 }
 
+struct cpu_info *
+cpu_pick(uint32_t hint)
+{
+    struct cpu_info *ci;
+    uint32_t ncpu = cpu_count();
+
+    for (uint32_t i = 0; i < ncpu; ++i) {
+        ci = cpu_get((hint + i) % ncpu);
+        if (ci == NULL) {
+            continue;
+        }
+
+        if (!ISSET(ci->flags, CPU_ISOLATED)) {
+            return ci;
+        }
+    }
+
+    return cpu_self();
+}
+
+void
+cpu_kick(struct cpu_info *ci)
+{
+    struct cpu_info *self = cpu_self();
+    struct lapic_ipi ipi;
+
+    if (ci == NULL) {
+        return;
+    }
+
+    if (ci == self) {
+        lapic_oneshot_usec(&ci->mcb, SCHED_QUANTUM);
+        return;
+    }
+
+    /* Looks like a tick to the other side */
+    ipi.dest_id = ci->mcb.hwid;
+    ipi.vector = LAPIC_TMR_VEC;
+    ipi.delmod = IPI_DELMOD_FIXED;
+    ipi.shorthand = IPI_SHAND_NONE;
+    ipi.logical_dest = 0;
+    lapic_send_ipi(&self->mcb, &ipi);
+}
+
 void
 cpu_start_aps(struct cpu_info *ci)
 {
@@ -467,7 +547,6 @@ cpu_start_aps(struct cpu_info *ci)
     /* Copy the bring up code to the BUA */
     bua = AP_BUA_VADDR;
     memcpy(bua, ap_code, AP_BUA_LEN);
-    cpu_start_idle();
 
     /* Start up the APs */
     mcb = &self->mcb;
@@ -490,5 +569,5 @@ cpu_start_aps(struct cpu_info *ci)
     }
 
     cpu_free_bootspace(&bs);
-
+    cpu_start_idle();
 }
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <os/trace.h>
+#include <md/cpuid.h>
+#include <md/cpu.h>
+#include <md/i8254.h>
+#include <md/tsc.h>
+
+#define dtrace(fmt, ...) trace("tsc: " fmt, ##__VA_ARGS__)
+
+/* i8254 ticks to sample over [~27ms] */
+#define TSC_CLBR_TICKS 0x8000
+
+static uint64_t tsc_hz = 0;
+
+bool
+tsc_invariant(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    CPUID(0x80000000, eax, ebx, ecx, edx);
+    if (eax < 0x80000007) {
+        return false;
+    }
+
+    CPUID(0x80000007, eax, ebx, ecx, edx);
+    return (edx & BIT(8)) != 0;
+}
+
+uint64_t
+tsc_freq(void)
+{
+    return tsc_hz;
+}
+
+/*
+ * Count TSC ticks across a fixed number of i8254
+ * ticks
+ */
+static uint64_t
+tsc_clbr(void)
+{
+    uint64_t tsc_begin, tsc_end;
+    uint16_t ticks_begin, ticks_end;
+    uint16_t ticks_total;
+
+    i8254_set_count(0xFFFF);
+    ticks_begin = i8254_get_count();
+    tsc_begin = rdtsc();
+
+    /* The i8254 counts down */
+    do {
+        ticks_end = i8254_get_count();
+        ticks_total = ticks_begin - ticks_end;
+    } while (ticks_total < TSC_CLBR_TICKS);
+
+    tsc_end = rdtsc();
+    return ((tsc_end - tsc_begin) * I8254_DIVIDEND) / ticks_total;
+}
+
+void
+tsc_init(void)
+{
+    if (tsc_hz != 0) {
+        return;
+    }
+
+    if (!tsc_invariant()) {
+        dtrace("TSC is not invariant\n");
+    }
+
+    tsc_hz = tsc_clbr();
+    dtrace("TSC at %d MHz\n", tsc_hz / 1000000);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/tty/tty.h>
+#include <os/intr.h>
+#include <os/trace.h>
+#include <md/pio.h>
+#include <md/isa.h>
+
+#define dtrace(fmt, ...) trace("com: " fmt, ##__VA_ARGS__)
+
+#define COM1            0x3F8
+
+/* Register offsets */
+#define COM_RBR         0       /* Receive buffer */
+#define COM_IER         1       /* Interrupt enable */
+#define COM_IIR         2       /* Interrupt identification */
+#define COM_FCR         2       /* FIFO control */
+#define COM_MCR         4       /* Modem control */
+#define COM_LSR         5       /* Line status */
+
+/* IER bits */
+#define COM_IER_RDA     BIT(0)  /* Received data available */
+
+/* IIR bits */
+#define COM_IIR_NOPEND  BIT(0)  /* No interrupt pending */
+
+/* FCR bits */
+#define COM_FCR_ENABLE  BIT(0)  /* Enable FIFOs */
+#define COM_FCR_CLRRX   BIT(1)  /* Clear receive FIFO */
+#define COM_FCR_CLRTX   BIT(2)  /* Clear transmit FIFO */
+#define COM_FCR_TRIG8   (2 << 6)    /* Interrupt at 8 bytes */
+
+/* MCR bits */
+#define COM_MCR_DTR     BIT(0)
+#define COM_MCR_RTS     BIT(1)
+#define COM_MCR_OUT2    BIT(3)  /* Gates the IRQ line */
+
+/* LSR bits */
+#define COM_LSR_DR      BIT(0)  /* Data ready */
+
+static struct tty *com_tty;
+
+static int
+com_intr(void *arg)
+{
+    uint8_t iir;
+
+    iir = pio_inb(COM1 + COM_IIR);
+    if (ISSET(iir, COM_IIR_NOPEND)) {
+        return INTR_UNHANDLED;
+    }
+
+    /*
+     * The line is edge triggered, drain the FIFO completely
+     * so the next byte raises a fresh edge.
+     */
+    while (ISSET(pio_inb(COM1 + COM_LSR), COM_LSR_DR)) {
+        tty_input(com_tty, pio_inb(COM1 + COM_RBR));
+    }
+
+    return INTR_HANDLED;
+}
+
+int
+com_attach(void)
+{
+    int error;
+
+    if ((error = tty_lookup("ttyS0", &com_tty)) < 0) {
+        return error;
+    }
+
+    /*
+     * Raise interrupts a few bytes in, pasted input then
+     * costs one interrupt per burst while single keys still
+     * arrive through the character timeout.
+     */
+    pio_outb(COM1 + COM_FCR, COM_FCR_ENABLE | COM_FCR_CLRRX |
+        COM_FCR_CLRTX | COM_FCR_TRIG8);
+    pio_outb(COM1 + COM_MCR, COM_MCR_DTR | COM_MCR_RTS | COM_MCR_OUT2);
+
+    error = isa_intr_establish(ISA_IRQ_COM1, "com1", com_intr, NULL, NULL);
+    if (error < 0) {
+        dtrace("could not establish interrupt\n");
+        return error;
+    }
+
+    /* Discard anything that came in before we were ready */
+    while (ISSET(pio_inb(COM1 + COM_LSR), COM_LSR_DR)) {
+        pio_inb(COM1 + COM_RBR);
+    }
+
+    pio_outb(COM1 + COM_IER, COM_IER_RDA);
+    return 0;
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/tty/tty.h>
+#include <lib/stdbool.h>
+#include <os/intr.h>
+#include <os/trace.h>
+#include <md/pio.h>
+#include <md/isa.h>
+
+#define dtrace(fmt, ...) trace("i8042: " fmt, ##__VA_ARGS__)
+
+/* Ports */
+#define I8042_DATA      0x60
+#define I8042_STATUS    0x64    /* Reads */
+#define I8042_CMD       0x64    /* Writes */
+
+/* Status bits */
+#define I8042_OBF       BIT(0)  /* Output buffer full */
+#define I8042_IBF       BIT(1)  /* Input buffer full */
+#define I8042_AUXDATA   BIT(5)  /* Output is from the second port */
+
+/* Controller commands */
+#define I8042_RDCONF    0x20
+#define I8042_WRCONF    0x60
+#define I8042_DISPORT2  0xA7
+#define I8042_DISPORT1  0xAD
+#define I8042_ENPORT1   0xAE
+
+/* Config byte bits */
+#define I8042_CONF_INT1     BIT(0)  /* First port IRQ */
+#define I8042_CONF_INT2     BIT(1)  /* Second port IRQ */
+#define I8042_CONF_XLATE    BIT(6)  /* Translate to set 1 */
+
+/* Polling attempts before a controller is given up on */
+#define I8042_TIMEOUT   100000
+
+/* Set 1 scancodes of the modifier keys */
+#define SC_LCTRL        0x1D
+#define SC_LSHIFT       0x2A
+#define SC_RSHIFT       0x36
+#define SC_CAPSLOCK     0x3A
+#define SC_RELEASE      0x80
+#define SC_EXTENDED     0xE0
+
+/* Modifier state */
+#define KBD_SHIFT       BIT(0)
+#define KBD_CTRL        BIT(1)
+#define KBD_CAPS        BIT(2)
+#define KBD_EXTENDED    BIT(3)
+
+static struct tty *kbd_tty;
+static uint8_t kbd_mods;
+
+/*
+ * Set 1 scancode to ASCII, zero for keys with no
+ * character
+ */
+static const char kbd_map[] = {
+    0,   0x1B, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=',
+    '\b', '\t', 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']',
+    '\n', 0,   'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
+    0,   '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0,   '*',
+    0,   ' '
+};
+
+static const char kbd_shiftmap[] = {
+    0,   0x1B, '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+',
+    '\b', '\t', 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}',
+    '\n', 0,   'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~',
+    0,   '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0,   '*',
+    0,   ' '
+};
+
+/*
+ * Wait for a status bit to reach a state
+ *
+ * Returns zero on success
+ */
+static int
+i8042_wait(uint8_t bit, bool set)
+{
+    for (size_t i = 0; i < I8042_TIMEOUT; ++i) {
+        if ((ISSET(pio_inb(I8042_STATUS), bit) != 0) == set) {
+            return 0;
+        }
+    }
+
+    return -ETIMEDOUT;
+}
+
+static int
+i8042_cmd(uint8_t cmd)
+{
+    if (i8042_wait(I8042_IBF, false) < 0) {
+        return -ETIMEDOUT;
+    }
+
+    pio_outb(I8042_CMD, cmd);
+    return 0;
+}
+
+static int
+i8042_write(uint8_t val)
+{
+    if (i8042_wait(I8042_IBF, false) < 0) {
+        return -ETIMEDOUT;
+    }
+
+    pio_outb(I8042_DATA, val);
+    return 0;
+}
+
+static int
+i8042_read(uint8_t *res)
+{
+    if (i8042_wait(I8042_OBF, true) < 0) {
+        return -ETIMEDOUT;
+    }
+
+    *res = pio_inb(I8042_DATA);
+    return 0;
+}
+
+/*
+ * Track modifiers and turn a scancode into a character
+ *
+ * Returns zero if there is nothing to deliver
+ */
+static char
+kbd_translate(uint8_t sc)
+{
+    bool release, upper;
+    char c;
+
+    if (sc == SC_EXTENDED) {
+        kbd_mods |= KBD_EXTENDED;
+        return 0;
+    }
+
+    release = ISSET(sc, SC_RELEASE);
+    sc &= ~SC_RELEASE;
+
+    /*
+     * Right control shares the code of the left one
+     *
+     * XXX: Other extended keys (arrows, keypad) are ignored
+     */
+    if (ISSET(kbd_mods, KBD_EXTENDED)) {
+        kbd_mods &= ~KBD_EXTENDED;
+        if (sc != SC_LCTRL) {
+            return 0;
+        }
+    }
+
+    switch (sc) {
+    case SC_LSHIFT:
+    case SC_RSHIFT:
+        if (release) {
+            kbd_mods &= ~KBD_SHIFT;
+        } else {
+            kbd_mods |= KBD_SHIFT;
+        }
+        return 0;
+    case SC_LCTRL:
+        if (release) {
+            kbd_mods &= ~KBD_CTRL;
+        } else {
+            kbd_mods |= KBD_CTRL;
+        }
+        return 0;
+    case SC_CAPSLOCK:
+        if (!release) {
+            kbd_mods ^= KBD_CAPS;
+        }
+        return 0;
+    }
+
+    if (release || sc >= NELEM(kbd_map)) {
+        return 0;
+    }
+
+    if ((c = kbd_map[sc]) == 0) {
+        return 0;
+    }
+
+    if (ISSET(kbd_mods, KBD_CTRL)) {
+        return (c >= 'a' && c <= 'z') ? c & 0x1F : 0;
+    }
+
+    /* Caps lock only affects letters, and shift undoes it */
+    upper = ISSET(kbd_mods, KBD_SHIFT);
+    if (c >= 'a' && c <= 'z' && ISSET(kbd_mods, KBD_CAPS)) {
+        upper = !upper;
+    }
+
+    if (upper) {
+        c = kbd_shiftmap[sc];
+    }
+
+    return c;
+}
+
+static int
+i8042_intr(void *arg)
+{
+    uint8_t status, sc;
+    bool handled = false;
+    char c;
+
+    for (;;) {
+        status = pio_inb(I8042_STATUS);
+        if (!ISSET(status, I8042_OBF) || ISSET(status, I8042_AUXDATA)) {
+            break;
+        }
+
+        sc = pio_inb(I8042_DATA);
+        handled = true;
+        if ((c = kbd_translate(sc)) != 0) {
+            tty_input(kbd_tty, c);
+        }
+    }
+
+    return handled ? INTR_HANDLED : INTR_UNHANDLED;
+}
+
+int
+i8042_attach(void)
+{
+    uint8_t conf;
+    int error;
+
+    /* Nothing decodes the ports if the controller is absent */
+    if (pio_inb(I8042_STATUS) == 0xFF) {
+        return -ENODEV;
+    }
+
+    if ((error = tty_lookup("console", &kbd_tty)) < 0) {
+        return error;
+    }
+
+    /* Quiesce both ports while we reconfigure */
+    if (i8042_cmd(I8042_DISPORT1) < 0 || i8042_cmd(I8042_DISPORT2) < 0) {
+        dtrace("controller not responding\n");
+        return -ETIMEDOUT;
+    }
+
+    while (ISSET(pio_inb(I8042_STATUS), I8042_OBF)) {
+        pio_inb(I8042_DATA);
+    }
+
+    if (i8042_cmd(I8042_RDCONF) < 0 || i8042_read(&conf) < 0) {
+        return -ETIMEDOUT;
+    }
+
+    /* First port only, scancodes translated to set 1 */
+    conf |= I8042_CONF_INT1 | I8042_CONF_XLATE;
+    conf &= ~I8042_CONF_INT2;
+    if (i8042_cmd(I8042_WRCONF) < 0 || i8042_write(conf) < 0) {
+        return -ETIMEDOUT;
+    }
+
+    error = isa_intr_establish(ISA_IRQ_KBD, "i8042", i8042_intr, NULL,
+        NULL);
+    if (error < 0) {
+        dtrace("could not establish interrupt\n");
+        return error;
+    }
+
+    return i8042_cmd(I8042_ENPORT1);
+}
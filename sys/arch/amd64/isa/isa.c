@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <os/intr.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <mu/tty.h>
+#include <md/ioapic.h>
+#include <md/isa.h>
+
+#define dtrace(fmt, ...) trace("isa: " fmt, ##__VA_ARGS__)
+
+int
+isa_intr_establish(uint8_t irq, const char *name, int(*func)(void *),
+    void *arg, struct cpu_info *ci)
+{
+    uint32_t gsi;
+    uint8_t vec;
+    int error;
+
+    if (ci == NULL) {
+        ci = cpu_pick(irq);
+    }
+
+    /*
+     * The vector must come from the processor the pin is
+     * routed to, as each one has its own vector space.
+     */
+    error = intr_establish(name, func, arg, ci, &vec);
+    if (error < 0) {
+        return error;
+    }
+
+    if ((error = ioapic_route_irq(irq, vec, ci)) < 0) {
+        intr_disestablish(ci, vec);
+        return error;
+    }
+
+    gsi = ioapic_irq_to_gsi(irq, NULL);
+    return ioapic_mask(gsi, false);
+}
+
+void
+mu_tty_attach(void)
+{
+    if (com_attach() < 0) {
+        dtrace("no serial input\n");
+    }
+
+    if (i8042_attach() < 0) {
+        dtrace("no keyboard input\n");
+    }
+}
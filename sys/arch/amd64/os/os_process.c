@@ -28,128 +28,383 @@
  */
 
 #include <sys/errno.h>
+#include <sys/atomic.h>
 #include <mu/process.h>
 #include <mu/mmu.h>
 #include <mu/cpu.h>
+#include <mu/irq.h>
+#include <mu/spinlock.h>
+#include <md/cpu.h>
 #include <md/gdt.h>
+#include <md/idle.h>
+#include <md/msr.h>
 #include <md/lapic.h>
+#include <md/timepage.h>
 #include <os/process.h>
+#include <os/thread.h>
 #include <os/sched.h>
+#include <os/softint.h>
 #include <vm/phys.h>
 #include <vm/vm.h>
 #include <lib/string.h>
 
 #define STACK_TOP 0xBFFFFFFF
 
-static void
+/* Stride between kernel stacks, includes the guard page */
+#define KSTACK_STRIDE (KSTACK_SIZE + PAGESIZE)
+
+static volatile size_t kstack_next = 0;
+
+/*
+ * Stacks of exited threads stay mapped and are handed
+ * out again, the link lives at the bottom of each one.
+ */
+static volatile size_t kstack_lock = 0;
+static uintptr_t kstack_free_head = 0;
+
+__used static void
 sched_enter(struct cpu_info *ci)
 {
     lapic_oneshot_usec(&ci->mcb, SCHED_QUANTUM);
     for (;;) {
-        __asmv("sti; hlt");
+        softint_run();
+        idle_wait(ci);
+    }
+}
+
+/*
+ * Idle on the per processor stack, the stack we are on
+ * may belong to a thread that another core picks up.
+ */
+__dead static void
+sched_idle(struct cpu_info *ci)
+{
+    __asmv(
+        "mov %0, %%rsp\n\t"
+        "call sched_enter"
+        :
+        : "r" (ci->kstack), "D" (ci)
+        : "memory"
+    );
+
+    __builtin_unreachable();
+}
+
+/*
+ * First thing run on the per processor stack once a
+ * thread has exited, nothing touches its stack anymore.
+ */
+__used static void
+thread_exit_enter(struct cpu_info *ci, struct thread *td)
+{
+    thread_retire(td);
+    sched_enter(ci);
+}
+
+/*
+ * Load the next runnable thread into a trapframe, if
+ * there is none we run the idle thread of this core.
+ */
+static void
+thread_load_next(struct cpu_info *ci, struct trapframe *tf)
+{
+    struct thread *next;
+    struct pcb *pcb;
+
+    if ((next = sched_dequeue_thread()) == NULL) {
+        next = ci->idle;
+    }
+
+    if (next == NULL) {
+        ci->curthread = NULL;
+        sched_idle(ci);
+    }
+
+    /* Switch to the next thread */
+    pcb = &next->pcb;
+    memcpy(tf, &pcb->tf, sizeof(*tf));
+    wrmsr(IA32_FS_BASE, pcb->fsbase);
+    ci->curthread = next;
+
+    /* Switch address space and go */
+    mu_pmap_writevas(&next->proc->vas);
+}
+
+int
+mu_thread_block(struct trapframe *tf)
+{
+    struct cpu_info *ci = cpu_self();
+    struct thread *self;
+
+    if ((self = ci->curthread) == NULL) {
+        return 0;
     }
+
+    if (self->state != THREAD_SLEEP) {
+        return 0;
+    }
+
+    /* Save our context before a waker can see us */
+    memcpy(&self->pcb.tf, tf, sizeof(self->pcb.tf));
+    if (!sched_block(self)) {
+        return 0;
+    }
+
+    thread_load_next(ci, tf);
+    return 1;
 }
 
 void
 mu_process_switch(struct trapframe *tf)
 {
     struct cpu_info *ci = cpu_self();
-    struct process *self, *next;
+    struct thread *self;
     struct pcb *pcb;
 
     if (ci == NULL) {
-        goto done;
+        return;
     }
 
-    if ((self = ci->curproc) == NULL) {
-        ci->curproc = sched_dequeue_proc();
-        goto done;
-    }
+    /*
+     * Drive the timer soft interrupt, the EOI goes out
+     * first as we may idle without returning. Run it here
+     * as device interrupts do, a busy processor may never
+     * see one.
+     */
+    softint_raise(SOFTINT_TIMER);
+    lapic_eoi(&ci->mcb);
+    softint_run();
 
-    /* Save current process */
-    sched_enqueue_proc(self);
-    pcb = &self->pcb;
-    memcpy(&pcb->tf, tf, sizeof(pcb->tf));
+    /*
+     * Save current thread, the idle thread is never queued
+     * and one going to sleep stays off the queue until it
+     * is woken.
+     */
+    if ((self = ci->curthread) != NULL) {
+        pcb = &self->pcb;
+        memcpy(&pcb->tf, tf, sizeof(pcb->tf));
+        if (self->state == THREAD_SLEEP && sched_block(self)) {
+            self = NULL;
+        }
 
-    /* Get the next process */
-    next = sched_dequeue_proc();
-    if (next == NULL) {
-        sched_enter(ci);
+        if (self != NULL && self != ci->idle) {
+            sched_enqueue_thread(self);
+        }
     }
 
-    /* Switch to the next process */
-    pcb = &next->pcb;
-    memcpy(tf, &pcb->tf, sizeof(*tf));
-    ci->curproc = next;
+    /* Get the next thread */
+    thread_load_next(ci, tf);
+    if (!sched_stop_tick(ci)) {
+        lapic_oneshot_usec(&ci->mcb, SCHED_QUANTUM);
+    }
+}
 
-    /* Switch address space and go */
-    mu_pmap_writevas(&pcb->vas);
-done:
-    lapic_eoi(&ci->mcb);
-    lapic_oneshot_usec(&ci->mcb, SCHED_QUANTUM);
+void
+mu_thread_yield(void)
+{
+    /* Looks like a tick, an EOI with nothing in service is ignored */
+    __asmv("int %0" :: "i" (LAPIC_TMR_VEC) : "memory");
 }
 
 int
-mu_process_init(struct process *process, uintptr_t ip, int flags)
+mu_process_init(struct process *process, int flags)
 {
-    struct trapframe *tf;
-    struct pcb *pcb;
-    uintptr_t stack_base;
-    uint8_t cs, ds;
     int error;
 
     if (process == NULL) {
         return -EINVAL;
     }
 
-    pcb = &process->pcb;
-    tf = &pcb->tf;
+    /* Kernel threads run in the current address space */
+    if (ISSET(flags, PROC_KERN)) {
+        return mu_pmap_readvas(&process->vas);
+    }
 
-    error = mu_pmap_forkvas(&pcb->vas);
+    error = mu_pmap_forkvas(&process->vas);
     if (error < 0) {
         return error;
     }
 
-    /* Allocate a new stack */
-    stack_base = vm_phys_alloc(1);
-    if (stack_base == 0) {
-        vm_phys_free(pcb->vas.cr3, 1);
-        return -ENOMEM;
+    /* Clock reads go through the time page */
+    error = timepage_map(&process->vas);
+    if (error < 0 && error != -ENODEV) {
+        vm_phys_free(process->vas.cr3, 1);
+        return error;
     }
 
-    /* Get the segment selectors based on mode */
-    if (ISSET(flags, PROC_KERN)) {
-        cs = GDT_KERNCODE;
-        ds = GDT_KERNDATA;
-    } else {
-        cs = GDT_USERCODE | 3;
-        ds = GDT_USERDATA | 3;
+    return 0;
+}
+
+/*
+ * Undo the first 'len' bytes of a partially mapped
+ * kernel stack
+ */
+static void
+kstack_unwind(struct mmu_vas *vas, uintptr_t base, size_t len)
+{
+    uintptr_t pa;
+
+    for (size_t off = 0; off < len; off += PAGESIZE) {
+        if (mu_pmap_translate(vas, base + off, &pa) == 0) {
+            mu_pmap_unmap(vas, base + off);
+            vm_phys_free(pa, 1);
+        }
+    }
+}
+
+/*
+ * Allocate a kernel stack with an unmapped guard page
+ * below it, returns the stack top.
+ */
+static uintptr_t
+kstack_alloc(void)
+{
+    struct mmu_vas vas;
+    uintptr_t base, pa, top;
+    size_t slot;
+
+    mu_spinlock_acq(&kstack_lock, 0);
+    if ((top = kstack_free_head) != 0) {
+        kstack_free_head = *(uintptr_t *)(top - KSTACK_SIZE);
+    }
+    mu_spinlock_rel(&kstack_lock, 0);
+
+    if (top != 0) {
+        return top;
+    }
+
+    slot = __atomic_fetch_add(&kstack_next, 1, __ATOMIC_RELAXED);
+    if ((slot + 1) * KSTACK_STRIDE > KSTACK_AREA_LEN) {
+        return 0;
+    }
+
+    /* Kernel mappings are shared by every address space */
+    mu_pmap_readvas(&vas);
+    base = KSTACK_AREA + (slot * KSTACK_STRIDE) + PAGESIZE;
+    for (size_t off = 0; off < KSTACK_SIZE; off += PAGESIZE) {
+        if ((pa = vm_phys_alloc(1)) == 0) {
+            kstack_unwind(&vas, base, off);
+            return 0;
+        }
+
+        if (mu_pmap_map(&vas, pa, base + off, PROT_READ | PROT_WRITE, PAGESIZE_4K) < 0) {
+            vm_phys_free(pa, 1);
+            kstack_unwind(&vas, base, off);
+            return 0;
+        }
+    }
+
+    return base + KSTACK_SIZE;
+}
+
+/*
+ * Put a kernel stack up for reuse
+ */
+static void
+kstack_free(uintptr_t top)
+{
+    mu_spinlock_acq(&kstack_lock, 0);
+    *(uintptr_t *)(top - KSTACK_SIZE) = kstack_free_head;
+    kstack_free_head = top;
+    mu_spinlock_rel(&kstack_lock, 0);
+}
+
+int
+mu_thread_init(struct thread *td, uintptr_t ip, uintptr_t arg, int flags)
+{
+    struct process *proc;
+    struct trapframe *tf;
+    uintptr_t stack_base, *tcb;
+    int error;
+
+    if (td == NULL || (proc = td->proc) == NULL) {
+        return -EINVAL;
     }
 
+    tf = &td->pcb.tf;
     memset(tf, 0, sizeof(*tf));
     tf->rip = ip;
+    tf->rdi = arg;
     tf->rflags = 0x202;
-    tf->cs = cs;
-    tf->ss = ds;
 
-    /* Map out the stack */
+    if (ISSET(flags, PROC_KERN)) {
+        if ((td->kstack = kstack_alloc()) == 0) {
+            return -ENOMEM;
+        }
+
+        /* As if called, returning lands in kthread_exit() */
+        tf->cs = GDT_KERNCODE;
+        tf->ss = GDT_KERNDATA;
+        tf->rsp = td->kstack - 8;
+        *(uintptr_t *)tf->rsp = (uintptr_t)kthread_exit;
+
+        /* TLS block ends in a self pointer [variant II] */
+        if (td->tls != NULL) {
+            tcb = PTR_OFFSET(td->tls, KTHREAD_TLS_SIZE - sizeof(*tcb));
+            *tcb = (uintptr_t)tcb;
+            td->pcb.fsbase = (uintptr_t)tcb;
+        }
+
+        return 0;
+    }
+
+    /* XXX: Only the main thread has a user stack for now */
+    if (proc->nthreads != 0) {
+        return -ENOTSUP;
+    }
+
+    stack_base = vm_phys_alloc(1);
+    if (stack_base == 0) {
+        return -ENOMEM;
+    }
+
     error = mu_pmap_map(
-        &pcb->vas,
+        &proc->vas,
         stack_base,
-        STACK_TOP,
-        PROT_READ | PROT_WRITE,
+        ALIGN_DOWN(STACK_TOP, PAGESIZE),
+        PROT_READ | PROT_WRITE | PROT_USER,
         PAGESIZE_4K
     );
 
     if (error < 0) {
         vm_phys_free(stack_base, 1);
-        vm_phys_free(pcb->vas.cr3, 1);
         return error;
     }
 
-    tf->rsp = ALIGN_DOWN(STACK_TOP + (PAGESIZE - 1), 16);
-    if (ISSET(flags, PROC_KERN)) {
-        tf->rsp += KERN_BASE;
-    }
+    tf->cs = GDT_USERCODE | 3;
+    tf->ss = GDT_USERDATA | 3;
+    tf->rsp = ALIGN_DOWN(STACK_TOP, 16);
     return 0;
 }
+
+void
+mu_thread_free(struct thread *td)
+{
+    if (td->kstack != 0) {
+        kstack_free(td->kstack);
+        td->kstack = 0;
+    }
+}
+
+__dead void
+mu_thread_exit(struct thread *td)
+{
+    struct cpu_info *ci;
+
+    /*
+     * Leave for the per processor stack before the thread
+     * can be reaped, the next tick picks up new work.
+     */
+    mu_irq_disable();
+    ci = cpu_self();
+    ci->curthread = NULL;
+    __asmv(
+        "mov %0, %%rsp\n\t"
+        "call thread_exit_enter"
+        :
+        : "r" (ci->kstack), "D" (ci), "S" (td)
+        : "memory"
+    );
+
+    __builtin_unreachable();
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <sys/errno.h>
+#include <kern/syscall.h>
+#include <mu/syscall.h>
+#include <mu/process.h>
+#include <md/frame.h>
+#include <md/cpu.h>
+
+/* Length of the SYSCALL instruction */
+#define SYSCALL_INSN_LEN 2
+
+int
+mu_syscall(struct trapframe *tf)
+{
+    struct syscall_args args;
+    uint64_t code, start;
+
+    start = rdtsc();
+    code = tf->rax;
+    args.arg[0] = tf->rdi;
+    args.arg[1] = tf->rsi;
+    args.arg[2] = tf->rdx;
+    args.arg[3] = tf->r10;
+    args.arg[4] = tf->r8;
+    args.arg[5] = tf->r9;
+
+    /*
+     * Nothing touches the return address so SYSRET always
+     * goes back to a canonical user RIP.
+     */
+    tf->rax = syscall_dispatch(code, &args);
+    syscall_account(code, rdtsc() - start);
+
+    /*
+     * The caller went to sleep waiting for something, run
+     * the same call again once it is woken. The argument
+     * registers are still intact in the frame.
+     */
+    if ((int64_t)tf->rax == -ERESTART) {
+        tf->rax = code;
+        tf->rip -= SYSCALL_INSN_LEN;
+    }
+
+    /* Switch out the caller if it went to sleep */
+    return mu_thread_block(tf);
+}
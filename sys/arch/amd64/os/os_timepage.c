@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <kern/panic.h>
+#include <kern/spinlock.h>
+#include <mu/mmu.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+#include <md/cpu.h>
+#include <md/tsc.h>
+#include <md/timepage.h>
+
+static struct timepage *timepage = NULL;
+static uintptr_t timepage_pa = 0;
+static struct spinlock timepage_lock;
+
+/*
+ * Nanoseconds elapsed over a span of TSC ticks
+ */
+static inline uint64_t
+timepage_nsec(uint64_t ticks)
+{
+    return ((unsigned __int128)ticks * timepage->mult) >> timepage->shift;
+}
+
+/*
+ * Begin and end an update of the time page, readers
+ * retry while the sequence count is odd or changed.
+ *
+ * XXX: The time page lock must be held
+ */
+static inline void
+timepage_wbegin(void)
+{
+    ++timepage->seq;
+    __asmv("" ::: "memory");
+}
+
+static inline void
+timepage_wend(void)
+{
+    __asmv("" ::: "memory");
+    ++timepage->seq;
+}
+
+void
+timepage_init(void)
+{
+    uint64_t freq, tsc;
+
+    if (timepage != NULL) {
+        return;
+    }
+
+    timepage_pa = vm_phys_alloc(1);
+    if (timepage_pa == 0) {
+        panic("timepage: could not allocate time page\n");
+    }
+
+    spinlock_init("timepage", &timepage_lock);
+    timepage = PHYS_TO_VIRT(timepage_pa);
+    memset(timepage, 0, PAGESIZE);
+    if ((freq = tsc_freq()) == 0) {
+        return;
+    }
+
+    /*
+     * A TSC that drifts with P-states cannot be read from
+     * userland, leave the page invalid so clock reads fall
+     * back to the system call.
+     */
+    if (!tsc_invariant()) {
+        return;
+    }
+
+    /* Monotonic time counts from processor reset */
+    tsc = rdtsc();
+    timepage->tsc_freq = freq;
+    timepage->shift = TIMEPAGE_SHIFT;
+    timepage->mult = (NSEC_PER_SEC << TIMEPAGE_SHIFT) / freq;
+    timepage->tsc_base = tsc;
+    timepage->mono_base = timepage_nsec(tsc);
+    timepage->flags = TIMEPAGE_TSC;
+}
+
+int
+timepage_map(struct mmu_vas *vas)
+{
+    if (vas == NULL) {
+        return -EINVAL;
+    }
+
+    if (timepage_pa == 0) {
+        return -ENODEV;
+    }
+
+    return mu_pmap_map(
+        vas,
+        timepage_pa,
+        TIMEPAGE_VA,
+        PROT_READ | PROT_USER,
+        PAGESIZE_4K
+    );
+}
+
+void
+timepage_settime(uint64_t realtime)
+{
+    uint64_t tsc, mono;
+
+    if (timepage == NULL || !ISSET(timepage->flags, TIMEPAGE_TSC)) {
+        return;
+    }
+
+    spinlock_acquire(&timepage_lock, true);
+    tsc = rdtsc();
+    mono = timepage->mono_base + timepage_nsec(tsc - timepage->tsc_base);
+
+    /* Rebase at the current TSC value */
+    timepage_wbegin();
+    timepage->tsc_base = tsc;
+    timepage->mono_base = mono;
+    timepage->wall_off = (int64_t)(realtime - mono);
+    timepage_wend();
+    spinlock_release(&timepage_lock, true);
+}
+
+const struct timepage *
+timepage_get(void)
+{
+    return timepage;
+}
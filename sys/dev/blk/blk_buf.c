@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/atomic.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <kern/ioring.h>
+#include <dev/blk/blkdev.h>
+#include <dev/blk/buf.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+#define BUF_HASHSIZE 64
+#define BUF_HASH(BDP, BLKNO) \
+    ((((uintptr_t)(BDP) >> 4) ^ (BLKNO)) & (BUF_HASHSIZE - 1))
+
+static struct buf bufs[NBUF];
+static struct spinlock bcache_lock;
+static LIST_HEAD(, buf) bcache_hash[BUF_HASHSIZE];
+static TAILQ_HEAD(, buf) bcache_lru;
+
+/*
+ * Take the busy lock of a buffer
+ */
+static void
+buf_lock(struct buf *bp)
+{
+    volatile unsigned int *flagp = (volatile unsigned int *)&bp->flags;
+    unsigned int old;
+
+    for (;;) {
+        old = *flagp;
+        if (ISSET(old, B_BUSY)) {
+            cpu_pause();
+            continue;
+        }
+
+        if (atomic_cas_int(flagp, old, old | B_BUSY) == old) {
+            break;
+        }
+    }
+}
+
+/*
+ * Drop the busy lock of a buffer
+ */
+static void
+buf_unlock(struct buf *bp)
+{
+    __atomic_and_fetch(&bp->flags, ~B_BUSY, __ATOMIC_RELEASE);
+}
+
+/*
+ * Make sure the buffer data can hold a sector of
+ * its device.
+ */
+static int
+buf_size(struct buf *bp, size_t size)
+{
+    if (bp->data != NULL && bp->size == size) {
+        return 0;
+    }
+
+    if (bp->data != NULL) {
+        kfree(bp->data);
+    }
+
+    if ((bp->data = kalloc(size)) == NULL) {
+        bp->size = 0;
+        return -ENOMEM;
+    }
+
+    bp->size = size;
+    return 0;
+}
+
+/*
+ * Get the buffer of a sector, a cached buffer is used if
+ * there is one, otherwise the least recently used free
+ * buffer is recycled. The buffer is returned locked.
+ */
+static int
+getblk(struct blkdev *bdp, uint64_t blkno, struct buf **bp_res)
+{
+    struct buf *bp;
+    uint32_t slot = BUF_HASH(bdp, blkno);
+    int error;
+
+    spinlock_acquire(&bcache_lock, true);
+    LIST_FOREACH(bp, &bcache_hash[slot], hashq) {
+        if (bp->bdp != bdp || bp->blkno != blkno) {
+            continue;
+        }
+
+        if (bp->ref++ == 0) {
+            TAILQ_REMOVE(&bcache_lru, bp, lruq);
+        }
+
+        spinlock_release(&bcache_lock, true);
+        buf_lock(bp);
+
+        /* A previous sizing may have failed and left no data */
+        if ((error = buf_size(bp, bdp->sector_size)) < 0) {
+            brelse(bp);
+            return error;
+        }
+
+        *bp_res = bp;
+        return 0;
+    }
+
+    /* Miss, recycle the oldest free buffer */
+    if ((bp = TAILQ_FIRST(&bcache_lru)) == NULL) {
+        spinlock_release(&bcache_lock, true);
+        return -ENOBUFS;
+    }
+
+    TAILQ_REMOVE(&bcache_lru, bp, lruq);
+    if (bp->bdp != NULL) {
+        LIST_REMOVE(bp, hashq);
+    }
+
+    bp->bdp = bdp;
+    bp->blkno = blkno;
+    bp->flags = B_BUSY;
+    bp->ref = 1;
+    LIST_INSERT_HEAD(&bcache_hash[slot], bp, hashq);
+    spinlock_release(&bcache_lock, true);
+
+    if ((error = buf_size(bp, bdp->sector_size)) < 0) {
+        brelse(bp);
+        return error;
+    }
+
+    *bp_res = bp;
+    return 0;
+}
+
+static void
+buf_iodone(struct io_req *req)
+{
+    struct buf *bp = req->arg;
+
+    if (req->status < 0) {
+        bp->flags |= B_ERROR;
+    } else {
+        bp->flags = (bp->flags & ~B_ERROR) | B_VALID;
+    }
+
+    __atomic_store_n(&bp->iodone, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Prepare the request of a buffer for I/O
+ */
+static void
+buf_setup_io(struct buf *bp, io_op_t op)
+{
+    struct io_req *req = &bp->req;
+
+    req->op = op;
+    req->vp = bp->bdp->vp;
+    req->buf = bp->data;
+    req->len = bp->size;
+    req->offset = bp->blkno * bp->size;
+    req->status = 0;
+    req->done = buf_iodone;
+    req->arg = bp;
+    req->ring = NULL;
+    bp->iodone = 0;
+}
+
+/*
+ * Wait for the outstanding I/O of a buffer, reaping
+ * completions ourselves in case interrupts are off.
+ */
+static int
+buf_wait(struct buf *bp)
+{
+    while (!__atomic_load_n(&bp->iodone, __ATOMIC_ACQUIRE)) {
+        blkdev_poll(bp->bdp);
+        cpu_pause();
+    }
+
+    return (bp->req.status < 0) ? bp->req.status : 0;
+}
+
+int
+breadn(struct blkdev *bdp, uint64_t blkno, size_t count, struct buf **bps)
+{
+    struct io_reqq reqq;
+    size_t i, nread = 0;
+    int error, status = 0;
+
+    if (bdp == NULL || bps == NULL) {
+        return -EINVAL;
+    }
+
+    if (count == 0 || count > BIO_CLUSTER) {
+        return -EINVAL;
+    }
+
+    if (blkno + count > bdp->nsectors) {
+        return -ENXIO;
+    }
+
+    TAILQ_INIT(&reqq);
+    for (i = 0; i < count; ++i) {
+        if ((error = getblk(bdp, blkno + i, &bps[i])) < 0) {
+            while (i-- > 0) {
+                brelse(bps[i]);
+            }
+            return error;
+        }
+
+        if (ISSET(bps[i]->flags, B_VALID)) {
+            continue;
+        }
+
+        buf_setup_io(bps[i], IO_OP_READ);
+        TAILQ_INSERT_TAIL(&reqq, &bps[i]->req, link);
+        ++nread;
+    }
+
+    /*
+     * Misses are submitted together so that the block
+     * layer can coalesce them into one device request.
+     */
+    if (nread > 0 && (error = blkdev_submit(bdp, &reqq)) < 0) {
+        for (i = 0; i < count; ++i) {
+            brelse(bps[i]);
+        }
+        return error;
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (ISSET(bps[i]->flags, B_VALID)) {
+            continue;
+        }
+        if ((error = buf_wait(bps[i])) < 0) {
+            status = error;
+        }
+    }
+
+    if (status < 0) {
+        for (i = 0; i < count; ++i) {
+            brelse(bps[i]);
+        }
+    }
+
+    return status;
+}
+
+int
+bread(struct blkdev *bdp, uint64_t blkno, struct buf **bp_res)
+{
+    return breadn(bdp, blkno, 1, bp_res);
+}
+
+int
+bwrite(struct buf *bp)
+{
+    struct io_reqq reqq;
+    int error;
+
+    if (bp == NULL) {
+        return -EINVAL;
+    }
+
+    TAILQ_INIT(&reqq);
+    buf_setup_io(bp, IO_OP_WRITE);
+    TAILQ_INSERT_TAIL(&reqq, &bp->req, link);
+    if ((error = blkdev_submit(bp->bdp, &reqq)) < 0) {
+        return error;
+    }
+
+    return buf_wait(bp);
+}
+
+void
+brelse(struct buf *bp)
+{
+    if (bp == NULL) {
+        return;
+    }
+
+    /* Don't keep data around that we failed to read */
+    if (ISSET(bp->flags, B_ERROR)) {
+        bp->flags &= ~(B_VALID | B_ERROR);
+    }
+
+    buf_unlock(bp);
+    spinlock_acquire(&bcache_lock, true);
+    if (--bp->ref == 0) {
+        TAILQ_INSERT_TAIL(&bcache_lru, bp, lruq);
+    }
+    spinlock_release(&bcache_lock, true);
+}
+
+ssize_t
+bio_read(struct blkdev *bdp, void *buf, size_t len, off_t off)
+{
+    struct buf *bps[BIO_CLUSTER];
+    uint8_t *p = buf;
+    uint32_t ssize;
+    uint64_t blkno, devsize;
+    size_t done = 0, skip, count, copy;
+    int error;
+
+    if (bdp == NULL || buf == NULL) {
+        return -EINVAL;
+    }
+
+    ssize = bdp->sector_size;
+    devsize = bdp->nsectors * ssize;
+    if ((uint64_t)off >= devsize) {
+        return 0;
+    }
+
+    len = MIN(len, devsize - off);
+    while (done < len) {
+        blkno = (off + done) / ssize;
+        skip = (off + done) & (ssize - 1);
+        count = ALIGN_UP(skip + (len - done), ssize) / ssize;
+        count = MIN(count, BIO_CLUSTER);
+
+        if ((error = breadn(bdp, blkno, count, bps)) < 0) {
+            return (done > 0) ? (ssize_t)done : error;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            copy = MIN(ssize - skip, len - done);
+            memcpy(&p[done], (uint8_t *)bps[i]->data + skip, copy);
+            done += copy;
+            skip = 0;
+            brelse(bps[i]);
+        }
+    }
+
+    return done;
+}
+
+ssize_t
+bio_write(struct blkdev *bdp, const void *buf, size_t len, off_t off)
+{
+    const uint8_t *p = buf;
+    struct buf *bp;
+    uint32_t ssize;
+    uint64_t blkno, devsize;
+    size_t done = 0, skip, copy;
+    int error;
+
+    if (bdp == NULL || buf == NULL) {
+        return -EINVAL;
+    }
+
+    ssize = bdp->sector_size;
+    devsize = bdp->nsectors * ssize;
+    if ((uint64_t)off >= devsize) {
+        return -ENOSPC;
+    }
+
+    len = MIN(len, devsize - off);
+    while (done < len) {
+        blkno = (off + done) / ssize;
+        skip = (off + done) & (ssize - 1);
+        copy = MIN(ssize - skip, len - done);
+
+        /* Partial sectors need the old contents first */
+        if (copy < ssize) {
+            error = bread(bdp, blkno, &bp);
+        } else {
+            error = getblk(bdp, blkno, &bp);
+        }
+
+        if (error < 0) {
+            return (done > 0) ? (ssize_t)done : error;
+        }
+
+        memcpy((uint8_t *)bp->data + skip, &p[done], copy);
+        error = bwrite(bp);
+        brelse(bp);
+        if (error < 0) {
+            return (done > 0) ? (ssize_t)done : error;
+        }
+
+        done += copy;
+    }
+
+    return done;
+}
+
+void
+buf_init(void)
+{
+    struct buf *bp;
+
+    if (spinlock_init("bcache", &bcache_lock) != 0) {
+        panic("bcache: failed to initialize lock\n");
+    }
+
+    TAILQ_INIT(&bcache_lru);
+    for (int i = 0; i < BUF_HASHSIZE; ++i) {
+        LIST_INIT(&bcache_hash[i]);
+    }
+
+    for (int i = 0; i < NBUF; ++i) {
+        bp = &bufs[i];
+        memset(bp, 0, sizeof(*bp));
+        TAILQ_INSERT_TAIL(&bcache_lru, bp, lruq);
+    }
+}
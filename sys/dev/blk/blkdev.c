@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <kern/ioring.h>
+#include <kern/vnode.h>
+#include <dev/blk/blkdev.h>
+#include <dev/blk/buf.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/stdbool.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("blk: " fmt, ##__VA_ARGS__)
+
+static struct spinlock blkdev_lock;
+static TAILQ_HEAD(, blkdev) blkdev_list;
+
+/*
+ * Get a free block request from a queue
+ *
+ * XXX: Queue must be locked
+ */
+static struct blk_req *
+blkq_alloc(struct blk_queue *q)
+{
+    struct blk_req *breq;
+
+    breq = TAILQ_FIRST(&q->freeq);
+    if (breq != NULL) {
+        TAILQ_REMOVE(&q->freeq, breq, link);
+        breq->dynamic = 0;
+        return breq;
+    }
+
+    /* Pool ran dry, fall back to the heap */
+    if ((breq = kalloc(sizeof(*breq))) != NULL) {
+        breq->dynamic = 1;
+    }
+    return breq;
+}
+
+/*
+ * Return a block request to its queue
+ *
+ * XXX: Queue must be locked
+ */
+static void
+blkq_free(struct blk_queue *q, struct blk_req *breq)
+{
+    if (breq->dynamic) {
+        kfree(breq);
+        return;
+    }
+
+    TAILQ_INSERT_HEAD(&q->freeq, breq, link);
+}
+
+/*
+ * Append an io_req to the end of a block request
+ */
+static void
+blk_req_append(struct blk_req *breq, struct io_req *req, size_t nsect)
+{
+    breq->seg[breq->nseg].buf = req->buf;
+    breq->seg[breq->nseg].len = req->len;
+    breq->nsect += nsect;
+    ++breq->nseg;
+    TAILQ_INSERT_TAIL(&breq->reqs, req, link);
+}
+
+/*
+ * Prepend an io_req to the start of a block request
+ */
+static void
+blk_req_prepend(struct blk_req *breq, struct io_req *req, size_t nsect)
+{
+    for (uint16_t i = breq->nseg; i > 0; --i) {
+        breq->seg[i] = breq->seg[i - 1];
+    }
+
+    breq->seg[0].buf = req->buf;
+    breq->seg[0].len = req->len;
+    breq->blkno -= nsect;
+    breq->nsect += nsect;
+    ++breq->nseg;
+    TAILQ_INSERT_TAIL(&breq->reqs, req, link);
+}
+
+/*
+ * Returns true if a block request touches any sector
+ * in [blkno, blkno + nsect)
+ */
+static inline bool
+blk_req_overlaps(struct blk_req *breq, uint64_t blkno, size_t nsect)
+{
+    return breq->blkno < blkno + nsect &&
+        blkno < breq->blkno + breq->nsect;
+}
+
+/*
+ * Try to merge an io_req into a pending request that it is
+ * adjacent to, returns true if merged. Pending requests are
+ * scanned from the newest one back and flushes act as a
+ * barrier that nothing is merged across.
+ *
+ * XXX: Queue must be locked
+ */
+static bool
+blkq_merge(struct blk_queue *q, struct io_req *req, uint64_t blkno, size_t nsect)
+{
+    uint32_t max_sectors = q->bdp->max_sectors;
+    struct blk_req *breq;
+
+    TAILQ_FOREACH_REVERSE(breq, &q->pending, blk_reqq, link) {
+        if (breq->op == IO_OP_FLUSH) {
+            return false;
+        }
+
+        /* Merging would move us ahead of this request */
+        if (blk_req_overlaps(breq, blkno, nsect)) {
+            return false;
+        }
+
+        if (breq->op != req->op || breq->nseg >= BLK_MAXSEG) {
+            continue;
+        }
+
+        /* Stay within what the driver can issue at once */
+        if (max_sectors != 0 && breq->nsect + nsect > max_sectors) {
+            continue;
+        }
+
+        if (breq->blkno + breq->nsect == blkno) {
+            blk_req_append(breq, req, nsect);
+            ++q->nmerge;
+            return true;
+        }
+
+        if (blkno + nsect == breq->blkno) {
+            blk_req_prepend(breq, req, nsect);
+            ++q->nmerge;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Insert a block request into the pending list in sector
+ * order so that the device sees an ascending sweep, though
+ * never in front of a flush or of a request touching the
+ * same sectors.
+ *
+ * XXX: Queue must be locked
+ */
+static void
+blkq_insert(struct blk_queue *q, struct blk_req *breq)
+{
+    struct blk_req *iter;
+
+    if (breq->op == IO_OP_FLUSH) {
+        TAILQ_INSERT_TAIL(&q->pending, breq, link);
+        return;
+    }
+
+    TAILQ_FOREACH_REVERSE(iter, &q->pending, blk_reqq, link) {
+        if (iter->op == IO_OP_FLUSH || iter->blkno <= breq->blkno) {
+            TAILQ_INSERT_AFTER(&q->pending, iter, breq, link);
+            return;
+        }
+
+        /* Never reorder requests that touch the same sectors */
+        if (blk_req_overlaps(iter, breq->blkno, breq->nsect)) {
+            TAILQ_INSERT_AFTER(&q->pending, iter, breq, link);
+            return;
+        }
+    }
+
+    TAILQ_INSERT_HEAD(&q->pending, breq, link);
+}
+
+/*
+ * Move as many pending requests as the queue depth allows
+ * onto a dispatch list.
+ *
+ * XXX: Queue must be locked
+ */
+static void
+blkq_pull(struct blk_queue *q, struct blk_reqq *dispatch)
+{
+    struct blkdev *bdp = q->bdp;
+    struct blk_req *breq;
+
+    while (q->inflight < bdp->qdepth) {
+        if ((breq = TAILQ_FIRST(&q->pending)) == NULL) {
+            break;
+        }
+
+        TAILQ_REMOVE(&q->pending, breq, link);
+        TAILQ_INSERT_TAIL(dispatch, breq, link);
+        ++q->inflight;
+        ++q->ndispatch;
+    }
+}
+
+/*
+ * Hand a list of pulled requests to the driver, then let
+ * it commit the whole batch to the hardware at once.
+ */
+static void
+blkq_dispatch(struct blk_queue *q, struct blk_reqq *dispatch)
+{
+    struct blkdev *bdp = q->bdp;
+    struct blk_req *breq;
+    size_t nstarted = 0;
+    int error;
+
+    while ((breq = TAILQ_FIRST(dispatch)) != NULL) {
+        TAILQ_REMOVE(dispatch, breq, link);
+        error = bdp->ops->strategy(bdp, breq);
+        if (error < 0) {
+            blkdev_done(breq, error);
+            continue;
+        }
+
+        ++nstarted;
+    }
+
+    if (nstarted > 0 && bdp->ops->commit != NULL) {
+        bdp->ops->commit(bdp, q);
+    }
+}
+
+/*
+ * Pull and dispatch requests until the queue is full or
+ * drained, then unlock it. Only one caller runs a queue
+ * at a time and the others leave their pull to it, so a
+ * driver that completes from its strategy routine loops
+ * here instead of recursing once per request.
+ *
+ * XXX: Queue must be locked
+ */
+static void
+blkq_run(struct blk_queue *q, bool irq)
+{
+    struct blk_reqq dispatch;
+
+    if (q->running) {
+        q->rerun = 1;
+        spinlock_release_irq(&q->lock, irq);
+        return;
+    }
+
+    TAILQ_INIT(&dispatch);
+    q->running = 1;
+    do {
+        q->rerun = 0;
+        blkq_pull(q, &dispatch);
+        spinlock_release_irq(&q->lock, irq);
+        blkq_dispatch(q, &dispatch);
+        irq = spinlock_acquire_irq(&q->lock);
+    } while (q->rerun);
+
+    q->running = 0;
+    spinlock_release_irq(&q->lock, irq);
+}
+
+/*
+ * Get the sector range of an io_req, returns a negative
+ * value if it cannot be issued to the device.
+ */
+static int
+blk_req_range(struct blkdev *bdp, struct io_req *req, uint64_t *blkno,
+    size_t *nsect)
+{
+    uint32_t ssize = bdp->sector_size;
+
+    if (req->op == IO_OP_FLUSH) {
+        *blkno = 0;
+        *nsect = 0;
+        return 0;
+    }
+
+    if (req->buf == NULL || req->len == 0) {
+        return -EINVAL;
+    }
+
+    if ((req->offset & (ssize - 1)) != 0 || (req->len & (ssize - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    *blkno = req->offset / ssize;
+    *nsect = req->len / ssize;
+    if (*blkno + *nsect > bdp->nsectors) {
+        return -ENXIO;
+    }
+
+    return 0;
+}
+
+int
+blkdev_submit(struct blkdev *bdp, struct io_reqq *reqq)
+{
+    struct blk_queue *q;
+    struct blk_req *breq;
+    struct io_reqq failq;
+    struct io_req *req;
+    uint64_t blkno;
+    size_t nsect;
+    bool irq;
+    int error;
+
+    if (bdp == NULL || reqq == NULL) {
+        return -EINVAL;
+    }
+
+    TAILQ_INIT(&failq);
+    q = &bdp->queues[cpu_self()->id % bdp->nqueues];
+
+    /*
+     * Plug the queue while the whole batch goes in so that
+     * adjacent requests get a chance to be merged.
+     */
+    irq = spinlock_acquire_irq(&q->lock);
+    while ((req = TAILQ_FIRST(reqq)) != NULL) {
+        TAILQ_REMOVE(reqq, req, link);
+        error = blk_req_range(bdp, req, &blkno, &nsect);
+        if (error < 0) {
+            req->status = error;
+            TAILQ_INSERT_TAIL(&failq, req, link);
+            continue;
+        }
+
+        if (req->op != IO_OP_FLUSH && blkq_merge(q, req, blkno, nsect)) {
+            continue;
+        }
+
+        if ((breq = blkq_alloc(q)) == NULL) {
+            req->status = -ENOMEM;
+            TAILQ_INSERT_TAIL(&failq, req, link);
+            continue;
+        }
+
+        breq->op = req->op;
+        breq->blkno = blkno;
+        breq->nsect = 0;
+        breq->nseg = 0;
+        breq->queue = q;
+        breq->data = NULL;
+        TAILQ_INIT(&breq->reqs);
+        if (req->op == IO_OP_FLUSH) {
+            TAILQ_INSERT_TAIL(&breq->reqs, req, link);
+        } else {
+            blk_req_append(breq, req, nsect);
+        }
+        blkq_insert(q, breq);
+    }
+
+    /* Unplug */
+    blkq_run(q, irq);
+
+    while ((req = TAILQ_FIRST(&failq)) != NULL) {
+        TAILQ_REMOVE(&failq, req, link);
+        ioring_complete(req, req->status);
+    }
+
+    return 0;
+}
+
+void
+blkdev_done(struct blk_req *breq, int status)
+{
+    struct blk_queue *q;
+    struct io_req *req;
+    bool irq;
+
+    if (breq == NULL) {
+        return;
+    }
+
+    while ((req = TAILQ_FIRST(&breq->reqs)) != NULL) {
+        TAILQ_REMOVE(&breq->reqs, req, link);
+        ioring_complete(req, (status < 0) ? status : (ssize_t)req->len);
+    }
+
+    /* Free the slot up and refill the device */
+    q = breq->queue;
+    irq = spinlock_acquire_irq(&q->lock);
+    --q->inflight;
+    blkq_free(q, breq);
+    blkq_run(q, irq);
+}
+
+void
+blkdev_poll(struct blkdev *bdp)
+{
+    if (bdp == NULL || bdp->ops->poll == NULL) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < bdp->nqueues; ++i) {
+        bdp->ops->poll(bdp, &bdp->queues[i]);
+    }
+}
+
+static ssize_t
+blkdev_vop_read(struct vop_buf_args *args)
+{
+    struct blkdev *bdp = args->vp->data;
+
+    return bio_read(bdp, args->buffer, args->len, args->offset);
+}
+
+static ssize_t
+blkdev_vop_write(struct vop_buf_args *args)
+{
+    struct blkdev *bdp = args->vp->data;
+
+    return bio_write(bdp, args->buffer, args->len, args->offset);
+}
+
+static int
+blkdev_vop_submit(struct vop_submit_args *args)
+{
+    struct blkdev *bdp = args->vp->data;
+
+    return blkdev_submit(bdp, args->reqq);
+}
+
+/*
+ * Release the queues of a block device
+ */
+static void
+blkdev_free_queues(struct blkdev *bdp)
+{
+    for (uint16_t i = 0; i < bdp->nqueues; ++i) {
+        if (bdp->queues[i].pool != NULL) {
+            kfree(bdp->queues[i].pool);
+        }
+    }
+
+    kfree(bdp->queues);
+    bdp->queues = NULL;
+}
+
+/*
+ * Initialize the queues of a block device
+ */
+static int
+blkdev_init_queues(struct blkdev *bdp)
+{
+    struct blk_queue *q;
+    struct blk_req *pool;
+    int error;
+
+    bdp->queues = kalloc(sizeof(*q) * bdp->nqueues);
+    if (bdp->queues == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(bdp->queues, 0, sizeof(*q) * bdp->nqueues);
+    for (uint16_t i = 0; i < bdp->nqueues; ++i) {
+        q = &bdp->queues[i];
+        if ((error = spinlock_init("blkq", &q->lock)) < 0) {
+            blkdev_free_queues(bdp);
+            return error;
+        }
+
+        q->bdp = bdp;
+        q->id = i;
+        TAILQ_INIT(&q->pending);
+        TAILQ_INIT(&q->freeq);
+
+        pool = kalloc(sizeof(*pool) * BLK_QPOOL);
+        if (pool == NULL) {
+            blkdev_free_queues(bdp);
+            return -ENOMEM;
+        }
+
+        q->pool = pool;
+        for (uint16_t j = 0; j < BLK_QPOOL; ++j) {
+            TAILQ_INSERT_TAIL(&q->freeq, &pool[j], link);
+        }
+    }
+
+    return 0;
+}
+
+int
+blkdev_register(struct blkdev *bdp)
+{
+    struct vnode *vp;
+    uint32_t ssize;
+    int error;
+
+    if (bdp == NULL || bdp->ops == NULL) {
+        return -EINVAL;
+    }
+
+    if (bdp->ops->strategy == NULL) {
+        return -EINVAL;
+    }
+
+    /* Sector size must be a sane power of two */
+    ssize = bdp->sector_size;
+    if (ssize < 512 || (ssize & (ssize - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    if (bdp->nqueues == 0 || bdp->qdepth == 0) {
+        return -EINVAL;
+    }
+
+    if ((error = blkdev_init_queues(bdp)) < 0) {
+        return error;
+    }
+
+    if ((error = vnode_init(&vp, VBLK)) < 0) {
+        blkdev_free_queues(bdp);
+        return error;
+    }
+
+    vp->data = bdp;
+    vp->vops.read = blkdev_vop_read;
+    vp->vops.write = blkdev_vop_write;
+    vp->vops.submit = blkdev_vop_submit;
+    bdp->vp = vp;
+
+    spinlock_acquire(&blkdev_lock, true);
+    TAILQ_INSERT_TAIL(&blkdev_list, bdp, link);
+    spinlock_release(&blkdev_lock, true);
+
+    dtrace(
+        "%s: %d sectors, %d bytes/sector, %d queue(s)\n",
+        bdp->name, bdp->nsectors, ssize, bdp->nqueues
+    );
+    return 0;
+}
+
+int
+blkdev_lookup(const char *name, struct blkdev **res)
+{
+    struct blkdev *iter, *bdp = NULL;
+
+    if (name == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    spinlock_acquire(&blkdev_lock, true);
+    TAILQ_FOREACH(iter, &blkdev_list, link) {
+        if (strcmp(iter->name, name) == 0) {
+            bdp = iter;
+            break;
+        }
+    }
+    spinlock_release(&blkdev_lock, true);
+
+    if (bdp == NULL) {
+        return -ENOENT;
+    }
+
+    *res = bdp;
+    return 0;
+}
+
+void
+blkdev_init(void)
+{
+    if (spinlock_init("blkdev", &blkdev_lock) != 0) {
+        panic("blk: failed to initialize device list\n");
+    }
+
+    TAILQ_INIT(&blkdev_list);
+    buf_init();
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/blk/blkdev.h>
+#include <dev/blk/ramdisk.h>
+#include <os/trace.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("ramdisk: " fmt, ##__VA_ARGS__)
+
+static int
+ramdisk_strategy(struct blkdev *bdp, struct blk_req *breq)
+{
+    uint8_t *p;
+    struct blk_seg *seg;
+
+    if (breq->op == IO_OP_FLUSH) {
+        blkdev_done(breq, 0);
+        return 0;
+    }
+
+    p = (uint8_t *)bdp->data + (breq->blkno * bdp->sector_size);
+    for (uint16_t i = 0; i < breq->nseg; ++i) {
+        seg = &breq->seg[i];
+        if (breq->op == IO_OP_READ) {
+            memcpy(seg->buf, p, seg->len);
+        } else {
+            memcpy(p, seg->buf, seg->len);
+        }
+        p += seg->len;
+    }
+
+    blkdev_done(breq, 0);
+    return 0;
+}
+
+static struct blkdev_ops ramdisk_ops = {
+    .strategy = ramdisk_strategy
+};
+
+int
+ramdisk_create(const char *name, size_t size, struct blkdev **bdp_res)
+{
+    struct blkdev *bdp;
+    uintptr_t phys;
+    size_t npages;
+    int error;
+
+    if (name == NULL || size == 0) {
+        return -EINVAL;
+    }
+
+    if ((bdp = kalloc(sizeof(*bdp))) == NULL) {
+        return -ENOMEM;
+    }
+
+    size = ALIGN_UP(size, PAGESIZE);
+    npages = size / PAGESIZE;
+    if ((phys = vm_phys_alloc(npages)) == 0) {
+        kfree(bdp);
+        return -ENOMEM;
+    }
+
+    memset(bdp, 0, sizeof(*bdp));
+    memcpy(bdp->name, name, MIN(strlen(name), BLK_NAMELEN - 1));
+    bdp->sector_size = RAMDISK_SECTSIZE;
+    bdp->nsectors = size / RAMDISK_SECTSIZE;
+    bdp->ops = &ramdisk_ops;
+    bdp->nqueues = 1;
+    bdp->qdepth = 32;
+    bdp->data = PHYS_TO_VIRT(phys);
+    memset(bdp->data, 0, size);
+
+    if ((error = blkdev_register(bdp)) < 0) {
+        vm_phys_free(phys, npages);
+        kfree(bdp);
+        return error;
+    }
+
+    if (bdp_res != NULL) {
+        *bdp_res = bdp;
+    }
+
+    return 0;
+}
+
+int
+ramdisk_init(void)
+{
+    int error;
+
+    error = ramdisk_create("rd0", RAMDISK_DEFSIZE, NULL);
+    if (error < 0) {
+        dtrace("failed to create rd0\n");
+    }
+
+    return error;
+}
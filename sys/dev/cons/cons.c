@@ -33,33 +33,88 @@
 #include <lib/string.h>
 #include <dev/cons/font.h>
 #include <dev/cons/cons.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
 
 #define DEFAULT_FG 0x808080
 #define DEFAULT_BG 0x000000
 
+/* Staging cell used before there is a shadow buffer */
+static uint32_t cons_cell[FONT_WIDTH * FONT_HEIGHT * FONT_MAXSCALE * FONT_MAXSCALE];
+
 /*
- * Render a character to the screen
+ * Copy a rectangle of 0x00RRGGBB pixels to every head
  */
 static void
-cons_blit_ch(struct console *cons, uint32_t x, uint32_t y, char c)
+cons_flush(struct console *cons, size_t x, size_t y, size_t w, size_t h,
+    const uint32_t *src, size_t stride)
 {
     struct vram_dev *vram;
-    size_t idx;
-    uint8_t *glyph;
-    uint32_t fg, bg;
 
-    vram = &cons->vram;
-    glyph = &g_CONS_FONT[(int)c*16];
+    for (size_t i = 0; i < cons->nheads; ++i) {
+        vram = &cons->heads[i];
+        for (size_t cy = 0; cy < h; ++cy) {
+            vram_write_row(vram, x, y + cy, &src[cy * stride], w);
+        }
+    }
+}
 
-    fg = cons->fg;
-    bg = cons->bg;
+/*
+ * Mark rows of the shadow buffer as dirty
+ */
+static inline void
+cons_dirty(struct console *cons, size_t y, size_t h)
+{
+    cons->dirty_lo = MIN(cons->dirty_lo, y);
+    cons->dirty_hi = MAX(cons->dirty_hi, y + h);
+}
 
-    for (uint32_t cy = 0; cy < FONT_HEIGHT; ++cy) {
-        idx = vram_index(vram, x + (FONT_WIDTH - 1), y + cy);
-        for (uint32_t cx = 0; cx < FONT_WIDTH; ++cx) {
-            vram->io[idx--] = ISSET(glyph[cy], BIT(cx)) ? fg : bg;
-        }
+/*
+ * Copy the dirty rows of the shadow out to the heads
+ */
+static void
+cons_sync(struct console *cons)
+{
+    size_t lo, hi;
+
+    lo = cons->dirty_lo;
+    hi = cons->dirty_hi;
+    if (cons->shadow == NULL || lo >= hi) {
+        return;
+    }
+
+    cons_flush(
+        cons, 0, lo,
+        cons->width, hi - lo,
+        &cons->shadow[lo * cons->width],
+        cons->width
+    );
+
+    cons->dirty_lo = cons->height;
+    cons->dirty_hi = 0;
+}
+
+/*
+ * Render a character to the screen
+ */
+static void
+cons_blit_ch(struct console *cons, uint32_t x, uint32_t y, char c)
+{
+    struct font *fp = &cons->font;
+
+    if (cons->shadow == NULL) {
+        font_draw(fp, c, cons->fg, cons->bg, cons_cell, fp->width);
+        cons_flush(cons, x, y, fp->width, fp->height, cons_cell, fp->width);
+        return;
     }
+
+    font_draw(
+        fp, c, cons->fg, cons->bg,
+        &cons->shadow[y * cons->width + x],
+        cons->width
+    );
+
+    cons_dirty(cons, y, fp->height);
 }
 
 /*
@@ -68,14 +123,40 @@ cons_blit_ch(struct console *cons, uint32_t x, uint32_t y, char c)
 static void
 cons_clear(struct console *cons)
 {
-    struct vram_dev *vram;
+    size_t npix;
 
-    vram = &cons->vram;
-    if (vram->io == NULL) {
+    if (cons->shadow == NULL) {
+        for (size_t i = 0; i < cons->nheads; ++i) {
+            vram_fill(&cons->heads[i], 0, 0, cons->width, cons->height, cons->bg);
+        }
         return;
     }
 
-    memset(vram->io, cons->bg, vram->pitch * vram->height);
+    npix = cons->width * cons->height;
+    for (size_t i = 0; i < npix; ++i) {
+        cons->shadow[i] = cons->bg;
+    }
+
+    cons_dirty(cons, 0, cons->height);
+}
+
+/*
+ * Scroll the shadow buffer up by one line of text
+ */
+static void
+cons_scroll(struct console *cons)
+{
+    uint32_t *shadow = cons->shadow;
+    size_t line, npix;
+
+    line = cons->width * cons->font.height;
+    npix = cons->width * cons->ty;
+    memmove(shadow, &shadow[line], npix * sizeof(*shadow));
+    for (size_t i = npix; i < npix + line; ++i) {
+        shadow[i] = cons->bg;
+    }
+
+    cons_dirty(cons, 0, cons->ty + cons->font.height);
 }
 
 /*
@@ -84,13 +165,19 @@ cons_clear(struct console *cons)
 static void
 cons_newline(struct console *cons)
 {
-    struct vram_dev *vram;
+    size_t fh = cons->font.height;
 
-    vram = &cons->vram;
-    cons->ty += FONT_HEIGHT;
+    cons->ty += fh;
     cons->tx = 0;
-    if (cons->ty >= vram->height - FONT_HEIGHT) {
-        cons->tx = 0;
+    if (cons->ty < cons->height - fh) {
+        return;
+    }
+
+    /* Without a shadow we cannot read back to scroll */
+    if (cons->shadow != NULL) {
+        cons->ty -= fh;
+        cons_scroll(cons);
+    } else {
         cons->ty = 0;
         cons_clear(cons);
     }
@@ -109,6 +196,11 @@ cons_special(struct console *cons, char c)
     case '\n':
         cons_newline(cons);
         return c;
+    case '\b':
+        if (cons->tx >= cons->font.width) {
+            cons->tx -= cons->font.width;
+        }
+        return c;
     }
 
     return -1;
@@ -120,16 +212,13 @@ cons_special(struct console *cons, char c)
 static void
 console_putch(struct console *cons, char c)
 {
-    struct vram_dev *vram;
-
     if (cons_special(cons, c) == c) {
         return;
     }
 
-    vram = &cons->vram;
     cons_blit_ch(cons, cons->tx, cons->ty, c);
-    cons->tx += FONT_WIDTH;
-    if (cons->tx >= vram->width - FONT_WIDTH) {
+    cons->tx += cons->font.width;
+    if (cons->tx >= cons->width - cons->font.width) {
         cons_newline(cons);
     }
 }
@@ -137,25 +226,121 @@ console_putch(struct console *cons, char c)
 int
 console_write(struct console *cons, const char *s, size_t len)
 {
+    bool irq;
+
+    if (cons == NULL || cons->nheads == 0) {
+        return -EINVAL;
+    }
+
+    /*
+     * Writers come from every context, tty echo runs from
+     * a softint that may land in the middle of a trace().
+     */
+    irq = spinlock_acquire_irq(&cons->lock);
     for (size_t i = 0; i < len; ++i) {
         console_putch(cons, *s++);
     }
+
+    cons_sync(cons);
+    spinlock_release_irq(&cons->lock, irq);
+    return 0;
+}
+
+int
+console_shadow_init(struct console *cons)
+{
+    struct vram_dev *vram;
+    uintptr_t pa;
+    size_t npgs;
+    bool irq;
+
+    if (cons == NULL || cons->nheads == 0) {
+        return -EINVAL;
+    }
+
+    if (cons->shadow != NULL) {
+        return 0;
+    }
+
+    npgs = cons->width * cons->height * sizeof(*cons->shadow);
+    npgs = ALIGN_UP(npgs, PAGESIZE) / PAGESIZE;
+    if ((pa = vm_phys_alloc(npgs)) == 0) {
+        return -ENOMEM;
+    }
+
+    /*
+     * Read what is on screen back once so text is kept,
+     * only the first head is looked at.
+     */
+    irq = spinlock_acquire_irq(&cons->lock);
+    cons->shadow = PHYS_TO_VIRT(pa);
+    vram = &cons->heads[0];
+    if (!vram->native) {
+        cons->tx = 0;
+        cons->ty = 0;
+        cons_clear(cons);
+        cons_sync(cons);
+        spinlock_release_irq(&cons->lock, irq);
+        return 0;
+    }
+
+    for (size_t y = 0; y < cons->height; ++y) {
+        memcpy(
+            &cons->shadow[y * cons->width],
+            vram_pixel(vram, 0, y),
+            cons->width * sizeof(*cons->shadow)
+        );
+    }
+
+    spinlock_release_irq(&cons->lock, irq);
+    return 0;
 }
 
 int
 console_reset(struct console *cons)
 {
-    int error;
+    struct vram_dev *vram;
+    size_t count, scale;
 
     if (cons == NULL) {
         return -EINVAL;
     }
 
-    /* Try to acquire the VRAM descriptor */
-    if ((error = vram_getdev(&cons->vram)) < 0) {
-        return error;
+    spinlock_init("cons", &cons->lock);
+
+    /* Mirror to every framebuffer we can draw to */
+    cons->nheads = 0;
+    count = vram_count();
+    for (size_t i = 0; i < count && cons->nheads < CONS_MAXHEADS; ++i) {
+        vram = &cons->heads[cons->nheads];
+        if (vram_getdev(i, vram) < 0) {
+            continue;
+        }
+
+        if (cons->nheads == 0) {
+            cons->width = vram->width;
+            cons->height = vram->height;
+        }
+
+        cons->width = MIN(cons->width, vram->width);
+        cons->height = MIN(cons->height, vram->height);
+        ++cons->nheads;
+    }
+
+    if (cons->nheads == 0) {
+        return -ENODEV;
+    }
+
+    /* Scale text up on high resolution panels */
+    scale = CONS_FONT_SCALE;
+    if (scale == 0) {
+        scale = cons->height / (FONT_HEIGHT * CONS_MINROWS);
     }
 
+    font_init(&cons->font, scale);
+    cons->shadow = NULL;
+    cons->dirty_lo = cons->height;
+    cons->dirty_hi = 0;
     cons->fg = DEFAULT_FG;
     cons->bg = DEFAULT_BG;
     cons->tx = 0;
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <dev/cons/font.h>
+#include <lib/string.h>
+
+#define ROW_PIXELS (FONT_WIDTH * FONT_MAXSCALE)
+
+/*
+ * Every possible glyph row byte expanded to one mask
+ * per pixel, set pixels are all ones.
+ */
+static uint32_t font_rows[256][ROW_PIXELS];
+static size_t font_scale = 0;
+
+/*
+ * Expand the row masks for a scale
+ */
+static void
+font_expand(size_t scale)
+{
+    uint32_t *row;
+    uint32_t mask;
+
+    for (size_t byte = 0; byte < 256; ++byte) {
+        row = font_rows[byte];
+        for (size_t cx = 0; cx < FONT_WIDTH; ++cx) {
+            mask = ISSET(byte, BIT(FONT_WIDTH - 1 - cx)) ? 0xFFFFFFFF : 0;
+            for (size_t i = 0; i < scale; ++i) {
+                *row++ = mask;
+            }
+        }
+    }
+
+    font_scale = scale;
+}
+
+void
+font_init(struct font *fp, size_t scale)
+{
+    scale = MAX(scale, 1);
+    scale = MIN(scale, FONT_MAXSCALE);
+    if (font_scale != scale) {
+        font_expand(scale);
+    }
+
+    fp->scale = scale;
+    fp->width = FONT_WIDTH * scale;
+    fp->height = FONT_HEIGHT * scale;
+}
+
+void
+font_draw(struct font *fp, char c, uint32_t fg, uint32_t bg,
+    uint32_t *dst, size_t stride)
+{
+    const uint32_t *mask;
+    uint8_t *glyph;
+    size_t width;
+
+    glyph = &g_CONS_FONT[(uint8_t)c * FONT_HEIGHT];
+    width = fp->width;
+
+    for (size_t cy = 0; cy < FONT_HEIGHT; ++cy) {
+        mask = font_rows[glyph[cy]];
+        for (size_t cx = 0; cx < width; ++cx) {
+            dst[cx] = (fg & mask[cx]) | (bg & ~mask[cx]);
+        }
+
+        /* Scaled rows repeat the one just drawn */
+        for (size_t i = 1; i < fp->scale; ++i) {
+            memcpy(&dst[i * stride], dst, width * sizeof(*dst));
+        }
+
+        dst += stride * fp->scale;
+    }
+}
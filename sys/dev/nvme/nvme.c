@@ -0,0 +1,911 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <kern/spinlock.h>
+#include <dev/blk/blkdev.h>
+#include <dev/nvme/nvme.h>
+#include <dev/nvme/nvmereg.h>
+#include <dev/pci/pci.h>
+#include <dev/pci/pcireg.h>
+#include <dev/clkdev/hpet.h>
+#include <os/trace.h>
+#include <os/intr.h>
+#include <os/mmio.h>
+#include <os/softint.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("nvme: " fmt, ##__VA_ARGS__)
+
+#define NVME_ADMIN_QSIZE    32
+#define NVME_ADMIN_TIMEOUT  1000    /* in ms */
+#define NVME_PRP_PER_PAGE   (PAGESIZE / sizeof(uint64_t))
+#define NVME_PRP_MAX        (NVME_PRP_PER_PAGE * PAGESIZE)
+#define NVME_MAX_NLB        0x10000 /* 16-bit zero-based count */
+
+/* Completions reaped per lock hold */
+#define NVME_REAP_BATCH     16
+
+static uint16_t nvme_unit = 0;
+
+static inline uint32_t
+nvme_read4(struct nvme_ctrl *ctrl, uint32_t reg)
+{
+    return mmio_read32(PTR_OFFSET(ctrl->regs, reg));
+}
+
+static inline uint64_t
+nvme_read8(struct nvme_ctrl *ctrl, uint32_t reg)
+{
+    return mmio_read64(PTR_OFFSET(ctrl->regs, reg));
+}
+
+static inline void
+nvme_write4(struct nvme_ctrl *ctrl, uint32_t reg, uint32_t val)
+{
+    mmio_write32(PTR_OFFSET(ctrl->regs, reg), val);
+}
+
+static inline void
+nvme_write8(struct nvme_ctrl *ctrl, uint32_t reg, uint64_t val)
+{
+    mmio_write64(PTR_OFFSET(ctrl->regs, reg), val);
+}
+
+/*
+ * Wait for CSTS.RDY to match 'ready'
+ */
+static int
+nvme_wait_ready(struct nvme_ctrl *ctrl, bool ready, size_t timeout)
+{
+    uint32_t csts;
+
+    for (size_t i = 0; i <= timeout; ++i) {
+        csts = nvme_read4(ctrl, NVME_REG_CSTS);
+        if (ISSET(csts, NVME_CSTS_CFS)) {
+            return -EIO;
+        }
+
+        if (ISSET(csts, NVME_CSTS_RDY) == ready) {
+            return 0;
+        }
+
+        hpet_msleep(1);
+    }
+
+    return -ETIMEDOUT;
+}
+
+/*
+ * Copy a command into the next SQ entry, the doorbell
+ * is left alone.
+ *
+ * XXX: Queue pair must be locked
+ */
+static void
+nvme_sq_push(struct nvme_qpair *qp, struct nvme_cmd *cmd)
+{
+    memcpy((void *)&qp->sq[qp->sq_tail], cmd, sizeof(*cmd));
+    if (++qp->sq_tail == qp->size) {
+        qp->sq_tail = 0;
+    }
+}
+
+/*
+ * Ring the SQ doorbell if new entries were pushed
+ *
+ * XXX: Queue pair must be locked
+ */
+static void
+nvme_sq_ring(struct nvme_qpair *qp)
+{
+    if (qp->sq_tail == qp->db_tail) {
+        return;
+    }
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    mmio_write32(qp->sq_db, qp->sq_tail);
+    qp->db_tail = qp->sq_tail;
+}
+
+/*
+ * Take the next completion off a CQ, returns false
+ * if the phase tag says there is none.
+ *
+ * XXX: Queue pair must be locked
+ */
+static bool
+nvme_cq_pop(struct nvme_qpair *qp, struct nvme_cpl *cpl)
+{
+    volatile struct nvme_cpl *ent = &qp->cq[qp->cq_head];
+
+    if (NVME_CPL_PHASE(ent->status) != qp->phase) {
+        return false;
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    memcpy(cpl, (void *)ent, sizeof(*cpl));
+    if (++qp->cq_head == qp->size) {
+        qp->cq_head = 0;
+        qp->phase ^= 1;
+    }
+
+    return true;
+}
+
+/*
+ * Issue an admin command and poll for its completion
+ *
+ * @ctrl: Controller to issue to
+ * @cmd: Command to issue
+ * @cdw0_res: Completion dword 0 is written here [optional]
+ *
+ * Returns zero on success
+ */
+static int
+nvme_admin(struct nvme_ctrl *ctrl, struct nvme_cmd *cmd, uint32_t *cdw0_res)
+{
+    struct nvme_qpair *qp = &ctrl->admin;
+    struct nvme_cpl cpl;
+    size_t waited = 0;
+    bool irq;
+
+    irq = spinlock_acquire_irq(&qp->lock);
+    cmd->cid = qp->sq_tail;
+    nvme_sq_push(qp, cmd);
+    nvme_sq_ring(qp);
+
+    while (!nvme_cq_pop(qp, &cpl)) {
+        if (waited++ >= NVME_ADMIN_TIMEOUT) {
+            spinlock_release_irq(&qp->lock, irq);
+            return -ETIMEDOUT;
+        }
+
+        hpet_msleep(1);
+    }
+
+    mmio_write32(qp->cq_db, qp->cq_head);
+    spinlock_release_irq(&qp->lock, irq);
+
+    if (NVME_CPL_STATUS(cpl.status) != 0) {
+        dtrace("admin opcode %x failed (status %x)\n",
+            cmd->opcode, NVME_CPL_STATUS(cpl.status));
+        return -EIO;
+    }
+
+    if (cdw0_res != NULL) {
+        *cdw0_res = cpl.cdw0;
+    }
+
+    return 0;
+}
+
+/*
+ * Allocate physically contiguous memory for a queue
+ */
+static volatile void *
+nvme_alloc_ring(size_t len, uintptr_t *phys_res)
+{
+    size_t npages = ALIGN_UP(len, PAGESIZE) / PAGESIZE;
+    void *va;
+
+    if ((*phys_res = vm_phys_alloc(npages)) == 0) {
+        return NULL;
+    }
+
+    va = PHYS_TO_VIRT(*phys_res);
+    memset(va, 0, npages * PAGESIZE);
+    return va;
+}
+
+static struct nvme_slot *
+nvme_slot_get(struct nvme_qpair *qp)
+{
+    struct nvme_slot *slot;
+
+    if ((slot = qp->freeslot) != NULL) {
+        qp->freeslot = slot->next;
+        --qp->nfree;
+    }
+
+    return slot;
+}
+
+static void
+nvme_slot_put(struct nvme_qpair *qp, struct nvme_slot *slot)
+{
+    slot->breq = NULL;
+    slot->next = qp->freeslot;
+    qp->freeslot = slot;
+    ++qp->nfree;
+}
+
+/*
+ * Set up the host side of a queue pair, I/O pairs also
+ * get a slot with a list page for every SQ entry.
+ */
+static int
+nvme_qpair_init(struct nvme_ctrl *ctrl, struct nvme_qpair *qp, uint16_t id,
+    uint16_t size)
+{
+    struct nvme_slot *slot;
+    volatile void *db;
+    uint16_t nslots;
+    int error;
+
+    memset(qp, 0, sizeof(*qp));
+    qp->ctrl = ctrl;
+    qp->id = id;
+    qp->size = size;
+    qp->phase = 1;
+    if ((error = spinlock_init("nvmeq", &qp->lock)) < 0) {
+        return error;
+    }
+
+    qp->sq = nvme_alloc_ring(sizeof(struct nvme_cmd) * size, &qp->sq_phys);
+    qp->cq = nvme_alloc_ring(sizeof(struct nvme_cpl) * size, &qp->cq_phys);
+    if (qp->sq == NULL || qp->cq == NULL) {
+        return -ENOMEM;
+    }
+
+    db = PTR_OFFSET(ctrl->regs, NVME_REG_DBS);
+    qp->sq_db = PTR_OFFSET(db, (2 * id) * ctrl->dstrd);
+    qp->cq_db = PTR_OFFSET(db, (2 * id + 1) * ctrl->dstrd);
+    if (id == 0) {
+        return 0;
+    }
+
+    /* One entry is always left empty so the SQ never looks idle */
+    nslots = size - 1;
+    if ((qp->slots = kalloc(sizeof(*qp->slots) * nslots)) == NULL) {
+        return -ENOMEM;
+    }
+
+    for (uint16_t i = 0; i < nslots; ++i) {
+        slot = &qp->slots[i];
+        memset(slot, 0, sizeof(*slot));
+        slot->cid = i;
+        if ((slot->list_phys = vm_phys_alloc(1)) == 0) {
+            return -ENOMEM;
+        }
+
+        slot->list = PHYS_TO_VIRT(slot->list_phys);
+        nvme_slot_put(qp, slot);
+    }
+
+    return 0;
+}
+
+/*
+ * Describe a buffer with PRP entries, anything past the
+ * second page goes through the list page of the slot.
+ * The buffer must fit within NVME_PRP_MAX bytes.
+ */
+static void
+nvme_build_prp(struct nvme_slot *slot, void *buf, size_t len,
+    struct nvme_cmd *cmd)
+{
+    uintptr_t addr = VIRT_TO_PHYS(buf);
+    uintptr_t page;
+    uint64_t *list = slot->list;
+    size_t first, n = 0;
+
+    cmd->dptr[0] = addr;
+    cmd->dptr[1] = 0;
+    first = PAGESIZE - (addr & (PAGESIZE - 1));
+    if (len <= first) {
+        return;
+    }
+
+    len -= first;
+    page = ALIGN_DOWN(addr, PAGESIZE) + PAGESIZE;
+    if (len <= PAGESIZE) {
+        cmd->dptr[1] = page;
+        return;
+    }
+
+    while (len > 0) {
+        list[n++] = page;
+        page += PAGESIZE;
+        len -= MIN(len, PAGESIZE);
+    }
+
+    cmd->dptr[1] = slot->list_phys;
+}
+
+/*
+ * Describe every segment of a block request with a
+ * single SGL, placed inline if there is only one.
+ */
+static void
+nvme_build_sgl(struct nvme_slot *slot, struct blk_req *breq,
+    struct nvme_cmd *cmd)
+{
+    struct nvme_sgl *sgl = slot->list;
+    struct nvme_sgl *inl = (struct nvme_sgl *)cmd->dptr;
+
+    for (uint16_t i = 0; i < breq->nseg; ++i) {
+        memset(&sgl[i], 0, sizeof(sgl[i]));
+        sgl[i].addr = VIRT_TO_PHYS(breq->seg[i].buf);
+        sgl[i].len = breq->seg[i].len;
+        sgl[i].type = NVME_SGL_DATA;
+    }
+
+    cmd->flags |= NVME_PSDT_SGL;
+    if (breq->nseg == 1) {
+        *inl = sgl[0];
+        return;
+    }
+
+    memset(inl, 0, sizeof(*inl));
+    inl->addr = slot->list_phys;
+    inl->len = sizeof(*sgl) * breq->nseg;
+    inl->type = NVME_SGL_LAST_SEG;
+}
+
+/*
+ * Fill in the common part of an I/O command
+ */
+static void
+nvme_io_cmd(struct nvme_cmd *cmd, struct blk_req *breq, uint64_t lba,
+    size_t nlb)
+{
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->nsid = 1;
+    switch (breq->op) {
+    case IO_OP_READ:
+        cmd->opcode = NVME_CMD_READ;
+        break;
+    case IO_OP_WRITE:
+        cmd->opcode = NVME_CMD_WRITE;
+        break;
+    case IO_OP_FLUSH:
+        cmd->opcode = NVME_CMD_FLUSH;
+        return;
+    }
+
+    cmd->cdw10 = lba & 0xFFFFFFFF;
+    cmd->cdw11 = lba >> 32;
+    cmd->cdw12 = (nlb - 1) & 0xFFFF;
+}
+
+/*
+ * Largest transfer a single PRP command may carry, it is
+ * bounded by the list page as well as by MDTS.
+ */
+static size_t
+nvme_prp_max(struct nvme_ctrl *ctrl)
+{
+    size_t max = NVME_PRP_MAX;
+
+    if (ctrl->mdts != 0) {
+        max = MIN(max, ctrl->mdts);
+    }
+
+    return max;
+}
+
+/*
+ * Queue the commands of a block request, SGL capable
+ * controllers take one command per request while PRPs
+ * need one command per segment. Anything larger than a
+ * single command may carry is split up.
+ *
+ * XXX: Queue pair must be locked
+ */
+static int
+nvme_queue_breq(struct nvme_qpair *qp, struct blk_req *breq)
+{
+    struct nvme_ctrl *ctrl = qp->ctrl;
+    struct nvme_slot *lead, *slot;
+    struct nvme_cmd cmd;
+    uint32_t ssize = ctrl->bdev.sector_size;
+    uint64_t lba = breq->blkno;
+    size_t nlb, len, maxlen;
+    size_t ncmd = 0;
+    bool single;
+    void *buf;
+
+    single = breq->op == IO_OP_FLUSH || (ctrl->sgl &&
+        breq->nsect <= NVME_MAX_NLB &&
+        (ctrl->mdts == 0 || breq->nsect * ssize <= ctrl->mdts));
+
+    maxlen = nvme_prp_max(ctrl);
+    if (single) {
+        ncmd = 1;
+    } else {
+        for (uint16_t i = 0; i < breq->nseg; ++i) {
+            ncmd += ALIGN_UP(breq->seg[i].len, maxlen) / maxlen;
+        }
+    }
+
+    /* XXX: Could never fit, the slots are sized for the queue */
+    if (ncmd > (size_t)qp->size - 1) {
+        return -EINVAL;
+    }
+
+    if (ncmd > qp->nfree) {
+        return -EAGAIN;
+    }
+
+    lead = nvme_slot_get(qp);
+    lead->pending = ncmd;
+    lead->status = 0;
+
+    if (single) {
+        lead->breq = breq;
+        lead->lead = lead;
+        nvme_io_cmd(&cmd, breq, lba, breq->nsect);
+        if (breq->op != IO_OP_FLUSH) {
+            nvme_build_sgl(lead, breq, &cmd);
+        }
+
+        cmd.cid = lead->cid;
+        nvme_sq_push(qp, &cmd);
+        return 0;
+    }
+
+    slot = lead;
+    for (uint16_t i = 0; i < breq->nseg; ++i) {
+        buf = breq->seg[i].buf;
+        for (size_t off = 0; off < breq->seg[i].len; off += len) {
+            if (slot == NULL) {
+                slot = nvme_slot_get(qp);
+            }
+
+            slot->breq = breq;
+            slot->lead = lead;
+
+            len = MIN(breq->seg[i].len - off, maxlen);
+            nlb = len / ssize;
+            nvme_io_cmd(&cmd, breq, lba, nlb);
+            nvme_build_prp(slot, PTR_OFFSET(buf, off), len, &cmd);
+            cmd.cid = slot->cid;
+            nvme_sq_push(qp, &cmd);
+            lba += nlb;
+            slot = NULL;
+        }
+    }
+
+    return 0;
+}
+
+static int
+nvme_strategy(struct blkdev *bdp, struct blk_req *breq)
+{
+    struct nvme_ctrl *ctrl = bdp->data;
+    struct nvme_qpair *qp = &ctrl->ioq[breq->queue->id];
+    bool irq;
+    int error;
+
+    /* Doorbell is rung by nvme_commit() once the batch is in */
+    irq = spinlock_acquire_irq(&qp->lock);
+    error = nvme_queue_breq(qp, breq);
+    spinlock_release_irq(&qp->lock, irq);
+    return error;
+}
+
+static void
+nvme_commit(struct blkdev *bdp, struct blk_queue *q)
+{
+    struct nvme_ctrl *ctrl = bdp->data;
+    struct nvme_qpair *qp = &ctrl->ioq[q->id];
+    bool irq;
+
+    irq = spinlock_acquire_irq(&qp->lock);
+    nvme_sq_ring(qp);
+    spinlock_release_irq(&qp->lock, irq);
+}
+
+/*
+ * Reap every completion on a queue pair, block requests
+ * are completed with the pair unlocked since that may
+ * start more I/O on it.
+ */
+static void
+nvme_reap(struct nvme_qpair *qp)
+{
+    struct blk_req *done[NVME_REAP_BATCH];
+    int status[NVME_REAP_BATCH];
+    struct nvme_slot *slot, *lead;
+    struct nvme_cpl cpl;
+    size_t ndone;
+    bool more, popped, irq;
+
+    do {
+        ndone = 0;
+        popped = false;
+        irq = spinlock_acquire_irq(&qp->lock);
+        while (ndone < NVME_REAP_BATCH && nvme_cq_pop(qp, &cpl)) {
+            popped = true;
+            if (cpl.cid >= qp->size - 1) {
+                dtrace("qid %d: bogus cid %d\n", qp->id, cpl.cid);
+                continue;
+            }
+
+            slot = &qp->slots[cpl.cid];
+            lead = slot->lead;
+            if (NVME_CPL_STATUS(cpl.status) != 0 && lead->status == 0) {
+                lead->status = -EIO;
+            }
+
+            if (slot != lead) {
+                nvme_slot_put(qp, slot);
+            }
+
+            if (--lead->pending == 0) {
+                done[ndone] = lead->breq;
+                status[ndone++] = lead->status;
+                nvme_slot_put(qp, lead);
+            }
+        }
+
+        if (popped) {
+            mmio_write32(qp->cq_db, qp->cq_head);
+        }
+
+        more = (ndone == NVME_REAP_BATCH);
+        spinlock_release_irq(&qp->lock, irq);
+
+        for (size_t i = 0; i < ndone; ++i) {
+            blkdev_done(done[i], status[i]);
+        }
+    } while (more);
+}
+
+static void
+nvme_poll(struct blkdev *bdp, struct blk_queue *q)
+{
+    struct nvme_ctrl *ctrl = bdp->data;
+
+    nvme_reap(&ctrl->ioq[q->id]);
+}
+
+/*
+ * Deferred completion work of a queue pair
+ */
+static void
+nvme_done(void *arg)
+{
+    nvme_reap(arg);
+}
+
+static int
+nvme_intr(void *arg)
+{
+    struct nvme_qpair *qp = arg;
+
+    softint_queue(&qp->work);
+    return INTR_HANDLED;
+}
+
+static struct blkdev_ops nvme_ops = {
+    .strategy = nvme_strategy,
+    .commit = nvme_commit,
+    .poll = nvme_poll
+};
+
+/*
+ * Reset the controller and bring it back up with a
+ * fresh admin queue pair.
+ */
+static int
+nvme_enable(struct nvme_ctrl *ctrl)
+{
+    struct nvme_qpair *qp = &ctrl->admin;
+    uint64_t cap;
+    uint32_t cc;
+    size_t timeout;
+    uint16_t size;
+    int error;
+
+    cap = nvme_read8(ctrl, NVME_REG_CAP);
+    timeout = MAX(NVME_CAP_TO(cap), 1) * 500;
+    ctrl->dstrd = 4 << NVME_CAP_DSTRD(cap);
+
+    /* We only do 4 KiB pages */
+    if (NVME_CAP_MPSMIN(cap) != 0) {
+        return -ENOTSUP;
+    }
+
+    cc = nvme_read4(ctrl, NVME_REG_CC);
+    if (ISSET(cc, NVME_CC_EN)) {
+        nvme_write4(ctrl, NVME_REG_CC, cc & ~NVME_CC_EN);
+    }
+
+    if ((error = nvme_wait_ready(ctrl, false, timeout)) < 0) {
+        return error;
+    }
+
+    size = MIN(NVME_ADMIN_QSIZE, NVME_CAP_MQES(cap) + 1);
+    if ((error = nvme_qpair_init(ctrl, qp, 0, size)) < 0) {
+        return error;
+    }
+
+    nvme_write4(ctrl, NVME_REG_AQA, ((size - 1) << 16) | (size - 1));
+    nvme_write8(ctrl, NVME_REG_ASQ, qp->sq_phys);
+    nvme_write8(ctrl, NVME_REG_ACQ, qp->cq_phys);
+
+    cc = NVME_CC_EN | NVME_CC_IOSQES(6) | NVME_CC_IOCQES(4);
+    nvme_write4(ctrl, NVME_REG_CC, cc);
+    return nvme_wait_ready(ctrl, true, timeout);
+}
+
+/*
+ * Identify the controller and the first namespace
+ */
+static int
+nvme_identify(struct nvme_ctrl *ctrl)
+{
+    struct nvme_cmd cmd;
+    uintptr_t phys;
+    uint8_t *id, mdts, flbas, lbads;
+    uint64_t nsze;
+    int error;
+
+    if ((phys = vm_phys_alloc(1)) == 0) {
+        return -ENOMEM;
+    }
+
+    id = PHYS_TO_VIRT(phys);
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADM_IDENTIFY;
+    cmd.dptr[0] = phys;
+    cmd.cdw10 = NVME_ID_CTRL;
+    if ((error = nvme_admin(ctrl, &cmd, NULL)) < 0) {
+        goto done;
+    }
+
+    mdts = id[NVME_IDC_MDTS];
+    ctrl->mdts = (mdts != 0) ? (PAGESIZE << mdts) : 0;
+    ctrl->sgl = (*(uint32_t *)&id[NVME_IDC_SGLS] & 3) != 0;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADM_IDENTIFY;
+    cmd.nsid = 1;
+    cmd.dptr[0] = phys;
+    cmd.cdw10 = NVME_ID_NS;
+    if ((error = nvme_admin(ctrl, &cmd, NULL)) < 0) {
+        goto done;
+    }
+
+    nsze = *(uint64_t *)&id[NVME_IDN_NSZE];
+    flbas = id[NVME_IDN_FLBAS] & 0xF;
+    lbads = id[NVME_IDN_LBAF + (flbas * 4) + 2];
+    if (nsze == 0 || lbads < 9) {
+        error = -ENODEV;
+        goto done;
+    }
+
+    ctrl->bdev.sector_size = 1 << lbads;
+    ctrl->bdev.nsectors = nsze;
+done:
+    vm_phys_free(phys, 1);
+    return error;
+}
+
+static int
+nvme_set_feature(struct nvme_ctrl *ctrl, uint8_t fid, uint32_t val,
+    uint32_t *cdw0_res)
+{
+    struct nvme_cmd cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADM_SETFEAT;
+    cmd.cdw10 = fid;
+    cmd.cdw11 = val;
+    return nvme_admin(ctrl, &cmd, cdw0_res);
+}
+
+/*
+ * Create an I/O queue pair, its CQ interrupts the core
+ * the pair belongs to unless we are polling.
+ */
+static int
+nvme_create_qpair(struct nvme_ctrl *ctrl, uint16_t id, uint16_t size)
+{
+    struct nvme_qpair *qp = &ctrl->ioq[id - 1];
+    struct nvme_cmd cmd;
+    struct cpu_info *ci;
+    uint32_t flags = NVME_Q_PC;
+    int error;
+
+    if ((error = nvme_qpair_init(ctrl, qp, id, size)) < 0) {
+        return error;
+    }
+
+    qp->work.func = nvme_done;
+    qp->work.arg = qp;
+    qp->ih.name = "nvmeq";
+    qp->ih.func = nvme_intr;
+    qp->ih.arg = qp;
+    if (!ctrl->polled) {
+        ci = cpu_get((id - 1) % cpu_count());
+        if ((error = pci_msix_establish(ctrl->pci, id, &qp->ih, ci)) < 0) {
+            return error;
+        }
+
+        flags |= NVME_CQ_IEN | (id << 16);
+    }
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADM_CREATE_CQ;
+    cmd.dptr[0] = qp->cq_phys;
+    cmd.cdw10 = ((size - 1) << 16) | id;
+    cmd.cdw11 = flags;
+    if ((error = nvme_admin(ctrl, &cmd, NULL)) < 0) {
+        return error;
+    }
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = NVME_ADM_CREATE_SQ;
+    cmd.dptr[0] = qp->sq_phys;
+    cmd.cdw10 = ((size - 1) << 16) | id;
+    cmd.cdw11 = (id << 16) | NVME_Q_PC;
+    return nvme_admin(ctrl, &cmd, NULL);
+}
+
+/*
+ * Create one I/O queue pair per core, each with its own
+ * MSI-X vector. Vector zero is left to the admin queue
+ * which is always polled.
+ */
+static int
+nvme_setup_ioq(struct nvme_ctrl *ctrl, uint16_t *qdepth_res)
+{
+    uint64_t cap = nvme_read8(ctrl, NVME_REG_CAP);
+    uint32_t granted;
+    uint16_t nq, nmsix, size;
+    int error;
+
+    nq = cpu_count();
+    nmsix = pci_msix_count(ctrl->pci);
+    ctrl->polled = NVME_POLLED || nmsix < 2;
+    if (!ctrl->polled) {
+        nq = MIN(nq, nmsix - 1);
+    }
+
+    error = nvme_set_feature(ctrl, NVME_FEAT_NQUEUES,
+        ((nq - 1) << 16) | (nq - 1), &granted);
+    if (error < 0) {
+        return error;
+    }
+
+    nq = MIN(nq, (granted & 0xFFFF) + 1);
+    nq = MIN(nq, (granted >> 16) + 1);
+
+    if (!ctrl->polled) {
+        nvme_set_feature(ctrl, NVME_FEAT_COALESCE,
+            NVME_COALESCE_THR | (NVME_COALESCE_TIME << 8), NULL);
+    }
+
+    if ((ctrl->ioq = kalloc(sizeof(*ctrl->ioq) * nq)) == NULL) {
+        return -ENOMEM;
+    }
+
+    size = MIN(NVME_QSIZE, NVME_CAP_MQES(cap) + 1);
+    for (uint16_t i = 1; i <= nq; ++i) {
+        if ((error = nvme_create_qpair(ctrl, i, size)) < 0) {
+            return error;
+        }
+
+        ++ctrl->nioq;
+    }
+
+    /* Without SGLs each segment may take its own slot */
+    *qdepth_res = ctrl->sgl ? (size - 1) : MAX((size - 1) / BLK_MAXSEG, 1);
+    return 0;
+}
+
+static int
+nvme_attach(struct pci_device *pci)
+{
+    struct nvme_ctrl *ctrl;
+    struct blkdev *bdp;
+    uint16_t qdepth;
+    void *regs;
+    int error;
+
+    if ((ctrl = kalloc(sizeof(*ctrl))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(ctrl, 0, sizeof(*ctrl));
+    ctrl->pci = pci;
+    pci_enable(pci, PCI_CMD_MEMEN | PCI_CMD_BMEN);
+    if ((error = pci_map_bar(pci, 0, &regs)) < 0) {
+        kfree(ctrl);
+        return error;
+    }
+
+    ctrl->regs = regs;
+    if ((error = nvme_enable(ctrl)) < 0) {
+        return error;
+    }
+
+    if ((error = nvme_identify(ctrl)) < 0) {
+        return error;
+    }
+
+    if ((error = nvme_setup_ioq(ctrl, &qdepth)) < 0) {
+        return error;
+    }
+
+    bdp = &ctrl->bdev;
+    snprintf(bdp->name, sizeof(bdp->name), "nvme%dn1", nvme_unit++);
+    bdp->ops = &nvme_ops;
+    bdp->nqueues = ctrl->nioq;
+    bdp->qdepth = qdepth;
+    bdp->data = ctrl;
+
+    /* Merged requests must not need splitting, qdepth counts on it */
+    if (!ctrl->sgl) {
+        bdp->max_sectors = nvme_prp_max(ctrl) / bdp->sector_size;
+    } else {
+        bdp->max_sectors = NVME_MAX_NLB;
+        if (ctrl->mdts != 0) {
+            bdp->max_sectors = MIN(NVME_MAX_NLB, ctrl->mdts / bdp->sector_size);
+        }
+    }
+
+    if ((error = blkdev_register(bdp)) < 0) {
+        return error;
+    }
+
+    dtrace(
+        "%s: %d queue pair(s), %s, %s completion\n",
+        bdp->name, ctrl->nioq, ctrl->sgl ? "SGL" : "PRP",
+        ctrl->polled ? "polled" : "coalesced MSI-X"
+    );
+    return 0;
+}
+
+void
+nvme_init(void)
+{
+    struct pci_device *pci = NULL;
+    int error;
+
+    while ((pci = pci_find_class(NVME_CLASS, NVME_SUBCLASS, pci)) != NULL) {
+        if (pci->progif != NVME_PROGIF) {
+            continue;
+        }
+
+        if ((error = nvme_attach(pci)) < 0) {
+            dtrace("%x:%x.%x: attach failed (%d)\n",
+                pci->bus, pci->slot, pci->func, error);
+        }
+    }
+}
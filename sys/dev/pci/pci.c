@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <acpi/acpi.h>
+#include <acpi/tables.h>
+#include <dev/pci/pci.h>
+#include <dev/pci/pcireg.h>
+#include <kern/panic.h>
+#include <os/mmio.h>
+#include <os/trace.h>
+#include <mu/mmu.h>
+#include <vm/kalloc.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("pci: " fmt, ##__VA_ARGS__)
+
+/*
+ * The HHDM only covers the low 4 GiB and usable memory,
+ * anything mapped above this must be mapped in by hand.
+ */
+#define HHDM_LOW_LIMIT 0x100000000ULL
+
+static struct acpi_mcfg *mcfg;
+static TAILQ_HEAD(, pci_device) pci_devices;
+static TAILQ_HEAD(, pci_device) pci_roots;
+static size_t pci_ndevices = 0;
+
+/*
+ * Make sure a physical range is reachable through
+ * the HHDM
+ */
+static int
+pci_map_range(uintptr_t pa, size_t len)
+{
+    struct mmu_vas vas;
+    uintptr_t end;
+    int error;
+
+    end = ALIGN_UP(pa + len, PAGESIZE);
+    if (end <= HHDM_LOW_LIMIT) {
+        return 0;
+    }
+
+    if ((error = mu_pmap_readvas(&vas)) < 0) {
+        return error;
+    }
+
+    for (pa = ALIGN_DOWN(pa, PAGESIZE); pa < end; pa += PAGESIZE) {
+        error = mu_pmap_map(
+            &vas, pa,
+            (uintptr_t)PHYS_TO_VIRT(pa),
+            PROT_WRITE, PAGESIZE_4K
+        );
+        if (error < 0) {
+            return error;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Get the ECAM window of a function
+ */
+static void *
+pci_ecam(struct acpi_mcfg_base *mbase, uint8_t bus, uint8_t slot,
+    uint8_t func)
+{
+    uintptr_t pa;
+
+    pa = mbase->base_pa;
+    pa += ((uintptr_t)(bus - mbase->bus_start) << 20);
+    pa += ((uintptr_t)slot << 15) | ((uintptr_t)func << 12);
+    return PHYS_TO_VIRT(pa);
+}
+
+uint8_t
+pci_readb(struct pci_device *dev, uint16_t off)
+{
+    return mmio_read8(PTR_OFFSET(dev->cfg, off));
+}
+
+uint16_t
+pci_readw(struct pci_device *dev, uint16_t off)
+{
+    return mmio_read16(PTR_OFFSET(dev->cfg, off));
+}
+
+uint32_t
+pci_readl(struct pci_device *dev, uint16_t off)
+{
+    return mmio_read32(PTR_OFFSET(dev->cfg, off));
+}
+
+void
+pci_writeb(struct pci_device *dev, uint16_t off, uint8_t val)
+{
+    mmio_write8(PTR_OFFSET(dev->cfg, off), val);
+}
+
+void
+pci_writew(struct pci_device *dev, uint16_t off, uint16_t val)
+{
+    mmio_write16(PTR_OFFSET(dev->cfg, off), val);
+}
+
+void
+pci_writel(struct pci_device *dev, uint16_t off, uint32_t val)
+{
+    mmio_write32(PTR_OFFSET(dev->cfg, off), val);
+}
+
+uint8_t
+pci_find_cap(struct pci_device *dev, uint8_t id, uint8_t start)
+{
+    uint8_t off;
+    int ttl = 48;
+
+    if (!ISSET(pci_readw(dev, PCIREG_STATUS), PCI_STATUS_CAPLIST)) {
+        return 0;
+    }
+
+    if (start == 0) {
+        off = pci_readb(dev, PCIREG_CAPPTR);
+    } else {
+        off = pci_readb(dev, start + 1);
+    }
+
+    /* Guard against broken, looping lists */
+    while (off != 0 && ttl-- > 0) {
+        off &= ~0x3;
+        if (pci_readb(dev, off) == id) {
+            return off;
+        }
+        off = pci_readb(dev, off + 1);
+    }
+
+    return 0;
+}
+
+void
+pci_enable(struct pci_device *dev, uint16_t cmd)
+{
+    uint16_t reg;
+
+    reg = pci_readw(dev, PCIREG_CMD);
+    pci_writew(dev, PCIREG_CMD, reg | cmd);
+}
+
+int
+pci_map_bar(struct pci_device *dev, uint8_t bar, void **va_res)
+{
+    int error;
+
+    if (dev == NULL || va_res == NULL || bar >= PCI_NBAR) {
+        return -EINVAL;
+    }
+
+    if (dev->bar_size[bar] == 0 || ISSET(dev->bar_io, BIT(bar))) {
+        return -ENXIO;
+    }
+
+    error = pci_map_range(dev->bar[bar], dev->bar_size[bar]);
+    if (error < 0) {
+        return error;
+    }
+
+    *va_res = PHYS_TO_VIRT(dev->bar[bar]);
+    return 0;
+}
+
+/*
+ * Find the base and size of every BAR, decoding is turned
+ * off while sizing so the device doesn't claim a bogus range.
+ */
+static void
+pci_size_bars(struct pci_device *dev)
+{
+    uint16_t cmd;
+    uint32_t orig, mask, hi;
+    uint64_t size;
+    uint8_t nbar, off;
+
+    nbar = (PCI_HDR_TYPE(dev->hdrtype) == PCI_HDR_BRIDGE) ? 2 : PCI_NBAR;
+    cmd = pci_readw(dev, PCIREG_CMD);
+    pci_writew(dev, PCIREG_CMD, cmd & ~(PCI_CMD_IOEN | PCI_CMD_MEMEN));
+
+    for (uint8_t i = 0; i < nbar; ++i) {
+        off = PCIREG_BAR0 + (i * 4);
+        orig = pci_readl(dev, off);
+        pci_writel(dev, off, 0xFFFFFFFF);
+        mask = pci_readl(dev, off);
+        pci_writel(dev, off, orig);
+
+        if (mask == 0) {
+            continue;
+        }
+
+        if (ISSET(orig, PCI_BAR_IO)) {
+            dev->bar_io |= BIT(i);
+            dev->bar[i] = orig & PCI_BAR_IOMASK;
+            dev->bar_size[i] = (~(mask & PCI_BAR_IOMASK) + 1) & 0xFFFF;
+            continue;
+        }
+
+        size = mask & PCI_BAR_MEMMASK;
+        dev->bar[i] = orig & PCI_BAR_MEMMASK;
+        if (PCI_BAR_TYPE(orig) == PCI_BAR_TYPE64 && i + 1 < nbar) {
+            hi = pci_readl(dev, off + 4);
+            pci_writel(dev, off + 4, 0xFFFFFFFF);
+            size |= (uint64_t)pci_readl(dev, off + 4) << 32;
+            pci_writel(dev, off + 4, hi);
+            dev->bar[i] |= (uint64_t)hi << 32;
+            dev->bar_size[i] = ~size + 1;
+            ++i;
+            continue;
+        }
+
+        dev->bar_size[i] = (uint32_t)(~size + 1);
+    }
+
+    pci_writew(dev, PCIREG_CMD, cmd);
+}
+
+static void pci_scan_bus(struct acpi_mcfg_base *mbase, uint8_t bus,
+    struct pci_device *parent);
+
+/*
+ * Probe a single function, returns the device or NULL
+ * if nothing is there.
+ */
+static struct pci_device *
+pci_probe(struct acpi_mcfg_base *mbase, uint8_t bus, uint8_t slot,
+    uint8_t func, struct pci_device *parent)
+{
+    struct pci_device *dev;
+    void *cfg;
+
+    cfg = pci_ecam(mbase, bus, slot, func);
+    if (mmio_read16(PTR_OFFSET(cfg, PCIREG_VENDOR)) == 0xFFFF) {
+        return NULL;
+    }
+
+    if ((dev = kalloc(sizeof(*dev))) == NULL) {
+        panic("pci: out of memory\n");
+    }
+
+    memset(dev, 0, sizeof(*dev));
+    dev->seg = mbase->seg_grpno;
+    dev->bus = bus;
+    dev->slot = slot;
+    dev->func = func;
+    dev->cfg = cfg;
+    dev->parent = parent;
+    TAILQ_INIT(&dev->children);
+
+    dev->vendor = pci_readw(dev, PCIREG_VENDOR);
+    dev->device = pci_readw(dev, PCIREG_DEVICE);
+    dev->class = pci_readb(dev, PCIREG_CLASS);
+    dev->subclass = pci_readb(dev, PCIREG_SUBCLASS);
+    dev->progif = pci_readb(dev, PCIREG_PROGIF);
+    dev->revid = pci_readb(dev, PCIREG_REVID);
+    dev->hdrtype = pci_readb(dev, PCIREG_HDRTYPE);
+    dev->msi_cap = pci_find_cap(dev, PCI_CAP_MSI, 0);
+    dev->msix_cap = pci_find_cap(dev, PCI_CAP_MSIX, 0);
+    pci_size_bars(dev);
+
+    TAILQ_INSERT_TAIL(&pci_devices, dev, link);
+    if (parent != NULL) {
+        TAILQ_INSERT_TAIL(&parent->children, dev, sibling);
+    } else {
+        TAILQ_INSERT_TAIL(&pci_roots, dev, sibling);
+    }
+
+    ++pci_ndevices;
+    dtrace(
+        "%d:%d.%d %x:%x class %x.%x\n",
+        bus, slot, func, dev->vendor, dev->device,
+        dev->class, dev->subclass
+    );
+
+    /* Walk down behind bridges */
+    if (PCI_HDR_TYPE(dev->hdrtype) == PCI_HDR_BRIDGE) {
+        uint8_t secbus = pci_readb(dev, PCIREG_SECBUS);
+
+        if (secbus > bus && secbus <= mbase->bus_end) {
+            pci_scan_bus(mbase, secbus, dev);
+        }
+    }
+
+    return dev;
+}
+
+static void
+pci_scan_bus(struct acpi_mcfg_base *mbase, uint8_t bus,
+    struct pci_device *parent)
+{
+    struct pci_device *dev;
+    uint8_t nfunc;
+
+    for (uint8_t slot = 0; slot < 32; ++slot) {
+        dev = pci_probe(mbase, bus, slot, 0, parent);
+        if (dev == NULL) {
+            continue;
+        }
+
+        nfunc = ISSET(dev->hdrtype, PCI_HDR_MF) ? 8 : 1;
+        for (uint8_t func = 1; func < nfunc; ++func) {
+            pci_probe(mbase, bus, slot, func, parent);
+        }
+    }
+}
+
+struct pci_device *
+pci_find(uint16_t vendor, uint16_t device, struct pci_device *after)
+{
+    struct pci_device *dev;
+
+    dev = (after == NULL) ? TAILQ_FIRST(&pci_devices) : TAILQ_NEXT(after, link);
+    for (; dev != NULL; dev = TAILQ_NEXT(dev, link)) {
+        if (dev->vendor != vendor) {
+            continue;
+        }
+
+        if (device == 0xFFFF || dev->device == device) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+struct pci_device *
+pci_find_class(uint8_t class, uint8_t subclass, struct pci_device *after)
+{
+    struct pci_device *dev;
+
+    dev = (after == NULL) ? TAILQ_FIRST(&pci_devices) : TAILQ_NEXT(after, link);
+    for (; dev != NULL; dev = TAILQ_NEXT(dev, link)) {
+        if (dev->class != class) {
+            continue;
+        }
+
+        if (subclass == 0xFF || dev->subclass == subclass) {
+            return dev;
+        }
+    }
+
+    return NULL;
+}
+
+void
+pci_init(void)
+{
+    struct acpi_mcfg_base *mbase;
+    size_t nbase, len;
+
+    TAILQ_INIT(&pci_devices);
+    TAILQ_INIT(&pci_roots);
+
+    mcfg = acpi_query("MCFG");
+    if (mcfg == NULL) {
+        dtrace("no MCFG, PCIe not supported\n");
+        return;
+    }
+
+    nbase = mcfg->hdr.length - __builtin_offsetof(struct acpi_mcfg, base);
+    nbase /= sizeof(struct acpi_mcfg_base);
+
+    for (size_t i = 0; i < nbase; ++i) {
+        mbase = &mcfg->base[i];
+        len = ((size_t)(mbase->bus_end - mbase->bus_start) + 1) << 20;
+        if (pci_map_range(mbase->base_pa, len) < 0) {
+            dtrace("failed to map ECAM for segment %d\n", mbase->seg_grpno);
+            continue;
+        }
+
+        /* Bridges pull in their secondary buses */
+        pci_scan_bus(mbase, mbase->bus_start, NULL);
+    }
+
+    dtrace("%d function(s) found\n", pci_ndevices);
+}
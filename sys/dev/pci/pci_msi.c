@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/pci/pci.h>
+#include <dev/pci/pcireg.h>
+#include <os/intr.h>
+#include <os/mmio.h>
+#include <mu/cpu.h>
+#include <mu/irq.h>
+
+static uint32_t next_cpu = 0;
+
+/*
+ * Pick a processor for a vector when the caller has no
+ * preference, vectors are spread round-robin so that the
+ * queues of a device land on different cores.
+ */
+static struct cpu_info *
+pci_msi_cpu(void)
+{
+    return cpu_pick(__atomic_fetch_add(&next_cpu, 1, __ATOMIC_RELAXED));
+}
+
+/*
+ * Allocate a vector on a processor and register a
+ * handler on it
+ */
+static int
+pci_msi_vector(struct intr_hand *ih, struct cpu_info *ci, uint8_t *vec_res)
+{
+    int error;
+
+    if ((error = intr_alloc(ci, vec_res)) < 0) {
+        return error;
+    }
+
+    if ((error = intr_register(ci, *vec_res, ih)) < 0) {
+        intr_free(ci, *vec_res);
+        return error;
+    }
+
+    return 0;
+}
+
+/*
+ * Map the MSI-X table of a device
+ */
+static int
+pci_msix_setup(struct pci_device *dev)
+{
+    uint32_t table;
+    uint16_t ctl;
+    uint8_t bir;
+    void *va;
+    int error;
+
+    if (dev->msix_table != NULL) {
+        return 0;
+    }
+
+    ctl = pci_readw(dev, dev->msix_cap + PCI_MSIX_CTL);
+    table = pci_readl(dev, dev->msix_cap + PCI_MSIX_TABLE);
+    bir = PCI_MSIX_BIR(table);
+
+    if ((error = pci_map_bar(dev, bir, &va)) < 0) {
+        return error;
+    }
+
+    dev->msix_table = PTR_OFFSET(va, PCI_MSIX_OFF(table));
+    dev->msix_count = PCI_MSIX_CTL_SIZE(ctl);
+
+    /*
+     * Mask every entry before turning MSI-X on, entries are
+     * unmasked one by one as vectors are handed out.
+     */
+    for (uint16_t i = 0; i < dev->msix_count; ++i) {
+        pci_msix_mask(dev, i, true);
+    }
+
+    pci_enable(dev, PCI_CMD_MEMEN | PCI_CMD_BMEN | PCI_CMD_INTXDIS);
+    ctl |= PCI_MSIX_CTL_EN;
+    ctl &= ~PCI_MSIX_CTL_FMASK;
+    pci_writew(dev, dev->msix_cap + PCI_MSIX_CTL, ctl);
+    return 0;
+}
+
+uint16_t
+pci_msix_count(struct pci_device *dev)
+{
+    uint16_t ctl;
+
+    if (dev == NULL || dev->msix_cap == 0) {
+        return 0;
+    }
+
+    ctl = pci_readw(dev, dev->msix_cap + PCI_MSIX_CTL);
+    return PCI_MSIX_CTL_SIZE(ctl);
+}
+
+void
+pci_msix_mask(struct pci_device *dev, uint16_t index, bool mask)
+{
+    volatile void *ent;
+    uint32_t ctl;
+
+    if (dev == NULL || dev->msix_table == NULL) {
+        return;
+    }
+
+    if (index >= dev->msix_count) {
+        return;
+    }
+
+    ent = PTR_OFFSET(dev->msix_table, index * PCI_MSIX_ENTSIZE);
+    ctl = mmio_read32(PTR_OFFSET(ent, PCI_MSIX_ENT_CTL));
+    if (mask) {
+        ctl |= PCI_MSIX_ENT_MASK;
+    } else {
+        ctl &= ~PCI_MSIX_ENT_MASK;
+    }
+
+    mmio_write32(PTR_OFFSET(ent, PCI_MSIX_ENT_CTL), ctl);
+}
+
+int
+pci_msix_establish(struct pci_device *dev, uint16_t index,
+    struct intr_hand *ih, struct cpu_info *ci)
+{
+    volatile void *ent;
+    uint64_t addr;
+    uint32_t data;
+    uint8_t vec;
+    int error;
+
+    if (dev == NULL || ih == NULL) {
+        return -EINVAL;
+    }
+
+    if (dev->msix_cap == 0) {
+        return -ENOTSUP;
+    }
+
+    if ((error = pci_msix_setup(dev)) < 0) {
+        return error;
+    }
+
+    if (index >= dev->msix_count) {
+        return -EINVAL;
+    }
+
+    if (ci == NULL) {
+        ci = pci_msi_cpu();
+    }
+
+    if ((error = pci_msi_vector(ih, ci, &vec)) < 0) {
+        return error;
+    }
+
+    if ((error = mu_msi_compose(ci, vec, &addr, &data)) < 0) {
+        intr_unregister(ci, vec, ih);
+        intr_free(ci, vec);
+        return error;
+    }
+
+    ent = PTR_OFFSET(dev->msix_table, index * PCI_MSIX_ENTSIZE);
+    pci_msix_mask(dev, index, true);
+    mmio_write32(PTR_OFFSET(ent, PCI_MSIX_ENT_ADDRLO), addr & 0xFFFFFFFF);
+    mmio_write32(PTR_OFFSET(ent, PCI_MSIX_ENT_ADDRHI), addr >> 32);
+    mmio_write32(PTR_OFFSET(ent, PCI_MSIX_ENT_DATA), data);
+    pci_msix_mask(dev, index, false);
+    return 0;
+}
+
+void
+pci_msix_disestablish(struct pci_device *dev, uint16_t index,
+    struct intr_hand *ih, struct cpu_info *ci)
+{
+    if (dev == NULL || ih == NULL || ci == NULL) {
+        return;
+    }
+
+    if (dev->msix_cap == 0 || index >= dev->msix_count) {
+        return;
+    }
+
+    /*
+     * The vector is not kept anywhere, find it through the
+     * handler. This only runs on teardown.
+     */
+    pci_msix_mask(dev, index, true);
+    for (uint16_t vec = IVEC_MIN; vec <= IVEC_MAX; ++vec) {
+        if (intr_unregister(ci, vec, ih) == 0) {
+            intr_free(ci, vec);
+            break;
+        }
+    }
+}
+
+int
+pci_msi_establish(struct pci_device *dev, struct intr_hand *ih,
+    struct cpu_info *ci)
+{
+    uint64_t addr;
+    uint32_t data;
+    uint16_t ctl;
+    uint8_t cap, vec;
+    int error;
+
+    if (dev == NULL || ih == NULL) {
+        return -EINVAL;
+    }
+
+    if ((cap = dev->msi_cap) == 0) {
+        return -ENOTSUP;
+    }
+
+    if (ci == NULL) {
+        ci = pci_msi_cpu();
+    }
+
+    if ((error = pci_msi_vector(ih, ci, &vec)) < 0) {
+        return error;
+    }
+
+    if ((error = mu_msi_compose(ci, vec, &addr, &data)) < 0) {
+        intr_unregister(ci, vec, ih);
+        intr_free(ci, vec);
+        return error;
+    }
+
+    /* Single message, the address width depends on the device */
+    ctl = pci_readw(dev, cap + PCI_MSI_CTL);
+    ctl &= ~(PCI_MSI_CTL_MME | PCI_MSI_CTL_EN);
+    pci_writew(dev, cap + PCI_MSI_CTL, ctl);
+
+    pci_writel(dev, cap + PCI_MSI_ADDRLO, addr & 0xFFFFFFFF);
+    if (ISSET(ctl, PCI_MSI_CTL_64)) {
+        pci_writel(dev, cap + PCI_MSI_ADDRHI, addr >> 32);
+        pci_writew(dev, cap + PCI_MSI_DATA64, data);
+    } else {
+        pci_writew(dev, cap + PCI_MSI_DATA32, data);
+    }
+
+    pci_enable(dev, PCI_CMD_BMEN | PCI_CMD_INTXDIS);
+    pci_writew(dev, cap + PCI_MSI_CTL, ctl | PCI_MSI_CTL_EN);
+    return 0;
+}
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <dev/tty/tty.h>
+#include <dev/cons/cons.h>
+#include <kern/serial.h>
+#include <kern/vnode.h>
+#include <os/thread.h>
+#include <os/sched.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <mu/tty.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("tty: " fmt, ##__VA_ARGS__)
+
+extern struct console g_bootcons;
+
+static TAILQ_HEAD(, tty) tty_list;
+static struct spinlock tty_lock;
+static struct tty cons_tty;
+static struct tty ser_tty;
+
+/*
+ * Echo input back if the terminal wants it
+ */
+static inline void
+tty_echo(struct tty *tp, const char *s, size_t len)
+{
+    if (ISSET(tp->flags, TTY_ECHO)) {
+        tp->output(s, len);
+    }
+}
+
+/*
+ * Make bytes visible to readers and wake them up
+ *
+ * XXX: Bytes that do not fit are dropped
+ */
+static void
+tty_deliver(struct tty *tp, const char *s, size_t len)
+{
+    struct thread *td;
+    bool irq;
+
+    irq = spinlock_acquire_irq(&tp->lock);
+    for (size_t i = 0; i < len; ++i) {
+        if (!tty_ring_put(&tp->readq, s[i])) {
+            break;
+        }
+    }
+
+    while ((td = TAILQ_FIRST(&tp->waiters)) != NULL) {
+        TAILQ_REMOVE(&tp->waiters, td, sleepq);
+        sched_wakeup(td);
+    }
+
+    spinlock_release_irq(&tp->lock, irq);
+}
+
+/*
+ * Line discipline, drains the raw input ring. The line
+ * being edited is only ever touched here.
+ */
+static void
+tty_ldisc(void *arg)
+{
+    struct tty *tp = arg;
+    char c;
+
+    while (tty_ring_get(&tp->inq, &c)) {
+        if (c == '\r') {
+            c = '\n';
+        }
+
+        if (!ISSET(tp->flags, TTY_ICANON)) {
+            tty_echo(tp, &c, 1);
+            tty_deliver(tp, &c, 1);
+            continue;
+        }
+
+        switch (c) {
+        case TTY_CERASE:
+        case TTY_CBS:
+            if (tp->linelen > 0) {
+                --tp->linelen;
+                tty_echo(tp, "\b \b", 3);
+            }
+            break;
+        case TTY_CKILL:
+            while (tp->linelen > 0) {
+                --tp->linelen;
+                tty_echo(tp, "\b \b", 3);
+            }
+            break;
+        case '\n':
+            tp->line[tp->linelen++] = c;
+            tty_echo(tp, &c, 1);
+            tty_deliver(tp, tp->line, tp->linelen);
+            tp->linelen = 0;
+            break;
+        default:
+            /* Leave room for the newline */
+            if (tp->linelen < TTY_LINESIZE - 1) {
+                tp->line[tp->linelen++] = c;
+                tty_echo(tp, &c, 1);
+            }
+            break;
+        }
+    }
+}
+
+static ssize_t
+tty_vop_read(struct vop_buf_args *args)
+{
+    struct tty *tp = args->vp->data;
+
+    return tty_read(tp, args->buffer, args->len);
+}
+
+static ssize_t
+tty_vop_write(struct vop_buf_args *args)
+{
+    struct tty *tp = args->vp->data;
+
+    return tty_write(tp, args->buffer, args->len);
+}
+
+void
+tty_input(struct tty *tp, char c)
+{
+    if (tp == NULL) {
+        return;
+    }
+
+    /* Nothing is waiting to take it, drop it */
+    if (!tty_ring_put(&tp->inq, c)) {
+        return;
+    }
+
+    softint_queue(&tp->work);
+}
+
+ssize_t
+tty_read(struct tty *tp, char *buf, size_t len)
+{
+    struct thread *self;
+    size_t n;
+    bool irq;
+    char c;
+
+    if (tp == NULL || buf == NULL) {
+        return -EINVAL;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    for (;;) {
+        irq = spinlock_acquire_irq(&tp->lock);
+
+        /* Canonical reads stop at the end of a line */
+        n = 0;
+        while (n < len && tty_ring_get(&tp->readq, &c)) {
+            buf[n++] = c;
+            if (c == '\n' && ISSET(tp->flags, TTY_ICANON)) {
+                break;
+            }
+        }
+
+        if (n > 0) {
+            spinlock_release_irq(&tp->lock, irq);
+            return n;
+        }
+
+        if ((self = cpu_self()->curthread) == NULL) {
+            spinlock_release_irq(&tp->lock, irq);
+            return -EAGAIN;
+        }
+
+        TAILQ_INSERT_TAIL(&tp->waiters, self, sleepq);
+        sched_sleep((uintptr_t)tp);
+        spinlock_release_irq(&tp->lock, irq);
+
+        /* System calls block on their way out and run again */
+        if (self->proc != &proc0) {
+            return -ERESTART;
+        }
+
+        sched_yield();
+    }
+}
+
+ssize_t
+tty_write(struct tty *tp, const char *buf, size_t len)
+{
+    if (tp == NULL || buf == NULL) {
+        return -EINVAL;
+    }
+
+    tp->output(buf, len);
+    return len;
+}
+
+void
+tty_setflags(struct tty *tp, uint32_t flags)
+{
+    if (tp == NULL) {
+        return;
+    }
+
+    tp->flags = flags;
+}
+
+int
+tty_attach(struct tty *tp)
+{
+    struct vnode *vp;
+    bool irq;
+    int error;
+
+    if (tp == NULL || tp->output == NULL) {
+        return -EINVAL;
+    }
+
+    if ((error = vnode_init(&vp, VCHR)) < 0) {
+        return error;
+    }
+
+    tp->inq.head = 0;
+    tp->inq.tail = 0;
+    tp->readq.head = 0;
+    tp->readq.tail = 0;
+    tp->linelen = 0;
+    spinlock_init("tty", &tp->lock);
+    TAILQ_INIT(&tp->waiters);
+
+    tp->work.func = tty_ldisc;
+    tp->work.arg = tp;
+    tp->work.queued = 0;
+
+    vp->data = tp;
+    vp->vops.read = tty_vop_read;
+    vp->vops.write = tty_vop_write;
+    tp->vp = vp;
+
+    irq = spinlock_acquire_irq(&tty_lock);
+    TAILQ_INSERT_TAIL(&tty_list, tp, link);
+    spinlock_release_irq(&tty_lock, irq);
+
+    dtrace("%s attached\n", tp->name);
+    return 0;
+}
+
+int
+tty_lookup(const char *name, struct tty **res)
+{
+    struct tty *iter, *tp = NULL;
+    bool irq;
+
+    if (name == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    irq = spinlock_acquire_irq(&tty_lock);
+    TAILQ_FOREACH(iter, &tty_list, link) {
+        if (strcmp(iter->name, name) == 0) {
+            tp = iter;
+            break;
+        }
+    }
+    spinlock_release_irq(&tty_lock, irq);
+
+    if (tp == NULL) {
+        return -ENOENT;
+    }
+
+    *res = tp;
+    return 0;
+}
+
+static void
+cons_output(const char *s, size_t len)
+{
+    if (g_bootcons.active) {
+        console_write(&g_bootcons, s, len);
+    }
+}
+
+void
+tty_init(void)
+{
+    spinlock_init("tty_list", &tty_lock);
+    TAILQ_INIT(&tty_list);
+
+    /* Framebuffer console */
+    memcpy(cons_tty.name, "console", sizeof("console"));
+    cons_tty.flags = TTY_ICANON | TTY_ECHO;
+    cons_tty.output = cons_output;
+    if (tty_attach(&cons_tty) < 0) {
+        dtrace("could not attach console\n");
+    }
+
+    /* COM1 */
+    memcpy(ser_tty.name, "ttyS0", sizeof("ttyS0"));
+    ser_tty.flags = TTY_ICANON | TTY_ECHO;
+    ser_tty.output = serial_write;
+    if (tty_attach(&ser_tty) < 0) {
+        dtrace("could not attach ttyS0\n");
+    }
+
+    mu_tty_attach();
+}
@@ -29,27 +29,121 @@
 
 #include <sys/errno.h>
 #include <sys/types.h>
+#include <sys/param.h>
 #include <dev/video/vram.h>
 #include <lib/limine.h>
-
-#define FRAMEBUFFER \
-        framebuffer_req.response->framebuffers[0]
+#include <lib/string.h>
 
 static volatile struct limine_framebuffer_request framebuffer_req = {
     .id = LIMINE_FRAMEBUFFER_REQUEST,
     .revision = 0
 };
 
+size_t
+vram_count(void)
+{
+    struct limine_framebuffer_response *resp;
+
+    if ((resp = framebuffer_req.response) == NULL) {
+        return 0;
+    }
+
+    return resp->framebuffer_count;
+}
+
 int
-vram_getdev(struct vram_dev *result)
+vram_getdev(size_t index, struct vram_dev *result)
 {
+    struct limine_framebuffer *fb;
+
     if (result == NULL) {
         return -EINVAL;
     }
 
-    result->io = FRAMEBUFFER->address;
-    result->width = FRAMEBUFFER->width;
-    result->height = FRAMEBUFFER->height;
-    result->pitch = FRAMEBUFFER->pitch;
+    if (index >= vram_count()) {
+        return -ENODEV;
+    }
+
+    fb = framebuffer_req.response->framebuffers[index];
+    if (fb->memory_model != LIMINE_FRAMEBUFFER_RGB) {
+        return -ENOTSUP;
+    }
+
+    switch (fb->bpp) {
+    case 16:
+    case 24:
+    case 32:
+        break;
+    default:
+        return -ENOTSUP;
+    }
+
+    result->io = fb->address;
+    result->width = fb->width;
+    result->height = fb->height;
+    result->pitch = fb->pitch;
+    result->bpp = fb->bpp;
+    result->red_size = fb->red_mask_size;
+    result->red_shift = fb->red_mask_shift;
+    result->green_size = fb->green_mask_size;
+    result->green_shift = fb->green_mask_shift;
+    result->blue_size = fb->blue_mask_size;
+    result->blue_shift = fb->blue_mask_shift;
+
+    /* Rows of these are plain copies */
+    result->native = fb->bpp == 32 &&
+        fb->red_mask_size == 8 && fb->red_mask_shift == 16 &&
+        fb->green_mask_size == 8 && fb->green_mask_shift == 8 &&
+        fb->blue_mask_size == 8 && fb->blue_mask_shift == 0;
     return 0;
 }
+
+void
+vram_write_row(struct vram_dev *vdp, size_t x, size_t y,
+    const uint32_t *src, size_t n)
+{
+    uint8_t *dst;
+    uint32_t px;
+
+    dst = vram_pixel(vdp, x, y);
+    if (vdp->native) {
+        memcpy(dst, src, n * sizeof(*src));
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        px = vram_color(vdp, src[i]);
+        switch (vdp->bpp) {
+        case 32:
+            ((uint32_t *)dst)[i] = px;
+            break;
+        case 24:
+            dst[i * 3 + 0] = px & 0xFF;
+            dst[i * 3 + 1] = (px >> 8) & 0xFF;
+            dst[i * 3 + 2] = (px >> 16) & 0xFF;
+            break;
+        case 16:
+            ((uint16_t *)dst)[i] = px;
+            break;
+        }
+    }
+}
+
+void
+vram_fill(struct vram_dev *vdp, size_t x, size_t y, size_t w,
+    size_t h, uint32_t rgb)
+{
+    uint32_t row[64];
+    size_t n;
+
+    for (size_t i = 0; i < NELEM(row); ++i) {
+        row[i] = rgb;
+    }
+
+    for (size_t cy = y; cy < y + h; ++cy) {
+        for (size_t cx = x; cx < x + w; cx += n) {
+            n = MIN(NELEM(row), x + w - cx);
+            vram_write_row(vdp, cx, cy, row, n);
+        }
+    }
+}
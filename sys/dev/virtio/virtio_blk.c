@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <dev/blk/blkdev.h>
+#include <dev/virtio/virtio.h>
+#include <dev/virtio/virtio_blk.h>
+#include <dev/pci/pci.h>
+#include <os/trace.h>
+#include <os/mmio.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("virtio_blk: " fmt, ##__VA_ARGS__)
+
+/* Completions reaped per lock hold */
+#define VBLK_REAP_BATCH 16
+
+/*
+ * Per request DMA state, the header and status byte
+ * must live in memory the device can reach.
+ *
+ * @hdr: Request header
+ * @status: Written by the device
+ * @breq: Block request being served
+ * @next: Free list link
+ */
+struct vblk_slot {
+    struct virtio_blk_hdr hdr;
+    volatile uint8_t status;
+    struct blk_req *breq;
+    struct vblk_slot *next;
+};
+
+/*
+ * A virtio block device
+ *
+ * @vdev: Virtio device
+ * @bdev: Block device registered with the block layer
+ * @freeslot: Free slot list of each queue
+ * @slots: Slot array of each queue
+ */
+struct vblk {
+    struct virtio_dev vdev;
+    struct blkdev bdev;
+    struct vblk_slot **freeslot;
+    struct vblk_slot **slots;
+};
+
+static uint16_t vblk_unit = 0;
+
+static int
+vblk_strategy(struct blkdev *bdp, struct blk_req *breq)
+{
+    struct vblk *vb = bdp->data;
+    struct virtqueue *vq = &vb->vdev.vqs[breq->queue->id];
+    struct virtq_buf bufs[BLK_MAXSEG + 2];
+    struct vblk_slot *slot;
+    uint16_t nbufs = 0;
+    bool irq;
+    int error;
+
+    if (breq->op == IO_OP_FLUSH && !ISSET(vb->vdev.features, VIRTIO_BLK_F_FLUSH)) {
+        /* No volatile cache to flush */
+        blkdev_done(breq, 0);
+        return 0;
+    }
+
+    irq = spinlock_acquire_irq(&vq->lock);
+    if ((slot = vb->freeslot[vq->index]) == NULL) {
+        spinlock_release_irq(&vq->lock, irq);
+        return -EAGAIN;
+    }
+
+    vb->freeslot[vq->index] = slot->next;
+    slot->breq = breq;
+    slot->status = VIRTIO_BLK_S_IOERR;
+    slot->hdr.reserved = 0;
+    slot->hdr.sector = breq->blkno * (bdp->sector_size / VIRTIO_BLK_SECTOR);
+    switch (breq->op) {
+    case IO_OP_READ:
+        slot->hdr.type = VIRTIO_BLK_T_IN;
+        break;
+    case IO_OP_WRITE:
+        slot->hdr.type = VIRTIO_BLK_T_OUT;
+        break;
+    case IO_OP_FLUSH:
+        slot->hdr.type = VIRTIO_BLK_T_FLUSH;
+        slot->hdr.sector = 0;
+        break;
+    }
+
+    bufs[nbufs++] = (struct virtq_buf){ &slot->hdr, sizeof(slot->hdr), 0 };
+    for (uint16_t i = 0; i < breq->nseg; ++i) {
+        bufs[nbufs++] = (struct virtq_buf){
+            breq->seg[i].buf,
+            breq->seg[i].len,
+            breq->op == IO_OP_READ
+        };
+    }
+    bufs[nbufs++] = (struct virtq_buf){ (void *)&slot->status, 1, 1 };
+
+    /* Published by vblk_commit() once the batch is in */
+    if ((error = virtq_add(vq, bufs, nbufs, slot)) < 0) {
+        slot->next = vb->freeslot[vq->index];
+        vb->freeslot[vq->index] = slot;
+    }
+
+    spinlock_release_irq(&vq->lock, irq);
+    return error;
+}
+
+static void
+vblk_commit(struct blkdev *bdp, struct blk_queue *q)
+{
+    struct vblk *vb = bdp->data;
+    struct virtqueue *vq = &vb->vdev.vqs[q->id];
+    bool irq;
+
+    irq = spinlock_acquire_irq(&vq->lock);
+    virtq_kick(vq);
+    spinlock_release_irq(&vq->lock, irq);
+}
+
+/*
+ * Reap every completed request on a queue, requests are
+ * completed with the queue unlocked since that may start
+ * more I/O on it.
+ */
+static void
+vblk_reap(struct vblk *vb, struct virtqueue *vq)
+{
+    struct blk_req *done[VBLK_REAP_BATCH];
+    int status[VBLK_REAP_BATCH];
+    struct vblk_slot *slot;
+    size_t ndone;
+    bool more, irq;
+
+    do {
+        ndone = 0;
+        irq = spinlock_acquire_irq(&vq->lock);
+        while (ndone < VBLK_REAP_BATCH) {
+            if ((slot = virtq_harvest(vq, NULL)) == NULL) {
+                break;
+            }
+
+            done[ndone] = slot->breq;
+            status[ndone++] = (slot->status == VIRTIO_BLK_S_OK) ? 0 : -EIO;
+            slot->next = vb->freeslot[vq->index];
+            vb->freeslot[vq->index] = slot;
+        }
+
+        more = (ndone == VBLK_REAP_BATCH) || virtq_rearm(vq);
+        spinlock_release_irq(&vq->lock, irq);
+
+        for (size_t i = 0; i < ndone; ++i) {
+            blkdev_done(done[i], status[i]);
+        }
+    } while (more);
+}
+
+static void
+vblk_poll(struct blkdev *bdp, struct blk_queue *q)
+{
+    struct vblk *vb = bdp->data;
+
+    vblk_reap(vb, &vb->vdev.vqs[q->id]);
+}
+
+/*
+ * Deferred completion work of a queue
+ */
+static void
+vblk_done(void *arg)
+{
+    struct virtqueue *vq = arg;
+
+    vblk_reap(vq->vdev->data, vq);
+}
+
+static struct blkdev_ops vblk_ops = {
+    .strategy = vblk_strategy,
+    .commit = vblk_commit,
+    .poll = vblk_poll
+};
+
+/*
+ * Give each queue a slot for every request the block
+ * layer may have in flight on it.
+ */
+static int
+vblk_init_slots(struct vblk *vb, uint16_t qdepth)
+{
+    struct vblk_slot *slots;
+    uint16_t nvq = vb->vdev.nvq;
+
+    vb->freeslot = kalloc(sizeof(*vb->freeslot) * nvq);
+    vb->slots = kalloc(sizeof(*vb->slots) * nvq);
+    if (vb->freeslot == NULL || vb->slots == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(vb->slots, 0, sizeof(*vb->slots) * nvq);
+    for (uint16_t i = 0; i < nvq; ++i) {
+        if ((slots = kalloc(sizeof(*slots) * qdepth)) == NULL) {
+            return -ENOMEM;
+        }
+
+        vb->slots[i] = slots;
+
+        vb->freeslot[i] = NULL;
+        for (uint16_t j = 0; j < qdepth; ++j) {
+            slots[j].next = vb->freeslot[i];
+            vb->freeslot[i] = &slots[j];
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Back out of a partial attach, anything not set up yet
+ * is zero.
+ *
+ * @vb: Device to free
+ */
+static void
+vblk_free(struct vblk *vb)
+{
+    uint16_t nvq = vb->vdev.nvq;
+
+    /* Reset the device before the slots it may use go away */
+    virtio_detach(&vb->vdev);
+    if (vb->slots != NULL) {
+        for (uint16_t i = 0; i < nvq; ++i) {
+            kfree(vb->slots[i]);
+        }
+    }
+
+    kfree(vb->slots);
+    kfree(vb->freeslot);
+    kfree(vb);
+}
+
+static int
+vblk_attach(struct pci_device *pci)
+{
+    volatile struct virtio_blk_config *cfg;
+    struct vblk *vb;
+    struct blkdev *bdp;
+    uint64_t want;
+    uint16_t nvq, nmsix, qdepth = 0xFFFF;
+    uint32_t ssize = VIRTIO_BLK_SECTOR;
+    int error;
+
+    if ((vb = kalloc(sizeof(*vb))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(vb, 0, sizeof(*vb));
+    want = VIRTIO_F_EVENT_IDX | VIRTIO_BLK_F_BLK_SIZE |
+        VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_MQ;
+    if ((error = virtio_attach(&vb->vdev, pci, want)) < 0) {
+        kfree(vb);
+        return error;
+    }
+
+    if ((cfg = vb->vdev.devcfg) == NULL) {
+        vblk_free(vb);
+        return -ENODEV;
+    }
+
+    /* One queue per core, each with its own vector */
+    vb->vdev.data = vb;
+    nvq = cpu_count();
+    if (ISSET(vb->vdev.features, VIRTIO_BLK_F_MQ)) {
+        nvq = MIN(nvq, mmio_read16(&cfg->num_queues));
+    } else {
+        nvq = 1;
+    }
+
+    nmsix = pci_msix_count(pci);
+    if (nmsix > 0) {
+        nvq = MIN(nvq, nmsix);
+    }
+
+    if ((error = virtio_setup_queues(&vb->vdev, MAX(nvq, 1), vblk_done)) < 0) {
+        vblk_free(vb);
+        return error;
+    }
+
+    /* Worst case every request takes a maximal chain */
+    for (uint16_t i = 0; i < vb->vdev.nvq; ++i) {
+        qdepth = MIN(qdepth, vb->vdev.vqs[i].size / (BLK_MAXSEG + 2));
+    }
+
+    qdepth = MAX(qdepth, 1);
+    if ((error = vblk_init_slots(vb, qdepth)) < 0) {
+        vblk_free(vb);
+        return error;
+    }
+
+    if (ISSET(vb->vdev.features, VIRTIO_BLK_F_BLK_SIZE)) {
+        ssize = mmio_read32(&cfg->blk_size);
+    }
+
+    bdp = &vb->bdev;
+    snprintf(bdp->name, sizeof(bdp->name), "vbd%d", vblk_unit++);
+    bdp->sector_size = ssize;
+    bdp->nsectors = (mmio_read64(&cfg->capacity) * VIRTIO_BLK_SECTOR) / ssize;
+    bdp->ops = &vblk_ops;
+    bdp->nqueues = vb->vdev.nvq;
+    bdp->qdepth = qdepth;
+    bdp->data = vb;
+
+    virtio_ready(&vb->vdev);
+    if ((error = blkdev_register(bdp)) < 0) {
+        vblk_free(vb);
+        return error;
+    }
+
+    dtrace(
+        "%s: %d queue(s), %s completion, event index %s\n",
+        bdp->name, vb->vdev.nvq,
+        vb->vdev.msix ? "MSI-X" : "polled",
+        ISSET(vb->vdev.features, VIRTIO_F_EVENT_IDX) ? "on" : "off"
+    );
+    return 0;
+}
+
+void
+virtio_blk_init(void)
+{
+    struct pci_device *pci = NULL;
+    int error;
+
+    while ((pci = pci_find(VIRTIO_VENDOR, 0xFFFF, pci)) != NULL) {
+        if (pci->device != VIRTIO_BLK_DEVICE &&
+            pci->device != VIRTIO_BLK_DEVICE_TRANS) {
+            continue;
+        }
+
+        if ((error = vblk_attach(pci)) < 0) {
+            dtrace("%x:%x.%x: attach failed (%d)\n",
+                pci->bus, pci->slot, pci->func, error);
+        }
+    }
+}
@@ -0,0 +1,616 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <kern/spinlock.h>
+#include <dev/virtio/virtio.h>
+#include <dev/virtio/virtio_net.h>
+#include <dev/pci/pci.h>
+#include <net/if.h>
+#include <os/trace.h>
+#include <os/mmio.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+#define dtrace(fmt, ...) trace("virtio_net: " fmt, ##__VA_ARGS__)
+
+/* Max parts of an outgoing frame */
+#define VNET_MAXSEG     16
+
+/* Frames handled per lock hold */
+#define VNET_BATCH      32
+
+/*
+ * A receive queue and its buffer pool, every buffer is
+ * posted to the device up front and reposted as soon as
+ * the consumer gives it back.
+ *
+ * @vq: Virtqueue
+ * @pkts: Packet of each buffer
+ * @pool: Buffer pool
+ * @pool_phys: Physical base of the pool
+ * @nbufs: Number of buffers
+ */
+struct vnet_rxq {
+    struct virtqueue *vq;
+    struct netif_pkt *pkts;
+    void *pool;
+    uintptr_t pool_phys;
+    uint16_t nbufs;
+};
+
+/*
+ * Completion record of a transmitted frame
+ */
+struct vnet_txrec {
+    netif_txdone_t done;
+    void *arg;
+    struct vnet_txrec *next;
+};
+
+/*
+ * A transmit queue, finished frames are reclaimed from
+ * its own vector if it got one, otherwise on the next
+ * send, receive or poll.
+ *
+ * @vq: Virtqueue
+ * @recs: Completion records
+ * @freerec: Free record list
+ */
+struct vnet_txq {
+    struct virtqueue *vq;
+    struct vnet_txrec *recs;
+    struct vnet_txrec *freerec;
+};
+
+/*
+ * A virtio network device
+ *
+ * @vdev: Virtio device
+ * @nif: Network interface
+ * @npairs: Queue pairs in use
+ * @rxq: Receive queues
+ * @txq: Transmit queues
+ * @txhdr: Header sent with every frame [all zero]
+ * @ctrl: Control virtqueue [NULL if none]
+ */
+struct vnet {
+    struct virtio_dev vdev;
+    struct netif nif;
+    uint16_t npairs;
+    struct vnet_rxq *rxq;
+    struct vnet_txq *txq;
+    struct virtio_net_hdr *txhdr;
+    struct virtqueue *ctrl;
+};
+
+static uint16_t vnet_unit = 0;
+
+/*
+ * Post a receive buffer to the device
+ *
+ * XXX: Queue must be locked
+ */
+static int
+vnet_rx_post(struct vnet_rxq *rxq, struct netif_pkt *pkt)
+{
+    struct virtq_buf buf;
+
+    buf.addr = pkt->priv;
+    buf.len = VIRTIO_NET_RXBUF_SIZE;
+    buf.write = 1;
+    return virtq_add(rxq->vq, &buf, 1, pkt);
+}
+
+/*
+ * Reap received frames and hand them up, they are
+ * delivered on this core with the queue unlocked.
+ */
+static void
+vnet_rx_reap(struct vnet *vn, struct vnet_rxq *rxq)
+{
+    struct netif_pkt *pkts[VNET_BATCH], *pkt;
+    struct virtqueue *vq = rxq->vq;
+    uint32_t len;
+    size_t npkt;
+    bool more, irq;
+
+    do {
+        npkt = 0;
+        irq = spinlock_acquire_irq(&vq->lock);
+        while (npkt < VNET_BATCH) {
+            if ((pkt = virtq_harvest(vq, &len)) == NULL) {
+                break;
+            }
+
+            len -= MIN(len, sizeof(struct virtio_net_hdr));
+            pkt->data = PTR_OFFSET(pkt->priv, sizeof(struct virtio_net_hdr));
+            pkt->len = len;
+            if (len < ETHER_HDR_LEN) {
+                vnet_rx_post(rxq, pkt);
+                __atomic_fetch_add(&vn->nif.stat.idrops, 1, __ATOMIC_RELAXED);
+                continue;
+            }
+
+            pkts[npkt++] = pkt;
+        }
+
+        virtq_kick(vq);
+        more = (npkt == VNET_BATCH) || virtq_rearm(vq);
+        spinlock_release_irq(&vq->lock, irq);
+
+        for (size_t i = 0; i < npkt; ++i) {
+            netif_input(pkts[i]);
+        }
+    } while (more);
+}
+
+/*
+ * Reclaim frames the device is done with and run their
+ * completions, at most one batch per call.
+ *
+ * Returns true if more are left
+ */
+static bool
+vnet_tx_reclaim(struct vnet_txq *txq)
+{
+    struct vnet_txrec done[VNET_BATCH];
+    struct vnet_txrec *rec;
+    size_t ndone = 0;
+    bool more, irq;
+
+    irq = spinlock_acquire_irq(&txq->vq->lock);
+    while (ndone < VNET_BATCH) {
+        if ((rec = virtq_harvest(txq->vq, NULL)) == NULL) {
+            break;
+        }
+
+        done[ndone++] = *rec;
+        rec->next = txq->freerec;
+        txq->freerec = rec;
+    }
+
+    more = (ndone == VNET_BATCH) || virtq_rearm(txq->vq);
+    spinlock_release_irq(&txq->vq->lock, irq);
+
+    for (size_t i = 0; i < ndone; ++i) {
+        if (done[i].done != NULL) {
+            done[i].done(done[i].arg, 0);
+        }
+    }
+
+    return more;
+}
+
+static int
+vnet_transmit(struct netif *nif, uint16_t txqi, struct netif_iov *iov,
+    uint16_t niov, netif_txdone_t done, void *arg)
+{
+    struct vnet *vn = nif->data;
+    struct vnet_txq *txq = &vn->txq[txqi];
+    struct virtq_buf bufs[VNET_MAXSEG + 1];
+    struct vnet_txrec *rec;
+    bool irq;
+    int error;
+
+    if (niov > VNET_MAXSEG) {
+        return -EINVAL;
+    }
+
+    /* Zero-copy, the device reads straight from the caller */
+    bufs[0] = (struct virtq_buf){ vn->txhdr, sizeof(*vn->txhdr), 0 };
+    for (uint16_t i = 0; i < niov; ++i) {
+        bufs[i + 1] = (struct virtq_buf){ iov[i].base, iov[i].len, 0 };
+    }
+
+    vnet_tx_reclaim(txq);
+    irq = spinlock_acquire_irq(&txq->vq->lock);
+    if ((rec = txq->freerec) == NULL) {
+        spinlock_release_irq(&txq->vq->lock, irq);
+        return -EAGAIN;
+    }
+
+    rec->done = done;
+    rec->arg = arg;
+    if ((error = virtq_add(txq->vq, bufs, niov + 1, rec)) < 0) {
+        spinlock_release_irq(&txq->vq->lock, irq);
+        return error;
+    }
+
+    txq->freerec = rec->next;
+    virtq_kick(txq->vq);
+    spinlock_release_irq(&txq->vq->lock, irq);
+    return 0;
+}
+
+static void
+vnet_rxfree(struct netif *nif, struct netif_pkt *pkt)
+{
+    struct vnet *vn = nif->data;
+    struct vnet_rxq *rxq = &vn->rxq[pkt->rxq];
+    bool irq;
+
+    irq = spinlock_acquire_irq(&rxq->vq->lock);
+    vnet_rx_post(rxq, pkt);
+    virtq_kick(rxq->vq);
+    spinlock_release_irq(&rxq->vq->lock, irq);
+}
+
+static void
+vnet_poll(struct netif *nif)
+{
+    struct vnet *vn = nif->data;
+
+    for (uint16_t i = 0; i < vn->npairs; ++i) {
+        vnet_rx_reap(vn, &vn->rxq[i]);
+        vnet_tx_reclaim(&vn->txq[i]);
+    }
+}
+
+/*
+ * Deferred receive work of a queue, the transmit queue
+ * of the pair is reclaimed too in case it has no vector.
+ */
+static void
+vnet_rxdone(void *arg)
+{
+    struct virtqueue *vq = arg;
+    struct vnet *vn = vq->vdev->data;
+
+    vnet_rx_reap(vn, &vn->rxq[vq->index / 2]);
+    vnet_tx_reclaim(&vn->txq[vq->index / 2]);
+}
+
+/*
+ * Deferred transmit work of a queue
+ */
+static void
+vnet_txdone(void *arg)
+{
+    struct virtqueue *vq = arg;
+    struct vnet *vn = vq->vdev->data;
+
+    while (vnet_tx_reclaim(&vn->txq[vq->index / 2]));
+}
+
+static struct netif_ops vnet_ops = {
+    .transmit = vnet_transmit,
+    .rxfree = vnet_rxfree,
+    .poll = vnet_poll
+};
+
+/*
+ * Carve the buffer pool of a receive queue out of
+ * dedicated pages and post all of it.
+ */
+static int
+vnet_rxq_init(struct vnet *vn, uint16_t index)
+{
+    struct vnet_rxq *rxq = &vn->rxq[index];
+    struct netif_pkt *pkt;
+    size_t npages;
+
+    rxq->vq = &vn->vdev.vqs[index * 2];
+    rxq->nbufs = rxq->vq->size;
+    npages = ALIGN_UP(rxq->nbufs * VIRTIO_NET_RXBUF_SIZE, PAGESIZE) / PAGESIZE;
+    if ((rxq->pool_phys = vm_phys_alloc(npages)) == 0) {
+        return -ENOMEM;
+    }
+
+    rxq->pool = PHYS_TO_VIRT(rxq->pool_phys);
+    rxq->pkts = kalloc(sizeof(*rxq->pkts) * rxq->nbufs);
+    if (rxq->pkts == NULL) {
+        return -ENOMEM;
+    }
+
+    for (uint16_t i = 0; i < rxq->nbufs; ++i) {
+        pkt = &rxq->pkts[i];
+        memset(pkt, 0, sizeof(*pkt));
+        pkt->nif = &vn->nif;
+        pkt->rxq = index;
+        pkt->priv = PTR_OFFSET(rxq->pool, i * VIRTIO_NET_RXBUF_SIZE);
+        vnet_rx_post(rxq, pkt);
+    }
+
+    return 0;
+}
+
+static int
+vnet_txq_init(struct vnet *vn, uint16_t index)
+{
+    struct vnet_txq *txq = &vn->txq[index];
+    struct vnet_txrec *rec;
+
+    txq->vq = &vn->vdev.vqs[index * 2 + 1];
+    txq->recs = kalloc(sizeof(*txq->recs) * txq->vq->size);
+    if (txq->recs == NULL) {
+        return -ENOMEM;
+    }
+
+    txq->freerec = NULL;
+    for (uint16_t i = 0; i < txq->vq->size; ++i) {
+        rec = &txq->recs[i];
+        rec->next = txq->freerec;
+        txq->freerec = rec;
+    }
+
+    return 0;
+}
+
+/*
+ * Tell the device how many queue pairs to use, the
+ * control queue is polled since this only runs once.
+ */
+static int
+vnet_set_pairs(struct vnet *vn, uint16_t npairs)
+{
+    struct virtio_net_ctrl *ctrl;
+    struct virtq_buf bufs[3];
+    struct virtqueue *vq = vn->ctrl;
+    bool irq;
+    int error;
+
+    if ((ctrl = kalloc(sizeof(*ctrl))) == NULL) {
+        return -ENOMEM;
+    }
+
+    ctrl->class = VIRTIO_NET_CTRL_MQ;
+    ctrl->cmd = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    ctrl->pairs = npairs;
+    ctrl->ack = 0xFF;
+    bufs[0] = (struct virtq_buf){ &ctrl->class, 2, 0 };
+    bufs[1] = (struct virtq_buf){ &ctrl->pairs, 2, 0 };
+    bufs[2] = (struct virtq_buf){ &ctrl->ack, 1, 1 };
+
+    irq = spinlock_acquire_irq(&vq->lock);
+    if ((error = virtq_add(vq, bufs, 3, ctrl)) == 0) {
+        virtq_kick(vq);
+        while (virtq_harvest(vq, NULL) == NULL) {
+            cpu_pause();
+        }
+    }
+    spinlock_release_irq(&vq->lock, irq);
+
+    if (error == 0 && ctrl->ack != VIRTIO_NET_OK) {
+        error = -EIO;
+    }
+
+    kfree(ctrl);
+    return error;
+}
+
+/*
+ * Set up 'npairs' queue pairs, each pair lands on its own
+ * core. Transmit queues only get a vector while there are
+ * enough to go around.
+ */
+static int
+vnet_setup_queues(struct vnet *vn, uint16_t maxpairs, uint16_t npairs,
+    bool has_ctrl)
+{
+    struct virtio_dev *vdev = &vn->vdev;
+    struct cpu_info *ci;
+    uint16_t ctrl_idx = maxpairs * 2;
+    int error;
+
+    error = virtio_alloc_queues(vdev, ctrl_idx + has_ctrl);
+    if (error < 0) {
+        return error;
+    }
+
+    /* Receive queues go first so they get the vectors */
+    for (uint16_t i = 0; i < npairs; ++i) {
+        if ((ci = cpu_get(i % cpu_count())) == NULL) {
+            ci = cpu_self();
+        }
+
+        if ((error = virtio_setup_queue(vdev, i * 2, vnet_rxdone, ci)) < 0) {
+            return error;
+        }
+    }
+
+    for (uint16_t i = 0; i < npairs; ++i) {
+        ci = vdev->vqs[i * 2].ci;
+        error = virtio_setup_queue(vdev, i * 2 + 1, vnet_txdone, ci);
+        if (error < 0) {
+            return error;
+        }
+    }
+
+    if (has_ctrl) {
+        if ((error = virtio_setup_queue(vdev, ctrl_idx, NULL, NULL)) < 0) {
+            return error;
+        }
+
+        vn->ctrl = &vdev->vqs[ctrl_idx];
+    }
+
+    return 0;
+}
+
+/*
+ * Back out of a partial attach, anything not set up yet
+ * is zero.
+ *
+ * @vn: Device to free
+ * @npairs: Number of queue pairs allocated
+ */
+static void
+vnet_free(struct vnet *vn, uint16_t npairs)
+{
+    struct vnet_rxq *rxq;
+    size_t npages;
+
+    virtio_detach(&vn->vdev);
+    for (uint16_t i = 0; i < npairs; ++i) {
+        rxq = &vn->rxq[i];
+        if (rxq->pool_phys != 0) {
+            npages = ALIGN_UP(rxq->nbufs * VIRTIO_NET_RXBUF_SIZE, PAGESIZE);
+            vm_phys_free(rxq->pool_phys, npages / PAGESIZE);
+        }
+
+        kfree(rxq->pkts);
+        kfree(vn->txq[i].recs);
+    }
+
+    kfree(vn->rxq);
+    kfree(vn->txq);
+    kfree(vn->txhdr);
+    kfree(vn);
+}
+
+static int
+vnet_attach(struct pci_device *pci)
+{
+    volatile struct virtio_net_config *cfg;
+    struct vnet *vn;
+    struct netif *nif;
+    uint64_t want;
+    uint16_t maxpairs = 1, npairs = 1, nmsix;
+    bool has_ctrl, irq;
+    int error;
+
+    if ((vn = kalloc(sizeof(*vn))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(vn, 0, sizeof(*vn));
+    want = VIRTIO_F_EVENT_IDX | VIRTIO_NET_F_MTU | VIRTIO_NET_F_MAC |
+        VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ;
+    if ((error = virtio_attach(&vn->vdev, pci, want)) < 0) {
+        kfree(vn);
+        return error;
+    }
+
+    if ((cfg = vn->vdev.devcfg) == NULL) {
+        vnet_free(vn, 0);
+        return -ENODEV;
+    }
+
+    /* One pair per core, each receive queue with its own vector */
+    vn->vdev.data = vn;
+    has_ctrl = ISSET(vn->vdev.features, VIRTIO_NET_F_CTRL_VQ) != 0;
+    if (has_ctrl && ISSET(vn->vdev.features, VIRTIO_NET_F_MQ)) {
+        maxpairs = MAX(mmio_read16(&cfg->max_virtqueue_pairs), 1);
+        npairs = MIN(maxpairs, cpu_count());
+    }
+
+    if ((nmsix = pci_msix_count(pci)) > 0) {
+        npairs = MIN(npairs, nmsix);
+    }
+
+    if ((error = vnet_setup_queues(vn, maxpairs, npairs, has_ctrl)) < 0) {
+        vnet_free(vn, 0);
+        return error;
+    }
+
+    vn->rxq = kalloc(sizeof(*vn->rxq) * npairs);
+    vn->txq = kalloc(sizeof(*vn->txq) * npairs);
+    vn->txhdr = kalloc(sizeof(*vn->txhdr));
+    if (vn->rxq == NULL || vn->txq == NULL || vn->txhdr == NULL) {
+        vnet_free(vn, 0);
+        return -ENOMEM;
+    }
+
+    memset(vn->rxq, 0, sizeof(*vn->rxq) * npairs);
+    memset(vn->txq, 0, sizeof(*vn->txq) * npairs);
+    memset(vn->txhdr, 0, sizeof(*vn->txhdr));
+    vn->npairs = npairs;
+    for (uint16_t i = 0; i < npairs; ++i) {
+        if ((error = vnet_rxq_init(vn, i)) < 0) {
+            vnet_free(vn, npairs);
+            return error;
+        }
+
+        if ((error = vnet_txq_init(vn, i)) < 0) {
+            vnet_free(vn, npairs);
+            return error;
+        }
+    }
+
+    virtio_ready(&vn->vdev);
+    for (uint16_t i = 0; i < npairs; ++i) {
+        irq = spinlock_acquire_irq(&vn->rxq[i].vq->lock);
+        virtq_kick(vn->rxq[i].vq);
+        spinlock_release_irq(&vn->rxq[i].vq->lock, irq);
+    }
+
+    if (npairs > 1 && vnet_set_pairs(vn, npairs) < 0) {
+        dtrace("device refused %d queue pairs\n", npairs);
+        vn->npairs = 1;
+    }
+
+    nif = &vn->nif;
+    snprintf(nif->name, sizeof(nif->name), "vnet%d", vnet_unit++);
+    if (ISSET(vn->vdev.features, VIRTIO_NET_F_MAC)) {
+        for (uint8_t i = 0; i < ETHER_ADDR_LEN; ++i) {
+            nif->hwaddr[i] = mmio_read8(&cfg->mac[i]);
+        }
+    }
+
+    nif->mtu = IF_MTU;
+    if (ISSET(vn->vdev.features, VIRTIO_NET_F_MTU)) {
+        nif->mtu = MIN(mmio_read16(&cfg->mtu), IF_MTU);
+    }
+
+    nif->nqueues = vn->npairs;
+    nif->ops = &vnet_ops;
+    nif->data = vn;
+    if ((error = netif_register(nif)) < 0) {
+        vnet_free(vn, npairs);
+        return error;
+    }
+
+    return 0;
+}
+
+void
+virtio_net_init(void)
+{
+    struct pci_device *pci = NULL;
+    int error;
+
+    while ((pci = pci_find(VIRTIO_VENDOR, 0xFFFF, pci)) != NULL) {
+        if (pci->device != VIRTIO_NET_DEVICE &&
+            pci->device != VIRTIO_NET_DEVICE_TRANS) {
+            continue;
+        }
+
+        if ((error = vnet_attach(pci)) < 0) {
+            dtrace("%x:%x.%x: attach failed (%d)\n",
+                pci->bus, pci->slot, pci->func, error);
+        }
+    }
+}
@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/virtio/virtio.h>
+#include <dev/pci/pci.h>
+#include <dev/pci/pcireg.h>
+#include <os/trace.h>
+#include <os/intr.h>
+#include <os/mmio.h>
+#include <os/softint.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("virtio: " fmt, ##__VA_ARGS__)
+
+/* Upper bound on descriptors per queue */
+#define VIRTQ_MAX_SIZE  256
+
+/* Offsets within a virtio PCI capability */
+#define VIRTIO_CAP_TYPE         3
+#define VIRTIO_CAP_BAR          4
+#define VIRTIO_CAP_OFFSET       8
+#define VIRTIO_CAP_NOTIFY_MUL   16
+
+#define COMMON(VDEV, FIELD) (&(VDEV)->common->FIELD)
+
+/*
+ * Map the structure a virtio vendor capability points to
+ */
+static int
+virtio_map_cap(struct pci_device *pci, uint8_t cap, volatile void **res)
+{
+    uint8_t bar;
+    uint32_t off;
+    void *va;
+    int error;
+
+    bar = pci_readb(pci, cap + VIRTIO_CAP_BAR);
+    off = pci_readl(pci, cap + VIRTIO_CAP_OFFSET);
+    if ((error = pci_map_bar(pci, bar, &va)) < 0) {
+        return error;
+    }
+
+    *res = PTR_OFFSET(va, off);
+    return 0;
+}
+
+/*
+ * Locate and map the configuration structures of a
+ * modern virtio device, the first one of each type wins.
+ */
+static int
+virtio_find_caps(struct virtio_dev *vdev)
+{
+    struct pci_device *pci = vdev->pci;
+    volatile void *va[VIRTIO_PCI_CAP_DEVICE + 1] = { NULL };
+    uint8_t cap = 0, type;
+    int error;
+
+    while ((cap = pci_find_cap(pci, PCI_CAP_VENDOR, cap)) != 0) {
+        type = pci_readb(pci, cap + VIRTIO_CAP_TYPE);
+        if (type < VIRTIO_PCI_CAP_COMMON || type > VIRTIO_PCI_CAP_DEVICE) {
+            continue;
+        }
+
+        if (va[type] != NULL) {
+            continue;
+        }
+
+        if ((error = virtio_map_cap(pci, cap, &va[type])) < 0) {
+            return error;
+        }
+
+        if (type == VIRTIO_PCI_CAP_NOTIFY) {
+            vdev->notify_mul = pci_readl(pci, cap + VIRTIO_CAP_NOTIFY_MUL);
+        }
+    }
+
+    vdev->common = va[VIRTIO_PCI_CAP_COMMON];
+    vdev->notify_base = va[VIRTIO_PCI_CAP_NOTIFY];
+    vdev->isr = va[VIRTIO_PCI_CAP_ISR];
+    vdev->devcfg = va[VIRTIO_PCI_CAP_DEVICE];
+
+    /* Legacy only devices are not supported */
+    if (vdev->common == NULL || vdev->notify_base == NULL) {
+        return -ENOTSUP;
+    }
+
+    return 0;
+}
+
+static void
+virtio_set_status(struct virtio_dev *vdev, uint8_t bits)
+{
+    uint8_t status;
+
+    status = mmio_read8(COMMON(vdev, device_status));
+    mmio_write8(COMMON(vdev, device_status), status | bits);
+}
+
+/*
+ * Reset the device and wait for it to come back, it
+ * stops using every queue.
+ */
+static void
+virtio_reset(struct virtio_dev *vdev)
+{
+    mmio_write8(COMMON(vdev, device_status), 0);
+    while (mmio_read8(COMMON(vdev, device_status)) != 0) {
+        cpu_pause();
+    }
+}
+
+int
+virtio_attach(struct virtio_dev *vdev, struct pci_device *pci, uint64_t want)
+{
+    uint64_t features;
+    int error;
+
+    if (vdev == NULL || pci == NULL) {
+        return -EINVAL;
+    }
+
+    memset(vdev, 0, sizeof(*vdev));
+    vdev->pci = pci;
+    pci_enable(pci, PCI_CMD_MEMEN | PCI_CMD_BMEN);
+    if ((error = virtio_find_caps(vdev)) < 0) {
+        return error;
+    }
+
+    virtio_reset(vdev);
+    virtio_set_status(vdev, VIRTIO_ACKNOWLEDGE | VIRTIO_DRIVER);
+    mmio_write32(COMMON(vdev, device_feature_select), 0);
+    features = mmio_read32(COMMON(vdev, device_feature));
+    mmio_write32(COMMON(vdev, device_feature_select), 1);
+    features |= (uint64_t)mmio_read32(COMMON(vdev, device_feature)) << 32;
+
+    features &= want | VIRTIO_F_VERSION_1;
+    if (!ISSET(features, VIRTIO_F_VERSION_1)) {
+        virtio_set_status(vdev, VIRTIO_FAILED);
+        return -ENOTSUP;
+    }
+
+    mmio_write32(COMMON(vdev, driver_feature_select), 0);
+    mmio_write32(COMMON(vdev, driver_feature), features & 0xFFFFFFFF);
+    mmio_write32(COMMON(vdev, driver_feature_select), 1);
+    mmio_write32(COMMON(vdev, driver_feature), features >> 32);
+    virtio_set_status(vdev, VIRTIO_FEATURES_OK);
+
+    if (!ISSET(mmio_read8(COMMON(vdev, device_status)), VIRTIO_FEATURES_OK)) {
+        virtio_set_status(vdev, VIRTIO_FAILED);
+        return -ENOTSUP;
+    }
+
+    vdev->features = features;
+    return 0;
+}
+
+static int
+virtq_intr(void *arg)
+{
+    struct virtqueue *vq = arg;
+
+    /* Completions are reaped outside of hard interrupt context */
+    softint_queue(&vq->work);
+    return INTR_HANDLED;
+}
+
+/*
+ * Allocate the rings of a virtqueue and thread every
+ * descriptor onto the free list.
+ */
+static int
+virtq_alloc(struct virtqueue *vq, uint16_t size)
+{
+    size_t avail_off, used_off, len;
+    void *base;
+
+    avail_off = sizeof(struct virtq_desc) * size;
+    used_off = ALIGN_UP(avail_off + 6 + (2 * size), 4);
+    len = used_off + 6 + (sizeof(struct virtq_used_elem) * size);
+
+    vq->npages = ALIGN_UP(len, PAGESIZE) / PAGESIZE;
+    if ((vq->phys = vm_phys_alloc(vq->npages)) == 0) {
+        return -ENOMEM;
+    }
+
+    vq->cookie = kalloc(sizeof(void *) * size);
+    if (vq->cookie == NULL) {
+        vm_phys_free(vq->phys, vq->npages);
+        return -ENOMEM;
+    }
+
+    base = PHYS_TO_VIRT(vq->phys);
+    memset(base, 0, vq->npages * PAGESIZE);
+    vq->desc = base;
+    vq->avail = PTR_OFFSET(base, avail_off);
+    vq->used = PTR_OFFSET(base, used_off);
+    vq->size = size;
+    vq->nfree = size;
+    vq->free_head = 0;
+    for (uint16_t i = 0; i < size - 1; ++i) {
+        vq->desc[i].next = i + 1;
+    }
+
+    return 0;
+}
+
+int
+virtio_alloc_queues(struct virtio_dev *vdev, uint16_t nvq)
+{
+    if (vdev == NULL || nvq == 0) {
+        return -EINVAL;
+    }
+
+    if (nvq > mmio_read16(COMMON(vdev, num_queues))) {
+        return -ENODEV;
+    }
+
+    vdev->vqs = kalloc(sizeof(*vdev->vqs) * nvq);
+    if (vdev->vqs == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(vdev->vqs, 0, sizeof(*vdev->vqs) * nvq);
+    vdev->nvq = nvq;
+    mmio_write16(COMMON(vdev, msix_config), VIRTIO_MSI_NO_VECTOR);
+    return 0;
+}
+
+int
+virtio_setup_queue(struct virtio_dev *vdev, uint16_t index,
+    void(*done)(void *vq), struct cpu_info *ci)
+{
+    struct virtqueue *vq;
+    uint16_t size, notify_off, vec;
+    int error;
+
+    if (vdev == NULL || index >= vdev->nvq) {
+        return -EINVAL;
+    }
+
+    vq = &vdev->vqs[index];
+    mmio_write16(COMMON(vdev, queue_select), index);
+    size = mmio_read16(COMMON(vdev, queue_size));
+    if (size == 0) {
+        return -ENODEV;
+    }
+
+    /* Split rings want a power of two */
+    size = MIN(size, VIRTQ_MAX_SIZE);
+    while ((size & (size - 1)) != 0) {
+        size &= size - 1;
+    }
+
+    memset(vq, 0, sizeof(*vq));
+    vq->vdev = vdev;
+    vq->index = index;
+    if ((error = spinlock_init("virtq", &vq->lock)) < 0) {
+        return error;
+    }
+
+    if ((error = virtq_alloc(vq, size)) < 0) {
+        return error;
+    }
+
+    vq->work.func = done;
+    vq->work.arg = vq;
+    vq->ih.name = "virtq";
+    vq->ih.func = virtq_intr;
+    vq->ih.arg = vq;
+
+    mmio_write16(COMMON(vdev, queue_size), size);
+    mmio_write64(COMMON(vdev, queue_desc), vq->phys);
+    mmio_write64(COMMON(vdev, queue_driver), VIRT_TO_PHYS(vq->avail));
+    mmio_write64(COMMON(vdev, queue_device), VIRT_TO_PHYS(vq->used));
+
+    notify_off = mmio_read16(COMMON(vdev, queue_notify_off));
+    vq->notify = PTR_OFFSET(vdev->notify_base, notify_off * vdev->notify_mul);
+
+    /* Out of vectors means the driver polls this one */
+    vec = VIRTIO_MSI_NO_VECTOR;
+    if (ci != NULL && done != NULL && vdev->nvec < pci_msix_count(vdev->pci)) {
+        vec = vdev->nvec;
+        error = pci_msix_establish(vdev->pci, vec, &vq->ih, ci);
+        if (error < 0) {
+            return error;
+        }
+
+        ++vdev->nvec;
+        vdev->msix = 1;
+        vq->intr = 1;
+        vq->ci = ci;
+        vq->msix = vec;
+    }
+
+    mmio_write16(COMMON(vdev, queue_msix_vector), vec);
+    if (mmio_read16(COMMON(vdev, queue_msix_vector)) != vec) {
+        dtrace("queue %d: could not bind MSI-X vector\n", index);
+        return -EIO;
+    }
+
+    mmio_write16(COMMON(vdev, queue_enable), 1);
+    return 0;
+}
+
+int
+virtio_setup_queues(struct virtio_dev *vdev, uint16_t nvq,
+    void(*done)(void *vq))
+{
+    struct cpu_info *ci;
+    int error;
+
+    if (done == NULL) {
+        return -EINVAL;
+    }
+
+    if ((error = virtio_alloc_queues(vdev, nvq)) < 0) {
+        return error;
+    }
+
+    /*
+     * Each queue gets its own vector on its own core so that
+     * completions land on the core that submitted them.
+     */
+    for (uint16_t i = 0; i < nvq; ++i) {
+        if ((ci = cpu_get(i % cpu_count())) == NULL) {
+            ci = cpu_self();
+        }
+
+        if ((error = virtio_setup_queue(vdev, i, done, ci)) < 0) {
+            virtio_set_status(vdev, VIRTIO_FAILED);
+            return error;
+        }
+    }
+
+    return 0;
+}
+
+void
+virtio_ready(struct virtio_dev *vdev)
+{
+    virtio_set_status(vdev, VIRTIO_DRIVER_OK);
+}
+
+void
+virtio_detach(struct virtio_dev *vdev)
+{
+    struct virtqueue *vq;
+
+    if (vdev == NULL) {
+        return;
+    }
+
+    /*
+     * Stop the device before its rings go away, after a reset
+     * it no longer touches them or raises interrupts.
+     *
+     * XXX: Completion work already queued by an interrupt on
+     *      another processor is not waited for.
+     */
+    virtio_reset(vdev);
+    for (uint16_t i = 0; i < vdev->nvq; ++i) {
+        vq = &vdev->vqs[i];
+        if (vq->intr) {
+            pci_msix_disestablish(vdev->pci, vq->msix, &vq->ih, vq->ci);
+            vq->intr = 0;
+        }
+
+        if (vq->phys != 0) {
+            kfree(vq->cookie);
+            vm_phys_free(vq->phys, vq->npages);
+            vq->phys = 0;
+        }
+    }
+
+    kfree(vdev->vqs);
+    vdev->vqs = NULL;
+    vdev->nvq = 0;
+    vdev->nvec = 0;
+    vdev->msix = 0;
+    virtio_set_status(vdev, VIRTIO_FAILED);
+}
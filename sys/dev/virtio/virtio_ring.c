@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <dev/virtio/virtio.h>
+#include <os/mmio.h>
+#include <vm/vm.h>
+
+/* Event index slots that trail each ring */
+#define USED_EVENT(VQ)  (*(volatile uint16_t *)&(VQ)->avail->ring[(VQ)->size])
+#define AVAIL_EVENT(VQ) (*(volatile uint16_t *)&(VQ)->used->ring[(VQ)->size])
+
+/*
+ * Returns true if the device asked to be notified
+ * once the ring moved from 'old' past 'event'
+ */
+static inline bool
+virtq_need_event(uint16_t event, uint16_t new, uint16_t old)
+{
+    return (uint16_t)(new - event - 1) < (uint16_t)(new - old);
+}
+
+static inline bool
+virtq_event_idx(struct virtqueue *vq)
+{
+    return ISSET(vq->vdev->features, VIRTIO_F_EVENT_IDX);
+}
+
+int
+virtq_add(struct virtqueue *vq, struct virtq_buf *bufs, uint16_t nbufs,
+    void *cookie)
+{
+    volatile struct virtq_desc *desc = NULL;
+    uint16_t head, idx;
+
+    if (vq == NULL || bufs == NULL || nbufs == 0) {
+        return -EINVAL;
+    }
+
+    if (nbufs > vq->nfree) {
+        return -EAGAIN;
+    }
+
+    head = idx = vq->free_head;
+    for (uint16_t i = 0; i < nbufs; ++i) {
+        desc = &vq->desc[idx];
+        desc->addr = VIRT_TO_PHYS(bufs[i].addr);
+        desc->len = bufs[i].len;
+        desc->flags = VIRTQ_DESC_F_NEXT;
+        if (bufs[i].write) {
+            desc->flags |= VIRTQ_DESC_F_WRITE;
+        }
+        idx = desc->next;
+    }
+
+    desc->flags &= ~VIRTQ_DESC_F_NEXT;
+    vq->free_head = idx;
+    vq->nfree -= nbufs;
+    vq->cookie[head] = cookie;
+
+    /* Published to the device by virtq_kick() */
+    vq->avail->ring[vq->avail_idx & (vq->size - 1)] = head;
+    ++vq->avail_idx;
+    return 0;
+}
+
+void
+virtq_kick(struct virtqueue *vq)
+{
+    uint16_t old = vq->kick_idx, new = vq->avail_idx;
+    bool notify;
+
+    if (old == new) {
+        return;
+    }
+
+    /* Ring entries must be visible before the index */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    vq->avail->idx = new;
+    vq->kick_idx = new;
+
+    /* ... and the index before we look at what the device wants */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (virtq_event_idx(vq)) {
+        notify = virtq_need_event(AVAIL_EVENT(vq), new, old);
+    } else {
+        notify = !ISSET(vq->used->flags, VIRTQ_USED_F_NO_NOTIFY);
+    }
+
+    if (!notify) {
+        ++vq->nsupp;
+        return;
+    }
+
+    mmio_write16(vq->notify, vq->index);
+    ++vq->nkick;
+}
+
+void *
+virtq_harvest(struct virtqueue *vq, uint32_t *len_res)
+{
+    volatile struct virtq_used_elem *elem;
+    uint16_t id, idx, count = 1;
+    void *cookie;
+
+    if (vq->last_used == __atomic_load_n(&vq->used->idx, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    elem = &vq->used->ring[vq->last_used & (vq->size - 1)];
+    id = elem->id;
+    if (len_res != NULL) {
+        *len_res = elem->len;
+    }
+
+    /* Put the chain back onto the free list */
+    idx = id;
+    while (ISSET(vq->desc[idx].flags, VIRTQ_DESC_F_NEXT)) {
+        idx = vq->desc[idx].next;
+        ++count;
+    }
+
+    vq->desc[idx].next = vq->free_head;
+    vq->free_head = id;
+    vq->nfree += count;
+
+    cookie = vq->cookie[id];
+    vq->cookie[id] = NULL;
+    ++vq->last_used;
+    return cookie;
+}
+
+bool
+virtq_rearm(struct virtqueue *vq)
+{
+    if (virtq_event_idx(vq)) {
+        USED_EVENT(vq) = vq->last_used;
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return vq->last_used != __atomic_load_n(&vq->used->idx, __ATOMIC_ACQUIRE);
+}
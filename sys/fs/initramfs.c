@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The initramfs is a ustar archive loaded by the bootloader
+ * as a module. Its headers are parsed once at mount time into
+ * a small in-memory tree, file data is never copied and is
+ * instead served straight out of the HHDM mapping of the
+ * module.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+#include <sys/queue.h>
+#include <kern/mount.h>
+#include <kern/vnode.h>
+#include <fs/initramfs.h>
+#include <os/trace.h>
+#include <vm/kalloc.h>
+#include <lib/limine.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("initramfs: " fmt, ##__VA_ARGS__)
+
+#define USTAR_BLKSIZE 512
+#define USTAR_NAMELEN 100
+
+/* ustar entry types */
+#define USTAR_REGTYPE  '0'
+#define USTAR_AREGTYPE '\0'
+#define USTAR_DIRTYPE  '5'
+
+/*
+ * On-disk ustar header
+ */
+struct __packed ustar_hdr {
+    char name[USTAR_NAMELEN];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char chksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+};
+
+/*
+ * Represents a file or directory within the archive
+ *
+ * @name: Name of the entry [path component]
+ * @type: VREG or VDIR
+ * @ino: Inode number [vnode cache key]
+ * @data: File data within the module
+ * @size: Size of the file data
+ * @children: Directory entries [if VDIR]
+ * @link: Sibling link
+ */
+struct initramfs_node {
+    char name[USTAR_NAMELEN + 1];
+    vtype_t type;
+    ino_t ino;
+    const char *data;
+    size_t size;
+    TAILQ_HEAD(, initramfs_node) children;
+    TAILQ_ENTRY(initramfs_node) link;
+};
+
+static volatile struct limine_module_request module_req = {
+    .id = LIMINE_MODULE_REQUEST,
+    .revision = 0
+};
+
+static struct initramfs_node *root_node;
+static ino_t next_ino = 1;
+static struct vops initramfs_vops;
+
+/*
+ * Convert an octal header field to an integer
+ */
+static size_t
+ustar_oct(const char *field, size_t len)
+{
+    size_t value = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        if (field[i] < '0' || field[i] > '7') {
+            break;
+        }
+        value = (value << 3) | (field[i] - '0');
+    }
+
+    return value;
+}
+
+static struct initramfs_node *
+initramfs_node_alloc(const char *name, size_t namelen, vtype_t type)
+{
+    struct initramfs_node *np;
+
+    if ((np = kalloc(sizeof(*np))) == NULL) {
+        return NULL;
+    }
+
+    memset(np, 0, sizeof(*np));
+    namelen = MIN(namelen, USTAR_NAMELEN);
+    memcpy(np->name, name, namelen);
+    np->name[namelen] = '\0';
+    np->type = type;
+    np->ino = next_ino++;
+    TAILQ_INIT(&np->children);
+    return np;
+}
+
+/*
+ * Find a directory entry by name
+ */
+static struct initramfs_node *
+initramfs_find(struct initramfs_node *dir, const char *name, size_t namelen)
+{
+    struct initramfs_node *np;
+
+    TAILQ_FOREACH(np, &dir->children, link) {
+        if (strlen(np->name) != namelen) {
+            continue;
+        }
+
+        if (memcmp(np->name, name, namelen) == 0) {
+            return np;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Create the node of an archive entry along with any
+ * parent directories that do not have entries of their
+ * own.
+ *
+ * @path: Full path of the entry
+ * @type: Type of the entry
+ *
+ * Returns the node of the entry
+ */
+static struct initramfs_node *
+initramfs_create(const char *path, vtype_t type)
+{
+    struct initramfs_node *dir = root_node, *np;
+    const char *p = path, *end;
+    size_t len;
+
+    for (;;) {
+        while (*p == '/') {
+            ++p;
+        }
+
+        /* Trailing slash of a directory, or "./" */
+        if (*p == '\0') {
+            return dir;
+        }
+
+        end = p;
+        while (*end != '\0' && *end != '/') {
+            ++end;
+        }
+
+        len = end - p;
+        if (len == 1 && *p == '.') {
+            p = end;
+            continue;
+        }
+
+        /* Is this the last component? */
+        while (*end == '/') {
+            ++end;
+        }
+
+        np = initramfs_find(dir, p, len);
+        if (np == NULL) {
+            np = initramfs_node_alloc(p, len, (*end == '\0') ? type : VDIR);
+            if (np == NULL) {
+                return NULL;
+            }
+            TAILQ_INSERT_TAIL(&dir->children, np, link);
+        }
+
+        if (*end == '\0') {
+            return np;
+        }
+
+        if (np->type != VDIR) {
+            return NULL;
+        }
+
+        dir = np;
+        p = end;
+    }
+}
+
+/*
+ * Parse a ustar archive into the node tree
+ *
+ * @base: Base of the archive
+ * @size: Size of the archive
+ */
+static int
+initramfs_parse(const char *base, size_t size)
+{
+    const struct ustar_hdr *hdr;
+    struct initramfs_node *np;
+    char path[sizeof(hdr->prefix) + USTAR_NAMELEN + 2];
+    size_t off = 0, fsize, plen, nlen, nfiles = 0;
+    vtype_t type;
+
+    while (off + USTAR_BLKSIZE <= size) {
+        hdr = (const struct ustar_hdr *)(base + off);
+
+        /* End of archive */
+        if (hdr->name[0] == '\0') {
+            break;
+        }
+
+        if (memcmp(hdr->magic, "ustar", 5) != 0) {
+            dtrace("bad header at offset %x\n", off);
+            return -EINVAL;
+        }
+
+        fsize = ustar_oct(hdr->size, sizeof(hdr->size));
+        if (fsize > size - off - USTAR_BLKSIZE) {
+            dtrace("truncated entry at offset %x\n", off);
+            return -EINVAL;
+        }
+
+        switch (hdr->typeflag) {
+        case USTAR_REGTYPE:
+        case USTAR_AREGTYPE:
+            type = VREG;
+            break;
+        case USTAR_DIRTYPE:
+            type = VDIR;
+            break;
+        default:
+            /* Links and specials are not supported */
+            off += USTAR_BLKSIZE + ALIGN_UP(fsize, USTAR_BLKSIZE);
+            continue;
+        }
+
+        /* The full path is the prefix and name joined */
+        plen = strnlen(hdr->prefix, sizeof(hdr->prefix));
+        nlen = strnlen(hdr->name, USTAR_NAMELEN);
+        memcpy(path, hdr->prefix, plen);
+        path[plen] = '/';
+        memcpy(&path[plen + 1], hdr->name, nlen);
+        path[plen + 1 + nlen] = '\0';
+
+        if ((np = initramfs_create(path, type)) == NULL) {
+            return -ENOMEM;
+        }
+
+        if (type == VREG && np->type == VREG) {
+            np->data = base + off + USTAR_BLKSIZE;
+            np->size = fsize;
+            ++nfiles;
+        }
+
+        off += USTAR_BLKSIZE + ALIGN_UP(fsize, USTAR_BLKSIZE);
+    }
+
+    dtrace("%d file(s) in archive\n", nfiles);
+    return 0;
+}
+
+/*
+ * Get the vnode of a node, taking it from the vnode
+ * cache when possible.
+ */
+static int
+initramfs_vget(struct mount *mp, struct initramfs_node *np, struct vnode **vp_res)
+{
+    struct vnode *vp;
+    int error;
+
+    for (;;) {
+        if (vnode_cache_lookup(mp, np->ino, vp_res) == 0) {
+            return 0;
+        }
+
+        if ((error = vnode_init(&vp, np->type)) < 0) {
+            return error;
+        }
+
+        vp->vops = initramfs_vops;
+        vp->data = np;
+        error = vnode_cache_enter(vp, mp, np->ino);
+        if (error == 0) {
+            *vp_res = vp;
+            return 0;
+        }
+
+        /* Lost a race against another lookup */
+        vnode_release(vp);
+        if (error != -EEXIST) {
+            return error;
+        }
+    }
+}
+
+/*
+ * Locate the archive within the boot modules
+ */
+static struct limine_file *
+initramfs_module(void)
+{
+    struct limine_module_response *resp = module_req.response;
+    struct limine_file *file;
+    size_t plen, mlen = sizeof(INITRAMFS_MODULE) - 1;
+
+    if (resp == NULL) {
+        return NULL;
+    }
+
+    for (uint64_t i = 0; i < resp->module_count; ++i) {
+        file = resp->modules[i];
+        plen = strlen(file->path);
+        if (plen < mlen) {
+            continue;
+        }
+
+        if (strcmp(&file->path[plen - mlen], INITRAMFS_MODULE) == 0) {
+            return file;
+        }
+    }
+
+    return NULL;
+}
+
+static ssize_t
+initramfs_read(struct vop_buf_args *args)
+{
+    struct initramfs_node *np = args->vp->data;
+    size_t len;
+
+    if (np->type != VREG) {
+        return -EISDIR;
+    }
+
+    if (args->offset >= np->size) {
+        return 0;
+    }
+
+    len = MIN(args->len, np->size - args->offset);
+    memcpy(args->buffer, np->data + args->offset, len);
+    return len;
+}
+
+static ssize_t
+initramfs_write(struct vop_buf_args *args)
+{
+    return -EROFS;
+}
+
+static int
+initramfs_lookup(struct vop_lookup_args *args)
+{
+    struct vnode *dvp = args->dvp;
+    struct initramfs_node *dir = dvp->data, *np;
+
+    if (dir->type != VDIR) {
+        return -ENOTDIR;
+    }
+
+    np = initramfs_find(dir, args->component, strlen(args->component));
+    if (np == NULL) {
+        return -ENOENT;
+    }
+
+    return initramfs_vget(dvp->mp, np, args->vp_res);
+}
+
+static int
+initramfs_map(struct vop_map_args *args)
+{
+    struct initramfs_node *np = args->vp->data;
+
+    if (np->type != VREG) {
+        return -EISDIR;
+    }
+
+    if (args->offset > np->size || args->len > np->size - args->offset) {
+        return -ENXIO;
+    }
+
+    *args->res = (void *)(np->data + args->offset);
+    return 0;
+}
+
+static int
+initramfs_mount(struct fs_info *fip, struct mount *mp)
+{
+    struct limine_file *file;
+    int error;
+
+    if ((file = initramfs_module()) == NULL) {
+        return -ENOENT;
+    }
+
+    root_node = initramfs_node_alloc("", 0, VDIR);
+    if (root_node == NULL) {
+        return -ENOMEM;
+    }
+
+    /* The module is already mapped within the HHDM */
+    error = initramfs_parse(file->address, file->size);
+    if (error < 0) {
+        return error;
+    }
+
+    return initramfs_vget(mp, root_node, &mp->vp);
+}
+
+static int
+initramfs_init(struct fs_info *fip)
+{
+    struct mount_args mountargs;
+    int error;
+
+    mountargs.target = "/initramfs";
+    mountargs.fstype = MOUNT_INITRAMFS;
+    error = mount(&mountargs);
+    if (error < 0) {
+        return error;
+    }
+
+    return 0;
+}
+
+static struct vops initramfs_vops = {
+    .read = initramfs_read,
+    .write = initramfs_write,
+    .lookup = initramfs_lookup,
+    .map = initramfs_map
+};
+
+struct vfsops g_initramfs_ops = {
+    .mount = initramfs_mount,
+    .init = initramfs_init
+};
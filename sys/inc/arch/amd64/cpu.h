@@ -30,6 +30,47 @@
 #ifndef _MACHINE_CPU_H_
 #define _MACHINE_CPU_H_ 1
 
+#if !defined(__ASSEMBLER__)
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#endif  /* !__ASSEMBLER__ */
+
+/* RFLAGS bits */
+#define RFLAGS_TF   0x00000100
+#define RFLAGS_IF   0x00000200
+#define RFLAGS_DF   0x00000400
+#define RFLAGS_AC   0x00040000
+
+/* Kernel stack used on entry from user mode */
+#define KSTACK_SIZE 0x4000
+
+/*
+ * Offsets into struct cpu_info used by the system call
+ * entry, checked at build time.
+ */
+#define CI_KSTACK   0x00
+#define CI_USCRATCH 0x08
+
+#if !defined(__ASSEMBLER__)
 void cpu_loinit(void);
 
+/*
+ * Read the time stamp counter
+ */
+__always_inline static inline uint64_t
+rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    __asm(
+        "rdtsc"
+        : "=a" (lo), "=d" (hi)
+        :
+        : "memory"
+    );
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#endif  /* !__ASSEMBLER__ */
 #endif  /* !_MACHINE_CPU_H_ */
@@ -30,13 +30,22 @@
 #ifndef _MACHINE_GDT_H_
 #define _MACHINE_GDT_H_
 
+#if !defined(__ASSEMBLER__)
 #include <sys/types.h>
 #include <sys/cdefs.h>
+#endif  /* !__ASSEMBLER__ */
 
+/*
+ * User data comes before user code as SYSRET loads
+ * SS and CS from fixed offsets of the same base.
+ */
 #define GDT_KERNCODE 0x08
 #define GDT_KERNDATA 0x10
-#define GDT_USERCODE 0x18
-#define GDT_USERDATA 0x20
+#define GDT_USERDATA 0x18
+#define GDT_USERCODE 0x20
+#define GDT_TSS      0x28
+
+#if !defined(__ASSEMBLER__)
 
 struct __packed gdt_entry {
     uint16_t limit;
@@ -52,4 +61,40 @@ struct __packed gdtr {
     uintptr_t offset;
 };
 
+/*
+ * 64-bit TSS descriptor, takes up two GDT slots
+ */
+struct __packed tss_desc {
+    uint16_t limit;
+    uint16_t base_low;
+    uint8_t base_mid;
+    uint8_t access;
+    uint8_t granularity;
+    uint8_t base_hi;
+    uint32_t base_upper;
+    uint32_t reserved;
+};
+
+/*
+ * Task state segment, only used for the stacks to load
+ * when entering the kernel from user mode.
+ *
+ * @rsp0: Stack for entry to ring 0
+ * @ist: Interrupt stack table
+ * @iomap: I/O permission bitmap offset
+ */
+struct __packed tss {
+    uint32_t reserved0;
+    uint64_t rsp0;
+    uint64_t rsp1;
+    uint64_t rsp2;
+    uint64_t reserved1;
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iomap;
+};
+
+#endif  /* !__ASSEMBLER__ */
+
 #endif  /* !_MACHINE_GDT_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_IDLE_H_
+#define _MACHINE_IDLE_H_ 1
+
+#include <sys/types.h>
+#include <lib/stdbool.h>
+
+struct cpu_info;
+
+/* Max number of MWAIT C-states, C1 through C7 */
+#define IDLE_NSTATE 7
+
+/*
+ * A state is only entered if the predicted idle time
+ * is at least this many times its exit latency
+ */
+#if !defined(IDLE_RESIDENCY_MULT)
+#define IDLE_RESIDENCY_MULT 3
+#endif  /* !IDLE_RESIDENCY_MULT */
+
+/*
+ * Returns true if idling uses MONITOR/MWAIT
+ */
+bool idle_has_mwait(void);
+
+/*
+ * Wait for work on the current processor, it wakes on
+ * an interrupt or a write to its run queue head. Called
+ * from the idle loop with interrupts enabled.
+ *
+ * @ci: Current processor
+ */
+void idle_wait(struct cpu_info *ci);
+
+/*
+ * Probe the usable idle states, called once on the BSP
+ */
+void idle_init(void);
+
+#endif  /* !_MACHINE_IDLE_H_ */
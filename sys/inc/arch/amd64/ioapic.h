@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_IOAPIC_H_
+#define _MACHINE_IOAPIC_H_ 1
+
+#include <sys/types.h>
+#include <lib/stdbool.h>
+#include <mu/cpu.h>
+
+#define IOAPIC_MAX 8        /* Max I/O APICs supported */
+
+/* Redirection entry flags */
+#define IOAPIC_ACTIVE_LOW   BIT(13)     /* Active low polarity */
+#define IOAPIC_LEVEL        BIT(15)     /* Level triggered */
+#define IOAPIC_MASKED       BIT(16)     /* Pin is masked */
+
+/*
+ * Translate a legacy ISA IRQ into the global system
+ * interrupt it is wired to, accounting for the interrupt
+ * source overrides within the MADT.
+ *
+ * @irq: ISA IRQ number
+ * @flags_res: Polarity/trigger flags are written here [optional]
+ *
+ * Returns the GSI
+ */
+uint32_t ioapic_irq_to_gsi(uint8_t irq, uint32_t *flags_res);
+
+/*
+ * Route a global system interrupt to a vector on a
+ * processor, the pin is left masked.
+ *
+ * @gsi: Global system interrupt to route
+ * @vector: Vector to deliver
+ * @ci: Processor to deliver to [owns the vector]
+ * @flags: Polarity/trigger flags (see IOAPIC_*)
+ *
+ * Returns zero on success
+ */
+int ioapic_route(uint32_t gsi, uint8_t vector, struct cpu_info *ci,
+    uint32_t flags);
+
+/*
+ * Route a legacy ISA IRQ to a vector on a processor,
+ * the pin is left masked.
+ *
+ * Returns zero on success
+ */
+int ioapic_route_irq(uint8_t irq, uint8_t vector, struct cpu_info *ci);
+
+/*
+ * Steer an already routed interrupt to another processor,
+ * its handlers move to a vector allocated there.
+ *
+ * Returns zero on success
+ */
+int ioapic_set_affinity(uint32_t gsi, struct cpu_info *ci);
+
+/*
+ * Mask or unmask an interrupt pin
+ *
+ * Returns zero on success
+ */
+int ioapic_mask(uint32_t gsi, bool mask);
+
+/*
+ * Initialize every I/O APIC on the machine with all
+ * pins masked
+ */
+void ioapic_init(void);
+
+#endif  /* !_MACHINE_IOAPIC_H_ */
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _MACHINE_ISA_H_
+#define _MACHINE_ISA_H_ 1
+
+#include <sys/types.h>
+
+struct cpu_info;
+
+/* Legacy ISA IRQ lines */
+#define ISA_IRQ_KBD     1       /* i8042 first port */
+#define ISA_IRQ_COM1    4       /* First serial port */
+
+/*
+ * Enable receive interrupts on COM1 and feed its
+ * input to the serial terminal
+ *
+ * Returns zero on success
+ */
+int com_attach(void);
+
+/*
+ * Probe the i8042 controller and feed keyboard input
+ * to the console terminal
+ *
+ * Returns zero on success
+ */
+int i8042_attach(void);
+
+/*
+ * Route an ISA IRQ to a newly allocated vector on a
+ * processor and unmask it
+ *
+ * @irq: ISA IRQ number
+ * @name: Name of the handler
+ * @func: Handler callback
+ * @arg: Argument to pass
+ * @ci: Processor to deliver to [NULL to pick from the general pool]
+ *
+ * Returns zero on success
+ */
+int isa_intr_establish(uint8_t irq, const char *name,
+    int(*func)(void *), void *arg, struct cpu_info *ci);
+
+#endif  /* !_MACHINE_ISA_H_ */
@@ -97,6 +97,12 @@ struct lapic_ipi {
  */
 void lapic_oneshot_usec(struct mcb *mcb, size_t usec);
 
+/*
+ * Returns the number of usec left until the local APIC
+ * timer fires, zero if it is not counting
+ */
+size_t lapic_remaining_usec(struct mcb *mcb);
+
 /*
  * Send an end-of-interrupt
  */
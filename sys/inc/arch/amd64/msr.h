@@ -36,6 +36,7 @@
 #endif  /* !__ASSEMBLER__ */
 
 #define IA32_APIC_BASE      0x0000001B
+#define IA32_FS_BASE        0xC0000100
 #define IA32_GS_BASE        0xC0000101
 #define IA32_MTRR_CAP       0x000000FE
 #define IA32_DEF_TYPE       0x000002FF
@@ -43,6 +44,12 @@
 #define IA32_MTRR_PHYSMASK  0x00000201
 #define IA32_KERNEL_GS_BASE 0xC0000102
 #define IA32_EFER           0xC0000080
+#define IA32_STAR           0xC0000081
+#define IA32_LSTAR          0xC0000082
+#define IA32_FMASK          0xC0000084
+
+/* EFER bits */
+#define EFER_SCE            0x00000001  /* SYSCALL/SYSRET enable */
 
 #if !defined(__ASSEMBLER__)
 __always_inline static inline uint64_t
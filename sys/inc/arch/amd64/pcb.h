@@ -31,17 +31,16 @@
 #define _MACHINE_PCB_H_ 1
 
 #include <md/frame.h>
-#include <md/vas.h>
 
 /*
- * Represents the process control block
+ * Represents the thread control block
  *
- * @vas: Virtual address space in-use
  * @tf: Trapframe snapshot
+ * @fsbase: FS base, points to thread-local storage
  */
 struct pcb {
-    struct mmu_vas vas;
     struct trapframe tf;
+    uintptr_t fsbase;
 };
 
 #endif  /* !_MACHINE_PCB_H_ */
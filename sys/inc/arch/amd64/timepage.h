@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MACHINE_TIMEPAGE_H_
+#define _MACHINE_TIMEPAGE_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+
+/* Where the time page lives in every user process */
+#define TIMEPAGE_VA     0x00007FFFFFFFF000
+
+/* Time page flags */
+#define TIMEPAGE_TSC    0x01    /* TSC parameters are valid */
+
+#define NSEC_PER_SEC    1000000000ULL
+#define TIMEPAGE_SHIFT  32
+
+/*
+ * Read-only page shared with every process, time is
+ * computed from the TSC without entering the kernel:
+ *
+ *     mono = mono_base + ((tsc - tsc_base) * mult) >> shift
+ *     wall = mono + wall_off
+ *
+ * @seq: Sequence count, odd while an update is underway
+ * @flags: Time page flags
+ * @tsc_base: TSC value at the last update
+ * @mono_base: Monotonic time at 'tsc_base' [nsec]
+ * @wall_off: Wall clock offset from monotonic [nsec]
+ * @mult: TSC to nanosecond multiplier
+ * @shift: TSC to nanosecond shift
+ * @tsc_freq: TSC frequency in Hz
+ */
+struct timepage {
+    volatile uint32_t seq;
+    uint32_t flags;
+    uint64_t tsc_base;
+    uint64_t mono_base;
+    int64_t wall_off;
+    uint64_t mult;
+    uint32_t shift;
+    uint32_t reserved;
+    uint64_t tsc_freq;
+};
+
+/*
+ * Read a consistent snapshot of the time page and
+ * compute the current monotonic time.
+ *
+ * @tp: Time page to read
+ * @wall_off: Wall clock offset is written here
+ *
+ * Returns zero if the time page has no valid TSC
+ * parameters
+ */
+__always_inline static inline uint64_t
+__timepage_read(const volatile struct timepage *tp, int64_t *wall_off)
+{
+    uint64_t mono, tsc, delta;
+    uint32_t seq, lo, hi;
+
+    do {
+        while ((seq = tp->seq) & 1) {
+            __asm volatile("pause");
+        }
+
+        __asm volatile("" ::: "memory");
+        if ((tp->flags & TIMEPAGE_TSC) == 0) {
+            return 0;
+        }
+
+        __asm volatile("lfence; rdtsc" : "=a" (lo), "=d" (hi));
+        tsc = ((uint64_t)hi << 32) | lo;
+        delta = tsc - tp->tsc_base;
+        mono = tp->mono_base;
+        mono += ((unsigned __int128)delta * tp->mult) >> tp->shift;
+        *wall_off = tp->wall_off;
+        __asm volatile("" ::: "memory");
+    } while (tp->seq != seq);
+
+    return mono;
+}
+
+/*
+ * Monotonic time in nanoseconds, zero if unavailable
+ */
+__always_inline static inline uint64_t
+timepage_monotonic(const volatile struct timepage *tp)
+{
+    int64_t off;
+
+    return __timepage_read(tp, &off);
+}
+
+/*
+ * Wall clock time in nanoseconds since the epoch,
+ * zero if unavailable
+ */
+__always_inline static inline uint64_t
+timepage_realtime(const volatile struct timepage *tp)
+{
+    uint64_t mono;
+    int64_t off;
+
+    if ((mono = __timepage_read(tp, &off)) == 0) {
+        return 0;
+    }
+
+    return mono + off;
+}
+
+#if defined(_KERNEL)
+struct mmu_vas;
+
+/*
+ * Set up the time page, the TSC must already be
+ * calibrated
+ */
+void timepage_init(void);
+
+/*
+ * Map the time page read-only into a user address
+ * space at TIMEPAGE_VA
+ */
+int timepage_map(struct mmu_vas *vas);
+
+/*
+ * Set the wall clock time
+ *
+ * @realtime: Nanoseconds since the epoch
+ */
+void timepage_settime(uint64_t realtime);
+
+/*
+ * Get the kernel's view of the time page
+ */
+const struct timepage *timepage_get(void);
+#endif  /* _KERNEL */
+
+#endif  /* !_MACHINE_TIMEPAGE_H_ */
@@ -32,6 +32,15 @@
 
 #include <sys/types.h>
 
+/*
+ * Kernel thread stacks live here, each one is preceded
+ * by an unmapped guard page. The top level entry for
+ * this area is created at boot so every address space
+ * shares it.
+ */
+#define KSTACK_AREA     0xFFFFFE8000000000
+#define KSTACK_AREA_LEN 0x0000008000000000
+
 struct mmu_vas {
     uintptr_t cr3;
 };
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLK_BLKDEV_H_
+#define _BLK_BLKDEV_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/ioring.h>
+#include <kern/vnode.h>
+
+#define BLK_NAMELEN 16      /* Max length of device names */
+#define BLK_MAXSEG  16      /* Max segments per merged request */
+#define BLK_QPOOL   64      /* Preallocated requests per queue */
+
+struct blkdev;
+struct blk_queue;
+
+/*
+ * A physically contiguous piece of a block request
+ *
+ * @buf: Buffer to transfer to/from
+ * @len: Length of the segment in bytes
+ */
+struct blk_seg {
+    void *buf;
+    size_t len;
+};
+
+/*
+ * A block request as seen by drivers, adjacent io_reqs
+ * may have been merged into a single block request.
+ *
+ * @op: Operation to perform
+ * @blkno: Starting sector
+ * @nsect: Number of sectors
+ * @nseg: Number of segments
+ * @seg: Segments making up the transfer, in order
+ * @reqs: io_reqs this request completes
+ * @queue: Queue this request was dispatched from
+ * @data: Driver private data
+ * @dynamic: Set if not taken from the queue pool
+ * @link: Queue link
+ */
+struct blk_req {
+    io_op_t op;
+    uint64_t blkno;
+    size_t nsect;
+    uint16_t nseg;
+    struct blk_seg seg[BLK_MAXSEG];
+    struct io_reqq reqs;
+    struct blk_queue *queue;
+    void *data;
+    uint8_t dynamic : 1;
+    TAILQ_ENTRY(blk_req) link;
+};
+
+/*
+ * Per device request queue, a device may have one of these
+ * per hardware queue so that submitters on different cores
+ * do not contend with each other.
+ *
+ * @lock: Protects the queue
+ * @bdp: Device this queue belongs to
+ * @id: Queue index
+ * @inflight: Requests currently owned by the driver
+ * @running: Set while a caller is dispatching
+ * @rerun: Set if the dispatcher should pull again
+ * @pending: Requests waiting for dispatch, sorted by sector
+ * @freeq: Pool of unused requests
+ * @pool: Backing storage of the request pool
+ * @nmerge: Number of io_reqs merged into another request
+ * @ndispatch: Number of requests dispatched to the driver
+ */
+struct __aligned(COHERENCY_UNIT) blk_queue {
+    struct spinlock lock;
+    struct blkdev *bdp;
+    uint16_t id;
+    uint16_t inflight;
+    uint8_t running : 1;
+    uint8_t rerun : 1;
+    TAILQ_HEAD(blk_reqq, blk_req) pending;
+    TAILQ_HEAD(, blk_req) freeq;
+    struct blk_req *pool;
+    size_t nmerge;
+    size_t ndispatch;
+};
+
+/*
+ * Operations provided by block device drivers
+ *
+ * @strategy: Start a block request, the driver must call
+ *            blkdev_done() once it has completed. Returns
+ *            zero if the request was started.
+ * @commit: Called after a batch of strategy calls on a queue
+ *          so the driver can notify the device once [optional]
+ * @poll: Reap completions of a queue without waiting for an
+ *        interrupt [optional]
+ */
+struct blkdev_ops {
+    int(*strategy)(struct blkdev *bdp, struct blk_req *breq);
+    void(*commit)(struct blkdev *bdp, struct blk_queue *q);
+    void(*poll)(struct blkdev *bdp, struct blk_queue *q);
+};
+
+/*
+ * Represents a block device
+ *
+ * @name: Name of the device
+ * @sector_size: Size of a sector in bytes [power of two]
+ * @nsectors: Number of sectors on the device
+ * @ops: Driver operations
+ * @nqueues: Number of queues [at least one]
+ * @qdepth: Max requests in flight per queue
+ * @max_sectors: Largest merged request [zero if unlimited]
+ * @queues: Request queues
+ * @vp: VBLK vnode of the device
+ * @data: Driver private data
+ * @link: Device list link
+ */
+struct blkdev {
+    char name[BLK_NAMELEN];
+    uint32_t sector_size;
+    uint64_t nsectors;
+    struct blkdev_ops *ops;
+    uint16_t nqueues;
+    uint16_t qdepth;
+    uint32_t max_sectors;
+    struct blk_queue *queues;
+    struct vnode *vp;
+    void *data;
+    TAILQ_ENTRY(blkdev) link;
+};
+
+/*
+ * Register a block device, the driver must fill in
+ * every field up to and including the queue depth and
+ * may set a max request size.
+ *
+ * Returns zero on success
+ */
+int blkdev_register(struct blkdev *bdp);
+
+/*
+ * Lookup a block device by name
+ *
+ * @name: Name of the device
+ * @res: Result pointer is written here
+ *
+ * Returns zero on success
+ */
+int blkdev_lookup(const char *name, struct blkdev **res);
+
+/*
+ * Submit a batch of io_reqs to a block device, they are
+ * merged and sorted within the queue of the current core
+ * before being handed to the driver.
+ *
+ * Returns zero on success
+ */
+int blkdev_submit(struct blkdev *bdp, struct io_reqq *reqq);
+
+/*
+ * Complete a block request, called by drivers
+ *
+ * @breq: Request that completed
+ * @status: Zero on success, otherwise a negative errno
+ */
+void blkdev_done(struct blk_req *breq, int status);
+
+/*
+ * Reap completed requests on every queue of a block
+ * device, used by waiters that cannot rely on interrupts.
+ */
+void blkdev_poll(struct blkdev *bdp);
+
+/*
+ * Initialize the block layer
+ */
+void blkdev_init(void);
+
+#endif  /* !_BLK_BLKDEV_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLK_BUF_H_
+#define _BLK_BUF_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/ioring.h>
+#include <dev/blk/blkdev.h>
+
+#define NBUF        128     /* Number of buffers in the cache */
+#define BIO_CLUSTER 16      /* Max sectors read in a single batch */
+
+/* Buffer flags */
+#define B_VALID BIT(0)      /* Data matches the device */
+#define B_BUSY  BIT(1)      /* Locked by a user */
+#define B_ERROR BIT(2)      /* Last I/O failed */
+
+/*
+ * Represents a cached device sector
+ *
+ * @bdp: Device the buffer belongs to
+ * @blkno: Sector number
+ * @data: Buffer data
+ * @size: Size of the data [device sector size]
+ * @flags: Buffer flags (see B_*)
+ * @ref: Reference count [protected by the cache lock]
+ * @iodone: Set once outstanding I/O completes
+ * @req: Request used to perform I/O on the buffer
+ * @hashq: Hash chain link
+ * @lruq: Free list link
+ */
+struct buf {
+    struct blkdev *bdp;
+    uint64_t blkno;
+    void *data;
+    size_t size;
+    volatile uint32_t flags;
+    uint32_t ref;
+    volatile uint8_t iodone;
+    struct io_req req;
+    LIST_ENTRY(buf) hashq;
+    TAILQ_ENTRY(buf) lruq;
+};
+
+/*
+ * Read a sector through the buffer cache, the buffer is
+ * returned locked and must be released with brelse()
+ *
+ * @bdp: Device to read from
+ * @blkno: Sector to read
+ * @bp_res: Result pointer is written here
+ *
+ * Returns zero on success
+ */
+int bread(struct blkdev *bdp, uint64_t blkno, struct buf **bp_res);
+
+/*
+ * Read a run of sectors through the buffer cache, sectors
+ * that miss are submitted as one batch so they can be merged
+ * into a single request.
+ *
+ * @bdp: Device to read from
+ * @blkno: First sector to read
+ * @count: Number of sectors [at most BIO_CLUSTER]
+ * @bps: Result buffers are written here
+ *
+ * Returns zero on success
+ */
+int breadn(struct blkdev *bdp, uint64_t blkno, size_t count, struct buf **bps);
+
+/*
+ * Write a locked buffer back to its device
+ *
+ * Returns zero on success
+ */
+int bwrite(struct buf *bp);
+
+/*
+ * Unlock and release a buffer
+ */
+void brelse(struct buf *bp);
+
+/*
+ * Read bytes from a block device through the buffer cache
+ *
+ * Returns the number of bytes read
+ */
+ssize_t bio_read(struct blkdev *bdp, void *buf, size_t len, off_t off);
+
+/*
+ * Write bytes to a block device through the buffer cache
+ *
+ * Returns the number of bytes written
+ */
+ssize_t bio_write(struct blkdev *bdp, const void *buf, size_t len, off_t off);
+
+/*
+ * Initialize the buffer cache
+ */
+void buf_init(void);
+
+#endif  /* !_BLK_BUF_H_ */
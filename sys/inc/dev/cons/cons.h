@@ -32,24 +32,62 @@
 
 #include <sys/types.h>
 #include <dev/video/vram.h>
+#include <dev/cons/font.h>
+#include <kern/spinlock.h>
+
+/* Max number of framebuffers a console mirrors to */
+#if !defined(CONS_MAXHEADS)
+#define CONS_MAXHEADS 4
+#endif  /* !CONS_MAXHEADS */
+
+/* Font scale, zero picks one from the resolution */
+#if !defined(CONS_FONT_SCALE)
+#define CONS_FONT_SCALE 0
+#endif  /* !CONS_FONT_SCALE */
+
+/* Rows of text the picked font scale keeps at least */
+#if !defined(CONS_MINROWS)
+#define CONS_MINROWS 60
+#endif  /* !CONS_MINROWS */
 
 /*
  * Represents a system console, these fields are mostly
  * internal and should not be written to directly.
  *
- * @vram: VRAM descriptor in-use
+ * Text is drawn once into a shadow buffer of 0x00RRGGBB
+ * pixels and the rows that changed are copied out to
+ * every head, until the shadow exists text is drawn to
+ * the heads directly.
+ *
+ * @heads: Framebuffers being mirrored to
+ * @nheads: Number of heads
+ * @width: Width in pixels, the smallest of all heads
+ * @height: Height in pixels, the smallest of all heads
+ * @shadow: Shadow buffer [width * height]
+ * @dirty_lo: First dirty row of the shadow
+ * @dirty_hi: Last dirty row of the shadow, exclusive
+ * @font: Font in-use
  * @fg: Foreground color in-use
  * @bg: Background color in-use
  * @tx: Text X position
  * @ty: Text Y position
+ * @lock: Serializes writers [taken with interrupts masked]
  * @active: Set if active
  */
 struct console {
-    struct vram_dev vram;
+    struct vram_dev heads[CONS_MAXHEADS];
+    size_t nheads;
+    size_t width;
+    size_t height;
+    uint32_t *shadow;
+    size_t dirty_lo;
+    size_t dirty_hi;
+    struct font font;
     uint32_t fg;
     uint32_t bg;
     size_t tx;
     size_t ty;
+    struct spinlock lock;
     uint8_t active : 1;
 };
 
@@ -61,6 +99,14 @@ struct console {
  */
 int console_reset(struct console *cons);
 
+/*
+ * Give a console its shadow buffer, this needs the
+ * physical memory allocator.
+ *
+ * Returns zero on success.
+ */
+int console_shadow_init(struct console *cons);
+
 /*
  * Write a stream of bytes to the console.
  *
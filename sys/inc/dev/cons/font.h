@@ -35,6 +35,49 @@
 #define FONT_WIDTH 8
 #define FONT_HEIGHT 16
 
+/* Largest integer scale of the font */
+#if !defined(FONT_MAXSCALE)
+#define FONT_MAXSCALE 4
+#endif  /* !FONT_MAXSCALE */
+
 extern uint8_t g_CONS_FONT[];
 
+/*
+ * A scaled view of the console font, drawing a glyph is
+ * a masked copy of rows expanded at init.
+ *
+ * @scale: Integer scale [1 to FONT_MAXSCALE]
+ * @width: Glyph width in pixels
+ * @height: Glyph height in pixels
+ */
+struct font {
+    size_t scale;
+    size_t width;
+    size_t height;
+};
+
+/*
+ * Expand the font at a given scale
+ *
+ * XXX: The expanded rows are shared, every font uses
+ *      the scale of the last one initialized.
+ *
+ * @fp: Font to initialize
+ * @scale: Integer scale, clamped to FONT_MAXSCALE
+ */
+void font_init(struct font *fp, size_t scale);
+
+/*
+ * Draw a glyph into a buffer of 0x00RRGGBB pixels
+ *
+ * @fp: Font to use
+ * @c: Character to draw
+ * @fg: Foreground color
+ * @bg: Background color
+ * @dst: Top left pixel to draw at
+ * @stride: Pixels per row of 'dst'
+ */
+void font_draw(struct font *fp, char c, uint32_t fg, uint32_t bg,
+    uint32_t *dst, size_t stride);
+
 #endif  /* !_CONS_FONT_H_ */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NVME_NVME_H_
+#define _NVME_NVME_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <kern/spinlock.h>
+#include <dev/blk/blkdev.h>
+#include <dev/pci/pci.h>
+#include <os/intr.h>
+#include <os/softint.h>
+
+/* Entries per I/O queue, capped by the controller */
+#if !defined(NVME_QSIZE)
+#define NVME_QSIZE 64
+#endif
+
+/* Completion handling without interrupts */
+#if !defined(NVME_POLLED)
+#define NVME_POLLED 0
+#endif
+
+/* Completions per interrupt [0-based] */
+#if !defined(NVME_COALESCE_THR)
+#define NVME_COALESCE_THR 7
+#endif
+
+/* Max interrupt delay in 100us units */
+#if !defined(NVME_COALESCE_TIME)
+#define NVME_COALESCE_TIME 1
+#endif
+
+struct nvme_ctrl;
+struct nvme_cmd;
+struct nvme_cpl;
+
+/*
+ * Per command state
+ *
+ * @cid: Command ID [index into the slot array]
+ * @breq: Block request the command belongs to
+ * @lead: Slot that tracks the whole block request
+ * @pending: Commands outstanding [lead only]
+ * @status: First error seen [lead only]
+ * @list: PRP or SGL list page
+ * @list_phys: Physical address of the list page
+ * @next: Free list link
+ */
+struct nvme_slot {
+    uint16_t cid;
+    struct blk_req *breq;
+    struct nvme_slot *lead;
+    uint16_t pending;
+    int status;
+    void *list;
+    uintptr_t list_phys;
+    struct nvme_slot *next;
+};
+
+/*
+ * A submission and completion queue pair
+ *
+ * @ctrl: Controller the pair belongs to
+ * @id: Queue ID [zero for admin]
+ * @size: Entries per queue
+ * @sq: Submission queue
+ * @cq: Completion queue
+ * @sq_phys: Physical base of the SQ
+ * @cq_phys: Physical base of the CQ
+ * @sq_db: SQ tail doorbell
+ * @cq_db: CQ head doorbell
+ * @sq_tail: Next SQ entry to fill
+ * @db_tail: Tail last written to the doorbell
+ * @cq_head: Next CQ entry to check
+ * @phase: Expected phase tag
+ * @slots: Command slots
+ * @freeslot: Free slot list
+ * @nfree: Number of free slots
+ * @lock: Protects the pair
+ * @ih: Interrupt handler
+ * @work: Deferred completion work
+ */
+struct nvme_qpair {
+    struct nvme_ctrl *ctrl;
+    uint16_t id;
+    uint16_t size;
+    volatile struct nvme_cmd *sq;
+    volatile struct nvme_cpl *cq;
+    uintptr_t sq_phys;
+    uintptr_t cq_phys;
+    volatile uint32_t *sq_db;
+    volatile uint32_t *cq_db;
+    uint16_t sq_tail;
+    uint16_t db_tail;
+    uint16_t cq_head;
+    uint8_t phase;
+    struct nvme_slot *slots;
+    struct nvme_slot *freeslot;
+    uint16_t nfree;
+    struct spinlock lock;
+    struct intr_hand ih;
+    struct softint_work work;
+};
+
+/*
+ * An NVMe controller, only the first namespace is
+ * exposed as a block device.
+ *
+ * @pci: PCI device
+ * @regs: Register base [BAR0]
+ * @dstrd: Doorbell stride in bytes
+ * @mdts: Max transfer size in bytes [zero if unlimited]
+ * @sgl: Set if the controller takes SGLs
+ * @polled: Set if completions are polled for
+ * @admin: Admin queue pair
+ * @nioq: Number of I/O queue pairs
+ * @ioq: I/O queue pairs
+ * @bdev: Block device of the namespace
+ */
+struct nvme_ctrl {
+    struct pci_device *pci;
+    volatile void *regs;
+    uint32_t dstrd;
+    size_t mdts;
+    uint8_t sgl : 1;
+    uint8_t polled : 1;
+    struct nvme_qpair admin;
+    uint16_t nioq;
+    struct nvme_qpair *ioq;
+    struct blkdev bdev;
+};
+
+/*
+ * Attach to every NVMe controller on the PCI bus
+ */
+void nvme_init(void);
+
+#endif  /* !_NVME_NVME_H_ */
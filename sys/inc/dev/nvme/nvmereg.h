@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NVME_NVMEREG_H_
+#define _NVME_NVMEREG_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+
+#define NVME_CLASS      0x01
+#define NVME_SUBCLASS   0x08
+#define NVME_PROGIF     0x02
+
+/* Controller registers */
+#define NVME_REG_CAP    0x00    /* Capabilities */
+#define NVME_REG_VS     0x08    /* Version */
+#define NVME_REG_INTMS  0x0C    /* Interrupt mask set */
+#define NVME_REG_INTMC  0x10    /* Interrupt mask clear */
+#define NVME_REG_CC     0x14    /* Controller configuration */
+#define NVME_REG_CSTS   0x1C    /* Controller status */
+#define NVME_REG_AQA    0x24    /* Admin queue attributes */
+#define NVME_REG_ASQ    0x28    /* Admin submission queue base */
+#define NVME_REG_ACQ    0x30    /* Admin completion queue base */
+#define NVME_REG_DBS    0x1000  /* Doorbells */
+
+/* CAP fields */
+#define NVME_CAP_MQES(CAP)      ((CAP) & 0xFFFF)
+#define NVME_CAP_TO(CAP)        (((CAP) >> 24) & 0xFF)
+#define NVME_CAP_DSTRD(CAP)     (((CAP) >> 32) & 0xF)
+#define NVME_CAP_MPSMIN(CAP)    (((CAP) >> 48) & 0xF)
+
+/* CC fields */
+#define NVME_CC_EN          BIT(0)
+#define NVME_CC_IOSQES(N)   ((N) << 16)
+#define NVME_CC_IOCQES(N)   ((N) << 20)
+
+/* CSTS fields */
+#define NVME_CSTS_RDY       BIT(0)
+#define NVME_CSTS_CFS       BIT(1)
+
+/* Admin opcodes */
+#define NVME_ADM_CREATE_SQ  0x01
+#define NVME_ADM_CREATE_CQ  0x05
+#define NVME_ADM_IDENTIFY   0x06
+#define NVME_ADM_SETFEAT    0x09
+
+/* NVM opcodes */
+#define NVME_CMD_FLUSH      0x00
+#define NVME_CMD_WRITE      0x01
+#define NVME_CMD_READ       0x02
+
+/* Features */
+#define NVME_FEAT_NQUEUES   0x07
+#define NVME_FEAT_COALESCE  0x08
+
+/* Identify CNS values */
+#define NVME_ID_NS          0x00
+#define NVME_ID_CTRL        0x01
+
+/* Queue creation flags */
+#define NVME_Q_PC           BIT(0)  /* Physically contiguous */
+#define NVME_CQ_IEN         BIT(1)  /* Interrupts enabled */
+
+/* Command flags */
+#define NVME_PSDT_SGL       (1 << 6)
+
+/* SGL descriptor types */
+#define NVME_SGL_DATA       0x00
+#define NVME_SGL_LAST_SEG   0x30
+
+/* Completion status */
+#define NVME_CPL_PHASE(S)   ((S) & 1)
+#define NVME_CPL_STATUS(S)  ((S) >> 1)
+
+/*
+ * Submission queue entry
+ */
+struct __packed nvme_cmd {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t cid;
+    uint32_t nsid;
+    uint64_t rsvd;
+    uint64_t mptr;
+    uint64_t dptr[2];
+    uint32_t cdw10;
+    uint32_t cdw11;
+    uint32_t cdw12;
+    uint32_t cdw13;
+    uint32_t cdw14;
+    uint32_t cdw15;
+};
+
+/*
+ * Completion queue entry
+ */
+struct __packed nvme_cpl {
+    uint32_t cdw0;
+    uint32_t rsvd;
+    uint16_t sqhd;
+    uint16_t sqid;
+    uint16_t cid;
+    uint16_t status;
+};
+
+struct __packed nvme_sgl {
+    uint64_t addr;
+    uint32_t len;
+    uint8_t rsvd[3];
+    uint8_t type;
+};
+
+/* Identify controller offsets */
+#define NVME_IDC_MDTS       77
+#define NVME_IDC_NN         516
+#define NVME_IDC_SGLS       536
+
+/* Identify namespace offsets */
+#define NVME_IDN_NSZE       0
+#define NVME_IDN_FLBAS      26
+#define NVME_IDN_LBAF       128
+
+#endif  /* !_NVME_NVMEREG_H_ */
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _PCI_PCI_H_
+#define _PCI_PCI_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <lib/stdbool.h>
+#include <os/intr.h>
+#include <dev/pci/pcireg.h>
+
+#define PCI_NBAR 6
+
+struct cpu_info;
+
+/*
+ * Represents a PCI(e) function
+ *
+ * @seg: Segment group
+ * @bus: Bus number
+ * @slot: Device number
+ * @func: Function number
+ * @vendor: Vendor ID
+ * @device: Device ID
+ * @class: Class code
+ * @subclass: Subclass
+ * @progif: Programming interface
+ * @revid: Revision ID
+ * @hdrtype: Header type
+ * @cfg: ECAM configuration space of this function
+ * @bar: BAR base addresses [physical]
+ * @bar_size: BAR sizes, zero if unused
+ * @bar_io: Set for I/O space BARs (bit per BAR)
+ * @msi_cap: Offset of the MSI capability [zero if none]
+ * @msix_cap: Offset of the MSI-X capability [zero if none]
+ * @msix_table: Mapped MSI-X table
+ * @msix_count: Number of MSI-X table entries
+ * @parent: Bridge this function sits behind [NULL if root bus]
+ * @children: Functions behind this bridge
+ * @sibling: Link within parent's children
+ * @link: Global device list link
+ */
+struct pci_device {
+    uint16_t seg;
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t func;
+    uint16_t vendor;
+    uint16_t device;
+    uint8_t class;
+    uint8_t subclass;
+    uint8_t progif;
+    uint8_t revid;
+    uint8_t hdrtype;
+    void *cfg;
+    uintptr_t bar[PCI_NBAR];
+    size_t bar_size[PCI_NBAR];
+    uint8_t bar_io;
+    uint8_t msi_cap;
+    uint8_t msix_cap;
+    volatile void *msix_table;
+    uint16_t msix_count;
+    struct pci_device *parent;
+    TAILQ_HEAD(, pci_device) children;
+    TAILQ_ENTRY(pci_device) sibling;
+    TAILQ_ENTRY(pci_device) link;
+};
+
+/* Configuration space access */
+uint8_t pci_readb(struct pci_device *dev, uint16_t off);
+uint16_t pci_readw(struct pci_device *dev, uint16_t off);
+uint32_t pci_readl(struct pci_device *dev, uint16_t off);
+void pci_writeb(struct pci_device *dev, uint16_t off, uint8_t val);
+void pci_writew(struct pci_device *dev, uint16_t off, uint16_t val);
+void pci_writel(struct pci_device *dev, uint16_t off, uint32_t val);
+
+/*
+ * Find a device by vendor and device ID
+ *
+ * @vendor: Vendor ID
+ * @device: Device ID [0xFFFF for any]
+ * @after: Continue after this device [NULL to start over]
+ *
+ * Returns the device, NULL if not found
+ */
+struct pci_device *pci_find(uint16_t vendor, uint16_t device,
+    struct pci_device *after);
+
+/*
+ * Find a device by class code
+ *
+ * @class: Class code
+ * @subclass: Subclass [0xFF for any]
+ * @after: Continue after this device [NULL to start over]
+ *
+ * Returns the device, NULL if not found
+ */
+struct pci_device *pci_find_class(uint8_t class, uint8_t subclass,
+    struct pci_device *after);
+
+/*
+ * Find a capability within the capability list
+ *
+ * @dev: Device to search
+ * @id: Capability ID
+ * @start: Continue after this offset [zero to start over]
+ *
+ * Returns the config space offset, zero if not found
+ */
+uint8_t pci_find_cap(struct pci_device *dev, uint8_t id, uint8_t start);
+
+/*
+ * Set bits within the command register, e.g. to turn
+ * on bus mastering
+ */
+void pci_enable(struct pci_device *dev, uint16_t cmd);
+
+/*
+ * Map a memory BAR into the kernel
+ *
+ * @dev: Device owning the BAR
+ * @bar: BAR index
+ * @va_res: Virtual address is written here
+ *
+ * Returns zero on success
+ */
+int pci_map_bar(struct pci_device *dev, uint8_t bar, void **va_res);
+
+/*
+ * Get the number of MSI-X vectors a device supports,
+ * zero if it lacks MSI-X.
+ */
+uint16_t pci_msix_count(struct pci_device *dev);
+
+/*
+ * Allocate a vector for an MSI-X table entry, register a
+ * handler on it and unmask the entry. MSI-X is enabled on
+ * the first call.
+ *
+ * @dev: Device to allocate for
+ * @index: MSI-X table entry
+ * @ih: Handler to register [must stay valid]
+ * @ci: Processor to target [NULL to spread across cores]
+ *
+ * Returns zero on success
+ */
+int pci_msix_establish(struct pci_device *dev, uint16_t index,
+    struct intr_hand *ih, struct cpu_info *ci);
+
+/*
+ * Undo pci_msix_establish(), the entry is masked and its
+ * vector released. The handler may still be running on
+ * its processor when this returns.
+ *
+ * @dev: Device the entry belongs to
+ * @index: MSI-X table entry
+ * @ih: Handler that was registered
+ * @ci: Processor it was targeted at
+ */
+void pci_msix_disestablish(struct pci_device *dev, uint16_t index,
+    struct intr_hand *ih, struct cpu_info *ci);
+
+/*
+ * Mask or unmask an MSI-X table entry
+ */
+void pci_msix_mask(struct pci_device *dev, uint16_t index, bool mask);
+
+/*
+ * Allocate a single vector for MSI, register a handler on
+ * it and enable MSI.
+ *
+ * Returns zero on success
+ */
+int pci_msi_establish(struct pci_device *dev, struct intr_hand *ih,
+    struct cpu_info *ci);
+
+/*
+ * Enumerate every PCI(e) segment described by the MCFG
+ */
+void pci_init(void);
+
+#endif  /* !_PCI_PCI_H_ */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _PCI_PCIREG_H_
+#define _PCI_PCIREG_H_ 1
+
+#include <sys/param.h>
+
+/* Common header registers */
+#define PCIREG_VENDOR       0x00    /* Vendor ID [16] */
+#define PCIREG_DEVICE       0x02    /* Device ID [16] */
+#define PCIREG_CMD          0x04    /* Command [16] */
+#define PCIREG_STATUS       0x06    /* Status [16] */
+#define PCIREG_REVID        0x08    /* Revision ID [8] */
+#define PCIREG_PROGIF       0x09    /* Programming interface [8] */
+#define PCIREG_SUBCLASS     0x0A    /* Subclass [8] */
+#define PCIREG_CLASS        0x0B    /* Class code [8] */
+#define PCIREG_HDRTYPE      0x0E    /* Header type [8] */
+#define PCIREG_BAR0         0x10    /* First BAR [32] */
+#define PCIREG_SUBSYS       0x2E    /* Subsystem ID [16] */
+#define PCIREG_CAPPTR       0x34    /* Capabilities pointer [8] */
+#define PCIREG_INTLINE      0x3C    /* Interrupt line [8] */
+
+/* Type 1 (bridge) header registers */
+#define PCIREG_PRIBUS       0x18    /* Primary bus [8] */
+#define PCIREG_SECBUS       0x19    /* Secondary bus [8] */
+#define PCIREG_SUBBUS       0x1A    /* Subordinate bus [8] */
+
+/* Command register bits */
+#define PCI_CMD_IOEN        BIT(0)  /* I/O space decoding */
+#define PCI_CMD_MEMEN       BIT(1)  /* Memory space decoding */
+#define PCI_CMD_BMEN        BIT(2)  /* Bus mastering */
+#define PCI_CMD_INTXDIS     BIT(10) /* INTx disable */
+
+/* Status register bits */
+#define PCI_STATUS_CAPLIST  BIT(4)  /* Has capabilities list */
+
+/* Header types */
+#define PCI_HDR_TYPE(V)     ((V) & 0x7F)
+#define PCI_HDR_MF          BIT(7)  /* Multi-function */
+#define PCI_HDR_NORMAL      0x00
+#define PCI_HDR_BRIDGE      0x01
+
+/* BAR bits */
+#define PCI_BAR_IO          BIT(0)
+#define PCI_BAR_TYPE(V)     (((V) >> 1) & 0x3)
+#define PCI_BAR_TYPE64      0x02
+#define PCI_BAR_MEMMASK     (~0xFULL)
+#define PCI_BAR_IOMASK      (~0x3ULL)
+
+/* Capability IDs */
+#define PCI_CAP_MSI         0x05
+#define PCI_CAP_VENDOR      0x09
+#define PCI_CAP_PCIE        0x10
+#define PCI_CAP_MSIX        0x11
+
+/* MSI capability registers and bits */
+#define PCI_MSI_CTL         0x02    /* Message control [16] */
+#define PCI_MSI_ADDRLO      0x04    /* Message address low [32] */
+#define PCI_MSI_ADDRHI      0x08    /* Message address high [32] */
+#define PCI_MSI_DATA32      0x08    /* Message data, 32-bit [16] */
+#define PCI_MSI_DATA64      0x0C    /* Message data, 64-bit [16] */
+#define PCI_MSI_CTL_EN      BIT(0)  /* MSI enable */
+#define PCI_MSI_CTL_MME     (0x7 << 4)  /* Multiple message enable */
+#define PCI_MSI_CTL_64      BIT(7)  /* 64-bit address capable */
+
+/* MSI-X capability registers and bits */
+#define PCI_MSIX_CTL        0x02    /* Message control [16] */
+#define PCI_MSIX_TABLE      0x04    /* Table offset/BIR [32] */
+#define PCI_MSIX_PBA        0x08    /* PBA offset/BIR [32] */
+#define PCI_MSIX_CTL_EN     BIT(15) /* MSI-X enable */
+#define PCI_MSIX_CTL_FMASK  BIT(14) /* Function mask */
+#define PCI_MSIX_CTL_SIZE(V) (((V) & 0x7FF) + 1)
+#define PCI_MSIX_BIR(V)     ((V) & 0x7)
+#define PCI_MSIX_OFF(V)     ((V) & ~0x7)
+
+/* MSI-X table entry layout */
+#define PCI_MSIX_ENTSIZE    16
+#define PCI_MSIX_ENT_ADDRLO 0x00
+#define PCI_MSIX_ENT_ADDRHI 0x04
+#define PCI_MSIX_ENT_DATA   0x08
+#define PCI_MSIX_ENT_CTL    0x0C
+#define PCI_MSIX_ENT_MASK   BIT(0)
+
+/* Classes */
+#define PCI_CLASS_STORAGE   0x01
+#define PCI_CLASS_NETWORK   0x02
+#define PCI_CLASS_BRIDGE    0x06
+
+#endif  /* !_PCI_PCIREG_H_ */
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _TTY_TTY_H_
+#define _TTY_TTY_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <os/softint.h>
+#include <kern/spinlock.h>
+#include <lib/stdbool.h>
+
+/* Size of input rings, must be a power of two */
+#if !defined(TTY_RINGSIZE)
+#define TTY_RINGSIZE 256
+#endif  /* !TTY_RINGSIZE */
+
+/* Longest line canonical mode can edit */
+#if !defined(TTY_LINESIZE)
+#define TTY_LINESIZE 256
+#endif  /* !TTY_LINESIZE */
+
+#define TTY_NAMELEN 16
+
+/* Line discipline flags */
+#define TTY_ICANON  BIT(0)      /* Reads return whole lines */
+#define TTY_ECHO    BIT(1)      /* Echo input back */
+
+/* Control characters */
+#define TTY_CERASE  0x7F        /* Erase a character [DEL] */
+#define TTY_CBS     0x08        /* Erase a character [BS] */
+#define TTY_CKILL   0x15        /* Erase the line [^U] */
+
+struct tty;
+struct thread;
+struct vnode;
+
+/*
+ * Single producer, single consumer byte ring
+ *
+ * @head: Next slot to write [producer]
+ * @tail: Next slot to read [consumer]
+ * @buf: Ring storage
+ */
+struct tty_ring {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    char buf[TTY_RINGSIZE];
+};
+
+/*
+ * A terminal, input arrives from a driver interrupt and
+ * goes through the line discipline before readers see
+ * it.
+ *
+ * @name: Terminal name
+ * @flags: Line discipline flags (TTY_*)
+ * @output: Write bytes to the device
+ * @inq: Raw input from the driver [lock free]
+ * @readq: Input ready to be read
+ * @line: Canonical line being edited
+ * @linelen: Length of 'line'
+ * @lock: Protects everything below 'inq'
+ * @waiters: Threads waiting on input
+ * @work: Runs the line discipline
+ * @vp: VCHR vnode of the terminal
+ * @link: Terminal list link
+ */
+struct tty {
+    char name[TTY_NAMELEN];
+    uint32_t flags;
+    void(*output)(const char *s, size_t len);
+    struct tty_ring inq;
+    struct tty_ring readq;
+    char line[TTY_LINESIZE];
+    size_t linelen;
+    struct spinlock lock;
+    TAILQ_HEAD(, thread) waiters;
+    struct softint_work work;
+    struct vnode *vp;
+    TAILQ_ENTRY(tty) link;
+};
+
+/*
+ * Put a byte into a ring
+ *
+ * Returns false if the ring is full
+ */
+__always_inline static inline bool
+tty_ring_put(struct tty_ring *r, char c)
+{
+    uint32_t head = r->head;
+
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= TTY_RINGSIZE) {
+        return false;
+    }
+
+    r->buf[head & (TTY_RINGSIZE - 1)] = c;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Take a byte from a ring
+ *
+ * Returns false if the ring is empty
+ */
+__always_inline static inline bool
+tty_ring_get(struct tty_ring *r, char *c)
+{
+    uint32_t tail = r->tail;
+
+    if (tail == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    *c = r->buf[tail & (TTY_RINGSIZE - 1)];
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Register a terminal, 'name' and 'output' must be set
+ *
+ * Returns zero on success
+ */
+int tty_attach(struct tty *tp);
+
+/*
+ * Look up a terminal by name
+ *
+ * Returns zero on success
+ */
+int tty_lookup(const char *name, struct tty **res);
+
+/*
+ * Feed a byte of input to a terminal, called from the
+ * interrupt handler of its driver.
+ *
+ * XXX: There may only be one producer per terminal
+ */
+void tty_input(struct tty *tp, char c);
+
+/*
+ * Read input from a terminal, in canonical mode reads
+ * stop at the end of a line. Kernel threads sleep until
+ * there is input, system calls get -ERESTART and are put
+ * to sleep on their way back to user mode, the call runs
+ * again once they are woken.
+ *
+ * Returns the number of bytes read
+ */
+ssize_t tty_read(struct tty *tp, char *buf, size_t len);
+
+/*
+ * Write output to a terminal
+ *
+ * Returns the number of bytes written
+ */
+ssize_t tty_write(struct tty *tp, const char *buf, size_t len);
+
+/*
+ * Set the line discipline flags of a terminal
+ */
+void tty_setflags(struct tty *tp, uint32_t flags);
+
+/*
+ * Register the console and serial terminals
+ */
+void tty_init(void);
+
+#endif  /* !_TTY_TTY_H_ */
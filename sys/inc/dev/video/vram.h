@@ -36,28 +36,111 @@
 /*
  * Video RAM descriptor, contains information needed
  * to draw pixels onto the screen.
+ *
+ * @io: Framebuffer base
+ * @width: Width in pixels
+ * @height: Height in pixels
+ * @pitch: Bytes per scanline
+ * @bpp: Bits per pixel [16, 24 or 32]
+ * @red_size: Bits of red
+ * @red_shift: Position of red
+ * @green_size: Bits of green
+ * @green_shift: Position of green
+ * @blue_size: Bits of blue
+ * @blue_shift: Position of blue
+ * @native: Set if pixels are 32-bit 0x00RRGGBB
  */
 struct vram_dev {
-    uint32_t *io;
+    void *io;
     size_t width;
     size_t height;
     size_t pitch;
+    uint16_t bpp;
+    uint8_t red_size;
+    uint8_t red_shift;
+    uint8_t green_size;
+    uint8_t green_shift;
+    uint8_t blue_size;
+    uint8_t blue_shift;
+    uint8_t native : 1;
 };
 
 /*
- * Acquire a vram descriptor of the vram device
- * currently in-use.
+ * Returns the number of framebuffers handed to us
+ */
+size_t vram_count(void);
+
+/*
+ * Acquire a vram descriptor of a framebuffer
+ *
+ * @index: Framebuffer index
+ * @result: Descriptor is written here
+ *
+ * Returns zero on success, -ENOTSUP if its pixel
+ * format cannot be drawn to.
+ */
+int vram_getdev(size_t index, struct vram_dev *result);
+
+/*
+ * Write a row of 0x00RRGGBB pixels to a framebuffer,
+ * converting them to its pixel format.
+ *
+ * @vdp: Framebuffer to write to
+ * @x: Column to start at
+ * @y: Row to write
+ * @src: Pixels to write
+ * @n: Number of pixels
+ */
+void vram_write_row(struct vram_dev *vdp, size_t x, size_t y,
+    const uint32_t *src, size_t n);
+
+/*
+ * Fill a rectangle of a framebuffer with a 0x00RRGGBB
+ * color
  */
-int vram_getdev(struct vram_dev *result);
+void vram_fill(struct vram_dev *vdp, size_t x, size_t y, size_t w,
+    size_t h, uint32_t rgb);
+
+/*
+ * Scale one 8-bit color channel to a field of the
+ * pixel format
+ */
+__always_inline static inline uint32_t
+vram_channel(uint32_t val, uint8_t size, uint8_t shift)
+{
+    if (size < 8) {
+        val >>= (8 - size);
+    } else {
+        val <<= (size - 8);
+    }
+
+    return val << shift;
+}
+
+/*
+ * Convert a 0x00RRGGBB color to the pixel format of
+ * a framebuffer
+ */
+__always_inline static inline uint32_t
+vram_color(struct vram_dev *vdp, uint32_t rgb)
+{
+    if (vdp->native) {
+        return rgb;
+    }
+
+    return vram_channel((rgb >> 16) & 0xFF, vdp->red_size, vdp->red_shift) |
+        vram_channel((rgb >> 8) & 0xFF, vdp->green_size, vdp->green_shift) |
+        vram_channel(rgb & 0xFF, vdp->blue_size, vdp->blue_shift);
+}
 
 /*
- * Acquire the index of a pixel at a given set of
+ * Acquire the address of a pixel at a given set of
  * x,y coordinates in cartesian units.
  */
-__always_inline static size_t
-vram_index(struct vram_dev *vdp, size_t x, size_t y)
+__always_inline static inline void *
+vram_pixel(struct vram_dev *vdp, size_t x, size_t y)
 {
-    return x + y * (vdp->pitch / 4);
+    return (uint8_t *)vdp->io + (y * vdp->pitch) + (x * (vdp->bpp / 8));
 }
 
-#endif  /* !_VIDEO_FRAME_*/
+#endif  /* !_VIDEO_VRAM_H_ */
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VIRTIO_VIRTIO_H_
+#define _VIRTIO_VIRTIO_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+#include <kern/spinlock.h>
+#include <os/intr.h>
+#include <os/softint.h>
+#include <dev/pci/pci.h>
+
+#define VIRTIO_VENDOR       0x1AF4
+
+/* Device status bits */
+#define VIRTIO_ACKNOWLEDGE  BIT(0)
+#define VIRTIO_DRIVER       BIT(1)
+#define VIRTIO_DRIVER_OK    BIT(2)
+#define VIRTIO_FEATURES_OK  BIT(3)
+#define VIRTIO_FAILED       BIT(7)
+
+/* Device independent feature bits */
+#define VIRTIO_F_INDIRECT_DESC  BIT(28)
+#define VIRTIO_F_EVENT_IDX      BIT(29)
+#define VIRTIO_F_VERSION_1      BIT(32)
+
+/* PCI capability types */
+#define VIRTIO_PCI_CAP_COMMON   1
+#define VIRTIO_PCI_CAP_NOTIFY   2
+#define VIRTIO_PCI_CAP_ISR      3
+#define VIRTIO_PCI_CAP_DEVICE   4
+
+#define VIRTIO_MSI_NO_VECTOR    0xFFFF
+
+/* Descriptor flags */
+#define VIRTQ_DESC_F_NEXT       BIT(0)
+#define VIRTQ_DESC_F_WRITE      BIT(1)
+
+/* Ring flags */
+#define VIRTQ_AVAIL_F_NO_INTERRUPT  BIT(0)
+#define VIRTQ_USED_F_NO_NOTIFY      BIT(0)
+
+/*
+ * Modern PCI common configuration layout
+ */
+struct __packed virtio_pci_common_cfg {
+    uint32_t device_feature_select;
+    uint32_t device_feature;
+    uint32_t driver_feature_select;
+    uint32_t driver_feature;
+    uint16_t msix_config;
+    uint16_t num_queues;
+    uint8_t device_status;
+    uint8_t config_generation;
+    uint16_t queue_select;
+    uint16_t queue_size;
+    uint16_t queue_msix_vector;
+    uint16_t queue_enable;
+    uint16_t queue_notify_off;
+    uint64_t queue_desc;
+    uint64_t queue_driver;
+    uint64_t queue_device;
+};
+
+struct __packed virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+};
+
+struct __packed virtq_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];    /* Followed by used_event */
+};
+
+struct __packed virtq_used_elem {
+    uint32_t id;
+    uint32_t len;
+};
+
+struct __packed virtq_used {
+    uint16_t flags;
+    uint16_t idx;
+    struct virtq_used_elem ring[];  /* Followed by avail_event */
+};
+
+struct virtio_dev;
+struct cpu_info;
+
+/*
+ * Represents a split virtqueue
+ *
+ * @vdev: Device the queue belongs to
+ * @index: Queue index
+ * @size: Number of descriptors
+ * @desc: Descriptor table
+ * @avail: Driver ring
+ * @used: Device ring
+ * @phys: Physical base of the rings
+ * @npages: Pages backing the rings
+ * @notify: Notification register
+ * @free_head: First free descriptor
+ * @nfree: Number of free descriptors
+ * @avail_idx: Shadow of avail->idx
+ * @kick_idx: avail->idx at the last notification
+ * @last_used: Next used entry to harvest
+ * @cookie: Per head descriptor driver data
+ * @lock: Protects the queue
+ * @ih: Interrupt handler [MSI-X]
+ * @ci: Processor the handler is on
+ * @msix: MSI-X table entry of the handler
+ * @work: Deferred completion work
+ * @nkick: Notifications sent to the device
+ * @nsupp: Notifications suppressed by the event index
+ * @intr: Set if the queue has an MSI-X vector
+ */
+struct virtqueue {
+    struct virtio_dev *vdev;
+    uint16_t index;
+    uint16_t size;
+    volatile struct virtq_desc *desc;
+    volatile struct virtq_avail *avail;
+    volatile struct virtq_used *used;
+    uintptr_t phys;
+    size_t npages;
+    volatile uint16_t *notify;
+    uint16_t free_head;
+    uint16_t nfree;
+    uint16_t avail_idx;
+    uint16_t kick_idx;
+    uint16_t last_used;
+    void **cookie;
+    struct spinlock lock;
+    struct intr_hand ih;
+    struct cpu_info *ci;
+    uint16_t msix;
+    struct softint_work work;
+    size_t nkick;
+    size_t nsupp;
+    uint8_t intr : 1;
+};
+
+/*
+ * A buffer to be chained into a virtqueue
+ *
+ * @addr: Virtual address [must be within the HHDM]
+ * @len: Length in bytes
+ * @write: Set if the device writes to the buffer
+ */
+struct virtq_buf {
+    void *addr;
+    uint32_t len;
+    uint8_t write : 1;
+};
+
+/*
+ * Represents a modern (1.x) virtio PCI device
+ *
+ * @pci: Underlying PCI device
+ * @common: Common configuration
+ * @isr: ISR status register
+ * @devcfg: Device specific configuration
+ * @notify_base: Base of the notification area
+ * @notify_mul: Notification offset multiplier
+ * @features: Negotiated features
+ * @nvq: Number of virtqueues allocated
+ * @nvec: MSI-X entries handed out
+ * @vqs: Virtqueues
+ * @data: Driver private data
+ * @msix: Set if MSI-X vectors are in use
+ */
+struct virtio_dev {
+    struct pci_device *pci;
+    volatile struct virtio_pci_common_cfg *common;
+    volatile uint8_t *isr;
+    volatile void *devcfg;
+    volatile void *notify_base;
+    uint32_t notify_mul;
+    uint64_t features;
+    uint16_t nvq;
+    uint16_t nvec;
+    struct virtqueue *vqs;
+    void *data;
+    uint8_t msix : 1;
+};
+
+/*
+ * Attach to a virtio PCI device, reset it and negotiate
+ * features
+ *
+ * @vdev: Device to initialize
+ * @pci: PCI device
+ * @want: Features the driver supports
+ *
+ * Returns zero on success
+ */
+int virtio_attach(struct virtio_dev *vdev, struct pci_device *pci,
+    uint64_t want);
+
+/*
+ * Allocate room for virtqueues 0 to nvq - 1, each one is
+ * then set up with virtio_setup_queue().
+ *
+ * Returns zero on success
+ */
+int virtio_alloc_queues(struct virtio_dev *vdev, uint16_t nvq);
+
+/*
+ * Set up a single virtqueue, it is given the next free
+ * MSI-X entry targeted at 'ci' if there is one left.
+ *
+ * @vdev: Device to set up the queue for
+ * @index: Queue index
+ * @done: Completion handler [NULL if never interrupted]
+ * @ci: Processor to interrupt [NULL if never interrupted]
+ *
+ * Returns zero on success
+ */
+int virtio_setup_queue(struct virtio_dev *vdev, uint16_t index,
+    void(*done)(void *vq), struct cpu_info *ci);
+
+/*
+ * Allocate and set up queues 0 to nvq - 1, each one gets
+ * its own MSI-X vector targeted at its own processor when
+ * possible.
+ *
+ * @vdev: Device to set up queues for
+ * @nvq: Number of queues
+ * @done: Completion handler for each queue
+ *
+ * Returns zero on success
+ */
+int virtio_setup_queues(struct virtio_dev *vdev, uint16_t nvq,
+    void(*done)(void *vq));
+
+/*
+ * Tell the device the driver is ready
+ */
+void virtio_ready(struct virtio_dev *vdev);
+
+/*
+ * Reset a device and release its queues and vectors,
+ * used to back out of a failed attach.
+ */
+void virtio_detach(struct virtio_dev *vdev);
+
+/*
+ * Add a chain of buffers to a virtqueue without notifying
+ * the device, use virtq_kick() once the batch is complete.
+ *
+ * @vq: Queue to add to
+ * @bufs: Buffers, device readable ones first
+ * @nbufs: Number of buffers
+ * @cookie: Returned by virtq_harvest() on completion
+ *
+ * Returns zero on success, -EAGAIN if the queue is full
+ *
+ * XXX: Queue must be locked
+ */
+int virtq_add(struct virtqueue *vq, struct virtq_buf *bufs, uint16_t nbufs,
+    void *cookie);
+
+/*
+ * Notify the device of newly added buffers unless the
+ * device has asked not to be.
+ *
+ * XXX: Queue must be locked
+ */
+void virtq_kick(struct virtqueue *vq);
+
+/*
+ * Take the next completed chain off a virtqueue
+ *
+ * @vq: Queue to harvest
+ * @len_res: Bytes written by the device [optional]
+ *
+ * Returns the cookie of the chain, NULL if none
+ *
+ * XXX: Queue must be locked
+ */
+void *virtq_harvest(struct virtqueue *vq, uint32_t *len_res);
+
+/*
+ * Re-arm completion interrupts after harvesting, returns
+ * true if more completions raced in meanwhile.
+ *
+ * XXX: Queue must be locked
+ */
+bool virtq_rearm(struct virtqueue *vq);
+
+#endif  /* !_VIRTIO_VIRTIO_H_ */
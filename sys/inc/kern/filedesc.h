@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERN_FILEDESC_H_
+#define _KERN_FILEDESC_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+
+#define NDFILE   20         /* Slots in the initial table */
+#define FDMAX    1024       /* Max descriptors per process */
+
+/* File flags */
+#define FREAD    BIT(0)     /* Open for reading */
+#define FWRITE   BIT(1)     /* Open for writing */
+
+struct vnode;
+
+/*
+ * Represents an open file
+ *
+ * File objects are type-stable, once allocated they are
+ * only ever recycled as file objects and never given back
+ * to the heap. This lets lookups take a reference without
+ * holding the table lock, a stale pointer still points to
+ * a file object whose reference count may be inspected.
+ *
+ * @vp: Vnode of the file
+ * @offset: Current offset [atomic]
+ * @flags: File flags (see F*)
+ * @ref: Reference count [atomic]
+ * @link: Free list link
+ */
+struct file {
+    struct vnode *vp;
+    volatile off_t offset;
+    uint32_t flags;
+    volatile unsigned int ref;
+    TAILQ_ENTRY(file) link;
+};
+
+/*
+ * A table of file slots, tables are replaced rather than
+ * resized in place. A replaced table is retired and kept
+ * until the descriptor table is destroyed so that lockless
+ * readers holding it never touch freed memory.
+ *
+ * @nfiles: Number of slots
+ * @files: File slots
+ * @retired: Next retired table
+ */
+struct fdtable {
+    size_t nfiles;
+    struct file *volatile *files;
+    struct fdtable *retired;
+};
+
+/*
+ * Per process descriptor table
+ *
+ * @fdt: Current table [readers need no lock]
+ * @lock: Serializes slot allocation and table growth
+ * @freefd: Lowest slot that may be free
+ * @retired: Tables that have been replaced
+ * @fdt0: Initial table
+ * @files0: Slots of the initial table
+ */
+struct filedesc {
+    struct fdtable *volatile fdt;
+    struct spinlock lock;
+    int freefd;
+    struct fdtable *retired;
+    struct fdtable fdt0;
+    struct file *files0[NDFILE];
+};
+
+/*
+ * Initialize a descriptor table
+ *
+ * Returns zero on success
+ */
+int filedesc_init(struct filedesc *fdp);
+
+/*
+ * Close every descriptor and release the tables,
+ * there must be no other users of the table left.
+ */
+void filedesc_destroy(struct filedesc *fdp);
+
+/*
+ * Open a vnode within a descriptor table, the file takes
+ * over the reference held by the caller on success.
+ *
+ * @fdp: Descriptor table
+ * @vp: Vnode to open
+ * @flags: File flags (see F*)
+ * @fd_res: Descriptor is written here
+ *
+ * Returns zero on success
+ */
+int fd_open(struct filedesc *fdp, struct vnode *vp, uint32_t flags, int *fd_res);
+
+/*
+ * Close a descriptor
+ *
+ * Returns zero on success
+ */
+int fd_close(struct filedesc *fdp, int fd);
+
+/*
+ * Get the file behind a descriptor without taking the
+ * table lock, a reference is acquired that must be dropped
+ * with fdrop().
+ *
+ * @fdp: Descriptor table
+ * @fd: Descriptor to lookup
+ * @fp_res: File is written here
+ *
+ * Returns zero on success
+ */
+int fd_get(struct filedesc *fdp, int fd, struct file **fp_res);
+
+/*
+ * Drop a reference to a file
+ */
+void fdrop(struct file *fp);
+
+/*
+ * Read from a file at its current offset
+ *
+ * Returns the number of bytes read
+ */
+ssize_t file_read(struct file *fp, void *buf, size_t len);
+
+/*
+ * Write to a file at its current offset
+ *
+ * Returns the number of bytes written
+ */
+ssize_t file_write(struct file *fp, const void *buf, size_t len);
+
+#endif  /* !_KERN_FILEDESC_H_ */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERN_FUTEX_H_
+#define _KERN_FUTEX_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <sys/cdefs.h>
+#include <kern/spinlock.h>
+
+/* Number of wait queues, must be a power of two */
+#if !defined(FUTEX_NHASH)
+#define FUTEX_NHASH 256
+#endif  /* !FUTEX_NHASH */
+
+struct thread;
+
+/*
+ * A futex wait queue, each has its own lock so waits
+ * and wakes on unrelated words never contend.
+ *
+ * @lock: Protects this queue
+ * @waiters: Threads sleeping on words hashing here
+ */
+struct __aligned(COHERENCY_UNIT) futex_queue {
+    struct spinlock lock;
+    TAILQ_HEAD(, thread) waiters;
+};
+
+/*
+ * Sleep until woken if the word at 'uaddr' still holds
+ * 'val'. Userland only calls this once it has seen the
+ * lock contended, the uncontended path is a plain atomic
+ * on the word itself.
+ *
+ * Futexes are keyed by physical address so processes
+ * sharing a page share the futex.
+ *
+ * @uaddr: User address of a 32-bit aligned word
+ * @val: Value the word is expected to hold
+ *
+ * Returns zero once woken, -EAGAIN if the word no
+ * longer holds 'val'.
+ */
+int futex_wait(uintptr_t uaddr, uint32_t val);
+
+/*
+ * Wake up to 'count' threads sleeping on a word
+ *
+ * @uaddr: User address of the word
+ * @count: Max number of threads to wake
+ *
+ * Returns the number of threads woken
+ */
+int futex_wake(uintptr_t uaddr, uint32_t count);
+
+/*
+ * Initialize the futex wait queues
+ */
+void futex_init(void);
+
+#endif  /* !_KERN_FUTEX_H_ */
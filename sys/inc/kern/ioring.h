@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERN_IORING_H_
+#define _KERN_IORING_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+
+/* Largest ring that may be created */
+#define IORING_MAX_ENTRIES 256
+
+/*
+ * Valid I/O request operations
+ */
+typedef enum {
+    IO_OP_READ,
+    IO_OP_WRITE,
+    IO_OP_FLUSH
+} io_op_t;
+
+struct vnode;
+struct io_req;
+struct io_ring;
+
+/*
+ * Called once a request has completed, may be invoked
+ * from interrupt context.
+ */
+typedef void(*io_done_t)(struct io_req *req);
+
+/*
+ * Represents a single asynchronous I/O request
+ *
+ * @op: Operation to perform
+ * @vp: Target device vnode
+ * @buf: Data buffer
+ * @len: Length of the transfer in bytes
+ * @offset: Byte offset on the device
+ * @status: Bytes transferred or negative errno once complete
+ * @done: Completion callback [optional]
+ * @arg: Private data for the submitter
+ * @ring: Ring the request was submitted through [optional]
+ * @link: Used by drivers to queue the request
+ */
+struct io_req {
+    io_op_t op;
+    struct vnode *vp;
+    void *buf;
+    size_t len;
+    off_t offset;
+    ssize_t status;
+    io_done_t done;
+    void *arg;
+    struct io_ring *ring;
+    TAILQ_ENTRY(io_req) link;
+};
+
+TAILQ_HEAD(io_reqq, io_req);
+
+/*
+ * Completion queue entry
+ *
+ * @req: Request that completed
+ * @status: Bytes transferred or negative errno
+ */
+struct io_cqe {
+    struct io_req *req;
+    ssize_t status;
+};
+
+/*
+ * An I/O ring pairs a submission queue with a completion
+ * queue. The owner is the only producer of submissions and
+ * the only consumer of completions, drivers produce the
+ * completions from any processor.
+ *
+ * @sq: Submission queue entries
+ * @cq: Completion queue entries
+ * @mask: Number of entries minus one
+ * @sq_head: Next submission to hand to a driver
+ * @sq_tail: Next free submission slot
+ * @cq_head: Next completion to reap
+ * @cq_tail: Next free completion slot
+ * @outstanding: Queued but not yet reaped requests
+ * @cq_lock: Serializes completion producers
+ */
+struct io_ring {
+    struct io_req **sq;
+    struct io_cqe *cq;
+    uint32_t mask;
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    volatile unsigned int outstanding;
+    struct spinlock cq_lock;
+};
+
+/*
+ * Initialize an I/O ring
+ *
+ * @ring: Ring to initialize
+ * @nentries: Number of entries [power of two]
+ *
+ * Returns zero on success
+ */
+int ioring_init(struct io_ring *ring, uint32_t nentries);
+
+/*
+ * Release the resources of an I/O ring, there must be
+ * no requests outstanding.
+ *
+ * Returns zero on success
+ */
+int ioring_destroy(struct io_ring *ring);
+
+/*
+ * Place a request on the submission queue without
+ * handing it to a driver yet.
+ *
+ * Returns zero on success, -EAGAIN if the ring is full
+ */
+int ioring_queue(struct io_ring *ring, struct io_req *req);
+
+/*
+ * Hand every queued request to its driver, requests that
+ * target the same vnode back to back are passed down as
+ * a single batch.
+ *
+ * Returns the number of requests submitted
+ */
+ssize_t ioring_submit(struct io_ring *ring);
+
+/*
+ * Reap completed requests without blocking
+ *
+ * @ring: Ring to reap from
+ * @cqes: Completion entries are written here
+ * @max: Maximum number of entries to reap
+ *
+ * Returns the number of entries reaped
+ */
+size_t ioring_reap(struct io_ring *ring, struct io_cqe *cqes, size_t max);
+
+/*
+ * Signal the completion of a request, called by drivers
+ *
+ * @req: Request that completed
+ * @status: Bytes transferred or negative errno
+ */
+void ioring_complete(struct io_req *req, ssize_t status);
+
+#endif  /* !_KERN_IORING_H_ */
@@ -36,6 +36,7 @@
 
 /* Filesystem names */
 #define MOUNT_TMPFS "tmpfs"
+#define MOUNT_INITRAMFS "initramfs"
 
 struct mount;
 struct fs_info;
@@ -66,4 +66,23 @@ void spinlock_acquire(struct spinlock *lock, bool irqclr);
  */
 void spinlock_release(struct spinlock *lock, bool irqset);
 
+/*
+ * Acquire a spinlock with interrupts masked until it is
+ * released, any lock also taken from interrupt or soft
+ * interrupt context must use this.
+ *
+ * @lock: Lock to acquire
+ *
+ * Returns the previous interrupt state
+ */
+bool spinlock_acquire_irq(struct spinlock *lock);
+
+/*
+ * Release a spinlock taken with spinlock_acquire_irq()
+ *
+ * @lock: Lock to release
+ * @irq: Interrupt state it returned
+ */
+void spinlock_release_irq(struct spinlock *lock, bool irq);
+
 #endif  /* !_KERN_SPINLOCK_H_ */
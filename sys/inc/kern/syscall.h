@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _KERN_SYSCALL_H_
+#define _KERN_SYSCALL_H_ 1
+
+#include <sys/types.h>
+#include <sys/syscall.h>
+
+#define SYSCALL_NARGS 6
+
+/*
+ * Arguments of a system call
+ */
+struct syscall_args {
+    uint64_t arg[SYSCALL_NARGS];
+};
+
+typedef int64_t(*syscall_func_t)(struct syscall_args *args);
+
+/*
+ * Per processor system call counters, cycles are counted
+ * across the dispatch on the kernel side of the call.
+ *
+ * @count: Calls per system call number
+ * @nosys: Calls with a bad number
+ * @cycles: Total cycles spent
+ * @min: Fastest call in cycles
+ * @max: Slowest call in cycles
+ */
+struct syscall_stat {
+    size_t count[NSYSCALL];
+    size_t nosys;
+    uint64_t cycles;
+    uint64_t min;
+    uint64_t max;
+};
+
+/*
+ * Run a system call, called by the machine dependent
+ * entry code.
+ *
+ * @code: System call number
+ * @args: Arguments
+ *
+ * Returns the value to hand back to user mode
+ */
+int64_t syscall_dispatch(uint64_t code, struct syscall_args *args);
+
+/*
+ * Account a finished system call to the current
+ * processor.
+ */
+void syscall_account(uint64_t code, uint64_t cycles);
+
+/*
+ * Sum up the counters of every processor
+ */
+void syscall_stat(struct syscall_stat *res);
+
+#endif  /* !_KERN_SYSCALL_H_ */
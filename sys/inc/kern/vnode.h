@@ -31,8 +31,22 @@
 #define _OS_VNODE_H_
 
 #include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+/*
+ * Number of vnodes that may exist before unreferenced
+ * ones start getting recycled instead of allocated.
+ */
+#define VNODE_CACHE_MAX 512
+
+/* Vnode flags */
+#define VNODE_HASHED BIT(0)     /* Entered in the vnode cache */
+#define VNODE_FREE   BIT(1)     /* On the free (LRU) list */
 
 struct vnode;
+struct mount;
+struct io_reqq;
 
 /*
  * Valid vnode types
@@ -46,8 +60,14 @@ typedef enum {
 
 /*
  * Arguments for buffer operations
+ *
+ * @vp: Vnode being operated on
+ * @buffer: Data buffer
+ * @offset: Byte offset within the file
+ * @len: Length of the operation in bytes
  */
 struct vop_buf_args {
+    struct vnode *vp;
     void *buffer;
     off_t offset;
     size_t len;
@@ -56,14 +76,44 @@ struct vop_buf_args {
 /*
  * Arguments for lookup() vop
  *
+ * @dvp: Directory vnode to lookup within
  * @component: Path component to lookup
  * @vp_res: Resulting vnode pointer
  */
 struct vop_lookup_args {
+    struct vnode *dvp;
     const char *component;
     struct vnode **vp_res;
 };
 
+/*
+ * Arguments for submit() vop
+ *
+ * @vp: Vnode the requests target
+ * @reqq: Batch of requests to start
+ * @count: Number of requests within the batch
+ */
+struct vop_submit_args {
+    struct vnode *vp;
+    struct io_reqq *reqq;
+    size_t count;
+};
+
+/*
+ * Arguments for map() vop
+ *
+ * @vp: Vnode to map
+ * @offset: Byte offset within the file
+ * @len: Length of the range in bytes
+ * @res: Kernel address of the range is written here
+ */
+struct vop_map_args {
+    struct vnode *vp;
+    off_t offset;
+    size_t len;
+    void **res;
+};
+
 /*
  * Operations that can be performed on a vnode
  */
@@ -71,22 +121,35 @@ struct vops {
     ssize_t(*read)(struct vop_buf_args *args);
     ssize_t(*write)(struct vop_buf_args *args);
     int(*lookup)(struct vop_lookup_args *args);
+    int(*submit)(struct vop_submit_args *args);
+    int(*map)(struct vop_map_args *args);
     void(*reclaim)(struct vnode *vp);
 };
 
 /*
- * A virtual file node is an abstract repre
+ * A virtual file node is an abstract representation
+ * of a file within a filesystem.
  *
  * @type: Vnode type
  * @vops: Operations associated with vnode
- * @ref:  Reference counter
+ * @ref:  Reference counter [atomic]
  * @data: Filesystem specific data
+ * @mp: Mountpoint this vnode belongs to [cache key]
+ * @ino: Inode number within the mountpoint [cache key]
+ * @flags: Vnode flags (see VNODE_*)
+ * @hashq: Vnode cache hash chain link
+ * @lruq: Free list link
  */
 struct vnode {
     vtype_t type;
     struct vops vops;
-    int ref;
+    volatile unsigned int ref;
     void *data;
+    struct mount *mp;
+    ino_t ino;
+    uint8_t flags;
+    LIST_ENTRY(vnode) hashq;
+    TAILQ_ENTRY(vnode) lruq;
 };
 
 /*
@@ -126,7 +189,37 @@ int vnode_lookup(struct vnode *vp, const char *name, struct vnode **res);
 ssize_t vnode_write(struct vnode *vp, const void *buf, size_t size, off_t off);
 
 /*
- * Initialize a vnode by type
+ * Get a direct kernel mapping of a range of a file, only
+ * supported by filesystems whose data is already resident
+ * in memory. The mapping is read-only and remains valid for
+ * as long as a reference to the vnode is held.
+ *
+ * @vp: Vnode to map
+ * @off: Offset of the range
+ * @len: Length of the range
+ * @res: Kernel address of the range is written here
+ *
+ * Returns zero on success
+ */
+int vnode_map(struct vnode *vp, off_t off, size_t len, void **res);
+
+/*
+ * Start a batch of asynchronous I/O requests on a block
+ * or character device vnode. Devices that lack a submit()
+ * vop have their requests performed synchronously.
+ *
+ * @vp: Vnode to submit the batch to
+ * @reqq: Requests to submit, taken off the queue as started
+ * @count: Number of requests within the queue
+ *
+ * Returns zero on success, on failure the requests left in
+ * the queue are still owned by the caller.
+ */
+int vnode_submit(struct vnode *vp, struct io_reqq *reqq, size_t count);
+
+/*
+ * Initialize a vnode by type, the vnode may be recycled
+ * from the free list rather than freshly allocated.
  *
  * @vp_res: Vnode pointer result
  * @vtype: Vnode type to initialize
@@ -136,13 +229,60 @@ ssize_t vnode_write(struct vnode *vp, const void *buf, size_t size, off_t off);
 int vnode_init(struct vnode **vp_res, vtype_t type);
 
 /*
- * Release a vnode from memory
+ * Acquire an additional reference to a vnode, the
+ * caller must already hold a reference.
+ *
+ * @vp: Vnode to reference
+ */
+void vnode_ref(struct vnode *vp);
+
+/*
+ * Drop a reference to a vnode, once the last one is
+ * dropped the vnode is placed on the free list where
+ * it may either be revived by a cache hit or recycled.
  *
- * @vp: Vnode to release from memory
+ * @vp: Vnode to release
  *
  * Returns the reference count if not released, zero
  * on successful release.
  */
 int vnode_release(struct vnode *vp);
 
+/*
+ * Lookup a vnode within the vnode cache, a reference
+ * is acquired on success.
+ *
+ * @mp: Mountpoint the vnode belongs to
+ * @ino: Inode number of the vnode
+ * @vp_res: Result pointer is written here
+ *
+ * Returns zero on success, -ENOENT on a cache miss.
+ */
+int vnode_cache_lookup(struct mount *mp, ino_t ino, struct vnode **vp_res);
+
+/*
+ * Enter a vnode into the vnode cache so that later
+ * lookups by (mount, inode) may hit it.
+ *
+ * @vp: Vnode to enter
+ * @mp: Mountpoint the vnode belongs to
+ * @ino: Inode number of the vnode
+ *
+ * Returns zero on success, -EEXIST if the key is
+ * already cached.
+ */
+int vnode_cache_enter(struct vnode *vp, struct mount *mp, ino_t ino);
+
+/*
+ * Remove a vnode from the vnode cache
+ *
+ * @vp: Vnode to remove
+ */
+void vnode_cache_remove(struct vnode *vp);
+
+/*
+ * Initialize the vnode cache
+ */
+void vnode_cache_init(void);
+
 #endif  /* !_OS_VNODE_H_ */
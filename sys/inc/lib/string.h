@@ -39,9 +39,15 @@ void *memset(void *dest, int c, size_t len);
 /* POSIX memcpy() */
 void *memcpy(void *dest, const void *src, size_t len);
 
+/* POSIX memmove() */
+void *memmove(void *dest, const void *src, size_t len);
+
 /* POSIX strlen() */
 size_t strlen(const char *s);
 
+/* POSIX strnlen() */
+size_t strnlen(const char *s, size_t maxlen);
+
 /* POSIX strcmp() */
 int strcmp(const char *s1, const char *s2);
 
@@ -33,26 +33,70 @@
 #include <sys/queue.h>
 #include <sys/types.h>
 #include <os/process.h>
+#include <os/softint.h>
+#include <kern/syscall.h>
+#include <kern/spinlock.h>
 #include <md/mcb.h> /* shared */
 #include <md/gdt.h> /* shared */
 
+/* Processor flags */
+#define CPU_ISOLATED BIT(0)     /* Kept out of the general pool */
+#define CPU_TICKLESS BIT(1)     /* Scheduler tick is stopped */
+#define CPU_IDLEWAIT BIT(2)     /* Idle, a run queue write wakes it */
+
+struct intr_cpu;
+
 /*
- * Processor descriptor
+ * Processor descriptor, split into cache line aligned
+ * sections so that remote enqueues never bounce the
+ * lines the owner works on.
  *
+ * Local [owner only]:
+ * @kstack: Kernel stack top for entry from user mode
+ * @uscratch: User stack pointer saved by the system
+ *            call entry
+ * @curthread: Current thread
+ * @idle: Thread run when the run queue is empty
  * @id: Logical ID of the processor
  * @mcb: Machine core block
- * @curproc: Current process
- * @ap_gdt: GDT for APs [unused for BSP]
+ * @intr: Interrupt vector state
+ * @softint: Soft interrupt state
+ * @sysstat: System call counters
+ *
+ * Shared [written by other processors]:
+ * @pqueue: Run queue of threads
+ * @flags: CPU_* flags [atomic]
+ * @pqueue_lock: Protects the run queue
+ *
+ * Cold [bring up and privilege changes]:
+ * @tss: Task state segment
  * @ap_gdtr: GDTR for APs [unused for BSP]
- * @pqueue: Process queue
+ * @ap_gdt: GDT for APs [unused for BSP]
+ *
+ * XXX: 'kstack' and 'uscratch' are reached through GS
+ *      from assembly, see CI_* in md/cpu.h
+ *
+ * XXX: Idle processors MWAIT on the 'pqueue' line,
+ *      keep it free of anything the owner writes.
  */
 struct cpu_info {
+    uintptr_t kstack;
+    uintptr_t uscratch;
+    struct thread *curthread;
+    struct thread *idle;
     uint8_t id;
     struct mcb mcb;
-    struct process *curproc;
-    struct gdt_entry ap_gdt[256];
+    struct intr_cpu *intr;
+    struct softint_cpu softint;
+    struct syscall_stat sysstat;
+
+    TAILQ_HEAD(, thread) pqueue __aligned(COHERENCY_UNIT);
+    volatile uint32_t flags;
+    struct spinlock pqueue_lock;
+
+    struct tss tss __aligned(COHERENCY_UNIT);
     struct gdtr ap_gdtr;
-    TAILQ_HEAD(, process) pqueue;
+    struct gdt_entry ap_gdt[256];
 };
 
 /*
@@ -71,6 +115,28 @@ struct cpu_info *cpu_get(uint32_t index);
  */
 size_t cpu_count(void);
 
+/*
+ * Pick a processor from the general pool for work that
+ * is not bound anywhere, isolated processors are never
+ * returned.
+ *
+ * @hint: Spreads the choice, e.g. a counter or an ID
+ */
+struct cpu_info *cpu_pick(uint32_t hint);
+
+/*
+ * Make a processor rescan its run queue, used to restart
+ * a stopped scheduler tick.
+ *
+ * XXX: The caller must have interrupts masked
+ */
+void cpu_kick(struct cpu_info *ci);
+
+/*
+ * Hint to the processor that we are spinning
+ */
+void cpu_pause(void);
+
 /*
  * Configure a processor core
  */
@@ -30,11 +30,46 @@
 #ifndef _MU_IRQ_H_
 #define _MU_IRQ_H_ 1
 
+#include <sys/types.h>
 #include <lib/stdbool.h>
 
+struct cpu_info;
+
 /*
  * Returns true if IRQs are enabled
  */
 bool mu_irq_state(void);
 
+/*
+ * Enable or disable IRQs on the current processor
+ */
+void mu_irq_enable(void);
+void mu_irq_disable(void);
+
+/*
+ * Install the entry points of every allocatable
+ * interrupt vector
+ */
+void mu_intr_init(void);
+
+/*
+ * Signal the end of the interrupt being serviced
+ * on the current processor
+ */
+void mu_intr_eoi(void);
+
+/*
+ * Compose a message signaled interrupt that delivers
+ * a vector to a processor
+ *
+ * @ci: Processor to target
+ * @vec: Vector to deliver
+ * @addr_res: Message address is written here
+ * @data_res: Message data is written here
+ *
+ * Returns zero on success
+ */
+int mu_msi_compose(struct cpu_info *ci, uint8_t vec, uint64_t *addr_res,
+    uint32_t *data_res);
+
 #endif  /* !_MU_IRQ_H_ */
@@ -49,6 +49,25 @@ __strong int mu_pmap_map(
     uint16_t prot, pagesize_t ps
 );
 
+/*
+ * Remove the mapping of a single page, the page itself
+ * is not freed.
+ *
+ * Returns zero on success, -EFAULT if not mapped
+ */
+__strong int mu_pmap_unmap(struct mmu_vas *vas, uintptr_t va);
+
+/*
+ * Get the physical address a virtual address maps to
+ *
+ * @vas: Address space to look in
+ * @va: Virtual address to translate
+ * @res: Physical address is written here
+ *
+ * Returns zero on success, -EFAULT if not mapped
+ */
+__strong int mu_pmap_translate(struct mmu_vas *vas, uintptr_t va, uintptr_t *res);
+
 /*
  * Copy the current VAS leaving the user-side
  * zeroed
@@ -72,4 +91,11 @@ __strong int mu_pmap_writevas(struct mmu_vas *vas);
  */
 __strong void mu_pmap_init(void);
 
+/*
+ * Handle a page fault trap, faults on user addresses
+ * are resolved through the map of the current process.
+ */
+struct trapframe;
+void mu_pmap_fault(struct trapframe *tf);
+
 #endif  /* !_MU_PMAP_H_ */
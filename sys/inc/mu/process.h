@@ -31,19 +31,68 @@
 #define _MU_PROCESS_H_
 
 #include <sys/types.h>
+#include <sys/cdefs.h>
 #include <os/process.h>
+#include <os/thread.h>
 #include <md/frame.h>       /* shared */
 
 /*
  * Initialize machine specific process fields
  *
  * @process: Process to initialize
+ * @flags: PROC_* flags
+ */
+int mu_process_init(struct process *process, int flags);
+
+/*
+ * Initialize machine specific thread fields, kernel
+ * threads get a guard paged kernel stack and the
+ * main user thread gets its user stack.
+ *
+ * @td: Thread to initialize, 'proc' must be set
  * @ip: Instruction pointer
+ * @arg: Argument passed in the first register
+ * @flags: PROC_* flags
+ */
+int mu_thread_init(struct thread *td, uintptr_t ip, uintptr_t arg, int flags);
+
+/*
+ * Release machine specific thread resources, the
+ * thread must never run again.
+ */
+void mu_thread_free(struct thread *td);
+
+/*
+ * Switch away from the current thread for good, it is
+ * handed to thread_retire() once off its stack.
+ *
+ * @td: Current thread
+ */
+__dead void mu_thread_exit(struct thread *td);
+
+/*
+ * Switch out the current thread if it is going to
+ * sleep, its context is saved from the trapframe and
+ * the next thread is loaded into it.
+ *
+ * @tf: Trapframe
+ *
+ * Returns nonzero if the trapframe now belongs to
+ * another thread.
+ */
+int mu_thread_block(struct trapframe *tf);
+
+/*
+ * Give up the processor, a thread that called
+ * sched_sleep() stays switched out until woken.
+ *
+ * XXX: Kernel threads only, system calls run on the
+ *      per processor stack.
  */
-int mu_process_init(struct process *process, uintptr_t ip, int flags);
+void mu_thread_yield(void);
 
 /*
- * Context switch to the next process
+ * Context switch to the next thread
  *
  * @tf: Trapframe
  */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_ETHER_H_
+#define _NET_ETHER_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/pbuf.h>
+
+#define ETHERTYPE_IP    0x0800
+#define ETHERTYPE_ARP   0x0806
+
+/* ARP opcodes */
+#define ARP_REQUEST     1
+#define ARP_REPLY       2
+
+/* Number of ARP cache entries */
+#define ARP_NENT        64
+
+struct __packed ether_header {
+    uint8_t dhost[ETHER_ADDR_LEN];
+    uint8_t shost[ETHER_ADDR_LEN];
+    uint16_t type;
+};
+
+struct __packed arp_packet {
+    uint16_t hrd;
+    uint16_t pro;
+    uint8_t hln;
+    uint8_t pln;
+    uint16_t op;
+    uint8_t sha[ETHER_ADDR_LEN];
+    in_addr_t spa;
+    uint8_t tha[ETHER_ADDR_LEN];
+    in_addr_t tpa;
+};
+
+/*
+ * Receive handler installed on the interface, runs to
+ * completion on the core the frame arrived on.
+ */
+void ether_input(struct netif_pkt *pkt, void *arg);
+
+/*
+ * Send an IPv4 packet to the next hop, the frame is held
+ * while the next hop is being resolved.
+ *
+ * @ifa: Interface to send on
+ * @nexthop: Next hop address [host order]
+ * @pb: Packet with the IP header pushed
+ *
+ * Returns zero if the packet was queued
+ */
+int ether_output(struct net_ifaddr *ifa, in_addr_t nexthop, struct pbuf *pb);
+
+/*
+ * Handle an ARP packet
+ */
+void arp_input(struct net_ifaddr *ifa, struct netif_pkt *pkt);
+
+/*
+ * Set up the ARP cache
+ */
+void arp_init(void);
+
+#endif  /* !_NET_ETHER_H_ */
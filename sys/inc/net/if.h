@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_IF_H_
+#define _NET_IF_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <lib/stdbool.h>
+
+#define IFNAMSIZ        16
+#define ETHER_ADDR_LEN  6
+#define ETHER_HDR_LEN   14
+
+/* Default link MTU */
+#define IF_MTU          1500
+
+struct netif;
+
+/*
+ * Describes part of an outgoing frame, transmit is
+ * zero-copy so the memory must stay untouched until the
+ * send completes.
+ *
+ * @base: Virtual address [must be within the HHDM]
+ * @len: Length in bytes
+ */
+struct netif_iov {
+    void *base;
+    size_t len;
+};
+
+/*
+ * A received frame, it lives in a buffer owned by the
+ * driver and must be handed back with netif_rxfree()
+ * once the consumer is done with it.
+ *
+ * @nif: Interface the frame arrived on
+ * @data: Start of the Ethernet header
+ * @len: Length of the frame
+ * @rxq: Receive queue the frame arrived on
+ * @hash: Flow hash [set by the protocol stack]
+ * @nhdr: Network layer header [set by the protocol stack]
+ * @priv: Driver private data
+ * @link: For use by the current owner
+ *
+ * Protocol layers strip their headers by advancing
+ * 'data' and shrinking 'len'.
+ */
+struct netif_pkt {
+    struct netif *nif;
+    void *data;
+    uint16_t len;
+    uint16_t rxq;
+    uint32_t hash;
+    void *nhdr;
+    void *priv;
+    TAILQ_ENTRY(netif_pkt) link;
+};
+
+TAILQ_HEAD(netif_pktq, netif_pkt);
+
+/*
+ * Called once the device no longer needs the memory of
+ * a transmitted frame.
+ */
+typedef void(*netif_txdone_t)(void *arg, int status);
+
+/*
+ * Receives frames from an interface, runs on the core
+ * the frame arrived on.
+ */
+typedef void(*netif_input_t)(struct netif_pkt *pkt, void *arg);
+
+/*
+ * Operations provided by network drivers
+ *
+ * @transmit: Queue a frame on a transmit queue
+ * @rxfree: Give a receive buffer back to the device
+ * @poll: Reap completions without waiting for an
+ *        interrupt [optional]
+ */
+struct netif_ops {
+    int(*transmit)(struct netif *nif, uint16_t txq, struct netif_iov *iov,
+        uint16_t niov, netif_txdone_t done, void *arg);
+    void(*rxfree)(struct netif *nif, struct netif_pkt *pkt);
+    void(*poll)(struct netif *nif);
+};
+
+/*
+ * Interface counters
+ */
+struct netif_stat {
+    size_t ipackets;
+    size_t ibytes;
+    size_t idrops;
+    size_t opackets;
+    size_t obytes;
+    size_t oerrors;
+};
+
+/*
+ * Represents a network interface
+ *
+ * @name: Name of the interface
+ * @hwaddr: Link layer address
+ * @mtu: Maximum transmission unit
+ * @nqueues: Number of TX/RX queue pairs
+ * @ops: Driver operations
+ * @input: Receive handler
+ * @input_arg: Argument passed to the receive handler
+ * @stat: Counters
+ * @data: Driver private data
+ * @link: Interface list link
+ */
+struct netif {
+    char name[IFNAMSIZ];
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+    uint16_t mtu;
+    uint16_t nqueues;
+    struct netif_ops *ops;
+    netif_input_t input;
+    void *input_arg;
+    struct netif_stat stat;
+    void *data;
+    TAILQ_ENTRY(netif) link;
+};
+
+/*
+ * Register a network interface
+ *
+ * Returns zero on success
+ */
+int netif_register(struct netif *nif);
+
+/*
+ * Lookup a network interface by name, returns zero
+ * on success
+ */
+int netif_lookup(const char *name, struct netif **res);
+
+/*
+ * Get an interface by index, NULL if out of range
+ */
+struct netif *netif_get(size_t index);
+
+/*
+ * Set the receive handler of an interface, frames are
+ * dropped while there is none.
+ */
+void netif_set_input(struct netif *nif, netif_input_t input, void *arg);
+
+/*
+ * Send a raw Ethernet frame on the transmit queue of the
+ * current core.
+ *
+ * @nif: Interface to send on
+ * @iov: Parts of the frame
+ * @niov: Number of parts
+ * @done: Called once the memory can be reused [optional]
+ * @arg: Argument passed to 'done'
+ *
+ * Returns zero if the frame was queued
+ */
+int netif_send(struct netif *nif, struct netif_iov *iov, uint16_t niov,
+    netif_txdone_t done, void *arg);
+
+/*
+ * Hand a received frame to the receive handler, called
+ * by drivers.
+ */
+void netif_input(struct netif_pkt *pkt);
+
+/*
+ * Give a received frame back to its driver
+ */
+void netif_rxfree(struct netif_pkt *pkt);
+
+/*
+ * Reap completions of an interface by polling
+ */
+void netif_poll(struct netif *nif);
+
+/*
+ * Initialize the interface list
+ */
+void netif_init(void);
+
+#endif  /* !_NET_IF_H_ */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_IP_H_
+#define _NET_IP_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/pbuf.h>
+
+#define IPVERSION       4
+#define IP_TTL          64
+
+#define IPPROTO_TCP     6
+#define IPPROTO_UDP     17
+
+/* Fragment field */
+#define IP_DF           0x4000
+#define IP_MF           0x2000
+#define IP_OFFMASK      0x1FFF
+
+struct __packed ip {
+    uint8_t vhl;
+    uint8_t tos;
+    uint16_t len;
+    uint16_t id;
+    uint16_t off;
+    uint8_t ttl;
+    uint8_t p;
+    uint16_t sum;
+    in_addr_t src;
+    in_addr_t dst;
+};
+
+#define IP_HLEN(IP) (((IP)->vhl & 0xF) << 2)
+#define IP_V(IP)    ((IP)->vhl >> 4)
+
+/*
+ * Internet checksum of a buffer
+ *
+ * @buf: Data to sum
+ * @len: Length in bytes
+ * @sum: Partial sum to start from
+ */
+uint16_t in_cksum(const void *buf, size_t len, uint32_t sum);
+
+/*
+ * Partial sum of the TCP/UDP pseudo header, addresses
+ * are in network order.
+ */
+uint32_t in_pseudo(in_addr_t src, in_addr_t dst, uint8_t proto,
+    uint16_t len);
+
+/*
+ * Handle an IPv4 packet
+ */
+void ip_input(struct net_ifaddr *ifa, struct netif_pkt *pkt);
+
+/*
+ * Push an IPv4 header and route the packet out
+ *
+ * @pb: Packet with the transport header pushed
+ * @proto: Transport protocol
+ * @src: Source address [host order, INADDR_ANY for ours]
+ * @dst: Destination address [host order]
+ *
+ * Returns zero if the packet was queued
+ */
+int ip_output(struct pbuf *pb, uint8_t proto, in_addr_t src, in_addr_t dst);
+
+#endif  /* !_NET_IP_H_ */
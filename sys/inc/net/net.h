@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_NET_H_
+#define _NET_NET_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <kern/spinlock.h>
+#include <net/if.h>
+
+/*
+ * Static interface configuration, defaults match the
+ * QEMU user-mode network.
+ */
+#if !defined(NET_IPADDR)
+#define NET_IPADDR  0x0A00020F  /* 10.0.2.15 */
+#endif
+#if !defined(NET_NETMASK)
+#define NET_NETMASK 0xFFFFFF00  /* 255.255.255.0 */
+#endif
+#if !defined(NET_GATEWAY)
+#define NET_GATEWAY 0x0A000202  /* 10.0.2.2 */
+#endif
+
+#define INADDR_ANY          0x00000000
+#define INADDR_BROADCAST    0xFFFFFFFF
+
+typedef uint32_t in_addr_t;
+typedef uint16_t in_port_t;
+
+/* Network byte order helpers [amd64 is little endian] */
+#define htons(X)    __builtin_bswap16(X)
+#define ntohs(X)    __builtin_bswap16(X)
+#define htonl(X)    __builtin_bswap32(X)
+#define ntohl(X)    __builtin_bswap32(X)
+
+/*
+ * Per processor protocol counters, packets are handled
+ * start to finish on the core they arrived on so these
+ * never bounce.
+ */
+struct net_stat {
+    size_t ip_in;
+    size_t ip_out;
+    size_t ip_drop;
+    size_t udp_in;
+    size_t udp_drop;
+    size_t tcp_in;
+    size_t tcp_drop;
+    size_t tcp_rexmt;
+};
+
+/*
+ * An interface with an IPv4 address, the stack only
+ * drives a single one.
+ *
+ * @nif: Network interface
+ * @addr: Address [host order]
+ * @mask: Netmask [host order]
+ * @gw: Default gateway [host order]
+ */
+struct net_ifaddr {
+    struct netif *nif;
+    in_addr_t addr;
+    in_addr_t mask;
+    in_addr_t gw;
+};
+
+/*
+ * Get the configured interface, NULL if there is none
+ */
+struct net_ifaddr *net_ifaddr(void);
+
+/*
+ * Get the counters of the current processor
+ */
+struct net_stat *net_stat_self(void);
+
+/*
+ * Compute the RSS (Toeplitz) hash of an IPv4 flow, all
+ * arguments are in network order.
+ */
+uint32_t net_flow_hash(in_addr_t saddr, in_addr_t daddr, in_port_t sport,
+    in_port_t dport);
+
+/*
+ * Get the processor a flow hash steers to
+ */
+uint32_t net_flow_cpu(uint32_t hash);
+
+/*
+ * Poll every interface for completions
+ */
+void net_poll(void);
+
+/*
+ * Bring up the protocol stack on the first interface
+ */
+void net_init(void);
+
+#endif  /* !_NET_NET_H_ */
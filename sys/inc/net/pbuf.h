@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_PBUF_H_
+#define _NET_PBUF_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+
+#define PBUF_SIZE       2048    /* Including the descriptor */
+#define PBUF_HEADROOM   128     /* Room for protocol headers */
+#define PBUF_CACHE      64      /* Max cached per processor */
+
+/* Transmit state */
+#define PBUF_BUSY       BIT(0)  /* Device still reading it */
+#define PBUF_ORPHAN     BIT(1)  /* Free once the device is done */
+
+/*
+ * An outgoing packet buffer, payload starts at 'data'
+ * and headers are pushed in front of it.
+ *
+ * @data: Start of the payload
+ * @len: Length of the payload
+ * @hlen: Length of the headers in front of 'data'
+ * @seq: TCP sequence number of the payload
+ * @state: Transmit state
+ * @link: For use by the current owner
+ * @buf: Backing storage
+ */
+struct pbuf {
+    uint8_t *data;
+    uint16_t len;
+    uint16_t hlen;
+    uint32_t seq;
+    volatile uint32_t state;
+    TAILQ_ENTRY(pbuf) link;
+    uint8_t buf[];
+};
+
+TAILQ_HEAD(pbufq, pbuf);
+
+/* Max payload of a single packet buffer */
+#define PBUF_MAXDATA (PBUF_SIZE - sizeof(struct pbuf) - PBUF_HEADROOM)
+
+/*
+ * Allocate a packet buffer from the slab cache of the
+ * current processor, NULL if out of memory.
+ */
+struct pbuf *pbuf_alloc(void);
+
+/*
+ * Return a packet buffer to the slab
+ */
+void pbuf_free(struct pbuf *pb);
+
+/*
+ * Push a header of 'len' bytes in front of what is
+ * already there, returns where to write it.
+ */
+void *pbuf_push(struct pbuf *pb, uint16_t len);
+
+/*
+ * Drop every pushed header
+ */
+void pbuf_reset(struct pbuf *pb);
+
+/*
+ * Free a buffer as soon as the device is done with it
+ */
+void pbuf_release(struct pbuf *pb);
+
+/*
+ * Transmit completion callback for netif_send()
+ */
+void pbuf_txdone(void *arg, int status);
+
+/*
+ * Set up the per processor caches
+ */
+void pbuf_init(void);
+
+#endif  /* !_NET_PBUF_H_ */
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_SOCKET_H_
+#define _NET_SOCKET_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <lib/stdbool.h>
+
+#define AF_INET         2
+
+#define SOCK_STREAM     1
+#define SOCK_DGRAM      2
+
+/* Max packets held on a receive queue */
+#define SO_RCVQMAX      64
+
+/* Socket state */
+#define SS_ISCONNECTED  BIT(0)
+#define SS_CANTRCVMORE  BIT(1)
+#define SS_LISTENING    BIT(2)
+#define SS_CLOSED       BIT(3)  /* Closed by its user */
+
+/* Ephemeral port range */
+#define IPPORT_EPHEMERAL_FIRST  49152
+#define IPPORT_EPHEMERAL_LAST   65535
+
+struct sockaddr_in {
+    uint8_t sin_len;
+    uint8_t sin_family;
+    in_port_t sin_port;
+    in_addr_t sin_addr;
+    uint8_t sin_zero[8];
+};
+
+struct socket;
+struct tcpcb;
+
+/*
+ * Internet protocol control block, addresses and ports
+ * are in network order.
+ *
+ * @so: Socket we belong to
+ * @laddr: Local address
+ * @faddr: Foreign address
+ * @lport: Local port
+ * @fport: Foreign port
+ * @hash: Flow hash [connected only]
+ * @bound: Set if in the bind table
+ * @connected: Set if in the connection table
+ * @bind_link: Bind table link
+ * @conn_link: Connection table link
+ */
+struct inpcb {
+    struct socket *so;
+    in_addr_t laddr;
+    in_addr_t faddr;
+    in_port_t lport;
+    in_port_t fport;
+    uint32_t hash;
+    uint8_t bound : 1;
+    uint8_t connected : 1;
+    LIST_ENTRY(inpcb) bind_link;
+    LIST_ENTRY(inpcb) conn_link;
+};
+
+/*
+ * Represents a socket
+ *
+ * @type: SOCK_STREAM or SOCK_DGRAM
+ * @proto: IP protocol
+ * @ref: Reference count
+ * @state: SS_* bits
+ * @error: Pending error
+ * @cpu: Core the flow is steered to
+ * @lock: Protects the socket
+ * @pcb: Protocol control block
+ * @tp: TCP control block [stream only]
+ * @rcvq: Received packets, handed up without copying
+ * @rcvqlen: Number of packets on the receive queue
+ * @rcvoff: Bytes already read from the first packet
+ * @head: Listening socket we came from
+ * @acceptq: Connections not yet accepted [listening only]
+ * @qlen: Length of the accept queue
+ * @qlimit: Max length of the accept queue
+ * @qlink: Accept queue link
+ */
+struct socket {
+    uint8_t type;
+    uint8_t proto;
+    volatile uint32_t ref;
+    volatile uint32_t state;
+    int error;
+    uint16_t cpu;
+    struct spinlock lock;
+    struct inpcb pcb;
+    struct tcpcb *tp;
+    struct netif_pktq rcvq;
+    uint16_t rcvqlen;
+    uint16_t rcvoff;
+    struct socket *head;
+    TAILQ_HEAD(, socket) acceptq;
+    uint16_t qlen;
+    uint16_t qlimit;
+    TAILQ_ENTRY(socket) qlink;
+};
+
+/*
+ * Sockets never block since there is nothing to sleep
+ * on yet, calls that would block return -EAGAIN and the
+ * caller may net_poll() and retry.
+ */
+int sock_create(int type, struct socket **res);
+int sock_bind(struct socket *so, const struct sockaddr_in *sin);
+int sock_listen(struct socket *so, uint16_t backlog);
+int sock_accept(struct socket *so, struct socket **res);
+int sock_connect(struct socket *so, const struct sockaddr_in *sin);
+ssize_t sock_send(struct socket *so, const void *buf, size_t len,
+    const struct sockaddr_in *to);
+ssize_t sock_recv(struct socket *so, void *buf, size_t len,
+    struct sockaddr_in *from);
+int sock_close(struct socket *so);
+
+/*
+ * Take the next received packet without copying, 'data'
+ * and 'len' describe the payload. The packet must be
+ * given back with netif_rxfree().
+ *
+ * Returns zero on success, '*res' is NULL once the peer
+ * closed the stream.
+ */
+int sock_recvpkt(struct socket *so, struct netif_pkt **res,
+    struct sockaddr_in *from);
+
+/*
+ * Protocol side interface, sock_enqueue() takes over the
+ * packet unless the receive queue is full.
+ *
+ * XXX: sock_enqueue() needs the socket locked
+ */
+struct socket *sock_alloc(int type);
+void sock_ref(struct socket *so);
+void sock_rele(struct socket *so);
+bool sock_enqueue(struct socket *so, struct netif_pkt *pkt);
+
+/*
+ * Lookup the socket a packet belongs to, a connected
+ * socket wins over a bound one. The socket is returned
+ * referenced. Addresses and ports are in network order.
+ */
+struct socket *in_pcblookup(uint8_t proto, in_addr_t faddr, in_port_t fport,
+    in_addr_t laddr, in_port_t lport, uint32_t hash);
+
+/*
+ * Bind to a local port, zero picks an ephemeral one
+ */
+int in_pcbbind(struct socket *so, in_addr_t laddr, in_port_t lport);
+
+/*
+ * Enter a socket in the connection table, an ephemeral
+ * port is picked so that the flow steers to the current
+ * processor.
+ */
+int in_pcbconnect(struct socket *so, in_addr_t faddr, in_port_t fport);
+
+/*
+ * Remove a socket from the tables
+ */
+void in_pcbdetach(struct socket *so);
+
+/*
+ * Set up the protocol control block tables
+ */
+void in_pcbinit(void);
+
+#endif  /* !_NET_SOCKET_H_ */
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_TCP_H_
+#define _NET_TCP_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/pbuf.h>
+#include <net/socket.h>
+
+/* Header flags */
+#define TH_FIN          0x01
+#define TH_SYN          0x02
+#define TH_RST          0x04
+#define TH_PUSH         0x08
+#define TH_ACK          0x10
+
+/* Options */
+#define TCPOPT_EOL      0
+#define TCPOPT_NOP      1
+#define TCPOPT_MAXSEG   2
+
+/* Connection states */
+#define TCPS_CLOSED         0
+#define TCPS_LISTEN         1
+#define TCPS_SYN_SENT       2
+#define TCPS_SYN_RECEIVED   3
+#define TCPS_ESTABLISHED    4
+#define TCPS_CLOSE_WAIT     5
+#define TCPS_FIN_WAIT_1     6
+#define TCPS_CLOSING        7
+#define TCPS_LAST_ACK       8
+#define TCPS_FIN_WAIT_2     9
+#define TCPS_TIME_WAIT      10
+
+/* Sequence number comparison */
+#define SEQ_LT(A, B)    ((int32_t)((A) - (B)) < 0)
+#define SEQ_LEQ(A, B)   ((int32_t)((A) - (B)) <= 0)
+#define SEQ_GT(A, B)    ((int32_t)((A) - (B)) > 0)
+#define SEQ_GEQ(A, B)   ((int32_t)((A) - (B)) >= 0)
+
+/* Largest segment we send on a default MTU link */
+#if !defined(TCP_MSS)
+#define TCP_MSS         (IF_MTU - 40)
+#endif
+
+/* Segment size assumed if the peer sends no option */
+#define TCP_MSS_DFLT    536
+
+/* Max segments queued for sending */
+#if !defined(TCP_SNDQMAX)
+#define TCP_SNDQMAX     64
+#endif
+
+/*
+ * Timer values in scheduler ticks, the retransmit
+ * timeout backs off up to TCP_MAXRXTSHIFT times before
+ * the connection is dropped.
+ */
+#if !defined(TCP_RTO_TICKS)
+#define TCP_RTO_TICKS   25
+#endif
+#if !defined(TCP_RTO_MAX)
+#define TCP_RTO_MAX     800
+#endif
+#if !defined(TCP_MSL_TICKS)
+#define TCP_MSL_TICKS   100
+#endif
+#define TCP_MAXRXTSHIFT 8
+
+/* Control block flags */
+#define TF_ACKNOW       BIT(0)  /* Send an ACK right away */
+#define TF_NEEDFIN      BIT(1)  /* Send a FIN after the data */
+#define TF_SENTFIN      BIT(2)  /* FIN is out */
+
+struct __packed tcphdr {
+    in_port_t sport;
+    in_port_t dport;
+    uint32_t seq;
+    uint32_t ack;
+    uint8_t off;
+    uint8_t flags;
+    uint16_t win;
+    uint16_t sum;
+    uint16_t urp;
+};
+
+#define TH_OFF(TH) (((TH)->off >> 4) << 2)
+
+/*
+ * TCP control block, protected by the socket lock
+ * except for the timer which belongs to the timer
+ * list of its processor.
+ *
+ * @so: Socket we belong to
+ * @state: Connection state
+ * @flags: TF_* flags
+ * @rxtshift: Retransmit backoff
+ * @mss: Max segment size to send
+ * @iss: Initial send sequence
+ * @snd_una: Oldest unacknowledged sequence
+ * @snd_nxt: Next sequence to send
+ * @snd_max: Highest sequence sent
+ * @snd_end: Sequence after the last queued byte
+ * @snd_wnd: Window of the peer
+ * @irs: Initial receive sequence
+ * @rcv_nxt: Next sequence expected
+ * @sndq: Queued segments, kept until acknowledged
+ * @sndqlen: Number of queued segments
+ * @cpu: Processor whose timer list we are on
+ * @timer: Ticks until the timer fires, zero if idle
+ * @timer_link: Timer list link
+ */
+struct tcpcb {
+    struct socket *so;
+    uint8_t state;
+    uint8_t flags;
+    uint8_t rxtshift;
+    uint16_t mss;
+    uint32_t iss;
+    uint32_t snd_una;
+    uint32_t snd_nxt;
+    uint32_t snd_max;
+    uint32_t snd_end;
+    uint32_t snd_wnd;
+    uint32_t irs;
+    uint32_t rcv_nxt;
+    struct pbufq sndq;
+    uint16_t sndqlen;
+    uint16_t cpu;
+    uint32_t timer;
+    TAILQ_ENTRY(tcpcb) timer_link;
+};
+
+/*
+ * Handle a TCP segment, the IP header is stripped
+ */
+void tcp_input(struct netif_pkt *pkt);
+
+/*
+ * Give a stream socket a control block, the protocol
+ * holds a reference on the socket from the time the
+ * connection leaves CLOSED until it is back.
+ *
+ * Returns zero on success
+ */
+int tcp_attach(struct socket *so);
+
+/*
+ * Start an active open, the socket is connected
+ *
+ * XXX: Socket must be locked
+ */
+int tcp_connect(struct socket *so);
+
+/*
+ * Turn a bound socket into a listener
+ *
+ * XXX: Socket must be locked
+ */
+int tcp_listen(struct socket *so);
+
+/*
+ * Queue data for sending, returns the number of bytes
+ * queued or -EAGAIN if the send queue is full.
+ *
+ * XXX: Socket must be locked
+ */
+ssize_t tcp_send(struct socket *so, const void *buf, size_t len);
+
+/*
+ * Called after the user took a packet off the receive
+ * queue, opens the window again if it was shut.
+ *
+ * XXX: Socket must be locked
+ */
+void tcp_rcvd(struct socket *so);
+
+/*
+ * The user closed the socket, start the close
+ * handshake.
+ *
+ * XXX: Socket must be locked and referenced
+ */
+void tcp_usrclose(struct socket *so);
+
+/*
+ * Set up the timer lists
+ */
+void tcp_init(void);
+
+#endif  /* !_NET_TCP_H_ */
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _NET_UDP_H_
+#define _NET_UDP_H_ 1
+
+#include <sys/types.h>
+#include <sys/cdefs.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/socket.h>
+
+struct __packed udphdr {
+    in_port_t sport;
+    in_port_t dport;
+    uint16_t len;
+    uint16_t sum;
+};
+
+/* Max payload of a datagram on a default MTU link */
+#define UDP_MAXDATA (IF_MTU - 20 - sizeof(struct udphdr))
+
+/*
+ * Handle a UDP datagram, the IP header is stripped
+ */
+void udp_input(struct netif_pkt *pkt);
+
+/*
+ * Send a datagram from a bound socket
+ *
+ * @so: Socket to send from
+ * @buf: Payload
+ * @len: Length of the payload
+ * @faddr: Destination address [network order]
+ * @fport: Destination port [network order]
+ *
+ * Returns the number of bytes sent
+ */
+ssize_t udp_output(struct socket *so, const void *buf, size_t len,
+    in_addr_t faddr, in_port_t fport);
+
+#endif  /* !_NET_UDP_H_ */
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OS_INTR_H_
+#define _OS_INTR_H_ 1
+
+#include <sys/types.h>
+#include <kern/spinlock.h>
+#include <lib/stdbool.h>
+#include <md/intr.h>    /* shared */
+
+/* Handler return values */
+#define INTR_UNHANDLED  0   /* Interrupt was not for us */
+#define INTR_HANDLED    1   /* Interrupt was serviced */
+
+struct cpu_info;
+
+/*
+ * Interrupt handler callback
+ *
+ * @arg: Argument given at registration
+ *
+ * Returns INTR_HANDLED if the interrupt was serviced
+ */
+typedef int(*intr_func_t)(void *arg);
+
+/*
+ * Represents a registered interrupt handler, handlers that
+ * share a vector are chained and each one is called in turn.
+ *
+ * @name: Name of the handler
+ * @func: Handler callback
+ * @arg: Argument passed to the callback
+ * @count: Number of interrupts serviced
+ * @next: Next handler on the vector
+ */
+struct intr_hand {
+    const char *name;
+    intr_func_t func;
+    void *arg;
+    size_t count;
+    struct intr_hand *volatile next;
+};
+
+/*
+ * Per vector state
+ *
+ * @head: Handler chain [readers need no lock]
+ * @count: Number of times the vector fired
+ * @nstray: Number of times no handler claimed it
+ */
+struct intr_vec {
+    struct intr_hand *volatile head;
+    size_t count;
+    size_t nstray;
+};
+
+/*
+ * Per processor interrupt state, as every processor has
+ * its own IDT view of the vectors, each one allocates them
+ * independently.
+ *
+ * @lock: Serializes allocation and handler chain updates
+ * @bitmap: Allocated vectors
+ * @vec: Vector state, indexed from IVEC_MIN
+ */
+struct intr_cpu {
+    struct spinlock lock;
+    uint64_t bitmap[4];
+    struct intr_vec vec[NIVEC];
+};
+
+/*
+ * Initialize the interrupt state of a processor
+ *
+ * Returns zero on success
+ */
+int intr_cpu_init(struct cpu_info *ci);
+
+/*
+ * Allocate a free vector on a processor
+ *
+ * @ci: Processor to allocate on
+ * @vec_res: Vector is written here
+ *
+ * Returns zero on success
+ */
+int intr_alloc(struct cpu_info *ci, uint8_t *vec_res);
+
+/*
+ * Mark a specific vector as in use on a processor
+ *
+ * Returns zero on success, -EBUSY if already taken
+ */
+int intr_reserve(struct cpu_info *ci, uint8_t vec);
+
+/*
+ * Release a vector, its handler chain must be empty
+ */
+void intr_free(struct cpu_info *ci, uint8_t vec);
+
+/*
+ * Add a handler to the chain of a vector
+ *
+ * @ci: Processor the vector belongs to
+ * @vec: Vector to add the handler to
+ * @ih: Handler to add [must stay valid until removed]
+ *
+ * Returns zero on success
+ */
+int intr_register(struct cpu_info *ci, uint8_t vec, struct intr_hand *ih);
+
+/*
+ * Remove a handler from the chain of a vector, the
+ * handler may still be running on its processor when
+ * this returns.
+ *
+ * Returns zero on success
+ */
+int intr_unregister(struct cpu_info *ci, uint8_t vec, struct intr_hand *ih);
+
+/*
+ * Allocate a vector and register a handler on it
+ *
+ * @name: Name of the handler
+ * @func: Handler callback
+ * @arg: Argument to pass
+ * @ci: Processor to use [NULL for current]
+ * @vec_res: Allocated vector is written here
+ *
+ * Returns zero on success
+ */
+int intr_establish(const char *name, intr_func_t func, void *arg,
+    struct cpu_info *ci, uint8_t *vec_res);
+
+/*
+ * Undo intr_establish(), the vector must not be able to
+ * fire anymore as its handler is freed right away.
+ *
+ * @ci: Processor the vector belongs to
+ * @vec: Vector returned by intr_establish()
+ *
+ * Returns zero on success
+ */
+int intr_disestablish(struct cpu_info *ci, uint8_t vec);
+
+/*
+ * Move the handlers of a vector over to a newly allocated
+ * vector on another processor and free the old one. The
+ * source must not fire while this runs.
+ *
+ * @from: Processor the vector belongs to
+ * @vec: Vector to move
+ * @to: Processor to move to
+ * @vec_res: New vector is written here
+ *
+ * Returns zero on success
+ */
+int intr_move(struct cpu_info *from, uint8_t vec, struct cpu_info *to,
+    uint8_t *vec_res);
+
+/*
+ * Dispatch an interrupt to the handlers of a vector,
+ * called from the common interrupt entry.
+ */
+void intr_dispatch(uint64_t vec);
+
+#endif  /* !_OS_INTR_H_ */
@@ -33,36 +33,67 @@
 #include <sys/types.h>
 #include <sys/param.h>
 #include <sys/queue.h>
-#include <md/pcb.h>     /* shared */
+#include <kern/filedesc.h>
+#include <kern/spinlock.h>
+#include <vm/map.h>
+#include <md/vas.h>     /* shared */
 
-/* Flags for proc_init() */
+/* Flags for process_init() and thread_create() */
 #define PROC_KERN BIT(0)     /* Kernel thread */
 
+struct thread;
+struct vnode;
+
 /*
- * Represents a running process on the
- * system
+ * Represents a running process on the system, the
+ * threads of a process share its address space and
+ * file descriptors.
  *
  * @pid: Process ID
- * @affinity: Processor affinity
- * @pcb: Process control block
- * @link: Queue link
+ * @vas: Virtual address space
+ * @fd: File descriptor table
+ * @map: User address space map
+ * @lock: Protects the thread list
+ * @threads: Threads of this process
+ * @nthreads: Number of threads
  */
 struct process {
     pid_t pid;
-    id_t affinity;
-    struct pcb pcb;
-    TAILQ_ENTRY(process) link;
+    struct mmu_vas vas;
+    struct filedesc fd;
+    struct vm_map map;
+    struct spinlock lock;
+    TAILQ_HEAD(, thread) threads;
+    size_t nthreads;
 };
 
 /*
- * Initialize a process to a known state
+ * The kernel process, owns every kernel thread
+ */
+extern struct process proc0;
+
+/*
+ * Initialize a process to a known state, it has no
+ * threads until thread_create() is used.
  *
  * @process: Process to initialize
- * @ip: Instruction pointer to jump to
  * @flags: Optional flags
  *
  * Returns zero on success
  */
-int process_init(struct process *process, uintptr_t ip, int flags);
+int process_init(struct process *process, int flags);
+
+/*
+ * Initialize a user process running an ELF executable,
+ * its segments are paged in on demand.
+ *
+ * @process: Process to initialize
+ * @vp: Vnode of the executable
+ * @td_res: Main thread is written here, it is not yet
+ *          on a run queue
+ *
+ * Returns zero on success
+ */
+int process_exec(struct process *process, struct vnode *vp, struct thread **td_res);
 
 #endif  /* !_OS_PROCESS_H_ */
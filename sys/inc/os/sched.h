@@ -31,20 +31,80 @@
 #define _OS_SCHED_H_
 
 #include <sys/types.h>
-#include <os/process.h>
+#include <lib/stdbool.h>
+#include <os/thread.h>
 #include <mu/cpu.h>
 
 #define SCHED_QUANTUM 9000  /* In usec */
 
 /*
- * Enqueue a process into a runqueue and return the processor
+ * Enqueue a thread into a runqueue and return the processor
  * now associated
  */
-struct cpu_info *sched_enqueue_proc(struct process *proc);
+struct cpu_info *sched_enqueue_thread(struct thread *td);
 
 /*
- * Dequeue a process from the current core
+ * Dequeue a thread from the current core
  */
-struct process *sched_dequeue_proc(void);
+struct thread *sched_dequeue_thread(void);
+
+/*
+ * Stop the scheduler tick of an isolated processor if
+ * it has nothing else queued, its current thread then
+ * runs until something is enqueued on it.
+ *
+ * @ci: Processor, must be the current one
+ *
+ * Returns true if the tick was stopped
+ */
+bool sched_stop_tick(struct cpu_info *ci);
+
+/*
+ * Move a processor between the general pool and the
+ * isolated set. Isolated processors only run threads
+ * pinned to them, get no unbound interrupts and stop
+ * their tick when idle or running a single thread.
+ *
+ * XXX: Interrupts already routed to the processor
+ *      stay there.
+ *
+ * @cpu: Logical processor ID
+ * @isolate: True to isolate, false to return it
+ *
+ * Returns zero on success, -EBUSY if it is the last
+ * processor in the general pool.
+ */
+int sched_isolate(uint32_t cpu, bool isolate);
+
+/*
+ * Put the current thread to sleep, it is switched out
+ * on its way back to user mode or, for kernel threads,
+ * by sched_yield(). The caller must make it reachable
+ * by a waker before calling this.
+ *
+ * @wchan: What the thread is sleeping on
+ */
+void sched_sleep(uintptr_t wchan);
+
+/*
+ * Mark a sleeping thread as switched out, the saved
+ * context must already be in its PCB.
+ *
+ * Returns false if it was woken in the meantime and
+ * should keep running instead.
+ */
+bool sched_block(struct thread *td);
+
+/*
+ * Give up the processor from a kernel thread
+ */
+void sched_yield(void);
+
+/*
+ * Wake up a sleeping thread
+ *
+ * @td: Thread to wake up
+ */
+void sched_wakeup(struct thread *td);
 
 #endif  /* !_OS_SCHED_H_ */
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OS_SOFTINT_H_
+#define _OS_SOFTINT_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <lib/stdbool.h>
+
+/*
+ * Soft interrupt levels, lower levels run first
+ */
+#define SOFTINT_TIMER   0       /* Timer callbacks */
+#define SOFTINT_WORK    1       /* Work items [drivers] */
+#define NSOFTINT        2
+
+/*
+ * Number of items a handler may process per call and the
+ * number of times pending levels are rescanned before the
+ * rest is left for the idle loop.
+ */
+#define SOFTINT_BUDGET  64
+#define SOFTINT_RESTART 4
+
+/*
+ * Soft interrupt handler, it runs with interrupts enabled
+ * on top of whatever kernel code was interrupted. Locks it
+ * shares with thread context must be taken through
+ * spinlock_acquire_irq() on both sides.
+ *
+ * @budget: Max number of items to process
+ *
+ * Returns true if work is left over
+ */
+typedef bool(*softint_func_t)(size_t budget);
+
+/*
+ * A deferred work item
+ *
+ * @func: Function to run
+ * @arg: Argument to pass
+ * @queued: Set while on a queue
+ * @link: Queue link
+ */
+struct softint_work {
+    void(*func)(void *arg);
+    void *arg;
+    volatile uint8_t queued;
+    TAILQ_ENTRY(softint_work) link;
+};
+
+/*
+ * Per processor soft interrupt state
+ *
+ * @pending: Pending levels [atomic]
+ * @active: Set while soft interrupts run
+ * @workq: Queued work items
+ * @nrun: Number of times each level ran
+ */
+struct softint_cpu {
+    volatile uint32_t pending;
+    uint8_t active;
+    TAILQ_HEAD(, softint_work) workq;
+    size_t nrun[NSOFTINT];
+};
+
+/*
+ * Set the handler of a soft interrupt level
+ *
+ * Returns zero on success
+ */
+int softint_establish(uint8_t level, softint_func_t func);
+
+/*
+ * Mark a level as pending on the current processor,
+ * it runs on the next interrupt exit or idle.
+ */
+void softint_raise(uint8_t level);
+
+/*
+ * Queue a work item on the current processor, does
+ * nothing if it is already queued.
+ */
+void softint_queue(struct softint_work *work);
+
+/*
+ * Run pending soft interrupts on the current processor
+ * within the budget, called on interrupt exit and from
+ * the idle loop.
+ */
+void softint_run(void);
+
+/*
+ * Initialize the soft interrupt state of the current
+ * processor
+ */
+void softint_cpu_init(void);
+
+#endif  /* !_OS_SOFTINT_H_ */
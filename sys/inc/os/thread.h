@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _OS_THREAD_H_
+#define _OS_THREAD_H_ 1
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <sys/cdefs.h>
+#include <md/pcb.h>     /* shared */
+
+/* Kernel thread-local storage per thread */
+#if !defined(KTHREAD_TLS_SIZE)
+#define KTHREAD_TLS_SIZE 0x1000
+#endif  /* !KTHREAD_TLS_SIZE */
+
+/* Scheduling states */
+#define THREAD_RUN     0    /* Runnable or running */
+#define THREAD_SLEEP   1    /* Going to sleep */
+#define THREAD_BLOCKED 2    /* Asleep and switched out */
+
+struct process;
+
+/*
+ * A thread of execution within a process
+ *
+ * @tid: Thread ID
+ * @affinity: Processor affinity
+ * @proc: Process this thread belongs to
+ * @pcb: Thread control block
+ * @kstack: Kernel stack base [kernel threads]
+ * @tls: Thread-local storage block [kernel threads]
+ * @state: Scheduling state (THREAD_*) [atomic]
+ * @wchan: What we are sleeping on
+ * @link: Run queue link
+ * @sleepq: Sleep queue link
+ * @plink: Process thread list link
+ */
+struct thread {
+    pid_t tid;
+    id_t affinity;
+    struct process *proc;
+    struct pcb pcb;
+    uintptr_t kstack;
+    void *tls;
+    volatile unsigned int state;
+    uintptr_t wchan;
+    TAILQ_ENTRY(thread) link;
+    TAILQ_ENTRY(thread) sleepq;
+    TAILQ_ENTRY(thread) plink;
+};
+
+/*
+ * Create a thread within a process, the thread is not
+ * put on a run queue.
+ *
+ * @proc: Process the thread belongs to
+ * @ip: Instruction pointer to start at
+ * @arg: Argument passed in the first register
+ * @flags: PROC_KERN for a kernel thread
+ * @res: Thread is written here [optional]
+ *
+ * Returns zero on success
+ */
+int thread_create(struct process *proc, uintptr_t ip, uintptr_t arg, int flags,
+    struct thread **res);
+
+/*
+ * Create a kernel thread and make it runnable, it runs
+ * on its own guard paged stack with FS pointing to its
+ * thread-local storage.
+ *
+ * @func: Function to run
+ * @arg: Argument passed to 'func'
+ * @cpu: Processor to pin to, -1 for any
+ * @res: Thread is written here [optional]
+ *
+ * Returns zero on success
+ */
+int kthread_create(void(*func)(void *), void *arg, id_t cpu, struct thread **res);
+
+/*
+ * Terminate the current kernel thread, returning from
+ * the function of a kernel thread ends up here too.
+ */
+__dead void kthread_exit(void);
+
+/*
+ * Queue a thread that exited and is no longer running
+ * to have its resources freed
+ */
+void thread_retire(struct thread *td);
+
+/*
+ * Get the thread-local storage of the current kernel
+ * thread
+ */
+void *kthread_tls(void);
+
+/*
+ * Initialize the kernel process
+ */
+void kthread_init(void);
+
+#endif  /* !_OS_THREAD_H_ */
@@ -104,6 +104,29 @@ atomic_store_64_nv(volatile uint64_t *p, long nv, unsigned int v)
     __atomic_store_n(p, nv, v);
 }
 
+/*
+ * Atomic compare-and-swap operations, these return
+ * the value found at 'p' before the operation, the
+ * swap happened if it equals 'old'.
+ */
+static inline unsigned int
+atomic_cas_int(volatile unsigned int *p, unsigned int old, unsigned int nv)
+{
+    return __sync_val_compare_and_swap(p, old, nv);
+}
+
+static inline unsigned long
+atomic_cas_long(volatile unsigned long *p, unsigned long old, unsigned long nv)
+{
+    return __sync_val_compare_and_swap(p, old, nv);
+}
+
+static inline void *
+atomic_cas_ptr(void *volatile *p, void *old, void *nv)
+{
+    return __sync_val_compare_and_swap(p, old, nv);
+}
+
 /* Atomic increment (and fetch) operations */
 #define atomic_inc_long(P) atomic_add_long_nv((P), 1)
 #define atomic_inc_int(P) atomic_add_int_nv((P), 1)
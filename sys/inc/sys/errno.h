@@ -153,4 +153,8 @@
 #define EILSEQ 138
 #define EOVERFLOW 139	/* Value too large for defined data type */
 
+#if defined(_KERNEL)
+#define ERESTART 512	/* Restart the system call once woken */
+#endif  /* _KERNEL */
+
 #endif  /* !_SYS_ERRNO_H_ */
@@ -57,4 +57,7 @@ typedef ssize_t     ptrdiff_t;
 typedef int32_t     id_t;
 typedef id_t        pid_t;
 
+/* Filesystem types */
+typedef uint64_t    ino_t;
+
 #endif  /* !_SYS_TYPES_H_ */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VM_MAP_H_
+#define _VM_MAP_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+
+struct vnode;
+struct mmu_vas;
+
+/*
+ * A range of a user address space that is populated
+ * on demand. Pages of read-only ranges that are fully
+ * backed by the file are shared through the page cache,
+ * all others get a private copy.
+ *
+ * @start: Page aligned start address
+ * @end: Page aligned end address [exclusive]
+ * @fend: Address where file backed data ends
+ * @prot: Protection flags (PROT_*)
+ * @vp: Backing vnode, NULL for anonymous memory
+ * @off: File offset of 'start'
+ * @link: Map entry link
+ */
+struct vm_mapent {
+    uintptr_t start;
+    uintptr_t end;
+    uintptr_t fend;
+    uint16_t prot;
+    struct vnode *vp;
+    off_t off;
+    TAILQ_ENTRY(vm_mapent) link;
+};
+
+/*
+ * Per process list of map entries
+ *
+ * @entries: Map entries sorted by address
+ * @lock: Protects this map
+ */
+struct vm_map {
+    TAILQ_HEAD(, vm_mapent) entries;
+    struct spinlock lock;
+};
+
+/*
+ * Initialize an empty map
+ */
+void vm_map_init(struct vm_map *map);
+
+/*
+ * Add a range to a map, nothing is mapped until it
+ * is first touched.
+ *
+ * @map: Map to add to
+ * @va: Start address of the range
+ * @len: Length of the range in bytes
+ * @prot: Protection flags
+ * @vp: Backing vnode, NULL for anonymous memory
+ * @off: File offset that 'va' maps to
+ * @filesz: Bytes of the range backed by the file
+ *
+ * Returns zero on success
+ */
+int vm_map_insert(
+    struct vm_map *map, uintptr_t va, size_t len,
+    uint16_t prot, struct vnode *vp, off_t off,
+    size_t filesz
+);
+
+/*
+ * Remove every entry from a map
+ *
+ * XXX: Pages already faulted in are not unmapped, only
+ *      use this on maps that were never touched.
+ */
+void vm_map_clear(struct vm_map *map);
+
+/*
+ * Populate the page that contains an address
+ *
+ * @map: Map the address belongs to
+ * @vas: Address space to populate
+ * @va: Faulting address
+ * @access: Access that faulted (PROT_*)
+ *
+ * Returns zero on success, -EFAULT if the access
+ * is not allowed.
+ */
+int vm_fault(struct vm_map *map, struct mmu_vas *vas, uintptr_t va, uint16_t access);
+
+#endif  /* !_VM_MAP_H_ */
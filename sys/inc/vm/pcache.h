@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VM_PCACHE_H_
+#define _VM_PCACHE_H_ 1
+
+#include <sys/types.h>
+#include <sys/queue.h>
+
+/* Number of page cache hash buckets */
+#if !defined(PCACHE_NHASH)
+#define PCACHE_NHASH 256
+#endif  /* !PCACHE_NHASH */
+
+struct vnode;
+
+/*
+ * A page of file data shared between every mapping
+ * of that page.
+ *
+ * @vp: Vnode the page belongs to [cache key]
+ * @off: Page aligned file offset [cache key]
+ * @pa: Physical address of the page
+ * @ref: Reference count
+ * @hashq: Hash chain link
+ */
+struct pcache_page {
+    struct vnode *vp;
+    off_t off;
+    uintptr_t pa;
+    uint32_t ref;
+    LIST_ENTRY(pcache_page) hashq;
+};
+
+/*
+ * Get a page of file data, reading it in on a miss.
+ * A reference to the page is acquired on success.
+ *
+ * @vp: Vnode to get a page of
+ * @off: Page aligned offset within the file
+ * @res: Physical address of the page is written here
+ *
+ * Returns zero on success
+ */
+int pcache_get(struct vnode *vp, off_t off, uintptr_t *res);
+
+/*
+ * Drop a reference acquired by pcache_get(), the page
+ * is freed once the last reference is dropped.
+ *
+ * @vp: Vnode the page belongs to
+ * @off: Page aligned offset within the file
+ */
+void pcache_put(struct vnode *vp, off_t off);
+
+/*
+ * Initialize the page cache
+ */
+void pcache_init(void);
+
+#endif  /* !_VM_PCACHE_H_ */
@@ -41,6 +41,9 @@ extern volatile struct limine_hhdm_request hhdm_req;
 #define PHYS_TO_VIRT(PHYS) PTR_OFFSET(PHYS, KERN_BASE)
 #define VIRT_TO_PHYS(VIRT) (uintptr_t)PTR_NOFFSET(VIRT, KERN_BASE)
 
+/* Highest user address [lower canonical half] */
+#define VM_MAXUSER 0x00007FFFFFFFFFFF
+
 /*
  * Initialize the virtual memory management
  * subsystem
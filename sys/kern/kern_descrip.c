@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/atomic.h>
+#include <sys/queue.h>
+#include <kern/filedesc.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <kern/vnode.h>
+#include <vm/kalloc.h>
+#include <lib/stdbool.h>
+#include <lib/string.h>
+
+/*
+ * Pool of unused file objects, see the comment above
+ * struct file in filedesc.h as for why these are never
+ * freed.
+ */
+__cacheline_aligned
+static struct spinlock file_lock;
+static TAILQ_HEAD(, file) file_freeq = TAILQ_HEAD_INITIALIZER(file_freeq);
+static bool is_file_init = false;
+
+static struct file *
+file_alloc(void)
+{
+    struct file *fp;
+
+    spinlock_acquire(&file_lock, true);
+    if ((fp = TAILQ_FIRST(&file_freeq)) != NULL) {
+        TAILQ_REMOVE(&file_freeq, fp, link);
+    }
+    spinlock_release(&file_lock, true);
+
+    if (fp == NULL && (fp = kalloc(sizeof(*fp))) == NULL) {
+        return NULL;
+    }
+
+    fp->vp = NULL;
+    fp->offset = 0;
+    fp->flags = 0;
+    return fp;
+}
+
+static void
+file_free(struct file *fp)
+{
+    spinlock_acquire(&file_lock, true);
+    TAILQ_INSERT_HEAD(&file_freeq, fp, link);
+    spinlock_release(&file_lock, true);
+}
+
+/*
+ * Acquire a reference to a file unless the count has
+ * already dropped to zero, returns true on success.
+ */
+static bool
+file_ref_nonzero(struct file *fp)
+{
+    unsigned int ref;
+
+    for (;;) {
+        ref = atomic_load_int_nv(&fp->ref, __ATOMIC_ACQUIRE);
+        if (ref == 0) {
+            return false;
+        }
+
+        if (atomic_cas_int(&fp->ref, ref, ref + 1) == ref) {
+            return true;
+        }
+    }
+}
+
+/*
+ * Replace the current table with one twice its size
+ *
+ * XXX: Descriptor table must be locked
+ */
+static int
+fdtable_grow(struct filedesc *fdp)
+{
+    struct fdtable *old = fdp->fdt, *new;
+    size_t nfiles;
+
+    if (old->nfiles >= FDMAX) {
+        return -EMFILE;
+    }
+
+    nfiles = MIN(old->nfiles * 2, FDMAX);
+    new = kalloc(sizeof(*new) + sizeof(struct file *) * nfiles);
+    if (new == NULL) {
+        return -ENOMEM;
+    }
+
+    new->nfiles = nfiles;
+    new->files = (struct file *volatile *)(new + 1);
+    new->retired = NULL;
+    memcpy((void *)new->files, (void *)old->files,
+        sizeof(struct file *) * old->nfiles);
+    memset((void *)&new->files[old->nfiles], 0,
+        sizeof(struct file *) * (nfiles - old->nfiles));
+
+    /*
+     * Readers may still be looking at the old table so it
+     * can only be retired, not freed.
+     */
+    __atomic_store_n(&fdp->fdt, new, __ATOMIC_RELEASE);
+    old->retired = fdp->retired;
+    fdp->retired = old;
+    return 0;
+}
+
+int
+filedesc_init(struct filedesc *fdp)
+{
+    if (fdp == NULL) {
+        return -EINVAL;
+    }
+
+    if (!is_file_init) {
+        spinlock_init("file", &file_lock);
+        is_file_init = true;
+    }
+
+    memset(fdp, 0, sizeof(*fdp));
+    fdp->fdt0.nfiles = NDFILE;
+    fdp->fdt0.files = fdp->files0;
+    fdp->fdt = &fdp->fdt0;
+    return spinlock_init("filedesc", &fdp->lock);
+}
+
+void
+filedesc_destroy(struct filedesc *fdp)
+{
+    struct fdtable *fdt, *next;
+
+    if (fdp == NULL) {
+        return;
+    }
+
+    fdt = fdp->fdt;
+    for (size_t i = 0; i < fdt->nfiles; ++i) {
+        if (fdt->files[i] != NULL) {
+            fd_close(fdp, i);
+        }
+    }
+
+    /* Nobody can see the tables anymore */
+    if (fdt != &fdp->fdt0) {
+        fdt->retired = fdp->retired;
+        fdp->retired = fdt;
+    }
+
+    for (fdt = fdp->retired; fdt != NULL; fdt = next) {
+        next = fdt->retired;
+        if (fdt != &fdp->fdt0) {
+            kfree(fdt);
+        }
+    }
+
+    fdp->retired = NULL;
+    fdp->fdt = &fdp->fdt0;
+}
+
+int
+fd_open(struct filedesc *fdp, struct vnode *vp, uint32_t flags, int *fd_res)
+{
+    struct fdtable *fdt;
+    struct file *fp;
+    int fd, error;
+
+    if (fdp == NULL || vp == NULL || fd_res == NULL) {
+        return -EINVAL;
+    }
+
+    if ((fp = file_alloc()) == NULL) {
+        return -ENOMEM;
+    }
+
+    fp->vp = vp;
+    fp->flags = flags;
+    atomic_store_int_nv(&fp->ref, 1, __ATOMIC_RELAXED);
+
+    spinlock_acquire(&fdp->lock, true);
+    for (;;) {
+        fdt = fdp->fdt;
+        for (fd = fdp->freefd; fd < (int)fdt->nfiles; ++fd) {
+            if (fdt->files[fd] == NULL) {
+                break;
+            }
+        }
+
+        if (fd < (int)fdt->nfiles) {
+            break;
+        }
+
+        if ((error = fdtable_grow(fdp)) < 0) {
+            spinlock_release(&fdp->lock, true);
+            fp->vp = NULL;
+            file_free(fp);
+            return error;
+        }
+    }
+
+    /* Publish a fully set up file */
+    __atomic_store_n(&fdt->files[fd], fp, __ATOMIC_RELEASE);
+    fdp->freefd = fd + 1;
+    spinlock_release(&fdp->lock, true);
+
+    *fd_res = fd;
+    return 0;
+}
+
+int
+fd_close(struct filedesc *fdp, int fd)
+{
+    struct fdtable *fdt;
+    struct file *fp;
+
+    if (fdp == NULL || fd < 0) {
+        return -EBADF;
+    }
+
+    spinlock_acquire(&fdp->lock, true);
+    fdt = fdp->fdt;
+    if (fd >= (int)fdt->nfiles || (fp = fdt->files[fd]) == NULL) {
+        spinlock_release(&fdp->lock, true);
+        return -EBADF;
+    }
+
+    __atomic_store_n(&fdt->files[fd], NULL, __ATOMIC_RELEASE);
+    if (fd < fdp->freefd) {
+        fdp->freefd = fd;
+    }
+    spinlock_release(&fdp->lock, true);
+
+    fdrop(fp);
+    return 0;
+}
+
+int
+fd_get(struct filedesc *fdp, int fd, struct file **fp_res)
+{
+    struct fdtable *fdt;
+    struct file *fp;
+
+    if (fdp == NULL || fp_res == NULL || fd < 0) {
+        return -EBADF;
+    }
+
+    for (;;) {
+        fdt = __atomic_load_n(&fdp->fdt, __ATOMIC_ACQUIRE);
+        if (fd >= (int)fdt->nfiles) {
+            return -EBADF;
+        }
+
+        fp = __atomic_load_n(&fdt->files[fd], __ATOMIC_ACQUIRE);
+        if (fp == NULL) {
+            return -EBADF;
+        }
+
+        /* Being torn down, look again */
+        if (!file_ref_nonzero(fp)) {
+            continue;
+        }
+
+        /*
+         * The file may have been closed and recycled for
+         * another slot between the load and the reference,
+         * make sure the slot still holds it.
+         */
+        fdt = __atomic_load_n(&fdp->fdt, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&fdt->files[fd], __ATOMIC_ACQUIRE) == fp) {
+            break;
+        }
+
+        fdrop(fp);
+    }
+
+    *fp_res = fp;
+    return 0;
+}
+
+void
+fdrop(struct file *fp)
+{
+    if (fp == NULL) {
+        return;
+    }
+
+    if (atomic_dec_int(&fp->ref) > 0) {
+        return;
+    }
+
+    if (fp->vp != NULL) {
+        vnode_release(fp->vp);
+    }
+
+    fp->vp = NULL;
+    file_free(fp);
+}
+
+ssize_t
+file_read(struct file *fp, void *buf, size_t len)
+{
+    ssize_t retval;
+
+    if (fp == NULL || !ISSET(fp->flags, FREAD)) {
+        return -EBADF;
+    }
+
+    retval = vnode_read(fp->vp, buf, len, fp->offset);
+    if (retval > 0) {
+        __atomic_fetch_add(&fp->offset, retval, __ATOMIC_RELAXED);
+    }
+
+    return retval;
+}
+
+ssize_t
+file_write(struct file *fp, const void *buf, size_t len)
+{
+    ssize_t retval;
+
+    if (fp == NULL || !ISSET(fp->flags, FWRITE)) {
+        return -EBADF;
+    }
+
+    retval = vnode_write(fp->vp, buf, len, fp->offset);
+    if (retval > 0) {
+        __atomic_fetch_add(&fp->offset, retval, __ATOMIC_RELAXED);
+    }
+
+    return retval;
+}
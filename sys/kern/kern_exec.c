@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/mman.h>
+#include <sys/elf.h>
+#include <kern/exec.h>
+#include <kern/vnode.h>
+#include <os/trace.h>
+#include <vm/map.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("exec: " fmt, ##__VA_ARGS__)
+
+static int
+elf_check(const Elf64_Ehdr *eh)
+{
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0) {
+        return -ENOEXEC;
+    }
+
+    if (eh->e_ident[EI_CLASS] != ELFCLASS64) {
+        return -ENOEXEC;
+    }
+
+    if (eh->e_ident[EI_DATA] != ELFDATA2LSB) {
+        return -ENOEXEC;
+    }
+
+    /* No relocation support yet */
+    if (eh->e_type != ET_EXEC || eh->e_machine != EM_X86_64) {
+        return -ENOEXEC;
+    }
+
+    if (eh->e_phentsize != sizeof(Elf64_Phdr)) {
+        return -ENOEXEC;
+    }
+
+    if (eh->e_phnum == 0 || eh->e_phnum > ELF_MAXPHDR) {
+        return -ENOEXEC;
+    }
+
+    return 0;
+}
+
+static uint16_t
+elf_prot(const Elf64_Phdr *ph)
+{
+    uint16_t prot = PROT_READ;
+
+    if (ISSET(ph->p_flags, PF_W)) {
+        prot |= PROT_WRITE;
+    }
+
+    if (ISSET(ph->p_flags, PF_X)) {
+        prot |= PROT_EXEC;
+    }
+
+    return prot;
+}
+
+int
+elf_load(struct vnode *vp, struct vm_map *map, uintptr_t *entry)
+{
+    Elf64_Ehdr eh;
+    Elf64_Phdr ph;
+    ssize_t len;
+    off_t off;
+    int error;
+
+    if (vp == NULL || map == NULL || entry == NULL) {
+        return -EINVAL;
+    }
+
+    len = vnode_read(vp, &eh, sizeof(eh), 0);
+    if (len < 0) {
+        return len;
+    }
+
+    if (len != sizeof(eh) || elf_check(&eh) < 0) {
+        return -ENOEXEC;
+    }
+
+    for (uint16_t i = 0; i < eh.e_phnum; ++i) {
+        off = eh.e_phoff + i * sizeof(ph);
+        len = vnode_read(vp, &ph, sizeof(ph), off);
+        if (len != sizeof(ph)) {
+            return (len < 0) ? len : -ENOEXEC;
+        }
+
+        if (ph.p_type != PT_LOAD || ph.p_memsz == 0) {
+            continue;
+        }
+
+        if (ph.p_filesz > ph.p_memsz) {
+            return -ENOEXEC;
+        }
+
+        /* Segments are mapped straight from the file */
+        if ((ph.p_vaddr & (PAGESIZE - 1)) != (ph.p_offset & (PAGESIZE - 1))) {
+            return -ENOEXEC;
+        }
+
+        error = vm_map_insert(
+            map,
+            ph.p_vaddr,
+            ph.p_memsz,
+            elf_prot(&ph),
+            vp,
+            ph.p_offset,
+            ph.p_filesz
+        );
+
+        if (error < 0) {
+            dtrace("bad segment at %p (%d)\n", ph.p_vaddr, error);
+            return (error == -ENOMEM) ? error : -ENOEXEC;
+        }
+    }
+
+    if (eh.e_entry == 0 || eh.e_entry > VM_MAXUSER) {
+        return -ENOEXEC;
+    }
+
+    *entry = eh.e_entry;
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/queue.h>
+#include <kern/futex.h>
+#include <os/thread.h>
+#include <os/sched.h>
+#include <mu/cpu.h>
+#include <mu/mmu.h>
+#include <vm/vm.h>
+
+/*
+ * Futexes are only waited on and woken from system
+ * calls which run with interrupts masked, the queue
+ * locks leave the interrupt state alone.
+ */
+static struct futex_queue futex_tab[FUTEX_NHASH];
+
+static inline struct futex_queue *
+futex_queue(uintptr_t key)
+{
+    uint64_t hash;
+
+    hash = (key >> 2) * 0x9E3779B97F4A7C15ULL;
+    hash ^= hash >> 32;
+    return &futex_tab[hash & (FUTEX_NHASH - 1)];
+}
+
+/*
+ * Get the key of a user word, reading it first pages
+ * it in if it has not been touched yet.
+ */
+static int
+futex_key(uintptr_t uaddr, uintptr_t *key)
+{
+    struct mmu_vas vas;
+
+    if ((uaddr & (sizeof(uint32_t) - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    if (uaddr == 0 || uaddr > VM_MAXUSER - sizeof(uint32_t)) {
+        return -EFAULT;
+    }
+
+    (void)*(volatile uint32_t *)uaddr;
+    mu_pmap_readvas(&vas);
+    return mu_pmap_translate(&vas, uaddr, key);
+}
+
+int
+futex_wait(uintptr_t uaddr, uint32_t val)
+{
+    struct futex_queue *fq;
+    struct thread *self;
+    uintptr_t key;
+    int error;
+
+    if ((self = cpu_self()->curthread) == NULL) {
+        return -ESRCH;
+    }
+
+    if ((error = futex_key(uaddr, &key)) < 0) {
+        return error;
+    }
+
+    /*
+     * The word is checked with the queue locked so a
+     * wake between the check and the sleep is never
+     * lost.
+     */
+    fq = futex_queue(key);
+    spinlock_acquire(&fq->lock, false);
+    if (*(volatile uint32_t *)uaddr != val) {
+        spinlock_release(&fq->lock, false);
+        return -EAGAIN;
+    }
+
+    TAILQ_INSERT_TAIL(&fq->waiters, self, sleepq);
+    sched_sleep(key);
+    spinlock_release(&fq->lock, false);
+    return 0;
+}
+
+int
+futex_wake(uintptr_t uaddr, uint32_t count)
+{
+    struct futex_queue *fq;
+    struct thread *td, *tmp;
+    uintptr_t key;
+    uint32_t nwoken = 0;
+    int error;
+
+    if ((error = futex_key(uaddr, &key)) < 0) {
+        return error;
+    }
+
+    fq = futex_queue(key);
+    spinlock_acquire(&fq->lock, false);
+    TAILQ_FOREACH_SAFE(td, &fq->waiters, sleepq, tmp) {
+        if (nwoken >= count) {
+            break;
+        }
+
+        if (td->wchan != key) {
+            continue;
+        }
+
+        TAILQ_REMOVE(&fq->waiters, td, sleepq);
+        sched_wakeup(td);
+        ++nwoken;
+    }
+
+    spinlock_release(&fq->lock, false);
+    return nwoken;
+}
+
+void
+futex_init(void)
+{
+    for (size_t i = 0; i < FUTEX_NHASH; ++i) {
+        spinlock_init("futex", &futex_tab[i].lock);
+        TAILQ_INIT(&futex_tab[i].waiters);
+    }
+}
@@ -29,9 +29,20 @@
 
 #include <sys/types.h>
 #include <dev/cons/cons.h>
+#include <dev/tty/tty.h>
 #include <os/trace.h>
 #include <os/sched.h>
+#include <os/thread.h>
 #include <kern/vfs.h>
+#include <kern/futex.h>
+#include <dev/blk/blkdev.h>
+#include <dev/blk/ramdisk.h>
+#include <dev/pci/pci.h>
+#include <dev/virtio/virtio_blk.h>
+#include <dev/nvme/nvme.h>
+#include <dev/virtio/virtio_net.h>
+#include <net/if.h>
+#include <net/net.h>
 #include <acpi/acpi.h>
 #include <mu/cpu.h>
 #include <vm/phys.h>
@@ -51,7 +62,19 @@ kmain(void)
     vm_init();
     acpi_init();
     vm_kalloc_init();
+    console_shadow_init(&g_bootcons);
     cpu_conf(&g_bsp);
+    kthread_init();
+    futex_init();
     vfs_init();
+    tty_init();
+    blkdev_init();
+    ramdisk_init();
+    netif_init();
     cpu_start_aps(&g_bsp);
+    pci_init();
+    virtio_blk_init();
+    nvme_init();
+    virtio_net_init();
+    net_init();
 }
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/atomic.h>
+#include <sys/queue.h>
+#include <kern/ioring.h>
+#include <kern/vnode.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+int
+ioring_init(struct io_ring *ring, uint32_t nentries)
+{
+    int error;
+
+    if (ring == NULL || nentries == 0) {
+        return -EINVAL;
+    }
+
+    if (nentries > IORING_MAX_ENTRIES) {
+        return -EINVAL;
+    }
+
+    /* Must be a power of two */
+    if ((nentries & (nentries - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+    ring->sq = kalloc(sizeof(*ring->sq) * nentries);
+    if (ring->sq == NULL) {
+        return -ENOMEM;
+    }
+
+    ring->cq = kalloc(sizeof(*ring->cq) * nentries);
+    if (ring->cq == NULL) {
+        kfree(ring->sq);
+        return -ENOMEM;
+    }
+
+    error = spinlock_init("ioring", &ring->cq_lock);
+    if (error < 0) {
+        kfree(ring->sq);
+        kfree(ring->cq);
+        return error;
+    }
+
+    ring->mask = nentries - 1;
+    return 0;
+}
+
+int
+ioring_destroy(struct io_ring *ring)
+{
+    if (ring == NULL) {
+        return -EINVAL;
+    }
+
+    if (atomic_load_int(&ring->outstanding) != 0) {
+        return -EBUSY;
+    }
+
+    kfree(ring->sq);
+    kfree(ring->cq);
+    ring->sq = NULL;
+    ring->cq = NULL;
+    return 0;
+}
+
+int
+ioring_queue(struct io_ring *ring, struct io_req *req)
+{
+    if (ring == NULL || req == NULL) {
+        return -EINVAL;
+    }
+
+    if (req->vp == NULL) {
+        return -EINVAL;
+    }
+
+    /*
+     * Bounding what is outstanding by the ring size is what
+     * guarantees the completion queue can never overflow.
+     */
+    if (atomic_load_int(&ring->outstanding) > ring->mask) {
+        return -EAGAIN;
+    }
+
+    atomic_inc_int(&ring->outstanding);
+    req->ring = ring;
+    req->status = 0;
+    ring->sq[ring->sq_tail++ & ring->mask] = req;
+    return 0;
+}
+
+/*
+ * Pass a batch of requests down to a device, anything
+ * the device refuses to take is failed back.
+ */
+static void
+ioring_dispatch(struct vnode *vp, struct io_reqq *batch, size_t count)
+{
+    struct io_req *req;
+    int error;
+
+    error = vnode_submit(vp, batch, count);
+    if (error == 0) {
+        return;
+    }
+
+    while ((req = TAILQ_FIRST(batch)) != NULL) {
+        TAILQ_REMOVE(batch, req, link);
+        ioring_complete(req, error);
+    }
+}
+
+ssize_t
+ioring_submit(struct io_ring *ring)
+{
+    struct io_reqq batch;
+    struct io_req *req;
+    struct vnode *vp = NULL;
+    size_t count = 0;
+    ssize_t submitted = 0;
+
+    if (ring == NULL) {
+        return -EINVAL;
+    }
+
+    TAILQ_INIT(&batch);
+    while (ring->sq_head != ring->sq_tail) {
+        req = ring->sq[ring->sq_head++ & ring->mask];
+
+        /* Flush the batch once the target changes */
+        if (req->vp != vp && count > 0) {
+            ioring_dispatch(vp, &batch, count);
+            count = 0;
+        }
+
+        vp = req->vp;
+        TAILQ_INSERT_TAIL(&batch, req, link);
+        ++count;
+        ++submitted;
+    }
+
+    if (count > 0) {
+        ioring_dispatch(vp, &batch, count);
+    }
+
+    return submitted;
+}
+
+size_t
+ioring_reap(struct io_ring *ring, struct io_cqe *cqes, size_t max)
+{
+    uint32_t head, tail;
+    size_t n = 0;
+
+    if (ring == NULL || cqes == NULL) {
+        return 0;
+    }
+
+    head = ring->cq_head;
+    tail = atomic_load_int(&ring->cq_tail);
+    while (head != tail && n < max) {
+        cqes[n++] = ring->cq[head & ring->mask];
+        ++head;
+    }
+
+    atomic_store_int(&ring->cq_head, head);
+    atomic_sub_int_nv(&ring->outstanding, n);
+    return n;
+}
+
+void
+ioring_complete(struct io_req *req, ssize_t status)
+{
+    struct io_ring *ring;
+    struct io_cqe *cqe;
+    uint32_t tail;
+    bool irq;
+
+    if (req == NULL) {
+        return;
+    }
+
+    /*
+     * The callback must run before the completion is posted
+     * as the request may be reused as soon as it is reaped.
+     */
+    req->status = status;
+    ring = req->ring;
+    if (req->done != NULL) {
+        req->done(req);
+    }
+
+    if (ring == NULL) {
+        return;
+    }
+
+    /* Completions are posted from soft interrupts as well */
+    irq = spinlock_acquire_irq(&ring->cq_lock);
+    tail = ring->cq_tail;
+    cqe = &ring->cq[tail & ring->mask];
+    cqe->req = req;
+    cqe->status = status;
+    atomic_store_int(&ring->cq_tail, tail + 1);
+    spinlock_release_irq(&ring->cq_lock, irq);
+}
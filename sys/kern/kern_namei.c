@@ -31,6 +31,7 @@
 #include <sys/limits.h>
 #include <kern/mount.h>
 #include <kern/namei.h>
+#include <kern/vnode.h>
 
 #include <os/trace.h>
 
@@ -38,7 +39,7 @@ int
 namei(struct nameidata *ndp)
 {
     struct mount *mpoint = NULL;
-    struct vnode *vp = NULL;
+    struct vnode *vp = NULL, *next;
     const char *p;
     int error;
     char namebuf[NAME_MAX];
@@ -48,7 +49,7 @@ namei(struct nameidata *ndp)
         return -EINVAL;
     }
 
-    if (ndp->pathname == NULL || ndp->vp_res == NULL) {
+    if (ndp->pathname == NULL) {
         return -EINVAL;
     }
 
@@ -59,7 +60,7 @@ namei(struct nameidata *ndp)
     while (*p != '\0') {
         /* Skip leading slashes */
         while (*p != '\0' && *p == '/') {
-            *p++;
+            ++p;
         }
 
         if (*p == '\0') {
@@ -91,10 +92,28 @@ namei(struct nameidata *ndp)
             continue;
         }
 
-        trace("d: %s\n", namebuf);
+        /* Walk down into the mounted filesystem */
+        error = vnode_lookup(vp, namebuf, &next);
+        if (vp != mpoint->vp) {
+            vnode_release(vp);
+        }
+        if (error != 0) {
+            return error;
+        }
+
+        vp = next;
         namebuf_idx = 0;
     }
 
+    if (vp == NULL) {
+        return -ENOENT;
+    }
+
+    /* The caller always gets a reference */
+    if (vp == mpoint->vp) {
+        vnode_ref(vp);
+    }
+
     ndp->vp_res = vp;
     return 0;
 }
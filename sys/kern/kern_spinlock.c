@@ -29,6 +29,7 @@
 
 #include <sys/errno.h>
 #include <mu/spinlock.h>
+#include <mu/irq.h>
 #include <kern/spinlock.h>
 #include <lib/string.h>
 
@@ -75,3 +76,28 @@ spinlock_release(struct spinlock *lock, bool irqset)
 
     mu_spinlock_rel(&lock->lock, flags);
 }
+
+bool
+spinlock_acquire_irq(struct spinlock *lock)
+{
+    bool irq;
+
+    /*
+     * Interrupts stay off for as long as the lock is held,
+     * so neither a soft interrupt nor a preemption can run
+     * on this processor and spin on it.
+     */
+    irq = mu_irq_state();
+    mu_irq_disable();
+    mu_spinlock_acq(&lock->lock, 0);
+    return irq;
+}
+
+void
+spinlock_release_irq(struct spinlock *lock, bool irq)
+{
+    mu_spinlock_rel(&lock->lock, 0);
+    if (irq) {
+        mu_irq_enable();
+    }
+}
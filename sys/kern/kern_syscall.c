@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/syscall.h>
+#include <kern/syscall.h>
+#include <kern/filedesc.h>
+#include <kern/futex.h>
+#include <os/process.h>
+#include <os/thread.h>
+#include <mu/cpu.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+/*
+ * Check that a buffer lies within user space
+ */
+static bool
+syscall_ubuf(uint64_t addr, uint64_t len)
+{
+    if (addr + len < addr) {
+        return false;
+    }
+
+    return (addr + len) <= VM_MAXUSER + 1;
+}
+
+static struct process *
+syscall_proc(void)
+{
+    struct thread *td;
+
+    if ((td = cpu_self()->curthread) == NULL) {
+        return NULL;
+    }
+
+    return td->proc;
+}
+
+/*
+ * Does nothing, used to measure the round trip
+ */
+static int64_t
+sys_nop(struct syscall_args *args)
+{
+    return 0;
+}
+
+static int64_t
+sys_getpid(struct syscall_args *args)
+{
+    struct process *p;
+
+    if ((p = syscall_proc()) == NULL) {
+        return -ESRCH;
+    }
+
+    return p->pid;
+}
+
+/*
+ * read(fd, buf, len)
+ */
+static int64_t
+sys_read(struct syscall_args *args)
+{
+    struct process *p;
+    struct file *fp;
+    void *buf = (void *)args->arg[1];
+    size_t len = args->arg[2];
+    ssize_t retval;
+    int error;
+
+    if ((p = syscall_proc()) == NULL) {
+        return -ESRCH;
+    }
+
+    if (!syscall_ubuf(args->arg[1], len)) {
+        return -EFAULT;
+    }
+
+    if ((error = fd_get(&p->fd, args->arg[0], &fp)) < 0) {
+        return error;
+    }
+
+    retval = file_read(fp, buf, len);
+    fdrop(fp);
+    return retval;
+}
+
+/*
+ * write(fd, buf, len)
+ */
+static int64_t
+sys_write(struct syscall_args *args)
+{
+    struct process *p;
+    struct file *fp;
+    const void *buf = (const void *)args->arg[1];
+    size_t len = args->arg[2];
+    ssize_t retval;
+    int error;
+
+    if ((p = syscall_proc()) == NULL) {
+        return -ESRCH;
+    }
+
+    if (!syscall_ubuf(args->arg[1], len)) {
+        return -EFAULT;
+    }
+
+    if ((error = fd_get(&p->fd, args->arg[0], &fp)) < 0) {
+        return error;
+    }
+
+    retval = file_write(fp, buf, len);
+    fdrop(fp);
+    return retval;
+}
+
+/*
+ * close(fd)
+ */
+static int64_t
+sys_close(struct syscall_args *args)
+{
+    struct process *p;
+
+    if ((p = syscall_proc()) == NULL) {
+        return -ESRCH;
+    }
+
+    return fd_close(&p->fd, args->arg[0]);
+}
+
+/*
+ * futex_wait(uaddr, val)
+ */
+static int64_t
+sys_futex_wait(struct syscall_args *args)
+{
+    return futex_wait(args->arg[0], args->arg[1]);
+}
+
+/*
+ * futex_wake(uaddr, count)
+ */
+static int64_t
+sys_futex_wake(struct syscall_args *args)
+{
+    return futex_wake(args->arg[0], args->arg[1]);
+}
+
+/*
+ * Indexed by system call number, see sys/syscall.h
+ */
+static const syscall_func_t syscall_tab[NSYSCALL] = {
+    [SYS_nop] = sys_nop,
+    [SYS_getpid] = sys_getpid,
+    [SYS_read] = sys_read,
+    [SYS_write] = sys_write,
+    [SYS_close] = sys_close,
+    [SYS_futex_wait] = sys_futex_wait,
+    [SYS_futex_wake] = sys_futex_wake
+};
+
+int64_t
+syscall_dispatch(uint64_t code, struct syscall_args *args)
+{
+    if (code >= NSYSCALL) {
+        return -ENOSYS;
+    }
+
+    return syscall_tab[code](args);
+}
+
+void
+syscall_account(uint64_t code, uint64_t cycles)
+{
+    struct syscall_stat *st = &cpu_self()->sysstat;
+
+    if (code < NSYSCALL) {
+        ++st->count[code];
+    } else {
+        ++st->nosys;
+    }
+
+    st->cycles += cycles;
+    if (st->min == 0 || cycles < st->min) {
+        st->min = cycles;
+    }
+
+    if (cycles > st->max) {
+        st->max = cycles;
+    }
+}
+
+void
+syscall_stat(struct syscall_stat *res)
+{
+    struct syscall_stat *st;
+    struct cpu_info *ci;
+
+    memset(res, 0, sizeof(*res));
+    for (uint32_t i = 0; (ci = cpu_get(i)) != NULL; ++i) {
+        st = &ci->sysstat;
+        for (size_t j = 0; j < NSYSCALL; ++j) {
+            res->count[j] += st->count[j];
+        }
+
+        res->nosys += st->nosys;
+        res->cycles += st->cycles;
+        if (st->min != 0 && (res->min == 0 || st->min < res->min)) {
+            res->min = st->min;
+        }
+
+        res->max = MAX(res->max, st->max);
+    }
+}
@@ -33,15 +33,18 @@
 #include <sys/cdefs.h>
 #include <lib/string.h>
 #include <fs/tmpfs.h>
+#include <fs/initramfs.h>
 #include <kern/vfs.h>
 #include <kern/mount.h>
+#include <kern/vnode.h>
 #include <os/trace.h>
 
 #define dtrace(fmt, ...) trace("vfs: " fmt, ##__VA_ARGS__)
 
 static uint16_t fs_count = 0;
 static struct fs_info fs_list[] = {
-    { MOUNT_TMPFS, &g_tmpfs_ops }
+    { MOUNT_TMPFS, &g_tmpfs_ops },
+    { MOUNT_INITRAMFS, &g_initramfs_ops }
 };
 
 int
@@ -74,8 +77,9 @@ vfs_init(void)
 {
     struct fs_info *fip;
     struct vfsops *ops;
-    int error;
+    int error = 0;
 
+    vnode_cache_init();
     fs_count = NELEM(fs_list);
     for (uint16_t i = 0; i < fs_count; ++i) {
         fip = &fs_list[i];
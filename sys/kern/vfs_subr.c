@@ -28,67 +28,9 @@
  */
 
 #include <sys/errno.h>
+#include <sys/queue.h>
 #include <kern/vnode.h>
-#include <vm/kalloc.h>
-#include <lib/string.h>
-
-int
-vnode_init(struct vnode **vp_res, vtype_t type)
-{
-    struct vnode *vp;
-
-    if (vp_res == NULL) {
-        return -EINVAL;
-    }
-
-    switch (type) {
-    case VREG:
-    case VDIR:
-    case VCHR:
-    case VBLK:
-        break;
-    default:
-        return -EINVAL;
-    }
-
-    vp = kalloc(sizeof(*vp));
-    if (vp == NULL) {
-        return -ENOMEM;
-    }
-
-    memset(vp, 0, sizeof(*vp));
-    vp->ref = 1;
-    vp->type = type;
-    *vp_res = vp;
-    return 0;
-}
-
-int
-vnode_release(struct vnode *vp)
-{
-    struct vops *vops;
-
-    if (vp == NULL) {
-        return -EINVAL;
-    }
-
-    vops = &vp->vops;
-
-    /*
-     * If there are zero outstanding references to this
-     * vnode, release it from memory.
-     */
-    if ((vp->ref--) > 0) {
-        return vp->ref;
-    }
-
-    if (vops->reclaim != NULL) {
-        vops->reclaim(vp);
-    }
-
-    kfree(vp);
-    return 0;
-}
+#include <kern/ioring.h>
 
 ssize_t
 vnode_read(struct vnode *vp, void *buf, size_t size, off_t off)
@@ -109,6 +51,7 @@ vnode_read(struct vnode *vp, void *buf, size_t size, off_t off)
         return -ENOTSUP;
     }
 
+    args.vp = vp;
     args.buffer = buf;
     args.len = size;
     args.offset = off;
@@ -134,6 +77,7 @@ vnode_write(struct vnode *vp, const void *buf, size_t size, off_t off)
         return -ENOTSUP;
     }
 
+    args.vp = vp;
     args.buffer = (void *)buf;
     args.len = size;
     args.offset = off;
@@ -159,7 +103,82 @@ vnode_lookup(struct vnode *vp, const char *name, struct vnode **res)
         return -ENOTSUP;
     }
 
+    args.dvp = vp;
     args.component = name;
     args.vp_res = res;
     return vops->lookup(&args);
 }
+
+int
+vnode_map(struct vnode *vp, off_t off, size_t len, void **res)
+{
+    struct vop_map_args args;
+    struct vops *vops;
+
+    if (vp == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    if (len == 0) {
+        return -EINVAL;
+    }
+
+    vops = &vp->vops;
+    if (vops->map == NULL) {
+        return -ENOTSUP;
+    }
+
+    args.vp = vp;
+    args.offset = off;
+    args.len = len;
+    args.res = res;
+    return vops->map(&args);
+}
+
+int
+vnode_submit(struct vnode *vp, struct io_reqq *reqq, size_t count)
+{
+    struct vop_submit_args args;
+    struct vops *vops;
+    struct io_req *req;
+    ssize_t status;
+
+    if (vp == NULL || reqq == NULL) {
+        return -EINVAL;
+    }
+
+    if (vp->type != VBLK && vp->type != VCHR) {
+        return -ENOTSUP;
+    }
+
+    vops = &vp->vops;
+    if (vops->submit != NULL) {
+        args.vp = vp;
+        args.reqq = reqq;
+        args.count = count;
+        return vops->submit(&args);
+    }
+
+    /*
+     * The device has no asynchronous path so perform
+     * each request in place and complete it right away.
+     */
+    while ((req = TAILQ_FIRST(reqq)) != NULL) {
+        TAILQ_REMOVE(reqq, req, link);
+        switch (req->op) {
+        case IO_OP_READ:
+            status = vnode_read(vp, req->buf, req->len, req->offset);
+            break;
+        case IO_OP_WRITE:
+            status = vnode_write(vp, req->buf, req->len, req->offset);
+            break;
+        default:
+            status = 0;
+            break;
+        }
+
+        ioring_complete(req, status);
+    }
+
+    return 0;
+}
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/cdefs.h>
+#include <sys/atomic.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <kern/vnode.h>
+#include <vm/kalloc.h>
+#include <lib/stdbool.h>
+#include <lib/string.h>
+
+/* Must be a power of two */
+#define VCACHE_NBUCKET 128
+
+/*
+ * The vnode cache lock protects the hash chains, the free
+ * list and the 1 -> 0 reference transition. References
+ * above one are taken and dropped without it.
+ */
+__cacheline_aligned
+static struct spinlock vcache_lock;
+
+static LIST_HEAD(vhash, vnode) vcache_hash[VCACHE_NBUCKET];
+static TAILQ_HEAD(, vnode) vnode_freelist;
+static size_t numvnodes = 0;
+
+/*
+ * Get the hash chain for a given (mount, inode) pair
+ */
+static inline struct vhash *
+vcache_bucket(struct mount *mp, ino_t ino)
+{
+    uint64_t hash;
+
+    hash = ((uintptr_t)mp >> 4) ^ (ino * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 32;
+    return &vcache_hash[hash & (VCACHE_NBUCKET - 1)];
+}
+
+/*
+ * Let the filesystem drop whatever it has attached
+ * to a vnode and clear out its operations.
+ */
+static void
+vnode_reclaim(struct vnode *vp)
+{
+    struct vops *vops;
+
+    vops = &vp->vops;
+    if (vops->reclaim != NULL) {
+        vops->reclaim(vp);
+    }
+
+    memset(vops, 0, sizeof(*vops));
+    vp->data = NULL;
+}
+
+/*
+ * Get a vnode to use, either by taking one from the free
+ * list or by allocating a new one.
+ *
+ * Vnodes that were never entered into the cache sit at the
+ * head of the free list and are always reused first as they
+ * hold nothing of value. Cached vnodes are only recycled
+ * (least recently used first) once we have hit the limit.
+ */
+static struct vnode *
+vnode_alloc(void)
+{
+    struct vnode *vp;
+
+    spinlock_acquire(&vcache_lock, true);
+    vp = TAILQ_FIRST(&vnode_freelist);
+    if (vp != NULL && ISSET(vp->flags, VNODE_HASHED)) {
+        if (numvnodes < VNODE_CACHE_MAX)
+            vp = NULL;
+    }
+
+    if (vp != NULL) {
+        TAILQ_REMOVE(&vnode_freelist, vp, lruq);
+        if (ISSET(vp->flags, VNODE_HASHED)) {
+            LIST_REMOVE(vp, hashq);
+        }
+        vp->flags = 0;
+    } else {
+        ++numvnodes;
+    }
+    spinlock_release(&vcache_lock, true);
+
+    if (vp != NULL) {
+        vnode_reclaim(vp);
+        return vp;
+    }
+
+    if ((vp = kalloc(sizeof(*vp))) == NULL) {
+        spinlock_acquire(&vcache_lock, true);
+        --numvnodes;
+        spinlock_release(&vcache_lock, true);
+    }
+
+    return vp;
+}
+
+int
+vnode_init(struct vnode **vp_res, vtype_t type)
+{
+    struct vnode *vp;
+
+    if (vp_res == NULL) {
+        return -EINVAL;
+    }
+
+    switch (type) {
+    case VREG:
+    case VDIR:
+    case VCHR:
+    case VBLK:
+        break;
+    default:
+        return -EINVAL;
+    }
+
+    vp = vnode_alloc();
+    if (vp == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(vp, 0, sizeof(*vp));
+    vp->ref = 1;
+    vp->type = type;
+    *vp_res = vp;
+    return 0;
+}
+
+void
+vnode_ref(struct vnode *vp)
+{
+    if (vp == NULL) {
+        return;
+    }
+
+    atomic_inc_int(&vp->ref);
+}
+
+int
+vnode_release(struct vnode *vp)
+{
+    unsigned int ref;
+    bool hashed;
+
+    if (vp == NULL) {
+        return -EINVAL;
+    }
+
+    /*
+     * If we are not dropping the last reference we can get
+     * away with a single atomic operation.
+     */
+    for (;;) {
+        ref = atomic_load_int(&vp->ref);
+        if (__unlikely(ref == 0)) {
+            panic("vnode: release of unreferenced vnode %p\n", vp);
+        }
+        if (ref == 1) {
+            break;
+        }
+        if (atomic_cas_int(&vp->ref, ref, ref - 1) == ref) {
+            return ref - 1;
+        }
+    }
+
+    /*
+     * This may be the last reference, though a cache lookup
+     * could still revive the vnode before we get the lock.
+     */
+    spinlock_acquire(&vcache_lock, true);
+    if ((ref = atomic_dec_int(&vp->ref)) > 0) {
+        spinlock_release(&vcache_lock, true);
+        return ref;
+    }
+
+    /*
+     * Cached vnodes keep their identity and filesystem data
+     * while on the free list so that a later lookup may hit
+     * them. Uncached ones are reclaimed right away.
+     */
+    hashed = ISSET(vp->flags, VNODE_HASHED);
+    if (hashed) {
+        TAILQ_INSERT_TAIL(&vnode_freelist, vp, lruq);
+        vp->flags |= VNODE_FREE;
+    }
+    spinlock_release(&vcache_lock, true);
+
+    if (!hashed) {
+        vnode_reclaim(vp);
+        spinlock_acquire(&vcache_lock, true);
+        TAILQ_INSERT_HEAD(&vnode_freelist, vp, lruq);
+        vp->flags |= VNODE_FREE;
+        spinlock_release(&vcache_lock, true);
+    }
+
+    return 0;
+}
+
+int
+vnode_cache_lookup(struct mount *mp, ino_t ino, struct vnode **vp_res)
+{
+    struct vhash *bucket;
+    struct vnode *vp;
+
+    if (vp_res == NULL) {
+        return -EINVAL;
+    }
+
+    bucket = vcache_bucket(mp, ino);
+    spinlock_acquire(&vcache_lock, true);
+    LIST_FOREACH(vp, bucket, hashq) {
+        if (vp->mp == mp && vp->ino == ino) {
+            break;
+        }
+    }
+
+    if (vp == NULL) {
+        spinlock_release(&vcache_lock, true);
+        return -ENOENT;
+    }
+
+    /* Revive it if it was sitting on the free list */
+    if (atomic_inc_int(&vp->ref) == 1) {
+        TAILQ_REMOVE(&vnode_freelist, vp, lruq);
+        vp->flags &= ~VNODE_FREE;
+    }
+
+    spinlock_release(&vcache_lock, true);
+    *vp_res = vp;
+    return 0;
+}
+
+int
+vnode_cache_enter(struct vnode *vp, struct mount *mp, ino_t ino)
+{
+    struct vhash *bucket;
+    struct vnode *iter;
+
+    if (vp == NULL) {
+        return -EINVAL;
+    }
+
+    bucket = vcache_bucket(mp, ino);
+    spinlock_acquire(&vcache_lock, true);
+    LIST_FOREACH(iter, bucket, hashq) {
+        if (iter->mp == mp && iter->ino == ino) {
+            spinlock_release(&vcache_lock, true);
+            return -EEXIST;
+        }
+    }
+
+    vp->mp = mp;
+    vp->ino = ino;
+    vp->flags |= VNODE_HASHED;
+    LIST_INSERT_HEAD(bucket, vp, hashq);
+    spinlock_release(&vcache_lock, true);
+    return 0;
+}
+
+void
+vnode_cache_remove(struct vnode *vp)
+{
+    if (vp == NULL) {
+        return;
+    }
+
+    spinlock_acquire(&vcache_lock, true);
+    if (ISSET(vp->flags, VNODE_HASHED)) {
+        LIST_REMOVE(vp, hashq);
+        vp->flags &= ~VNODE_HASHED;
+    }
+    spinlock_release(&vcache_lock, true);
+}
+
+void
+vnode_cache_init(void)
+{
+    if (spinlock_init("vcache", &vcache_lock) != 0) {
+        panic("vnode: failed to initialize vnode cache\n");
+    }
+
+    for (size_t i = 0; i < VCACHE_NBUCKET; ++i) {
+        LIST_INIT(&vcache_hash[i]);
+    }
+
+    TAILQ_INIT(&vnode_freelist);
+}
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ether.h>
+#include <net/ip.h>
+#include <net/pbuf.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+/*
+ * ARP cache entry
+ *
+ * @addr: Protocol address [host order]
+ * @hwaddr: Link layer address
+ * @valid: Set once resolved
+ * @hold: Packet waiting on resolution
+ */
+struct arp_entry {
+    in_addr_t addr;
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+    uint8_t valid : 1;
+    struct pbuf *hold;
+};
+
+static const uint8_t ether_bcast[ETHER_ADDR_LEN] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static struct spinlock arp_lock;
+static struct arp_entry arp_tab[ARP_NENT];
+static size_t arp_next = 0;
+
+/*
+ * Push the Ethernet header and hand the frame to the
+ * interface, the buffer stays busy until the device is
+ * done with it.
+ */
+static void
+ether_xmit(struct net_ifaddr *ifa, struct pbuf *pb, const uint8_t *dst,
+    uint16_t type)
+{
+    struct netif *nif = ifa->nif;
+    struct ether_header *eh;
+    struct netif_iov iov;
+    int error;
+
+    eh = pbuf_push(pb, sizeof(*eh));
+    memcpy(eh->dhost, dst, ETHER_ADDR_LEN);
+    memcpy(eh->shost, nif->hwaddr, ETHER_ADDR_LEN);
+    eh->type = htons(type);
+
+    iov.base = pb->data - pb->hlen;
+    iov.len = pb->hlen + pb->len;
+    __atomic_fetch_or(&pb->state, PBUF_BUSY, __ATOMIC_ACQ_REL);
+    if ((error = netif_send(nif, &iov, 1, pbuf_txdone, pb)) < 0) {
+        pbuf_txdone(pb, error);
+    }
+}
+
+/*
+ * Find the cache entry of an address
+ *
+ * XXX: ARP cache must be locked
+ */
+static struct arp_entry *
+arp_lookup(in_addr_t addr)
+{
+    for (size_t i = 0; i < ARP_NENT; ++i) {
+        if (arp_tab[i].addr == addr) {
+            return &arp_tab[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Claim an entry for an address, the oldest one is
+ * recycled once the cache is full.
+ *
+ * XXX: ARP cache must be locked
+ */
+static struct arp_entry *
+arp_claim(in_addr_t addr)
+{
+    struct arp_entry *ent;
+
+    ent = &arp_tab[arp_next];
+    arp_next = (arp_next + 1) % ARP_NENT;
+    if (ent->hold != NULL) {
+        pbuf_txdone(ent->hold, -EHOSTUNREACH);
+    }
+
+    memset(ent, 0, sizeof(*ent));
+    ent->addr = addr;
+    return ent;
+}
+
+static void
+arp_send(struct net_ifaddr *ifa, uint16_t op, in_addr_t tpa,
+    const uint8_t *tha)
+{
+    struct arp_packet *ap;
+    struct pbuf *pb;
+
+    if ((pb = pbuf_alloc()) == NULL) {
+        return;
+    }
+
+    ap = (struct arp_packet *)pb->data;
+    pb->len = sizeof(*ap);
+    ap->hrd = htons(1);
+    ap->pro = htons(ETHERTYPE_IP);
+    ap->hln = ETHER_ADDR_LEN;
+    ap->pln = sizeof(in_addr_t);
+    ap->op = htons(op);
+    memcpy(ap->sha, ifa->nif->hwaddr, ETHER_ADDR_LEN);
+    ap->spa = htonl(ifa->addr);
+    memset(ap->tha, 0, ETHER_ADDR_LEN);
+    ap->tpa = htonl(tpa);
+
+    if (op == ARP_REPLY) {
+        memcpy(ap->tha, tha, ETHER_ADDR_LEN);
+    }
+
+    ether_xmit(ifa, pb, (op == ARP_REPLY) ? tha : ether_bcast, ETHERTYPE_ARP);
+    pbuf_release(pb);
+}
+
+void
+arp_input(struct net_ifaddr *ifa, struct netif_pkt *pkt)
+{
+    struct arp_packet *ap = pkt->data;
+    struct arp_entry *ent;
+    struct pbuf *hold = NULL;
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+    in_addr_t spa, tpa;
+    bool irq;
+
+    if (pkt->len < sizeof(*ap) || ntohs(ap->pro) != ETHERTYPE_IP) {
+        netif_rxfree(pkt);
+        return;
+    }
+
+    spa = ntohl(ap->spa);
+    tpa = ntohl(ap->tpa);
+    memcpy(hwaddr, ap->sha, ETHER_ADDR_LEN);
+
+    /* Learn the sender, flush anything waiting on it */
+    irq = spinlock_acquire_irq(&arp_lock);
+    ent = arp_lookup(spa);
+    if (ent == NULL && tpa == ifa->addr) {
+        ent = arp_claim(spa);
+    }
+
+    if (ent != NULL) {
+        memcpy(ent->hwaddr, hwaddr, ETHER_ADDR_LEN);
+        ent->valid = 1;
+        hold = ent->hold;
+        ent->hold = NULL;
+    }
+    spinlock_release_irq(&arp_lock, irq);
+
+    /* Still marked busy from when it was held */
+    if (hold != NULL) {
+        ether_xmit(ifa, hold, hwaddr, ETHERTYPE_IP);
+    }
+
+    if (ntohs(ap->op) == ARP_REQUEST && tpa == ifa->addr) {
+        arp_send(ifa, ARP_REPLY, spa, hwaddr);
+    }
+
+    netif_rxfree(pkt);
+}
+
+int
+ether_output(struct net_ifaddr *ifa, in_addr_t nexthop, struct pbuf *pb)
+{
+    struct arp_entry *ent;
+    uint8_t hwaddr[ETHER_ADDR_LEN];
+    bool resolved = false;
+    bool irq;
+
+    if (nexthop == INADDR_BROADCAST) {
+        ether_xmit(ifa, pb, ether_bcast, ETHERTYPE_IP);
+        return 0;
+    }
+
+    irq = spinlock_acquire_irq(&arp_lock);
+    if ((ent = arp_lookup(nexthop)) == NULL) {
+        ent = arp_claim(nexthop);
+    }
+
+    if (ent->valid) {
+        memcpy(hwaddr, ent->hwaddr, ETHER_ADDR_LEN);
+        resolved = true;
+    } else {
+        /* Only the newest packet is held, like BSD */
+        if (ent->hold != NULL) {
+            pbuf_txdone(ent->hold, -EHOSTUNREACH);
+        }
+
+        __atomic_fetch_or(&pb->state, PBUF_BUSY, __ATOMIC_ACQ_REL);
+        ent->hold = pb;
+    }
+    spinlock_release_irq(&arp_lock, irq);
+
+    if (resolved) {
+        ether_xmit(ifa, pb, hwaddr, ETHERTYPE_IP);
+        return 0;
+    }
+
+    arp_send(ifa, ARP_REQUEST, nexthop, NULL);
+    return 0;
+}
+
+void
+ether_input(struct netif_pkt *pkt, void *arg)
+{
+    struct net_ifaddr *ifa = arg;
+    struct ether_header *eh = pkt->data;
+    uint16_t type;
+
+    if (pkt->len < sizeof(*eh)) {
+        netif_rxfree(pkt);
+        return;
+    }
+
+    if (memcmp(eh->dhost, ifa->nif->hwaddr, ETHER_ADDR_LEN) != 0 &&
+        memcmp(eh->dhost, ether_bcast, ETHER_ADDR_LEN) != 0) {
+        netif_rxfree(pkt);
+        return;
+    }
+
+    type = ntohs(eh->type);
+    pkt->data = PTR_OFFSET(pkt->data, sizeof(*eh));
+    pkt->len -= sizeof(*eh);
+
+    switch (type) {
+    case ETHERTYPE_IP:
+        ip_input(ifa, pkt);
+        break;
+    case ETHERTYPE_ARP:
+        arp_input(ifa, pkt);
+        break;
+    default:
+        netif_rxfree(pkt);
+        break;
+    }
+}
+
+void
+arp_init(void)
+{
+    if (spinlock_init("arp", &arp_lock) != 0) {
+        panic("arp: could not initialize cache\n");
+    }
+
+    memset(arp_tab, 0, sizeof(arp_tab));
+}
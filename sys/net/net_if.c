@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <net/if.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("if: " fmt, ##__VA_ARGS__)
+
+static struct spinlock netif_lock;
+static TAILQ_HEAD(, netif) netif_list;
+
+int
+netif_register(struct netif *nif)
+{
+    if (nif == NULL || nif->ops == NULL) {
+        return -EINVAL;
+    }
+
+    if (nif->ops->transmit == NULL || nif->ops->rxfree == NULL) {
+        return -EINVAL;
+    }
+
+    if (nif->nqueues == 0) {
+        return -EINVAL;
+    }
+
+    if (nif->mtu == 0) {
+        nif->mtu = IF_MTU;
+    }
+
+    spinlock_acquire(&netif_lock, true);
+    TAILQ_INSERT_TAIL(&netif_list, nif, link);
+    spinlock_release(&netif_lock, true);
+
+    dtrace(
+        "%s: %x:%x:%x:%x:%x:%x, %d queue pair(s)\n",
+        nif->name, nif->hwaddr[0], nif->hwaddr[1], nif->hwaddr[2],
+        nif->hwaddr[3], nif->hwaddr[4], nif->hwaddr[5], nif->nqueues
+    );
+    return 0;
+}
+
+int
+netif_lookup(const char *name, struct netif **res)
+{
+    struct netif *iter, *nif = NULL;
+
+    if (name == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    spinlock_acquire(&netif_lock, true);
+    TAILQ_FOREACH(iter, &netif_list, link) {
+        if (strcmp(iter->name, name) == 0) {
+            nif = iter;
+            break;
+        }
+    }
+    spinlock_release(&netif_lock, true);
+
+    if (nif == NULL) {
+        return -ENOENT;
+    }
+
+    *res = nif;
+    return 0;
+}
+
+struct netif *
+netif_get(size_t index)
+{
+    struct netif *iter, *nif = NULL;
+
+    spinlock_acquire(&netif_lock, true);
+    TAILQ_FOREACH(iter, &netif_list, link) {
+        if (index-- == 0) {
+            nif = iter;
+            break;
+        }
+    }
+    spinlock_release(&netif_lock, true);
+    return nif;
+}
+
+void
+netif_set_input(struct netif *nif, netif_input_t input, void *arg)
+{
+    /* Argument first so a racing receive never sees a stale one */
+    __atomic_store_n(&nif->input_arg, arg, __ATOMIC_RELAXED);
+    __atomic_store_n(&nif->input, input, __ATOMIC_RELEASE);
+}
+
+int
+netif_send(struct netif *nif, struct netif_iov *iov, uint16_t niov,
+    netif_txdone_t done, void *arg)
+{
+    size_t len = 0;
+    uint16_t txq;
+    int error;
+
+    if (nif == NULL || iov == NULL || niov == 0) {
+        return -EINVAL;
+    }
+
+    for (uint16_t i = 0; i < niov; ++i) {
+        len += iov[i].len;
+    }
+
+    if (len < ETHER_HDR_LEN || len > (size_t)nif->mtu + ETHER_HDR_LEN) {
+        return -EMSGSIZE;
+    }
+
+    txq = cpu_self()->id % nif->nqueues;
+    error = nif->ops->transmit(nif, txq, iov, niov, done, arg);
+    if (error < 0) {
+        __atomic_fetch_add(&nif->stat.oerrors, 1, __ATOMIC_RELAXED);
+        return error;
+    }
+
+    __atomic_fetch_add(&nif->stat.opackets, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&nif->stat.obytes, len, __ATOMIC_RELAXED);
+    return 0;
+}
+
+void
+netif_input(struct netif_pkt *pkt)
+{
+    struct netif *nif = pkt->nif;
+    netif_input_t input;
+
+    __atomic_fetch_add(&nif->stat.ipackets, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&nif->stat.ibytes, pkt->len, __ATOMIC_RELAXED);
+
+    input = __atomic_load_n(&nif->input, __ATOMIC_ACQUIRE);
+    if (input == NULL) {
+        __atomic_fetch_add(&nif->stat.idrops, 1, __ATOMIC_RELAXED);
+        netif_rxfree(pkt);
+        return;
+    }
+
+    input(pkt, nif->input_arg);
+}
+
+void
+netif_rxfree(struct netif_pkt *pkt)
+{
+    struct netif *nif = pkt->nif;
+
+    nif->ops->rxfree(nif, pkt);
+}
+
+void
+netif_poll(struct netif *nif)
+{
+    if (nif == NULL || nif->ops->poll == NULL) {
+        return;
+    }
+
+    nif->ops->poll(nif);
+}
+
+void
+netif_init(void)
+{
+    if (spinlock_init("netif", &netif_lock) != 0) {
+        panic("if: failed to initialize interface list\n");
+    }
+
+    TAILQ_INIT(&netif_list);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <kern/panic.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ether.h>
+#include <net/pbuf.h>
+#include <net/socket.h>
+#include <net/tcp.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("net: " fmt, ##__VA_ARGS__)
+
+/* Entries in the hash indirection table */
+#define NET_RETA_SIZE 128
+
+/*
+ * The well known Microsoft RSS key, most NICs default
+ * to it so a device doing RSS picks the same queue we
+ * pick a processor.
+ */
+static const uint8_t rss_key[40] = {
+    0x6D, 0x5A, 0x56, 0xDA, 0x25, 0x5B, 0x0E, 0xC2,
+    0x41, 0x67, 0x25, 0x3D, 0x43, 0xA3, 0x8F, 0xB0,
+    0xD0, 0xCA, 0x2B, 0xCB, 0xAE, 0x7B, 0x30, 0xB4,
+    0x77, 0xCB, 0x2D, 0xA3, 0x80, 0x30, 0xF2, 0x0C,
+    0x6A, 0x42, 0xB7, 0x3B, 0xBE, 0xAC, 0x01, 0xFA
+};
+
+static struct net_ifaddr ifaddr;
+static struct net_stat *net_stats;
+static size_t ncpu;
+
+static uint32_t
+toeplitz(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 0, v;
+
+    v = (rss_key[0] << 24) | (rss_key[1] << 16) | (rss_key[2] << 8) |
+        rss_key[3];
+
+    for (size_t i = 0; i < len; ++i) {
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            if (ISSET(data[i], 0x80 >> bit)) {
+                hash ^= v;
+            }
+
+            v <<= 1;
+            if (ISSET(rss_key[i + 4], 0x80 >> bit)) {
+                v |= 1;
+            }
+        }
+    }
+
+    return hash;
+}
+
+uint32_t
+net_flow_hash(in_addr_t saddr, in_addr_t daddr, in_port_t sport,
+    in_port_t dport)
+{
+    uint8_t tuple[12];
+
+    memcpy(&tuple[0], &saddr, 4);
+    memcpy(&tuple[4], &daddr, 4);
+    memcpy(&tuple[8], &sport, 2);
+    memcpy(&tuple[10], &dport, 2);
+    return toeplitz(tuple, sizeof(tuple));
+}
+
+uint32_t
+net_flow_cpu(uint32_t hash)
+{
+    return (hash % NET_RETA_SIZE) % ncpu;
+}
+
+struct net_ifaddr *
+net_ifaddr(void)
+{
+    if (ifaddr.nif == NULL) {
+        return NULL;
+    }
+
+    return &ifaddr;
+}
+
+struct net_stat *
+net_stat_self(void)
+{
+    return &net_stats[cpu_self()->id % ncpu];
+}
+
+void
+net_poll(void)
+{
+    struct netif *nif;
+
+    for (size_t i = 0; (nif = netif_get(i)) != NULL; ++i) {
+        netif_poll(nif);
+    }
+}
+
+void
+net_init(void)
+{
+    struct netif *nif;
+
+    ncpu = cpu_count();
+    net_stats = kalloc(sizeof(*net_stats) * ncpu);
+    if (net_stats == NULL) {
+        panic("net: could not allocate counters\n");
+    }
+
+    memset(net_stats, 0, sizeof(*net_stats) * ncpu);
+    pbuf_init();
+    arp_init();
+    in_pcbinit();
+    tcp_init();
+
+    if ((nif = netif_get(0)) == NULL) {
+        dtrace("no interfaces, stack idle\n");
+        return;
+    }
+
+    ifaddr.addr = NET_IPADDR;
+    ifaddr.mask = NET_NETMASK;
+    ifaddr.gw = NET_GATEWAY;
+    ifaddr.nif = nif;
+
+    dtrace(
+        "%s: %d.%d.%d.%d, gateway %d.%d.%d.%d\n", nif->name,
+        (ifaddr.addr >> 24) & 0xFF, (ifaddr.addr >> 16) & 0xFF,
+        (ifaddr.addr >> 8) & 0xFF, ifaddr.addr & 0xFF,
+        (ifaddr.gw >> 24) & 0xFF, (ifaddr.gw >> 16) & 0xFF,
+        (ifaddr.gw >> 8) & 0xFF, ifaddr.gw & 0xFF
+    );
+
+    netif_set_input(nif, ether_input, &ifaddr);
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ether.h>
+#include <net/ip.h>
+#include <net/udp.h>
+#include <net/tcp.h>
+#include <net/pbuf.h>
+
+static uint16_t ip_id = 0;
+
+uint16_t
+in_cksum(const void *buf, size_t len, uint32_t sum)
+{
+    const uint16_t *p = buf;
+
+    while (len > 1) {
+        sum += *p++;
+        len -= 2;
+    }
+
+    if (len > 0) {
+        sum += *(const uint8_t *)p;
+    }
+
+    while ((sum >> 16) != 0) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return ~sum & 0xFFFF;
+}
+
+uint32_t
+in_pseudo(in_addr_t src, in_addr_t dst, uint8_t proto, uint16_t len)
+{
+    uint32_t sum = 0;
+
+    sum += (src & 0xFFFF) + (src >> 16);
+    sum += (dst & 0xFFFF) + (dst >> 16);
+    sum += htons(proto);
+    sum += htons(len);
+    return sum;
+}
+
+void
+ip_input(struct net_ifaddr *ifa, struct netif_pkt *pkt)
+{
+    struct net_stat *stat = net_stat_self();
+    struct ip *ip = pkt->data;
+    in_addr_t dst;
+    uint16_t hlen, len;
+
+    ++stat->ip_in;
+    if (pkt->len < sizeof(*ip) || IP_V(ip) != IPVERSION) {
+        goto drop;
+    }
+
+    hlen = IP_HLEN(ip);
+    len = ntohs(ip->len);
+    if (hlen < sizeof(*ip) || len < hlen || len > pkt->len) {
+        goto drop;
+    }
+
+    if (in_cksum(ip, hlen, 0) != 0) {
+        goto drop;
+    }
+
+    /* No reassembly */
+    if ((ntohs(ip->off) & (IP_MF | IP_OFFMASK)) != 0) {
+        goto drop;
+    }
+
+    dst = ntohl(ip->dst);
+    if (dst != ifa->addr && dst != INADDR_BROADCAST) {
+        goto drop;
+    }
+
+    /* Trim link layer padding */
+    pkt->nhdr = ip;
+    pkt->data = PTR_OFFSET(pkt->data, hlen);
+    pkt->len = len - hlen;
+
+    switch (ip->p) {
+    case IPPROTO_UDP:
+        udp_input(pkt);
+        return;
+    case IPPROTO_TCP:
+        tcp_input(pkt);
+        return;
+    }
+drop:
+    ++stat->ip_drop;
+    netif_rxfree(pkt);
+}
+
+int
+ip_output(struct pbuf *pb, uint8_t proto, in_addr_t src, in_addr_t dst)
+{
+    struct net_ifaddr *ifa = net_ifaddr();
+    in_addr_t nexthop;
+    struct ip *ip;
+    uint16_t len;
+
+    if (ifa == NULL) {
+        return -ENETDOWN;
+    }
+
+    if (src == INADDR_ANY) {
+        src = ifa->addr;
+    }
+
+    len = pb->hlen + pb->len + sizeof(*ip);
+    ip = pbuf_push(pb, sizeof(*ip));
+    ip->vhl = (IPVERSION << 4) | (sizeof(*ip) >> 2);
+    ip->tos = 0;
+    ip->len = htons(len);
+    ip->id = htons(__atomic_fetch_add(&ip_id, 1, __ATOMIC_RELAXED));
+    ip->off = htons(IP_DF);
+    ip->ttl = IP_TTL;
+    ip->p = proto;
+    ip->sum = 0;
+    ip->src = htonl(src);
+    ip->dst = htonl(dst);
+    ip->sum = in_cksum(ip, sizeof(*ip), 0);
+
+    nexthop = dst;
+    if (dst != INADDR_BROADCAST && ((dst ^ ifa->addr) & ifa->mask) != 0) {
+        nexthop = ifa->gw;
+    }
+
+    ++net_stat_self()->ip_out;
+    return ether_output(ifa, nexthop, pb);
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <net/pbuf.h>
+#include <mu/cpu.h>
+#include <mu/irq.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/stdbool.h>
+
+/* Pages carved up per slab refill */
+#define PBUF_SLAB_PAGES 4
+
+/*
+ * Per processor cache of free buffers, only touched by
+ * its own processor with interrupts masked.
+ */
+struct pbuf_cpu {
+    struct pbufq freeq;
+    size_t count;
+};
+
+static struct pbuf_cpu *pbuf_cpus;
+static struct spinlock depot_lock;
+static struct pbufq depot;
+static size_t ncpu;
+
+/*
+ * Carve a fresh slab into buffers and put them on
+ * the depot.
+ *
+ * XXX: Depot must be locked
+ */
+static int
+pbuf_grow(void)
+{
+    uintptr_t phys;
+    size_t nbufs;
+    struct pbuf *pb;
+
+    if ((phys = vm_phys_alloc(PBUF_SLAB_PAGES)) == 0) {
+        return -1;
+    }
+
+    nbufs = (PBUF_SLAB_PAGES * PAGESIZE) / PBUF_SIZE;
+    for (size_t i = 0; i < nbufs; ++i) {
+        pb = PHYS_TO_VIRT(phys + (i * PBUF_SIZE));
+        TAILQ_INSERT_TAIL(&depot, pb, link);
+    }
+
+    return 0;
+}
+
+static struct pbuf_cpu *
+pbuf_cpu_self(void)
+{
+    return &pbuf_cpus[cpu_self()->id % ncpu];
+}
+
+struct pbuf *
+pbuf_alloc(void)
+{
+    struct pbuf_cpu *pc;
+    struct pbuf *pb;
+    bool irq_en, irq;
+
+    irq_en = mu_irq_state();
+    mu_irq_disable();
+    pc = pbuf_cpu_self();
+    if ((pb = TAILQ_FIRST(&pc->freeq)) != NULL) {
+        TAILQ_REMOVE(&pc->freeq, pb, link);
+        --pc->count;
+    }
+
+    if (irq_en) {
+        mu_irq_enable();
+    }
+
+    /* Cache ran dry, go to the depot */
+    if (pb == NULL) {
+        irq = spinlock_acquire_irq(&depot_lock);
+        if (TAILQ_EMPTY(&depot)) {
+            pbuf_grow();
+        }
+
+        if ((pb = TAILQ_FIRST(&depot)) != NULL) {
+            TAILQ_REMOVE(&depot, pb, link);
+        }
+        spinlock_release_irq(&depot_lock, irq);
+    }
+
+    if (pb != NULL) {
+        pb->data = &pb->buf[PBUF_HEADROOM];
+        pb->len = 0;
+        pb->hlen = 0;
+        pb->seq = 0;
+        pb->state = 0;
+    }
+
+    return pb;
+}
+
+void
+pbuf_free(struct pbuf *pb)
+{
+    struct pbuf_cpu *pc;
+    bool irq_en, irq, cached = false;
+
+    irq_en = mu_irq_state();
+    mu_irq_disable();
+    pc = pbuf_cpu_self();
+    if (pc->count < PBUF_CACHE) {
+        TAILQ_INSERT_HEAD(&pc->freeq, pb, link);
+        ++pc->count;
+        cached = true;
+    }
+
+    if (irq_en) {
+        mu_irq_enable();
+    }
+
+    if (!cached) {
+        irq = spinlock_acquire_irq(&depot_lock);
+        TAILQ_INSERT_HEAD(&depot, pb, link);
+        spinlock_release_irq(&depot_lock, irq);
+    }
+}
+
+void *
+pbuf_push(struct pbuf *pb, uint16_t len)
+{
+    pb->hlen += len;
+    return pb->data - pb->hlen;
+}
+
+void
+pbuf_reset(struct pbuf *pb)
+{
+    pb->hlen = 0;
+}
+
+void
+pbuf_release(struct pbuf *pb)
+{
+    uint32_t old;
+
+    old = __atomic_fetch_or(&pb->state, PBUF_ORPHAN, __ATOMIC_ACQ_REL);
+    if (!ISSET(old, PBUF_BUSY)) {
+        pbuf_free(pb);
+    }
+}
+
+void
+pbuf_txdone(void *arg, int status)
+{
+    struct pbuf *pb = arg;
+    uint32_t old;
+
+    old = __atomic_fetch_and(&pb->state, ~PBUF_BUSY, __ATOMIC_ACQ_REL);
+    if (ISSET(old, PBUF_ORPHAN)) {
+        pbuf_free(pb);
+    }
+}
+
+void
+pbuf_init(void)
+{
+    ncpu = cpu_count();
+    pbuf_cpus = kalloc(sizeof(*pbuf_cpus) * ncpu);
+    if (pbuf_cpus == NULL) {
+        panic("pbuf: could not allocate caches\n");
+    }
+
+    for (size_t i = 0; i < ncpu; ++i) {
+        TAILQ_INIT(&pbuf_cpus[i].freeq);
+        pbuf_cpus[i].count = 0;
+    }
+
+    if (spinlock_init("pbuf", &depot_lock) != 0) {
+        panic("pbuf: could not initialize depot\n");
+    }
+
+    TAILQ_INIT(&depot);
+}
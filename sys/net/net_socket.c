@@ -0,0 +1,713 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ip.h>
+#include <net/udp.h>
+#include <net/tcp.h>
+#include <net/socket.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+#define INPCB_NHASH 256
+
+/*
+ * Control block hash bucket, the bind table is keyed
+ * by local port and the connection table by flow hash.
+ */
+struct inpcb_bucket {
+    struct spinlock lock;
+    LIST_HEAD(, inpcb) head;
+};
+
+static struct inpcb_bucket bind_tab[INPCB_NHASH];
+static struct inpcb_bucket conn_tab[INPCB_NHASH];
+static volatile uint32_t port_next = 0;
+
+static struct inpcb_bucket *
+in_bindhash(uint8_t proto, in_port_t lport)
+{
+    return &bind_tab[(ntohs(lport) ^ proto) % INPCB_NHASH];
+}
+
+static struct inpcb_bucket *
+in_connhash(uint32_t hash)
+{
+    return &conn_tab[hash % INPCB_NHASH];
+}
+
+/*
+ * Enter a socket in the bind table if the port is free
+ */
+static int
+in_pcbinsert(struct socket *so, in_addr_t laddr, in_port_t lport)
+{
+    struct inpcb_bucket *b = in_bindhash(so->proto, lport);
+    struct inpcb *inp;
+    bool irq;
+
+    irq = spinlock_acquire_irq(&b->lock);
+    LIST_FOREACH(inp, &b->head, bind_link) {
+        if (inp->so->proto == so->proto && inp->lport == lport) {
+            spinlock_release_irq(&b->lock, irq);
+            return -EADDRINUSE;
+        }
+    }
+
+    so->pcb.laddr = laddr;
+    so->pcb.lport = lport;
+    so->pcb.bound = 1;
+    LIST_INSERT_HEAD(&b->head, &so->pcb, bind_link);
+    spinlock_release_irq(&b->lock, irq);
+    return 0;
+}
+
+/*
+ * Bind to a free ephemeral port, with a foreign end the
+ * port is picked so that the flow hash lands on us.
+ */
+static int
+in_pcbephemeral(struct socket *so, in_addr_t laddr, in_addr_t faddr,
+    in_port_t fport)
+{
+    const uint32_t nport = IPPORT_EPHEMERAL_LAST - IPPORT_EPHEMERAL_FIRST + 1;
+    uint32_t cpu = cpu_self()->id;
+    uint32_t start, hash;
+    in_port_t lport;
+
+    start = __atomic_fetch_add(&port_next, 1, __ATOMIC_RELAXED);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (uint32_t i = 0; i < nport; ++i) {
+            lport = htons(IPPORT_EPHEMERAL_FIRST + ((start + i) % nport));
+            if (pass == 0 && faddr != INADDR_ANY) {
+                hash = net_flow_hash(faddr, laddr, fport, lport);
+                if (net_flow_cpu(hash) != cpu) {
+                    continue;
+                }
+            }
+
+            if (in_pcbinsert(so, laddr, lport) == 0) {
+                return 0;
+            }
+        }
+    }
+
+    return -EADDRINUSE;
+}
+
+struct socket *
+in_pcblookup(uint8_t proto, in_addr_t faddr, in_port_t fport,
+    in_addr_t laddr, in_port_t lport, uint32_t hash)
+{
+    struct inpcb_bucket *b;
+    struct inpcb *inp;
+    struct socket *so;
+    bool irq;
+
+    b = in_connhash(hash);
+    irq = spinlock_acquire_irq(&b->lock);
+    LIST_FOREACH(inp, &b->head, conn_link) {
+        so = inp->so;
+        if (so->proto != proto || inp->faddr != faddr ||
+            inp->fport != fport || inp->laddr != laddr ||
+            inp->lport != lport) {
+            continue;
+        }
+
+        sock_ref(so);
+        spinlock_release_irq(&b->lock, irq);
+        return so;
+    }
+    spinlock_release_irq(&b->lock, irq);
+
+    b = in_bindhash(proto, lport);
+    irq = spinlock_acquire_irq(&b->lock);
+    LIST_FOREACH(inp, &b->head, bind_link) {
+        so = inp->so;
+        if (so->proto != proto || inp->lport != lport || inp->connected) {
+            continue;
+        }
+
+        if (inp->laddr != INADDR_ANY && inp->laddr != laddr) {
+            continue;
+        }
+
+        sock_ref(so);
+        spinlock_release_irq(&b->lock, irq);
+        return so;
+    }
+    spinlock_release_irq(&b->lock, irq);
+    return NULL;
+}
+
+int
+in_pcbbind(struct socket *so, in_addr_t laddr, in_port_t lport)
+{
+    if (so->pcb.bound) {
+        return -EINVAL;
+    }
+
+    if (lport == 0) {
+        return in_pcbephemeral(so, laddr, INADDR_ANY, 0);
+    }
+
+    return in_pcbinsert(so, laddr, lport);
+}
+
+int
+in_pcbconnect(struct socket *so, in_addr_t faddr, in_port_t fport)
+{
+    struct net_ifaddr *ifa = net_ifaddr();
+    struct inpcb *inp = &so->pcb, *tmp;
+    struct inpcb_bucket *b;
+    in_addr_t laddr;
+    uint32_t hash;
+    bool irq;
+    int error;
+
+    if (ifa == NULL) {
+        return -ENETDOWN;
+    }
+
+    if (faddr == INADDR_ANY || fport == 0) {
+        return -EDESTADDRREQ;
+    }
+
+    if (inp->connected) {
+        return -EISCONN;
+    }
+
+    laddr = inp->laddr;
+    if (laddr == INADDR_ANY) {
+        laddr = htonl(ifa->addr);
+    }
+
+    if (inp->lport == 0) {
+        error = in_pcbephemeral(so, laddr, faddr, fport);
+        if (error < 0) {
+            return error;
+        }
+    }
+
+    hash = net_flow_hash(faddr, laddr, fport, inp->lport);
+    b = in_connhash(hash);
+    irq = spinlock_acquire_irq(&b->lock);
+    LIST_FOREACH(tmp, &b->head, conn_link) {
+        if (tmp->so->proto == so->proto && tmp->faddr == faddr &&
+            tmp->fport == fport && tmp->laddr == laddr &&
+            tmp->lport == inp->lport) {
+            spinlock_release_irq(&b->lock, irq);
+            return -EADDRINUSE;
+        }
+    }
+
+    inp->laddr = laddr;
+    inp->faddr = faddr;
+    inp->fport = fport;
+    inp->hash = hash;
+    inp->connected = 1;
+    LIST_INSERT_HEAD(&b->head, inp, conn_link);
+    spinlock_release_irq(&b->lock, irq);
+
+    so->cpu = net_flow_cpu(hash);
+    return 0;
+}
+
+void
+in_pcbdetach(struct socket *so)
+{
+    struct inpcb *inp = &so->pcb;
+    struct inpcb_bucket *b;
+    bool irq;
+
+    if (inp->connected) {
+        b = in_connhash(inp->hash);
+        irq = spinlock_acquire_irq(&b->lock);
+        LIST_REMOVE(inp, conn_link);
+        inp->connected = 0;
+        spinlock_release_irq(&b->lock, irq);
+    }
+
+    if (inp->bound) {
+        b = in_bindhash(so->proto, inp->lport);
+        irq = spinlock_acquire_irq(&b->lock);
+        LIST_REMOVE(inp, bind_link);
+        inp->bound = 0;
+        spinlock_release_irq(&b->lock, irq);
+    }
+}
+
+void
+in_pcbinit(void)
+{
+    for (size_t i = 0; i < INPCB_NHASH; ++i) {
+        if (spinlock_init("inpcb", &bind_tab[i].lock) != 0) {
+            panic("socket: could not initialize bind table\n");
+        }
+
+        if (spinlock_init("inpcb", &conn_tab[i].lock) != 0) {
+            panic("socket: could not initialize connection table\n");
+        }
+
+        LIST_INIT(&bind_tab[i].head);
+        LIST_INIT(&conn_tab[i].head);
+    }
+}
+
+/*
+ * Hand back a list of received packets
+ */
+static void
+sock_pktfree(struct netif_pktq *q)
+{
+    struct netif_pkt *pkt;
+
+    while ((pkt = TAILQ_FIRST(q)) != NULL) {
+        TAILQ_REMOVE(q, pkt, link);
+        netif_rxfree(pkt);
+    }
+}
+
+/*
+ * Fill in where a received packet came from, stream
+ * sockets need no packet.
+ */
+static void
+sock_from(struct socket *so, struct netif_pkt *pkt, struct sockaddr_in *from)
+{
+    struct udphdr *uh;
+    struct ip *ip;
+
+    if (from == NULL) {
+        return;
+    }
+
+    memset(from, 0, sizeof(*from));
+    from->sin_len = sizeof(*from);
+    from->sin_family = AF_INET;
+    if (so->type == SOCK_STREAM) {
+        from->sin_addr = so->pcb.faddr;
+        from->sin_port = so->pcb.fport;
+        return;
+    }
+
+    ip = pkt->nhdr;
+    uh = PTR_OFFSET(ip, IP_HLEN(ip));
+    from->sin_addr = ip->src;
+    from->sin_port = uh->sport;
+}
+
+struct socket *
+sock_alloc(int type)
+{
+    struct socket *so;
+
+    if ((so = kalloc(sizeof(*so))) == NULL) {
+        return NULL;
+    }
+
+    memset(so, 0, sizeof(*so));
+    if (spinlock_init("socket", &so->lock) != 0) {
+        kfree(so);
+        return NULL;
+    }
+
+    so->type = type;
+    so->proto = (type == SOCK_STREAM) ? IPPROTO_TCP : IPPROTO_UDP;
+    so->ref = 1;
+    so->cpu = cpu_self()->id;
+    so->pcb.so = so;
+    TAILQ_INIT(&so->rcvq);
+    TAILQ_INIT(&so->acceptq);
+    return so;
+}
+
+void
+sock_ref(struct socket *so)
+{
+    __atomic_fetch_add(&so->ref, 1, __ATOMIC_ACQUIRE);
+}
+
+void
+sock_rele(struct socket *so)
+{
+    if (__atomic_sub_fetch(&so->ref, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+
+    sock_pktfree(&so->rcvq);
+    if (so->tp != NULL) {
+        kfree(so->tp);
+    }
+
+    kfree(so);
+}
+
+bool
+sock_enqueue(struct socket *so, struct netif_pkt *pkt)
+{
+    if (so->rcvqlen >= SO_RCVQMAX || ISSET(so->state, SS_CANTRCVMORE)) {
+        return false;
+    }
+
+    TAILQ_INSERT_TAIL(&so->rcvq, pkt, link);
+    ++so->rcvqlen;
+    return true;
+}
+
+int
+sock_create(int type, struct socket **res)
+{
+    struct socket *so;
+    int error;
+
+    if (type != SOCK_STREAM && type != SOCK_DGRAM) {
+        return -EPROTONOSUPPORT;
+    }
+
+    if ((so = sock_alloc(type)) == NULL) {
+        return -ENOMEM;
+    }
+
+    if (type == SOCK_STREAM) {
+        if ((error = tcp_attach(so)) < 0) {
+            sock_rele(so);
+            return error;
+        }
+    }
+
+    *res = so;
+    return 0;
+}
+
+int
+sock_bind(struct socket *so, const struct sockaddr_in *sin)
+{
+    int error;
+    bool irq;
+
+    if (sin == NULL || sin->sin_family != AF_INET) {
+        return -EINVAL;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    error = in_pcbbind(so, sin->sin_addr, sin->sin_port);
+    spinlock_release_irq(&so->lock, irq);
+    return error;
+}
+
+int
+sock_listen(struct socket *so, uint16_t backlog)
+{
+    int error = 0;
+    bool irq;
+
+    if (so->type != SOCK_STREAM) {
+        return -EOPNOTSUPP;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    if (!so->pcb.bound) {
+        error = in_pcbbind(so, INADDR_ANY, 0);
+    }
+
+    if (error == 0) {
+        error = tcp_listen(so);
+    }
+
+    if (error == 0) {
+        so->qlimit = MAX(backlog, 1);
+        __atomic_or_fetch(&so->state, SS_LISTENING, __ATOMIC_RELEASE);
+    }
+    spinlock_release_irq(&so->lock, irq);
+    return error;
+}
+
+int
+sock_accept(struct socket *so, struct socket **res)
+{
+    struct socket *child, *tmp;
+    int error = -EAGAIN;
+    bool irq, cirq;
+
+    if (!ISSET(so->state, SS_LISTENING)) {
+        return -EINVAL;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    TAILQ_FOREACH_SAFE(child, &so->acceptq, qlink, tmp) {
+        /* Still shaking hands */
+        cirq = spinlock_acquire_irq(&child->lock);
+        if (child->tp->state == TCPS_SYN_RECEIVED) {
+            spinlock_release_irq(&child->lock, cirq);
+            continue;
+        }
+        spinlock_release_irq(&child->lock, cirq);
+
+        TAILQ_REMOVE(&so->acceptq, child, qlink);
+        --so->qlen;
+        child->head = NULL;
+
+        /* Dead with nothing left to read */
+        if (!ISSET(child->state, SS_ISCONNECTED) && child->error != 0 &&
+            child->rcvqlen == 0) {
+            sock_rele(child);
+            continue;
+        }
+
+        *res = child;
+        error = 0;
+        break;
+    }
+    spinlock_release_irq(&so->lock, irq);
+    return error;
+}
+
+int
+sock_connect(struct socket *so, const struct sockaddr_in *sin)
+{
+    int error;
+    bool irq;
+
+    if (sin == NULL || sin->sin_family != AF_INET) {
+        return -EINVAL;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    if (so->pcb.connected) {
+        if (so->error != 0) {
+            error = so->error;
+        } else if (ISSET(so->state, SS_ISCONNECTED)) {
+            error = -EISCONN;
+        } else {
+            error = -EALREADY;
+        }
+
+        spinlock_release_irq(&so->lock, irq);
+        return error;
+    }
+
+    error = in_pcbconnect(so, sin->sin_addr, sin->sin_port);
+    if (error == 0 && so->type == SOCK_STREAM) {
+        if ((error = tcp_connect(so)) == 0) {
+            error = -EINPROGRESS;
+        }
+    } else if (error == 0) {
+        __atomic_or_fetch(&so->state, SS_ISCONNECTED, __ATOMIC_RELEASE);
+    }
+    spinlock_release_irq(&so->lock, irq);
+    return error;
+}
+
+ssize_t
+sock_send(struct socket *so, const void *buf, size_t len,
+    const struct sockaddr_in *to)
+{
+    in_addr_t faddr;
+    in_port_t fport;
+    ssize_t retval;
+    bool irq;
+
+    if (buf == NULL && len > 0) {
+        return -EINVAL;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    if (so->type == SOCK_STREAM) {
+        retval = tcp_send(so, buf, len);
+        spinlock_release_irq(&so->lock, irq);
+        return retval;
+    }
+
+    faddr = so->pcb.faddr;
+    fport = so->pcb.fport;
+    if (to != NULL && !so->pcb.connected) {
+        faddr = to->sin_addr;
+        fport = to->sin_port;
+    }
+
+    if (faddr == INADDR_ANY || fport == 0) {
+        spinlock_release_irq(&so->lock, irq);
+        return -EDESTADDRREQ;
+    }
+
+    retval = 0;
+    if (!so->pcb.bound) {
+        retval = in_pcbbind(so, INADDR_ANY, 0);
+    }
+
+    if (retval == 0) {
+        retval = udp_output(so, buf, len, faddr, fport);
+    }
+    spinlock_release_irq(&so->lock, irq);
+    return retval;
+}
+
+int
+sock_recvpkt(struct socket *so, struct netif_pkt **res,
+    struct sockaddr_in *from)
+{
+    struct netif_pkt *pkt;
+    int error = 0;
+    bool irq;
+
+    irq = spinlock_acquire_irq(&so->lock);
+    if ((pkt = TAILQ_FIRST(&so->rcvq)) == NULL) {
+        if (so->error != 0) {
+            error = so->error;
+        } else if (!ISSET(so->state, SS_CANTRCVMORE)) {
+            error = -EAGAIN;
+        }
+
+        spinlock_release_irq(&so->lock, irq);
+        *res = NULL;
+        return error;
+    }
+
+    TAILQ_REMOVE(&so->rcvq, pkt, link);
+    --so->rcvqlen;
+
+    /* Skip what sock_recv() already copied out */
+    pkt->data = PTR_OFFSET(pkt->data, so->rcvoff);
+    pkt->len -= so->rcvoff;
+    so->rcvoff = 0;
+
+    sock_from(so, pkt, from);
+    if (so->type == SOCK_STREAM) {
+        tcp_rcvd(so);
+    }
+    spinlock_release_irq(&so->lock, irq);
+
+    *res = pkt;
+    return 0;
+}
+
+ssize_t
+sock_recv(struct socket *so, void *buf, size_t len, struct sockaddr_in *from)
+{
+    struct netif_pktq done;
+    struct netif_pkt *pkt;
+    size_t off = 0, avail, n;
+    ssize_t retval;
+    bool irq;
+
+    TAILQ_INIT(&done);
+    irq = spinlock_acquire_irq(&so->lock);
+    while (off < len && (pkt = TAILQ_FIRST(&so->rcvq)) != NULL) {
+        avail = pkt->len - so->rcvoff;
+        n = MIN(avail, len - off);
+        memcpy(PTR_OFFSET(buf, off), PTR_OFFSET(pkt->data, so->rcvoff), n);
+        off += n;
+
+        /* The rest of a datagram is lost */
+        if (so->type == SOCK_DGRAM) {
+            sock_from(so, pkt, from);
+            n = avail;
+        }
+
+        if (n < avail) {
+            so->rcvoff += n;
+            break;
+        }
+
+        TAILQ_REMOVE(&so->rcvq, pkt, link);
+        TAILQ_INSERT_TAIL(&done, pkt, link);
+        --so->rcvqlen;
+        so->rcvoff = 0;
+
+        if (so->type == SOCK_DGRAM) {
+            break;
+        }
+
+        tcp_rcvd(so);
+    }
+
+    retval = off;
+    if (off == 0 && len > 0) {
+        if (so->error != 0) {
+            retval = so->error;
+        } else if (!ISSET(so->state, SS_CANTRCVMORE)) {
+            retval = -EAGAIN;
+        }
+    }
+
+    if (so->type == SOCK_STREAM && off > 0) {
+        sock_from(so, NULL, from);
+    }
+    spinlock_release_irq(&so->lock, irq);
+
+    sock_pktfree(&done);
+    return retval;
+}
+
+int
+sock_close(struct socket *so)
+{
+    TAILQ_HEAD(, socket) children;
+    struct netif_pktq rcvq;
+    struct socket *child;
+    bool irq;
+
+    TAILQ_INIT(&children);
+    TAILQ_INIT(&rcvq);
+
+    irq = spinlock_acquire_irq(&so->lock);
+    __atomic_or_fetch(&so->state, SS_CLOSED | SS_CANTRCVMORE, __ATOMIC_RELEASE);
+    TAILQ_CONCAT(&rcvq, &so->rcvq, link);
+    TAILQ_CONCAT(&children, &so->acceptq, qlink);
+    so->rcvqlen = 0;
+    so->rcvoff = 0;
+    so->qlen = 0;
+
+    if (so->type == SOCK_STREAM) {
+        tcp_usrclose(so);
+    } else {
+        in_pcbdetach(so);
+    }
+    spinlock_release_irq(&so->lock, irq);
+
+    sock_pktfree(&rcvq);
+    while ((child = TAILQ_FIRST(&children)) != NULL) {
+        TAILQ_REMOVE(&children, child, qlink);
+        child->head = NULL;
+        sock_close(child);
+    }
+
+    sock_rele(so);
+    return 0;
+}
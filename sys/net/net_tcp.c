@@ -0,0 +1,1094 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <kern/spinlock.h>
+#include <kern/panic.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ip.h>
+#include <net/tcp.h>
+#include <net/pbuf.h>
+#include <net/socket.h>
+#include <os/softint.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+/* Max timers expired per tick */
+#define TCP_TIMER_BATCH 32
+
+/*
+ * Per processor list of running timers, a control
+ * block sits on the list of the processor its flow is
+ * steered to unless that one is isolated, see
+ * tcp_timer_cpu().
+ */
+struct tcp_cpu {
+    struct spinlock lock;
+    TAILQ_HEAD(, tcpcb) timerq;
+};
+
+static struct tcp_cpu *tcp_cpus;
+static size_t ncpu;
+static volatile uint32_t tcp_issgen = 0;
+
+/*
+ * Isolated processors may stop their tick and would never
+ * run the timers, place the list on the core the flow is
+ * steered to or a general one near it.
+ */
+static uint16_t
+tcp_timer_cpu(struct socket *so)
+{
+    return cpu_pick(so->cpu)->id % ncpu;
+}
+
+/*
+ * Lock the timer list a control block is on, the tick
+ * of another processor may move it while we wait.
+ */
+static struct tcp_cpu *
+tcp_timer_lock(struct tcpcb *tp, bool *irq)
+{
+    struct tcp_cpu *tc;
+
+    for (;;) {
+        tc = &tcp_cpus[__atomic_load_n(&tp->cpu, __ATOMIC_ACQUIRE)];
+        *irq = spinlock_acquire_irq(&tc->lock);
+        if (tc == &tcp_cpus[tp->cpu]) {
+            return tc;
+        }
+        spinlock_release_irq(&tc->lock, *irq);
+    }
+}
+
+/*
+ * XXX: Socket must be locked
+ */
+static void
+tcp_timer_arm(struct tcpcb *tp, uint32_t ticks)
+{
+    struct tcp_cpu *tc;
+    bool irq;
+
+    tc = tcp_timer_lock(tp, &irq);
+    if (tp->timer == 0) {
+        TAILQ_INSERT_TAIL(&tc->timerq, tp, timer_link);
+    }
+
+    tp->timer = ticks;
+    spinlock_release_irq(&tc->lock, irq);
+}
+
+/*
+ * XXX: Socket must be locked
+ */
+static void
+tcp_timer_cancel(struct tcpcb *tp)
+{
+    struct tcp_cpu *tc;
+    bool irq;
+
+    tc = tcp_timer_lock(tp, &irq);
+    if (tp->timer != 0) {
+        TAILQ_REMOVE(&tc->timerq, tp, timer_link);
+        tp->timer = 0;
+    }
+    spinlock_release_irq(&tc->lock, irq);
+}
+
+static uint32_t
+tcp_rto(struct tcpcb *tp)
+{
+    return MIN((uint32_t)TCP_RTO_TICKS << tp->rxtshift, TCP_RTO_MAX);
+}
+
+static uint32_t
+tcp_newiss(uint32_t hash)
+{
+    return (hash * 2654435761U) +
+        __atomic_add_fetch(&tcp_issgen, 64000, __ATOMIC_RELAXED);
+}
+
+/*
+ * Receive window we advertise, one segment for every
+ * free slot on the receive queue.
+ */
+static uint16_t
+tcp_rcvwin(struct socket *so)
+{
+    size_t win;
+
+    win = (size_t)(SO_RCVQMAX - MIN(so->rcvqlen, SO_RCVQMAX)) * TCP_MSS;
+    return MIN(win, 0xFFFF);
+}
+
+/*
+ * Get the segment size announced in a SYN
+ */
+static uint16_t
+tcp_mss(struct tcphdr *th)
+{
+    const uint8_t *opt = (const uint8_t *)(th + 1);
+    size_t len = TH_OFF(th) - sizeof(*th);
+    uint16_t mss = TCP_MSS_DFLT;
+
+    while (len > 0) {
+        if (opt[0] == TCPOPT_EOL) {
+            break;
+        }
+
+        if (opt[0] == TCPOPT_NOP) {
+            ++opt;
+            --len;
+            continue;
+        }
+
+        if (len < 2 || opt[1] < 2 || opt[1] > len) {
+            break;
+        }
+
+        if (opt[0] == TCPOPT_MAXSEG && opt[1] == 4) {
+            mss = (opt[2] << 8) | opt[3];
+        }
+
+        len -= opt[1];
+        opt += opt[1];
+    }
+
+    return MIN(MAX(mss, 64), TCP_MSS);
+}
+
+/*
+ * Send a segment without data, addresses and ports are
+ * in network order.
+ */
+static int
+tcp_respond(in_addr_t laddr, in_addr_t faddr, in_port_t lport,
+    in_port_t fport, uint32_t seq, uint32_t ack, uint8_t flags, uint16_t win)
+{
+    struct tcphdr *th;
+    struct pbuf *pb;
+    uint8_t *opt;
+    uint16_t hlen;
+    int error;
+
+    if ((pb = pbuf_alloc()) == NULL) {
+        return -ENOMEM;
+    }
+
+    /* Announce our segment size on SYNs */
+    if (ISSET(flags, TH_SYN)) {
+        opt = pb->data;
+        opt[0] = TCPOPT_MAXSEG;
+        opt[1] = 4;
+        opt[2] = TCP_MSS >> 8;
+        opt[3] = TCP_MSS & 0xFF;
+        pb->len = 4;
+    }
+
+    hlen = sizeof(*th) + pb->len;
+    th = pbuf_push(pb, sizeof(*th));
+    th->sport = lport;
+    th->dport = fport;
+    th->seq = htonl(seq);
+    th->ack = ISSET(flags, TH_ACK) ? htonl(ack) : 0;
+    th->off = (hlen >> 2) << 4;
+    th->flags = flags;
+    th->win = htons(win);
+    th->sum = 0;
+    th->urp = 0;
+    th->sum = in_cksum(th, hlen, in_pseudo(laddr, faddr, IPPROTO_TCP, hlen));
+
+    error = ip_output(pb, IPPROTO_TCP, ntohl(laddr), ntohl(faddr));
+    pbuf_release(pb);
+    return error;
+}
+
+static int
+tcp_respond_tp(struct tcpcb *tp, uint32_t seq, uint8_t flags)
+{
+    struct socket *so = tp->so;
+    struct inpcb *inp = &so->pcb;
+
+    return tcp_respond(inp->laddr, inp->faddr, inp->lport, inp->fport, seq,
+        tp->rcv_nxt, flags, tcp_rcvwin(so));
+}
+
+/*
+ * Send a queued segment, the buffer stays on the send
+ * queue for retransmission.
+ */
+static void
+tcp_xmit(struct tcpcb *tp, struct pbuf *pb)
+{
+    struct socket *so = tp->so;
+    struct inpcb *inp = &so->pcb;
+    struct tcphdr *th;
+    uint16_t len;
+
+    pbuf_reset(pb);
+    len = sizeof(*th) + pb->len;
+    th = pbuf_push(pb, sizeof(*th));
+    th->sport = inp->lport;
+    th->dport = inp->fport;
+    th->seq = htonl(pb->seq);
+    th->ack = htonl(tp->rcv_nxt);
+    th->off = (sizeof(*th) >> 2) << 4;
+    th->flags = TH_ACK | TH_PUSH;
+    th->win = htons(tcp_rcvwin(so));
+    th->sum = 0;
+    th->urp = 0;
+    th->sum = in_cksum(th, len, in_pseudo(inp->laddr, inp->faddr,
+        IPPROTO_TCP, len));
+
+    ip_output(pb, IPPROTO_TCP, ntohl(inp->laddr), ntohl(inp->faddr));
+}
+
+/*
+ * Send whatever the window allows, then the FIN once
+ * the data is out.
+ *
+ * XXX: Socket must be locked
+ */
+static void
+tcp_output(struct tcpcb *tp)
+{
+    struct pbuf *pb;
+    uint32_t wend;
+    bool sent = false;
+
+    if (tp->state < TCPS_ESTABLISHED) {
+        return;
+    }
+
+    wend = tp->snd_una + tp->snd_wnd;
+    TAILQ_FOREACH(pb, &tp->sndq, link) {
+        if (SEQ_LT(pb->seq, tp->snd_nxt)) {
+            continue;
+        }
+
+        if (SEQ_GT(pb->seq + pb->len, wend)) {
+            break;
+        }
+
+        /* Still on the wire from last time */
+        if (ISSET(pb->state, PBUF_BUSY)) {
+            break;
+        }
+
+        tcp_xmit(tp, pb);
+        tp->snd_nxt = pb->seq + pb->len;
+        sent = true;
+    }
+
+    if (ISSET(tp->flags, TF_NEEDFIN) && !ISSET(tp->flags, TF_SENTFIN) &&
+        tp->snd_nxt == tp->snd_end) {
+        tcp_respond_tp(tp, tp->snd_end, TH_FIN | TH_ACK);
+        tp->flags |= TF_SENTFIN;
+        tp->snd_nxt = tp->snd_end + 1;
+        sent = true;
+    }
+
+    if (!sent && ISSET(tp->flags, TF_ACKNOW)) {
+        tcp_respond_tp(tp, tp->snd_nxt, TH_ACK);
+    }
+
+    tp->flags &= ~TF_ACKNOW;
+    if (SEQ_GT(tp->snd_nxt, tp->snd_max)) {
+        tp->snd_max = tp->snd_nxt;
+    }
+
+    if (tp->timer == 0 && tp->state != TCPS_TIME_WAIT) {
+        if (tp->snd_una != tp->snd_max || !TAILQ_EMPTY(&tp->sndq)) {
+            tcp_timer_arm(tp, tcp_rto(tp));
+        }
+    }
+}
+
+/*
+ * Tear down a connection, drops the protocol reference
+ *
+ * XXX: Socket must be locked and referenced
+ */
+static void
+tcp_close(struct tcpcb *tp, int error)
+{
+    struct socket *so = tp->so;
+    struct pbuf *pb;
+
+    if (tp->state == TCPS_CLOSED) {
+        return;
+    }
+
+    tp->state = TCPS_CLOSED;
+    if (error != 0) {
+        so->error = error;
+    }
+
+    tcp_timer_cancel(tp);
+    while ((pb = TAILQ_FIRST(&tp->sndq)) != NULL) {
+        TAILQ_REMOVE(&tp->sndq, pb, link);
+        pbuf_release(pb);
+    }
+
+    tp->sndqlen = 0;
+    __atomic_and_fetch(&so->state, ~SS_ISCONNECTED, __ATOMIC_RELEASE);
+    __atomic_or_fetch(&so->state, SS_CANTRCVMORE, __ATOMIC_RELEASE);
+    in_pcbdetach(so);
+    sock_rele(so);
+}
+
+/*
+ * Abort a connection, the peer is told with a reset
+ *
+ * XXX: Socket must be locked and referenced
+ */
+static void
+tcp_drop(struct tcpcb *tp, int error)
+{
+    if (tp->state >= TCPS_SYN_RECEIVED) {
+        tcp_respond_tp(tp, tp->snd_nxt, TH_RST | TH_ACK);
+    }
+
+    tcp_close(tp, error);
+}
+
+/*
+ * Free everything up to 'ack'
+ *
+ * XXX: Socket must be locked
+ */
+static void
+tcp_acked(struct tcpcb *tp, uint32_t ack)
+{
+    struct pbuf *pb;
+    uint32_t trim;
+
+    tp->snd_una = ack;
+    if (SEQ_LT(tp->snd_nxt, ack)) {
+        tp->snd_nxt = ack;
+    }
+
+    while ((pb = TAILQ_FIRST(&tp->sndq)) != NULL) {
+        if (SEQ_GT(pb->seq + pb->len, ack)) {
+            break;
+        }
+
+        TAILQ_REMOVE(&tp->sndq, pb, link);
+        --tp->sndqlen;
+        pbuf_release(pb);
+    }
+
+    /* Partially acknowledged segment */
+    if (pb != NULL && SEQ_LT(pb->seq, ack)) {
+        trim = ack - pb->seq;
+        pb->data += trim;
+        pb->len -= trim;
+        pb->seq = ack;
+    }
+
+    tp->rxtshift = 0;
+    tcp_timer_cancel(tp);
+}
+
+/*
+ * Answer a segment nobody wants with a reset
+ */
+static void
+tcp_reset(struct ip *ip, struct tcphdr *th, uint16_t tlen)
+{
+    uint32_t ack;
+
+    if (ISSET(th->flags, TH_RST)) {
+        return;
+    }
+
+    if (ISSET(th->flags, TH_ACK)) {
+        tcp_respond(ip->dst, ip->src, th->dport, th->sport, ntohl(th->ack),
+            0, TH_RST, 0);
+        return;
+    }
+
+    ack = ntohl(th->seq) + tlen;
+    if (ISSET(th->flags, TH_SYN)) {
+        ++ack;
+    }
+
+    if (ISSET(th->flags, TH_FIN)) {
+        ++ack;
+    }
+
+    tcp_respond(ip->dst, ip->src, th->dport, th->sport, 0, ack,
+        TH_RST | TH_ACK, 0);
+}
+
+/*
+ * A SYN hit a listener, the new connection lives on
+ * the core that took the SYN and goes on the accept
+ * queue right away.
+ *
+ * XXX: Listener must be locked
+ */
+static void
+tcp_passive(struct socket *lso, struct ip *ip, struct tcphdr *th,
+    uint32_t hash)
+{
+    struct socket *so;
+    struct tcpcb *tp;
+    bool irq;
+
+    if (lso->qlen >= lso->qlimit) {
+        return;
+    }
+
+    if ((so = sock_alloc(SOCK_STREAM)) == NULL) {
+        return;
+    }
+
+    if (tcp_attach(so) < 0) {
+        sock_rele(so);
+        return;
+    }
+
+    tp = so->tp;
+    tp->irs = ntohl(th->seq);
+    tp->rcv_nxt = tp->irs + 1;
+    tp->iss = tcp_newiss(hash);
+    tp->snd_una = tp->iss;
+    tp->snd_nxt = tp->iss + 1;
+    tp->snd_max = tp->snd_nxt;
+    tp->snd_end = tp->snd_nxt;
+    tp->snd_wnd = ntohs(th->win);
+    tp->mss = tcp_mss(th);
+
+    /* The protocol reference */
+    tp->state = TCPS_SYN_RECEIVED;
+    sock_ref(so);
+
+    /* Visible to input on other cores from here on */
+    irq = spinlock_acquire_irq(&so->lock);
+    so->pcb.laddr = ip->dst;
+    so->pcb.lport = th->dport;
+    if (in_pcbconnect(so, ip->src, th->sport) < 0) {
+        tcp_close(tp, 0);
+        spinlock_release_irq(&so->lock, irq);
+        sock_rele(so);
+        return;
+    }
+
+    tp->cpu = tcp_timer_cpu(so);
+    tcp_respond_tp(tp, tp->iss, TH_SYN | TH_ACK);
+    tcp_timer_arm(tp, tcp_rto(tp));
+    spinlock_release_irq(&so->lock, irq);
+
+    so->head = lso;
+    TAILQ_INSERT_TAIL(&lso->acceptq, so, qlink);
+    ++lso->qlen;
+}
+
+/*
+ * Handle a segment in SYN_SENT
+ *
+ * XXX: Socket must be locked
+ */
+static void
+tcp_synsent(struct tcpcb *tp, struct tcphdr *th)
+{
+    struct socket *so = tp->so;
+    uint32_t ack = ntohl(th->ack);
+
+    if (ISSET(th->flags, TH_ACK)) {
+        if (SEQ_LEQ(ack, tp->iss) || SEQ_GT(ack, tp->snd_max)) {
+            if (!ISSET(th->flags, TH_RST)) {
+                tcp_respond_tp(tp, ack, TH_RST);
+            }
+            return;
+        }
+    }
+
+    if (ISSET(th->flags, TH_RST)) {
+        if (ISSET(th->flags, TH_ACK)) {
+            tcp_close(tp, -ECONNREFUSED);
+        }
+        return;
+    }
+
+    /* No simultaneous open */
+    if (!ISSET(th->flags, TH_SYN) || !ISSET(th->flags, TH_ACK)) {
+        return;
+    }
+
+    tp->irs = ntohl(th->seq);
+    tp->rcv_nxt = tp->irs + 1;
+    tp->snd_wnd = ntohs(th->win);
+    tp->mss = tcp_mss(th);
+    tcp_acked(tp, ack);
+
+    tp->state = TCPS_ESTABLISHED;
+    __atomic_or_fetch(&so->state, SS_ISCONNECTED, __ATOMIC_RELEASE);
+    tp->flags |= TF_ACKNOW;
+    tcp_output(tp);
+}
+
+/*
+ * Handle a segment on a synchronized connection, only
+ * in order data is taken and it is queued on the socket
+ * in place.
+ *
+ * Returns true if the packet went on the receive queue
+ *
+ * XXX: Socket must be locked and referenced
+ */
+static bool
+tcp_segment(struct tcpcb *tp, struct netif_pkt *pkt, struct tcphdr *th)
+{
+    struct socket *so = tp->so;
+    uint32_t seq = ntohl(th->seq);
+    uint32_t ack = ntohl(th->ack);
+    uint16_t off = TH_OFF(th);
+    uint16_t tlen = pkt->len - off;
+    uint8_t flags = th->flags;
+    bool queued = false;
+
+    if (ISSET(flags, TH_RST)) {
+        if (seq == tp->rcv_nxt) {
+            tcp_close(tp, -ECONNRESET);
+        }
+        return false;
+    }
+
+    if (ISSET(flags, TH_SYN)) {
+        if (tp->state == TCPS_SYN_RECEIVED && seq == tp->irs) {
+            tcp_respond_tp(tp, tp->iss, TH_SYN | TH_ACK);
+            return false;
+        }
+
+        tp->flags |= TF_ACKNOW;
+        tcp_output(tp);
+        return false;
+    }
+
+    if (!ISSET(flags, TH_ACK)) {
+        return false;
+    }
+
+    if (tp->state == TCPS_SYN_RECEIVED) {
+        if (ack != tp->iss + 1) {
+            tcp_respond_tp(tp, ack, TH_RST);
+            return false;
+        }
+
+        tp->state = TCPS_ESTABLISHED;
+        __atomic_or_fetch(&so->state, SS_ISCONNECTED, __ATOMIC_RELEASE);
+    }
+
+    if (SEQ_GT(ack, tp->snd_max)) {
+        tp->flags |= TF_ACKNOW;
+        tcp_output(tp);
+        return false;
+    }
+
+    if (SEQ_GT(ack, tp->snd_una)) {
+        tcp_acked(tp, ack);
+    }
+
+    if (SEQ_GEQ(ack, tp->snd_una)) {
+        tp->snd_wnd = ntohs(th->win);
+    }
+
+    /* Our FIN went through */
+    if (ISSET(tp->flags, TF_NEEDFIN) && SEQ_GT(ack, tp->snd_end)) {
+        switch (tp->state) {
+        case TCPS_FIN_WAIT_1:
+            tp->state = TCPS_FIN_WAIT_2;
+            break;
+        case TCPS_CLOSING:
+            tp->state = TCPS_TIME_WAIT;
+            tcp_timer_arm(tp, 2 * TCP_MSL_TICKS);
+            break;
+        case TCPS_LAST_ACK:
+            tcp_close(tp, 0);
+            return false;
+        }
+    }
+
+    /* Nobody left to read it */
+    if (tlen > 0 && ISSET(so->state, SS_CLOSED)) {
+        tcp_drop(tp, 0);
+        return false;
+    }
+
+    if (tlen > 0) {
+        tp->flags |= TF_ACKNOW;
+        if (seq == tp->rcv_nxt && !ISSET(so->state, SS_CANTRCVMORE)) {
+            pkt->data = PTR_OFFSET(th, off);
+            pkt->len = tlen;
+            if ((queued = sock_enqueue(so, pkt))) {
+                tp->rcv_nxt += tlen;
+            }
+        }
+    }
+
+    /* Only a FIN in sequence counts */
+    if (ISSET(flags, TH_FIN) && seq + tlen == tp->rcv_nxt) {
+        ++tp->rcv_nxt;
+        tp->flags |= TF_ACKNOW;
+        __atomic_or_fetch(&so->state, SS_CANTRCVMORE, __ATOMIC_RELEASE);
+        switch (tp->state) {
+        case TCPS_ESTABLISHED:
+            tp->state = TCPS_CLOSE_WAIT;
+            break;
+        case TCPS_FIN_WAIT_1:
+            tp->state = TCPS_CLOSING;
+            break;
+        case TCPS_FIN_WAIT_2:
+        case TCPS_TIME_WAIT:
+            tp->state = TCPS_TIME_WAIT;
+            tcp_timer_arm(tp, 2 * TCP_MSL_TICKS);
+            break;
+        }
+    }
+
+    tcp_output(tp);
+    return queued;
+}
+
+/*
+ * XXX: Socket must be locked and referenced
+ */
+static void
+tcp_timeout(struct tcpcb *tp)
+{
+    struct pbuf *pb;
+
+    if (tp->state == TCPS_TIME_WAIT) {
+        tcp_close(tp, 0);
+        return;
+    }
+
+    if (++tp->rxtshift > TCP_MAXRXTSHIFT) {
+        tcp_drop(tp, -ETIMEDOUT);
+        return;
+    }
+
+    ++net_stat_self()->tcp_rexmt;
+    switch (tp->state) {
+    case TCPS_SYN_SENT:
+        tcp_respond_tp(tp, tp->iss, TH_SYN);
+        tcp_timer_arm(tp, tcp_rto(tp));
+        return;
+    case TCPS_SYN_RECEIVED:
+        tcp_respond_tp(tp, tp->iss, TH_SYN | TH_ACK);
+        tcp_timer_arm(tp, tcp_rto(tp));
+        return;
+    }
+
+    /* Go back to the oldest unacknowledged byte */
+    tp->snd_nxt = tp->snd_una;
+    tp->flags &= ~TF_SENTFIN;
+
+    /* Probe a shut window with the first segment */
+    pb = TAILQ_FIRST(&tp->sndq);
+    if (tp->snd_wnd == 0 && pb != NULL && !ISSET(pb->state, PBUF_BUSY)) {
+        tcp_xmit(tp, pb);
+        tp->snd_nxt = pb->seq + pb->len;
+    }
+
+    tcp_output(tp);
+}
+
+/*
+ * Move the timers of processors that were isolated after
+ * they got them onto our list, their tick may be stopped.
+ * Locks are taken in list order.
+ */
+static void
+tcp_timer_adopt(uint32_t self)
+{
+    struct tcp_cpu *tc, *from, *first, *second;
+    struct cpu_info *ci;
+    struct tcpcb *tp;
+    bool irq, irq1;
+
+    tc = &tcp_cpus[self];
+    for (uint32_t i = 0; i < ncpu; ++i) {
+        ci = cpu_get(i);
+        if (i == self || ci == NULL || !ISSET(ci->flags, CPU_ISOLATED)) {
+            continue;
+        }
+
+        from = &tcp_cpus[i];
+        if (TAILQ_EMPTY(&from->timerq)) {
+            continue;
+        }
+
+        first = (i < self) ? from : tc;
+        second = (i < self) ? tc : from;
+        irq = spinlock_acquire_irq(&first->lock);
+        irq1 = spinlock_acquire_irq(&second->lock);
+        while ((tp = TAILQ_FIRST(&from->timerq)) != NULL) {
+            TAILQ_REMOVE(&from->timerq, tp, timer_link);
+            TAILQ_INSERT_TAIL(&tc->timerq, tp, timer_link);
+            __atomic_store_n(&tp->cpu, self, __ATOMIC_RELEASE);
+        }
+        spinlock_release_irq(&second->lock, irq1);
+        spinlock_release_irq(&first->lock, irq);
+    }
+}
+
+/*
+ * Scheduler tick, run the expired timers of this
+ * processor.
+ */
+static bool
+tcp_slowtimo(size_t budget)
+{
+    struct tcpcb *expired[TCP_TIMER_BATCH];
+    struct net_ifaddr *ifa;
+    struct cpu_info *ci;
+    struct tcp_cpu *tc;
+    struct tcpcb *tp, *tmp;
+    struct socket *so;
+    size_t nexp = 0;
+    bool irq;
+
+    if (tcp_cpus == NULL) {
+        return false;
+    }
+
+    ci = cpu_self();
+    if (!ISSET(ci->flags, CPU_ISOLATED)) {
+        tcp_timer_adopt(ci->id % ncpu);
+    }
+
+    tc = &tcp_cpus[ci->id % ncpu];
+    irq = spinlock_acquire_irq(&tc->lock);
+    TAILQ_FOREACH_SAFE(tp, &tc->timerq, timer_link, tmp) {
+        if (--tp->timer > 0) {
+            continue;
+        }
+
+        /* Out of room, fire on the next tick */
+        if (nexp == NELEM(expired)) {
+            tp->timer = 1;
+            continue;
+        }
+
+        TAILQ_REMOVE(&tc->timerq, tp, timer_link);
+        sock_ref(tp->so);
+        expired[nexp++] = tp;
+    }
+    spinlock_release_irq(&tc->lock, irq);
+
+    /*
+     * A segment still marked busy is not resent, reap the
+     * transmit completions first so a lost one that went
+     * out last is not skipped on every timeout.
+     */
+    if (nexp > 0 && (ifa = net_ifaddr()) != NULL) {
+        netif_poll(ifa->nif);
+    }
+
+    for (size_t i = 0; i < nexp; ++i) {
+        tp = expired[i];
+        so = tp->so;
+
+        /* Skip if rearmed in the meantime */
+        irq = spinlock_acquire_irq(&so->lock);
+        if (tp->timer == 0 && tp->state != TCPS_CLOSED) {
+            tcp_timeout(tp);
+        }
+        spinlock_release_irq(&so->lock, irq);
+        sock_rele(so);
+    }
+
+    return false;
+}
+
+void
+tcp_input(struct netif_pkt *pkt)
+{
+    struct net_stat *stat = net_stat_self();
+    struct ip *ip = pkt->nhdr;
+    struct tcphdr *th = pkt->data;
+    struct socket *so;
+    struct tcpcb *tp;
+    uint16_t off;
+    bool queued = false, irq;
+
+    ++stat->tcp_in;
+    if (pkt->len < sizeof(*th) || ntohl(ip->dst) == INADDR_BROADCAST) {
+        goto drop;
+    }
+
+    off = TH_OFF(th);
+    if (off < sizeof(*th) || off > pkt->len) {
+        goto drop;
+    }
+
+    if (in_cksum(th, pkt->len, in_pseudo(ip->src, ip->dst, IPPROTO_TCP,
+        pkt->len)) != 0) {
+        goto drop;
+    }
+
+    pkt->hash = net_flow_hash(ip->src, ip->dst, th->sport, th->dport);
+    so = in_pcblookup(IPPROTO_TCP, ip->src, th->sport, ip->dst, th->dport,
+        pkt->hash);
+
+    if (so == NULL || so->tp == NULL) {
+        tcp_reset(ip, th, pkt->len - off);
+        if (so != NULL) {
+            sock_rele(so);
+        }
+        goto drop;
+    }
+
+    irq = spinlock_acquire_irq(&so->lock);
+    tp = so->tp;
+    switch (tp->state) {
+    case TCPS_CLOSED:
+        tcp_reset(ip, th, pkt->len - off);
+        break;
+    case TCPS_LISTEN:
+        if (ISSET(th->flags, TH_RST)) {
+            break;
+        }
+
+        if (ISSET(th->flags, TH_ACK)) {
+            tcp_reset(ip, th, pkt->len - off);
+            break;
+        }
+
+        if (ISSET(th->flags, TH_SYN)) {
+            tcp_passive(so, ip, th, pkt->hash);
+        }
+        break;
+    case TCPS_SYN_SENT:
+        tcp_synsent(tp, th);
+        break;
+    default:
+        queued = tcp_segment(tp, pkt, th);
+        break;
+    }
+    spinlock_release_irq(&so->lock, irq);
+
+    sock_rele(so);
+    if (queued) {
+        return;
+    }
+
+    netif_rxfree(pkt);
+    return;
+drop:
+    ++stat->tcp_drop;
+    netif_rxfree(pkt);
+}
+
+int
+tcp_attach(struct socket *so)
+{
+    struct tcpcb *tp;
+
+    if ((tp = kalloc(sizeof(*tp))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(tp, 0, sizeof(*tp));
+    tp->so = so;
+    tp->state = TCPS_CLOSED;
+    tp->mss = TCP_MSS;
+    tp->cpu = tcp_timer_cpu(so);
+    TAILQ_INIT(&tp->sndq);
+    so->tp = tp;
+    return 0;
+}
+
+int
+tcp_connect(struct socket *so)
+{
+    struct tcpcb *tp = so->tp;
+
+    if (tp->state != TCPS_CLOSED) {
+        return -EISCONN;
+    }
+
+    tp->cpu = tcp_timer_cpu(so);
+    tp->iss = tcp_newiss(so->pcb.hash);
+    tp->snd_una = tp->iss;
+    tp->snd_nxt = tp->iss + 1;
+    tp->snd_max = tp->snd_nxt;
+    tp->snd_end = tp->snd_nxt;
+
+    /* The protocol reference */
+    tp->state = TCPS_SYN_SENT;
+    sock_ref(so);
+
+    tcp_respond_tp(tp, tp->iss, TH_SYN);
+    tcp_timer_arm(tp, tcp_rto(tp));
+    return 0;
+}
+
+int
+tcp_listen(struct socket *so)
+{
+    struct tcpcb *tp = so->tp;
+
+    if (tp->state == TCPS_LISTEN) {
+        return 0;
+    }
+
+    if (tp->state != TCPS_CLOSED) {
+        return -EISCONN;
+    }
+
+    tp->state = TCPS_LISTEN;
+    sock_ref(so);
+    return 0;
+}
+
+ssize_t
+tcp_send(struct socket *so, const void *buf, size_t len)
+{
+    struct tcpcb *tp = so->tp;
+    struct pbuf *pb;
+    size_t off = 0, n;
+
+    if (so->error != 0) {
+        return so->error;
+    }
+
+    switch (tp->state) {
+    case TCPS_ESTABLISHED:
+    case TCPS_CLOSE_WAIT:
+        break;
+    case TCPS_SYN_SENT:
+    case TCPS_SYN_RECEIVED:
+        return -EAGAIN;
+    default:
+        return ISSET(tp->flags, TF_NEEDFIN) ? -EPIPE : -ENOTCONN;
+    }
+
+    /* Top up the last segment if it is not out yet */
+    pb = TAILQ_LAST(&tp->sndq, pbufq);
+    if (pb != NULL && SEQ_GEQ(pb->seq, tp->snd_nxt) && pb->len < tp->mss) {
+        n = MIN(len, (size_t)(tp->mss - pb->len));
+        memcpy(pb->data + pb->len, buf, n);
+        pb->len += n;
+        tp->snd_end += n;
+        off += n;
+    }
+
+    while (off < len && tp->sndqlen < TCP_SNDQMAX) {
+        if ((pb = pbuf_alloc()) == NULL) {
+            break;
+        }
+
+        n = MIN(len - off, tp->mss);
+        memcpy(pb->data, PTR_OFFSET(buf, off), n);
+        pb->len = n;
+        pb->seq = tp->snd_end;
+        tp->snd_end += n;
+        TAILQ_INSERT_TAIL(&tp->sndq, pb, link);
+        ++tp->sndqlen;
+        off += n;
+    }
+
+    if (off == 0) {
+        return -EAGAIN;
+    }
+
+    tcp_output(tp);
+    return off;
+}
+
+void
+tcp_rcvd(struct socket *so)
+{
+    struct tcpcb *tp = so->tp;
+
+    /* The window was shut, tell the peer it opened */
+    if (so->rcvqlen == SO_RCVQMAX - 1 && tp->state >= TCPS_ESTABLISHED) {
+        tp->flags |= TF_ACKNOW;
+        tcp_output(tp);
+    }
+}
+
+void
+tcp_usrclose(struct socket *so)
+{
+    struct tcpcb *tp = so->tp;
+
+    switch (tp->state) {
+    case TCPS_LISTEN:
+    case TCPS_SYN_SENT:
+        tcp_close(tp, 0);
+        break;
+    case TCPS_SYN_RECEIVED:
+        tcp_drop(tp, 0);
+        break;
+    case TCPS_ESTABLISHED:
+        tp->flags |= TF_NEEDFIN;
+        tp->state = TCPS_FIN_WAIT_1;
+        tcp_output(tp);
+        break;
+    case TCPS_CLOSE_WAIT:
+        tp->flags |= TF_NEEDFIN;
+        tp->state = TCPS_LAST_ACK;
+        tcp_output(tp);
+        break;
+    }
+}
+
+void
+tcp_init(void)
+{
+    ncpu = cpu_count();
+    tcp_cpus = kalloc(sizeof(*tcp_cpus) * ncpu);
+    if (tcp_cpus == NULL) {
+        panic("tcp: could not allocate timer lists\n");
+    }
+
+    for (size_t i = 0; i < ncpu; ++i) {
+        if (spinlock_init("tcp_timer", &tcp_cpus[i].lock) != 0) {
+            panic("tcp: could not initialize timer list\n");
+        }
+
+        TAILQ_INIT(&tcp_cpus[i].timerq);
+    }
+
+    if (softint_establish(SOFTINT_TIMER, tcp_slowtimo) < 0) {
+        panic("tcp: could not hook the timer soft interrupt\n");
+    }
+}
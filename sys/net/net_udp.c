@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <net/if.h>
+#include <net/net.h>
+#include <net/ip.h>
+#include <net/udp.h>
+#include <net/pbuf.h>
+#include <net/socket.h>
+#include <kern/spinlock.h>
+#include <lib/string.h>
+#include <lib/stdbool.h>
+
+void
+udp_input(struct netif_pkt *pkt)
+{
+    struct net_stat *stat = net_stat_self();
+    struct ip *ip = pkt->nhdr;
+    struct udphdr *uh = pkt->data;
+    struct socket *so;
+    uint32_t sum;
+    uint16_t len;
+    bool queued, irq;
+
+    ++stat->udp_in;
+    if (pkt->len < sizeof(*uh)) {
+        goto drop;
+    }
+
+    len = ntohs(uh->len);
+    if (len < sizeof(*uh) || len > pkt->len) {
+        goto drop;
+    }
+
+    sum = in_pseudo(ip->src, ip->dst, IPPROTO_UDP, len);
+    if (uh->sum != 0 && in_cksum(uh, len, sum) != 0) {
+        goto drop;
+    }
+
+    pkt->hash = net_flow_hash(ip->src, ip->dst, uh->sport, uh->dport);
+    so = in_pcblookup(IPPROTO_UDP, ip->src, uh->sport, ip->dst, uh->dport,
+        pkt->hash);
+
+    if (so == NULL) {
+        goto drop;
+    }
+
+    /* Hand the payload up in place */
+    pkt->data = PTR_OFFSET(uh, sizeof(*uh));
+    pkt->len = len - sizeof(*uh);
+    irq = spinlock_acquire_irq(&so->lock);
+    queued = sock_enqueue(so, pkt);
+    spinlock_release_irq(&so->lock, irq);
+
+    sock_rele(so);
+    if (queued) {
+        return;
+    }
+drop:
+    ++stat->udp_drop;
+    netif_rxfree(pkt);
+}
+
+ssize_t
+udp_output(struct socket *so, const void *buf, size_t len, in_addr_t faddr,
+    in_port_t fport)
+{
+    struct net_ifaddr *ifa = net_ifaddr();
+    struct udphdr *uh;
+    struct pbuf *pb;
+    uint16_t ulen;
+    in_addr_t src;
+    int error;
+
+    if (ifa == NULL) {
+        return -ENETDOWN;
+    }
+
+    if (len > UDP_MAXDATA) {
+        return -EMSGSIZE;
+    }
+
+    if ((pb = pbuf_alloc()) == NULL) {
+        return -ENOMEM;
+    }
+
+    memcpy(pb->data, buf, len);
+    pb->len = len;
+    ulen = len + sizeof(*uh);
+
+    src = so->pcb.laddr;
+    if (src == INADDR_ANY) {
+        src = htonl(ifa->addr);
+    }
+
+    uh = pbuf_push(pb, sizeof(*uh));
+    uh->sport = so->pcb.lport;
+    uh->dport = fport;
+    uh->len = htons(ulen);
+    uh->sum = 0;
+    uh->sum = in_cksum(uh, ulen, in_pseudo(src, faddr, IPPROTO_UDP, ulen));
+    if (uh->sum == 0) {
+        uh->sum = 0xFFFF;
+    }
+
+    error = ip_output(pb, IPPROTO_UDP, ntohl(src), ntohl(faddr));
+    pbuf_release(pb);
+    if (error < 0) {
+        return error;
+    }
+
+    return len;
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <kern/spinlock.h>
+#include <os/intr.h>
+#include <os/softint.h>
+#include <os/trace.h>
+#include <mu/cpu.h>
+#include <mu/irq.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("intr: " fmt, ##__VA_ARGS__)
+
+#define IVEC_SLOT(VEC) ((VEC) - IVEC_MIN)
+#define IVEC_VALID(VEC) ((VEC) >= IVEC_MIN && (VEC) <= IVEC_MAX)
+
+/*
+ * Get the interrupt state of a processor
+ */
+static inline struct intr_cpu *
+intr_cpu(struct cpu_info *ci)
+{
+    if (ci == NULL) {
+        ci = cpu_self();
+    }
+
+    return (ci != NULL) ? ci->intr : NULL;
+}
+
+int
+intr_cpu_init(struct cpu_info *ci)
+{
+    struct intr_cpu *ic;
+
+    if (ci == NULL) {
+        return -EINVAL;
+    }
+
+    if ((ic = kalloc(sizeof(*ic))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(ic, 0, sizeof(*ic));
+    spinlock_init("intr", &ic->lock);
+    ci->intr = ic;
+    return 0;
+}
+
+int
+intr_alloc(struct cpu_info *ci, uint8_t *vec_res)
+{
+    struct intr_cpu *ic;
+    uint8_t slot;
+
+    if (vec_res == NULL) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return -ENXIO;
+    }
+
+    /*
+     * Hand out vectors from the top down, higher vectors
+     * have a higher priority class on the Local APIC.
+     */
+    spinlock_acquire(&ic->lock, true);
+    for (int vec = IVEC_MAX; vec >= IVEC_MIN; --vec) {
+        slot = IVEC_SLOT(vec);
+        if (ISSET(ic->bitmap[slot / 64], BIT(slot % 64))) {
+            continue;
+        }
+
+        ic->bitmap[slot / 64] |= BIT(slot % 64);
+        spinlock_release(&ic->lock, true);
+        *vec_res = vec;
+        return 0;
+    }
+
+    spinlock_release(&ic->lock, true);
+    return -ENOSPC;
+}
+
+int
+intr_reserve(struct cpu_info *ci, uint8_t vec)
+{
+    struct intr_cpu *ic;
+    uint8_t slot;
+    int error = 0;
+
+    if (!IVEC_VALID(vec)) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return -ENXIO;
+    }
+
+    slot = IVEC_SLOT(vec);
+    spinlock_acquire(&ic->lock, true);
+    if (ISSET(ic->bitmap[slot / 64], BIT(slot % 64))) {
+        error = -EBUSY;
+    } else {
+        ic->bitmap[slot / 64] |= BIT(slot % 64);
+    }
+
+    spinlock_release(&ic->lock, true);
+    return error;
+}
+
+void
+intr_free(struct cpu_info *ci, uint8_t vec)
+{
+    struct intr_cpu *ic;
+    uint8_t slot;
+
+    if (!IVEC_VALID(vec)) {
+        return;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return;
+    }
+
+    slot = IVEC_SLOT(vec);
+    spinlock_acquire(&ic->lock, true);
+    if (ic->vec[slot].head == NULL) {
+        ic->bitmap[slot / 64] &= ~BIT(slot % 64);
+    }
+    spinlock_release(&ic->lock, true);
+}
+
+int
+intr_register(struct cpu_info *ci, uint8_t vec, struct intr_hand *ih)
+{
+    struct intr_cpu *ic;
+    struct intr_vec *iv;
+    struct intr_hand **tail;
+
+    if (ih == NULL || ih->func == NULL || !IVEC_VALID(vec)) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return -ENXIO;
+    }
+
+    ih->count = 0;
+    ih->next = NULL;
+    iv = &ic->vec[IVEC_SLOT(vec)];
+
+    /*
+     * The dispatcher walks the chain without the lock so the
+     * handler must be fully set up before it is linked in.
+     */
+    spinlock_acquire(&ic->lock, true);
+    tail = (struct intr_hand **)&iv->head;
+    while (*tail != NULL) {
+        tail = (struct intr_hand **)&(*tail)->next;
+    }
+
+    __atomic_store_n(tail, ih, __ATOMIC_RELEASE);
+    spinlock_release(&ic->lock, true);
+    return 0;
+}
+
+int
+intr_unregister(struct cpu_info *ci, uint8_t vec, struct intr_hand *ih)
+{
+    struct intr_cpu *ic;
+    struct intr_vec *iv;
+    struct intr_hand **prev;
+
+    if (ih == NULL || !IVEC_VALID(vec)) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return -ENXIO;
+    }
+
+    iv = &ic->vec[IVEC_SLOT(vec)];
+    spinlock_acquire(&ic->lock, true);
+    prev = (struct intr_hand **)&iv->head;
+    while (*prev != NULL && *prev != ih) {
+        prev = (struct intr_hand **)&(*prev)->next;
+    }
+
+    if (*prev == NULL) {
+        spinlock_release(&ic->lock, true);
+        return -ENOENT;
+    }
+
+    /* Leave ih->next alone for a dispatcher still on it */
+    __atomic_store_n(prev, ih->next, __ATOMIC_RELEASE);
+    spinlock_release(&ic->lock, true);
+    return 0;
+}
+
+int
+intr_establish(const char *name, intr_func_t func, void *arg,
+    struct cpu_info *ci, uint8_t *vec_res)
+{
+    struct intr_hand *ih;
+    uint8_t vec;
+    int error;
+
+    if (func == NULL || vec_res == NULL) {
+        return -EINVAL;
+    }
+
+    if (ci == NULL) {
+        ci = cpu_self();
+    }
+
+    if ((ih = kalloc(sizeof(*ih))) == NULL) {
+        return -ENOMEM;
+    }
+
+    ih->name = name;
+    ih->func = func;
+    ih->arg = arg;
+
+    if ((error = intr_alloc(ci, &vec)) < 0) {
+        kfree(ih);
+        return error;
+    }
+
+    if ((error = intr_register(ci, vec, ih)) < 0) {
+        intr_free(ci, vec);
+        kfree(ih);
+        return error;
+    }
+
+    *vec_res = vec;
+    return 0;
+}
+
+int
+intr_disestablish(struct cpu_info *ci, uint8_t vec)
+{
+    struct intr_cpu *ic;
+    struct intr_hand *ih;
+    int error;
+
+    if (!IVEC_VALID(vec)) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(ci)) == NULL) {
+        return -ENXIO;
+    }
+
+    ih = __atomic_load_n(&ic->vec[IVEC_SLOT(vec)].head, __ATOMIC_ACQUIRE);
+    if ((error = intr_unregister(ci, vec, ih)) < 0) {
+        return error;
+    }
+
+    intr_free(ci, vec);
+    kfree(ih);
+    return 0;
+}
+
+int
+intr_move(struct cpu_info *from, uint8_t vec, struct cpu_info *to,
+    uint8_t *vec_res)
+{
+    struct intr_cpu *ic;
+    struct intr_hand *ih;
+    uint8_t newvec;
+    int error;
+
+    if (!IVEC_VALID(vec) || to == NULL || vec_res == NULL) {
+        return -EINVAL;
+    }
+
+    if ((ic = intr_cpu(from)) == NULL) {
+        return -ENXIO;
+    }
+
+    if ((error = intr_alloc(to, &newvec)) < 0) {
+        return error;
+    }
+
+    /* Taken from the head so the chain keeps its order */
+    for (;;) {
+        ih = __atomic_load_n(&ic->vec[IVEC_SLOT(vec)].head, __ATOMIC_ACQUIRE);
+        if (ih == NULL) {
+            break;
+        }
+
+        intr_unregister(from, vec, ih);
+        intr_register(to, newvec, ih);
+    }
+
+    intr_free(from, vec);
+    *vec_res = newvec;
+    return 0;
+}
+
+void
+intr_dispatch(uint64_t vec)
+{
+    struct intr_cpu *ic;
+    struct intr_vec *iv;
+    struct intr_hand *ih;
+    bool handled = false;
+
+    if ((ic = intr_cpu(NULL)) == NULL || !IVEC_VALID(vec)) {
+        mu_intr_eoi();
+        return;
+    }
+
+    /*
+     * Counters are only ever written by the processor that
+     * owns them with interrupts masked, no atomics needed.
+     */
+    iv = &ic->vec[IVEC_SLOT(vec)];
+    ++iv->count;
+
+    ih = __atomic_load_n(&iv->head, __ATOMIC_ACQUIRE);
+    while (ih != NULL) {
+        if (ih->func(ih->arg) == INTR_HANDLED) {
+            ++ih->count;
+            handled = true;
+        }
+
+        ih = __atomic_load_n(&ih->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (!handled) {
+        ++iv->nstray;
+    }
+
+    /* Deferred work runs outside of the hard IRQ window */
+    mu_intr_eoi();
+    softint_run();
+}
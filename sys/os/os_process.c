@@ -30,21 +30,59 @@
 #include <sys/types.h>
 #include <sys/atomic.h>
 #include <sys/errno.h>
+#include <kern/exec.h>
 #include <os/process.h>
+#include <os/thread.h>
 #include <mu/process.h>
 
 static size_t next_pid = 0;
 
 int
-process_init(struct process *process, uintptr_t ip, int flags)
+process_init(struct process *process, int flags)
 {
+    int error;
+
     if (process == NULL) {
         return -EINVAL;
     }
 
     process->pid = next_pid;
-    process->affinity = -1;
+    process->nthreads = 0;
     atomic_inc_64(&next_pid);
-    mu_process_init(process, ip, flags);
+    TAILQ_INIT(&process->threads);
+    spinlock_init("proc", &process->lock);
+    if ((error = filedesc_init(&process->fd)) < 0) {
+        return error;
+    }
+
+    vm_map_init(&process->map);
+    return mu_process_init(process, flags);
+}
+
+int
+process_exec(struct process *process, struct vnode *vp, struct thread **td_res)
+{
+    uintptr_t entry;
+    int error;
+
+    if (process == NULL || vp == NULL) {
+        return -EINVAL;
+    }
+
+    if ((error = process_init(process, 0)) < 0) {
+        return error;
+    }
+
+    if ((error = elf_load(vp, &process->map, &entry)) < 0) {
+        vm_map_clear(&process->map);
+        return error;
+    }
+
+    error = thread_create(process, entry, 0, 0, td_res);
+    if (error < 0) {
+        vm_map_clear(&process->map);
+        return error;
+    }
+
     return 0;
 }
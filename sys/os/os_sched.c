@@ -28,57 +28,230 @@
  */
 
 #include <sys/queue.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/atomic.h>
 #include <os/sched.h>
 #include <os/trace.h>
 #include <mu/cpu.h>
+#include <mu/process.h>
 
-struct cpu_info *
-sched_enqueue_proc(struct process *proc)
+#define dtrace(fmt, ...) trace("sched: " fmt, ##__VA_ARGS__)
+
+static struct spinlock isolate_lock;
+
+/*
+ * Pick the processor a thread should run on, unpinned
+ * threads are kept off isolated processors.
+ */
+static struct cpu_info *
+sched_pick_core(struct thread *td)
 {
     struct cpu_info *core;
-    size_t ncpu, i;
 
-    if (proc == NULL) {
-        return NULL;
-    }
-
-    if (proc->affinity >= 0) {
-        if ((core = cpu_get(proc->affinity)) != NULL)
+    if (td->affinity >= 0) {
+        if ((core = cpu_get(td->affinity)) != NULL)
             return core;
     }
 
     /*
      * Here, we derive the processor index by using the lower
      * byte MOD the number of cores, this works best and most
-     * evenly when the PID assignment increments monotonically
+     * evenly when the TID assignment increments monotonically
      * though could potentially work with random assignment, just
      * more sporadic.
      */
-    ncpu = cpu_count();
-    i = (proc->pid & 0xFF) % ncpu;
-    while ((core = cpu_get(i++)) == NULL) {
-        if (i > ncpu) {
-            i = 0;
+    return cpu_pick(td->tid & 0xFF);
+}
+
+struct cpu_info *
+sched_enqueue_thread(struct thread *td)
+{
+    struct cpu_info *core;
+    bool irq;
+
+    if (td == NULL) {
+        return NULL;
+    }
+
+    core = sched_pick_core(td);
+    irq = spinlock_acquire_irq(&core->pqueue_lock);
+    TAILQ_INSERT_TAIL(&core->pqueue, td, link);
+
+    /*
+     * Restart the tick so it gets to run, a core waiting
+     * on its queue head is already woken by the insert.
+     */
+    if (ISSET(core->flags, CPU_TICKLESS)) {
+        __atomic_fetch_and(&core->flags, ~CPU_TICKLESS, __ATOMIC_RELAXED);
+        if (!ISSET(core->flags, CPU_IDLEWAIT)) {
+            cpu_kick(core);
         }
     }
-    TAILQ_INSERT_TAIL(&core->pqueue, proc, link);
+
+    spinlock_release_irq(&core->pqueue_lock, irq);
     return core;
 }
 
-struct process *
-sched_dequeue_proc(void)
+struct thread *
+sched_dequeue_thread(void)
 {
     struct cpu_info *core;
-    struct process *proc;
+    struct thread *td;
+    bool irq;
 
     core = cpu_self();
     if (core == NULL) {
         return NULL;
     }
 
-    proc = TAILQ_FIRST(&core->pqueue);
-    if (proc != NULL) {
-        TAILQ_REMOVE(&core->pqueue, proc, link);
+    irq = spinlock_acquire_irq(&core->pqueue_lock);
+    td = TAILQ_FIRST(&core->pqueue);
+    if (td != NULL) {
+        TAILQ_REMOVE(&core->pqueue, td, link);
+    }
+
+    spinlock_release_irq(&core->pqueue_lock, irq);
+    return td;
+}
+
+bool
+sched_stop_tick(struct cpu_info *ci)
+{
+    bool stop = false;
+    bool irq;
+
+    if (!ISSET(ci->flags, CPU_ISOLATED)) {
+        return false;
+    }
+
+    /*
+     * Checked under the queue lock so an enqueue either
+     * sees the tick stopped and kicks us, or we see its
+     * thread.
+     */
+    irq = spinlock_acquire_irq(&ci->pqueue_lock);
+    if (TAILQ_EMPTY(&ci->pqueue)) {
+        __atomic_fetch_or(&ci->flags, CPU_TICKLESS, __ATOMIC_RELAXED);
+        stop = true;
+    }
+
+    spinlock_release_irq(&ci->pqueue_lock, irq);
+    return stop;
+}
+
+int
+sched_isolate(uint32_t cpu, bool isolate)
+{
+    TAILQ_HEAD(, thread) moved;
+    struct cpu_info *core, *ci;
+    struct thread *td, *tmp;
+    size_t ngeneral = 0;
+    bool irq;
+
+    if ((core = cpu_get(cpu)) == NULL) {
+        return -EINVAL;
+    }
+
+    spinlock_acquire(&isolate_lock, false);
+    if (!isolate) {
+        __atomic_fetch_and(&core->flags, ~CPU_ISOLATED, __ATOMIC_RELAXED);
+        spinlock_release(&isolate_lock, false);
+
+        irq = spinlock_acquire_irq(&core->pqueue_lock);
+        if (ISSET(core->flags, CPU_TICKLESS)) {
+            __atomic_fetch_and(&core->flags, ~CPU_TICKLESS, __ATOMIC_RELAXED);
+            cpu_kick(core);
+        }
+
+        spinlock_release_irq(&core->pqueue_lock, irq);
+        return 0;
+    }
+
+    /* Something has to be left for unbound work */
+    for (uint32_t i = 0; (ci = cpu_get(i)) != NULL; ++i) {
+        if (ci != core && !ISSET(ci->flags, CPU_ISOLATED)) {
+            ++ngeneral;
+        }
+    }
+
+    if (ngeneral == 0) {
+        spinlock_release(&isolate_lock, false);
+        return -EBUSY;
+    }
+
+    __atomic_fetch_or(&core->flags, CPU_ISOLATED, __ATOMIC_RELAXED);
+    spinlock_release(&isolate_lock, false);
+
+    /* Move threads that are not pinned here elsewhere */
+    TAILQ_INIT(&moved);
+    irq = spinlock_acquire_irq(&core->pqueue_lock);
+    TAILQ_FOREACH_SAFE(td, &core->pqueue, link, tmp) {
+        if (td->affinity == (id_t)cpu) {
+            continue;
+        }
+
+        TAILQ_REMOVE(&core->pqueue, td, link);
+        TAILQ_INSERT_TAIL(&moved, td, link);
+    }
+
+    spinlock_release_irq(&core->pqueue_lock, irq);
+    while ((td = TAILQ_FIRST(&moved)) != NULL) {
+        TAILQ_REMOVE(&moved, td, link);
+        sched_enqueue_thread(td);
+    }
+
+    dtrace("cpu %d isolated\n", cpu);
+    return 0;
+}
+
+void
+sched_sleep(uintptr_t wchan)
+{
+    struct thread *self;
+
+    if ((self = cpu_self()->curthread) == NULL) {
+        return;
+    }
+
+    self->wchan = wchan;
+    self->state = THREAD_SLEEP;
+}
+
+void
+sched_yield(void)
+{
+    mu_thread_yield();
+}
+
+bool
+sched_block(struct thread *td)
+{
+    return atomic_cas_int(&td->state, THREAD_SLEEP, THREAD_BLOCKED) == THREAD_SLEEP;
+}
+
+void
+sched_wakeup(struct thread *td)
+{
+    unsigned int state;
+
+    if (td == NULL) {
+        return;
+    }
+
+    /*
+     * A thread still on its way to sleep just keeps
+     * running, only one that was switched out needs to
+     * go back on a run queue.
+     */
+    state = atomic_cas_int(&td->state, THREAD_SLEEP, THREAD_RUN);
+    if (state != THREAD_BLOCKED) {
+        return;
+    }
+
+    state = atomic_cas_int(&td->state, THREAD_BLOCKED, THREAD_RUN);
+    if (state == THREAD_BLOCKED) {
+        td->wchan = 0;
+        sched_enqueue_thread(td);
     }
-    return proc;
 }
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/queue.h>
+#include <os/softint.h>
+#include <mu/cpu.h>
+#include <mu/irq.h>
+
+static softint_func_t softint_tab[NSOFTINT];
+
+/*
+ * Drain the work queue of the current processor
+ */
+static bool
+softint_work(size_t budget)
+{
+    struct softint_cpu *sc = &cpu_self()->softint;
+    struct softint_work *work;
+    bool irq_en;
+
+    while (budget-- > 0) {
+        irq_en = mu_irq_state();
+        mu_irq_disable();
+        work = TAILQ_FIRST(&sc->workq);
+        if (work != NULL) {
+            TAILQ_REMOVE(&sc->workq, work, link);
+            work->queued = 0;
+        }
+
+        if (irq_en) {
+            mu_irq_enable();
+        }
+
+        if (work == NULL) {
+            return false;
+        }
+
+        work->func(work->arg);
+    }
+
+    return !TAILQ_EMPTY(&sc->workq);
+}
+
+int
+softint_establish(uint8_t level, softint_func_t func)
+{
+    if (level >= NSOFTINT || func == NULL) {
+        return -EINVAL;
+    }
+
+    if (softint_tab[level] != NULL) {
+        return -EBUSY;
+    }
+
+    softint_tab[level] = func;
+    return 0;
+}
+
+void
+softint_raise(uint8_t level)
+{
+    struct cpu_info *ci = cpu_self();
+
+    if (level >= NSOFTINT || ci == NULL) {
+        return;
+    }
+
+    __atomic_fetch_or(&ci->softint.pending, BIT(level), __ATOMIC_RELEASE);
+}
+
+void
+softint_queue(struct softint_work *work)
+{
+    struct softint_cpu *sc;
+    bool irq_en;
+
+    if (work == NULL || work->func == NULL) {
+        return;
+    }
+
+    /*
+     * The queue is only ever touched by its own processor,
+     * masking interrupts is enough to protect it.
+     */
+    irq_en = mu_irq_state();
+    mu_irq_disable();
+    sc = &cpu_self()->softint;
+    if (!work->queued) {
+        work->queued = 1;
+        TAILQ_INSERT_TAIL(&sc->workq, work, link);
+    }
+
+    if (irq_en) {
+        mu_irq_enable();
+    }
+
+    softint_raise(SOFTINT_WORK);
+}
+
+void
+softint_run(void)
+{
+    struct cpu_info *ci;
+    struct softint_cpu *sc;
+    softint_func_t func;
+    uint32_t pending;
+    bool irq_en;
+
+    irq_en = mu_irq_state();
+    mu_irq_disable();
+
+    /* Don't nest within ourselves */
+    ci = cpu_self();
+    sc = &ci->softint;
+    if (sc->active || sc->pending == 0) {
+        if (irq_en)
+            mu_irq_enable();
+        return;
+    }
+
+    sc->active = 1;
+    for (int i = 0; i < SOFTINT_RESTART; ++i) {
+        pending = __atomic_exchange_n(&sc->pending, 0, __ATOMIC_ACQUIRE);
+        if (pending == 0) {
+            break;
+        }
+
+        /*
+         * Handlers run with interrupts enabled so that hardware
+         * interrupts keep their latency, work that does not fit
+         * the budget is raised again for the next round.
+         */
+        mu_irq_enable();
+        for (uint8_t level = 0; level < NSOFTINT; ++level) {
+            if (!ISSET(pending, BIT(level))) {
+                continue;
+            }
+
+            if ((func = softint_tab[level]) == NULL) {
+                continue;
+            }
+
+            ++sc->nrun[level];
+            if (func(SOFTINT_BUDGET)) {
+                softint_raise(level);
+            }
+        }
+        mu_irq_disable();
+    }
+
+    sc->active = 0;
+    if (irq_en) {
+        mu_irq_enable();
+    }
+}
+
+void
+softint_cpu_init(void)
+{
+    struct softint_cpu *sc = &cpu_self()->softint;
+
+    sc->pending = 0;
+    sc->active = 0;
+    TAILQ_INIT(&sc->workq);
+    for (int i = 0; i < NSOFTINT; ++i) {
+        sc->nrun[i] = 0;
+    }
+
+    if (softint_tab[SOFTINT_WORK] == NULL) {
+        softint_tab[SOFTINT_WORK] = softint_work;
+    }
+}
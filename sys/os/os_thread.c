@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/atomic.h>
+#include <sys/errno.h>
+#include <os/process.h>
+#include <os/thread.h>
+#include <os/sched.h>
+#include <os/trace.h>
+#include <kern/panic.h>
+#include <mu/process.h>
+#include <mu/cpu.h>
+#include <vm/kalloc.h>
+#include <lib/string.h>
+
+#define dtrace(fmt, ...) trace("thread: " fmt, ##__VA_ARGS__)
+
+struct process proc0;
+static size_t next_tid = 0;
+
+/* Exited threads waiting to be freed */
+static TAILQ_HEAD(, thread) zombies;
+static struct spinlock zombie_lock;
+
+/*
+ * Free the threads that have exited since last time
+ */
+static void
+thread_reap(void)
+{
+    struct thread *td;
+    bool irq;
+
+    for (;;) {
+        irq = spinlock_acquire_irq(&zombie_lock);
+        if ((td = TAILQ_FIRST(&zombies)) != NULL) {
+            TAILQ_REMOVE(&zombies, td, plink);
+        }
+        spinlock_release_irq(&zombie_lock, irq);
+
+        if (td == NULL) {
+            break;
+        }
+
+        mu_thread_free(td);
+        if (td->tls != NULL) {
+            kfree(td->tls);
+        }
+
+        kfree(td);
+    }
+}
+
+int
+thread_create(struct process *proc, uintptr_t ip, uintptr_t arg, int flags,
+    struct thread **res)
+{
+    struct thread *td;
+    int error;
+
+    if (proc == NULL) {
+        return -EINVAL;
+    }
+
+    if ((td = kalloc(sizeof(*td))) == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(td, 0, sizeof(*td));
+    td->tid = atomic_inc_64(&next_tid);
+    td->affinity = -1;
+    td->proc = proc;
+    td->state = THREAD_RUN;
+
+    /* Kernel threads get their own TLS block */
+    if (ISSET(flags, PROC_KERN)) {
+        if ((td->tls = kalloc(KTHREAD_TLS_SIZE)) == NULL) {
+            kfree(td);
+            return -ENOMEM;
+        }
+
+        memset(td->tls, 0, KTHREAD_TLS_SIZE);
+    }
+
+    spinlock_acquire(&proc->lock, false);
+    error = mu_thread_init(td, ip, arg, flags);
+    if (error < 0) {
+        spinlock_release(&proc->lock, false);
+        if (td->tls != NULL) {
+            kfree(td->tls);
+        }
+
+        kfree(td);
+        return error;
+    }
+
+    TAILQ_INSERT_TAIL(&proc->threads, td, plink);
+    ++proc->nthreads;
+    spinlock_release(&proc->lock, false);
+
+    if (res != NULL) {
+        *res = td;
+    }
+
+    return 0;
+}
+
+int
+kthread_create(void(*func)(void *), void *arg, id_t cpu, struct thread **res)
+{
+    struct thread *td;
+    int error;
+
+    if (func == NULL) {
+        return -EINVAL;
+    }
+
+    thread_reap();
+    error = thread_create(
+        &proc0,
+        (uintptr_t)func,
+        (uintptr_t)arg,
+        PROC_KERN,
+        &td
+    );
+
+    if (error < 0) {
+        return error;
+    }
+
+    td->affinity = cpu;
+    sched_enqueue_thread(td);
+    if (res != NULL) {
+        *res = td;
+    }
+
+    return 0;
+}
+
+void
+thread_retire(struct thread *td)
+{
+    bool irq;
+
+    if (td == NULL) {
+        return;
+    }
+
+    irq = spinlock_acquire_irq(&zombie_lock);
+    TAILQ_INSERT_TAIL(&zombies, td, plink);
+    spinlock_release_irq(&zombie_lock, irq);
+}
+
+__dead void
+kthread_exit(void)
+{
+    struct thread *td;
+    struct process *proc;
+
+    if ((td = cpu_self()->curthread) == NULL) {
+        panic("kthread_exit: no current thread\n");
+    }
+
+    proc = td->proc;
+    spinlock_acquire(&proc->lock, false);
+    TAILQ_REMOVE(&proc->threads, td, plink);
+    --proc->nthreads;
+    spinlock_release(&proc->lock, false);
+
+    dtrace("tid %d exited\n", td->tid);
+    mu_thread_exit(td);
+}
+
+void *
+kthread_tls(void)
+{
+    struct thread *td;
+
+    if ((td = cpu_self()->curthread) == NULL) {
+        return NULL;
+    }
+
+    return td->tls;
+}
+
+void
+kthread_init(void)
+{
+    if (process_init(&proc0, PROC_KERN) < 0) {
+        panic("thread: could not initialize proc0\n");
+    }
+
+    TAILQ_INIT(&zombies);
+    spinlock_init("zombie", &zombie_lock);
+
+    dtrace("kernel process online\n");
+}
@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <os/trace.h>
 #include <vm/vm.h>
+#include <vm/pcache.h>
 #include <mu/mmu.h>
 
 #define dtrace(fmt, ...) trace("vm: " fmt, ##__VA_ARGS__)
@@ -39,5 +40,6 @@ vm_init(void)
 {
     dtrace("bringing up mmu...\n");
     mu_pmap_init();
+    pcache_init();
     dtrace("OK\n");
 }
@@ -32,6 +32,7 @@
 #include <vm/tlsf.h>
 #include <vm/phys.h>
 #include <mu/spinlock.h>
+#include <mu/irq.h>
 #include <vm/vm.h>
 
 #define MEM_SIZE 0x200000
@@ -44,23 +45,51 @@
 static volatile size_t lock = 0;
 static tlsf_t ctx;
 
+/*
+ * The heap is used from soft interrupts as well, keep
+ * interrupts masked while the lock is held so one cannot
+ * land on top of a holder on the same processor.
+ */
+static bool
+kalloc_lock(void)
+{
+    bool irq;
+
+    irq = mu_irq_state();
+    mu_irq_disable();
+    mu_spinlock_acq(&lock, 0);
+    return irq;
+}
+
+static void
+kalloc_unlock(bool irq)
+{
+    mu_spinlock_rel(&lock, 0);
+    if (irq) {
+        mu_irq_enable();
+    }
+}
+
 void *
 kalloc(size_t sz)
 {
     void *tmp;
+    bool irq;
 
-    mu_spinlock_acq(&lock, 0);
+    irq = kalloc_lock();
     tmp = tlsf_malloc(ctx, sz);
-    mu_spinlock_rel(&lock, 0);
+    kalloc_unlock(irq);
     return tmp;
 }
 
 void
 kfree(void *ptr)
 {
-    mu_spinlock_acq(&lock, 0);
+    bool irq;
+
+    irq = kalloc_lock();
     tlsf_free(ctx, ptr);
-    mu_spinlock_rel(&lock, 0);
+    kalloc_unlock(irq);
 }
 
 void
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <sys/mman.h>
+#include <kern/vnode.h>
+#include <mu/mmu.h>
+#include <vm/map.h>
+#include <vm/pcache.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+void
+vm_map_init(struct vm_map *map)
+{
+    TAILQ_INIT(&map->entries);
+    spinlock_init("vm_map", &map->lock);
+}
+
+int
+vm_map_insert(struct vm_map *map, uintptr_t va, size_t len,
+    uint16_t prot, struct vnode *vp, off_t off, size_t filesz)
+{
+    struct vm_mapent *ent, *cur, *prev = NULL;
+    uintptr_t start, end;
+
+    if (map == NULL || len == 0 || filesz > len) {
+        return -EINVAL;
+    }
+
+    /* File offsets must line up with addresses */
+    if (vp != NULL && (va & (PAGESIZE - 1)) != (off & (PAGESIZE - 1))) {
+        return -EINVAL;
+    }
+
+    if (va + len < va || va + len > VM_MAXUSER + 1) {
+        return -EINVAL;
+    }
+
+    start = ALIGN_DOWN(va, PAGESIZE);
+    end = ALIGN_UP(va + len, PAGESIZE);
+    if ((ent = kalloc(sizeof(*ent))) == NULL) {
+        return -ENOMEM;
+    }
+
+    ent->start = start;
+    ent->end = end;
+    ent->fend = va + filesz;
+    ent->prot = prot;
+    ent->vp = vp;
+    ent->off = off - (va - start);
+
+    spinlock_acquire(&map->lock, true);
+    TAILQ_FOREACH(cur, &map->entries, link) {
+        if (end <= cur->start) {
+            break;
+        }
+
+        if (start < cur->end) {
+            spinlock_release(&map->lock, true);
+            kfree(ent);
+            return -EEXIST;
+        }
+
+        prev = cur;
+    }
+
+    if (vp != NULL) {
+        vnode_ref(vp);
+    }
+
+    if (prev == NULL) {
+        TAILQ_INSERT_HEAD(&map->entries, ent, link);
+    } else {
+        TAILQ_INSERT_AFTER(&map->entries, prev, ent, link);
+    }
+
+    spinlock_release(&map->lock, true);
+    return 0;
+}
+
+void
+vm_map_clear(struct vm_map *map)
+{
+    struct vm_mapent *ent;
+
+    spinlock_acquire(&map->lock, true);
+    while ((ent = TAILQ_FIRST(&map->entries)) != NULL) {
+        TAILQ_REMOVE(&map->entries, ent, link);
+        if (ent->vp != NULL) {
+            vnode_release(ent->vp);
+        }
+
+        kfree(ent);
+    }
+
+    spinlock_release(&map->lock, true);
+}
+
+/*
+ * XXX: The map lock must be held
+ */
+static struct vm_mapent *
+vm_map_lookup(struct vm_map *map, uintptr_t va)
+{
+    struct vm_mapent *ent;
+
+    TAILQ_FOREACH(ent, &map->entries, link) {
+        if (va < ent->start) {
+            break;
+        }
+
+        if (va < ent->end) {
+            return ent;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Make a private copy of a page, any part of it past
+ * the file backed data is zeroed.
+ */
+static int
+vm_fault_private(struct vm_mapent *ent, uintptr_t page, uintptr_t *res)
+{
+    uintptr_t pa, src;
+    size_t len = 0;
+    off_t off;
+    void *va;
+    int error;
+
+    if ((pa = vm_phys_alloc(1)) == 0) {
+        return -ENOMEM;
+    }
+
+    va = PHYS_TO_VIRT(pa);
+    if (ent->vp != NULL && page < ent->fend) {
+        off = ent->off + (page - ent->start);
+        if ((error = pcache_get(ent->vp, off, &src)) < 0) {
+            vm_phys_free(pa, 1);
+            return error;
+        }
+
+        len = MIN(PAGESIZE, ent->fend - page);
+        memcpy(va, PHYS_TO_VIRT(src), len);
+        pcache_put(ent->vp, off);
+    }
+
+    memset((char *)va + len, 0, PAGESIZE - len);
+    *res = pa;
+    return 0;
+}
+
+int
+vm_fault(struct vm_map *map, struct mmu_vas *vas, uintptr_t va, uint16_t access)
+{
+    struct vm_mapent *ent, snap;
+    uintptr_t page, pa, cur;
+    bool shared, mapped = false;
+    off_t off;
+    int error;
+
+    if (map == NULL || vas == NULL) {
+        return -EINVAL;
+    }
+
+    page = ALIGN_DOWN(va, PAGESIZE);
+    spinlock_acquire(&map->lock, true);
+    if ((ent = vm_map_lookup(map, va)) == NULL) {
+        spinlock_release(&map->lock, true);
+        return -EFAULT;
+    }
+
+    if ((access & ~ent->prot) != 0) {
+        spinlock_release(&map->lock, true);
+        return -EFAULT;
+    }
+
+    /* Filling the page may block on I/O, work from a copy */
+    snap = *ent;
+    if (snap.vp != NULL) {
+        vnode_ref(snap.vp);
+    }
+    spinlock_release(&map->lock, true);
+
+    /*
+     * Read-only pages wholly backed by the file come
+     * straight from the page cache.
+     */
+    shared = snap.vp != NULL && !ISSET(snap.prot, PROT_WRITE);
+    shared = shared && page + PAGESIZE <= snap.fend;
+    off = snap.off + (page - snap.start);
+    if (shared) {
+        error = pcache_get(snap.vp, off, &pa);
+    } else {
+        error = vm_fault_private(&snap, page, &pa);
+    }
+
+    if (error < 0) {
+        goto done;
+    }
+
+    /*
+     * The map may have changed in the meantime. If the entry
+     * is gone or another fault mapped the page first, let the
+     * access retry and fault again if it has to.
+     */
+    spinlock_acquire(&map->lock, true);
+    ent = vm_map_lookup(map, va);
+    if (ent != NULL && ent->start == snap.start && ent->vp == snap.vp &&
+        ent->off == snap.off && ent->prot == snap.prot &&
+        mu_pmap_translate(vas, page, &cur) < 0) {
+        error = mu_pmap_map(vas, pa, page, snap.prot | PROT_USER, PAGESIZE_4K);
+        mapped = (error == 0);
+    }
+    spinlock_release(&map->lock, true);
+
+    if (!mapped && shared) {
+        pcache_put(snap.vp, off);
+    } else if (!mapped) {
+        vm_phys_free(pa, 1);
+    }
+done:
+    if (snap.vp != NULL) {
+        vnode_release(snap.vp);
+    }
+
+    return error;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2025 Ian Marco Moffett and the Osmora Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of Hyra nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sys/types.h>
+#include <sys/errno.h>
+#include <sys/param.h>
+#include <kern/vnode.h>
+#include <kern/spinlock.h>
+#include <vm/pcache.h>
+#include <vm/kalloc.h>
+#include <vm/phys.h>
+#include <vm/vm.h>
+#include <lib/string.h>
+
+/*
+ * The page cache lock is taken with map locks held and
+ * never from interrupt context, it leaves the interrupt
+ * state alone.
+ */
+static LIST_HEAD(, pcache_page) pcache_hash[PCACHE_NHASH];
+static struct spinlock pcache_lock;
+
+static inline size_t
+pcache_hashfn(struct vnode *vp, off_t off)
+{
+    return (((uintptr_t)vp >> 6) ^ (off / PAGESIZE)) % PCACHE_NHASH;
+}
+
+/*
+ * XXX: The page cache lock must be held
+ */
+static struct pcache_page *
+pcache_lookup(struct vnode *vp, off_t off)
+{
+    struct pcache_page *pg;
+
+    LIST_FOREACH(pg, &pcache_hash[pcache_hashfn(vp, off)], hashq) {
+        if (pg->vp == vp && pg->off == off) {
+            return pg;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Allocate a page and read file data into it, the
+ * tail past the end of the file is zeroed.
+ */
+static struct pcache_page *
+pcache_fill(struct vnode *vp, off_t off, int *error)
+{
+    struct pcache_page *pg;
+    ssize_t len;
+    void *va;
+
+    if ((pg = kalloc(sizeof(*pg))) == NULL) {
+        *error = -ENOMEM;
+        return NULL;
+    }
+
+    if ((pg->pa = vm_phys_alloc(1)) == 0) {
+        kfree(pg);
+        *error = -ENOMEM;
+        return NULL;
+    }
+
+    va = PHYS_TO_VIRT(pg->pa);
+    len = vnode_read(vp, va, PAGESIZE, off);
+    if (len < 0) {
+        vm_phys_free(pg->pa, 1);
+        kfree(pg);
+        *error = len;
+        return NULL;
+    }
+
+    memset((char *)va + len, 0, PAGESIZE - len);
+    pg->vp = vp;
+    pg->off = off;
+    pg->ref = 1;
+    return pg;
+}
+
+int
+pcache_get(struct vnode *vp, off_t off, uintptr_t *res)
+{
+    struct pcache_page *pg, *new;
+    int error;
+
+    if (vp == NULL || res == NULL) {
+        return -EINVAL;
+    }
+
+    if ((off & (PAGESIZE - 1)) != 0) {
+        return -EINVAL;
+    }
+
+    spinlock_acquire(&pcache_lock, false);
+    if ((pg = pcache_lookup(vp, off)) != NULL) {
+        ++pg->ref;
+        *res = pg->pa;
+        spinlock_release(&pcache_lock, false);
+        return 0;
+    }
+
+    /* Read the page in without holding the lock */
+    spinlock_release(&pcache_lock, false);
+    if ((new = pcache_fill(vp, off, &error)) == NULL) {
+        return error;
+    }
+
+    /* Someone may have beaten us to it */
+    spinlock_acquire(&pcache_lock, false);
+    if ((pg = pcache_lookup(vp, off)) != NULL) {
+        ++pg->ref;
+        *res = pg->pa;
+        spinlock_release(&pcache_lock, false);
+        vm_phys_free(new->pa, 1);
+        kfree(new);
+        return 0;
+    }
+
+    vnode_ref(vp);
+    LIST_INSERT_HEAD(&pcache_hash[pcache_hashfn(vp, off)], new, hashq);
+    *res = new->pa;
+    spinlock_release(&pcache_lock, false);
+    return 0;
+}
+
+void
+pcache_put(struct vnode *vp, off_t off)
+{
+    struct pcache_page *pg;
+
+    spinlock_acquire(&pcache_lock, false);
+    if ((pg = pcache_lookup(vp, off)) == NULL) {
+        spinlock_release(&pcache_lock, false);
+        return;
+    }
+
+    if (--pg->ref > 0) {
+        spinlock_release(&pcache_lock, false);
+        return;
+    }
+
+    LIST_REMOVE(pg, hashq);
+    spinlock_release(&pcache_lock, false);
+    vm_phys_free(pg->pa, 1);
+    vnode_release(vp);
+    kfree(pg);
+}
+
+void
+pcache_init(void)
+{
+    for (size_t i = 0; i < PCACHE_NHASH; ++i) {
+        LIST_INIT(&pcache_hash[i]);
+    }
+
+    spinlock_init("pcache", &pcache_lock);
+}